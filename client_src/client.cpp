@@ -16,6 +16,8 @@
 #include <thread>
 #include "client_event_handler.h"
 #include "lobby/controller/lobby_controller.h"
+#include "game/car_predictor.h"
+#include "game/snapshot_interpolator.h"
 #include "game/game_renderer.h"
 // Asegúrate que esta ruta sea correcta (mayúsculas/minúsculas)
 #include "lobby/Rankings/final_ranking.h"
@@ -69,7 +71,7 @@ void Client::start() {
         threads_started = true;
 
         // Variables para guardar los resultados y mostrarlos después de cerrar SDL
-        std::vector<InfoPlayer> final_game_results;
+        GameState final_game_results;  // con su roster: nombres y autos del ranking
         bool show_qt_ranking = false;
 
         // ---------------------------------------------------------
@@ -91,9 +93,12 @@ void Client::start() {
 
             Renderer renderer(window, -1, SDL_RENDERER_ACCELERATED);
             GameRenderer game_renderer(renderer);
+            CarPredictor predictor;  // el auto propio se mueve sin esperar al servidor
+            SnapshotInterpolator interpolator;  // los ajenos, suavizados entre snapshots
 
             if (!races_paths.empty()) {
                 game_renderer.init_race(races_paths[0]);
+                predictor.init_race(races_paths[0]);
             }
 
             ClientEventHandler event_handler(command_queue, player_id, active);
@@ -103,6 +108,7 @@ void Client::start() {
             bool race_finished = false;
             bool ranking_phase = false;
             auto ranking_start = std::chrono::steady_clock::time_point{};
+            auto last_title = std::chrono::steady_clock::time_point{};
             size_t current_race_index = 0;
 
 
@@ -111,9 +117,13 @@ void Client::start() {
 
                 // 1. Consumir snapshots
                 GameState new_snapshot;
+                bool got_snapshot = false;
                 while (snapshot_queue.try_pop(new_snapshot)) {
+                    interpolator.push(new_snapshot);
                     current_snapshot = new_snapshot;
+                    got_snapshot = true;
                 }
+                if (got_snapshot) predictor.reconcile(current_snapshot, player_id);
 
                 bool all_finished = true;
                 int vivos = 0;
@@ -125,8 +135,24 @@ void Client::start() {
 
                 if (!ranking_phase) {
                     event_handler.handle_events();
+                    predictor.predict(event_handler.last_input_sequence(),
+                                      event_handler.last_input_bits());
                 }
 
+                // Latencia en el HUD y, en números, en el título (una vez por segundo)
+                const LinkStats link = protocol.link_stats();
+                game_renderer.set_link_stats(link);
+                if (link.samples > 0 && t1 - last_title >= std::chrono::seconds(1)) {
+                    window.SetTitle(std::string(NFS_TITLE) + " - RTT " +
+                                    std::to_string(static_cast<int>(link.rtt_ms)) +
+                                    " ms, jitter " +
+                                    std::to_string(static_cast<int>(link.jitter_ms)) + " ms");
+                    last_title = t1;
+                }
+
+                // El auto propio se dibuja donde lo predijo el cliente y los demás un poco atrás
+                interpolator.apply_to(current_snapshot, player_id, std::chrono::steady_clock::now());
+                predictor.apply_to(current_snapshot, player_id);
                 game_renderer.render(current_snapshot, player_id);
 
                 if (all_finished && vivos > 0 && !ranking_phase && !race_finished) {
@@ -144,9 +170,11 @@ void Client::start() {
                             current_race_index++;
                             std::cout << "[Client] Siguiente carrera: " << races_paths[current_race_index] << std::endl;
                             game_renderer.init_race(races_paths[current_race_index]);
+                            predictor.init_race(races_paths[current_race_index]);
+                            interpolator.clear();
                         } else {
 
-                            final_game_results = current_snapshot.players;
+                            final_game_results = current_snapshot;
                             show_qt_ranking = true;
                             active = false; // Salir del loop SDL
 
@@ -170,7 +198,7 @@ void Client::start() {
         if (show_qt_ranking) {
 
             // 1. Ordenar resultados por tiempo total acumulado
-            std::sort(final_game_results.begin(), final_game_results.end(),
+            std::sort(final_game_results.players.begin(), final_game_results.players.end(),
                 [](const InfoPlayer& a, const InfoPlayer& b) {
                     // Ordenar por tiempo total acumulado (menor a mayor)
                     return a.total_time_ms < b.total_time_ms;
@@ -178,12 +206,12 @@ void Client::start() {
 
             // 2. Convertir InfoPlayer (Lógica Juego) -> PlayerResult (Vista Qt)
             std::vector<PlayerResult> view_results;
-            for (size_t i = 0; i < final_game_results.size(); ++i) {
-                const auto& p = final_game_results[i];
+            for (size_t i = 0; i < final_game_results.players.size(); ++i) {
+                const auto& p = final_game_results.players[i];
                 PlayerResult res;
                 res.rank = (int)(i + 1);
-                res.playerName = QString::fromStdString(p.username);
-                res.carName = QString::fromStdString(p.car_name);
+                res.playerName = QString::fromStdString(final_game_results.username_of(p));
+                res.carName = QString::fromStdString(final_game_results.car_name_of(p));
 
                 // Formatear tiempo TOTAL: "MM:SS.ms"
                 int min = p.total_time_ms / 60000;
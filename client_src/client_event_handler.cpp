@@ -14,7 +14,9 @@ ClientEventHandler::ClientEventHandler(Queue<ComandMatchDTO>& cmd_queue, int p_i
                   SDL_SCANCODE_F2,
                   SDL_SCANCODE_F4,
                   SDL_SCANCODE_P
-      }) {
+      }),
+      input_sequence(0),
+      input_bits(0) {
 }
 
 
@@ -32,65 +34,24 @@ void ClientEventHandler::process_movement(const SDL_Event& event) {
     } else if (event.type == SDL_KEYUP) {
         pressed_keys.erase(event.key.keysym.scancode);
     }
+}
 
-    // Detectar estado actual de teclas
-    bool up = pressed_keys.count(SDL_SCANCODE_UP);
-    bool down = pressed_keys.count(SDL_SCANCODE_DOWN);
-    bool left = pressed_keys.count(SDL_SCANCODE_LEFT);
-    bool right = pressed_keys.count(SDL_SCANCODE_RIGHT);
-    bool space = pressed_keys.count(SDL_SCANCODE_SPACE);
-
-    // Enviar comandos según teclas presionadas
-    // Nota: Las 4 direcciones son mutuamente exclusivas (solo se procesa una a la vez)
-
-    // Mover arriba (↑)
-    if (up) {
-        ComandMatchDTO cmd;
-        cmd.player_id = player_id;
-        cmd.command = GameCommand::MOVE_UP;
-        cmd.speed_boost = 1.0f;
-        command_queue.try_push(cmd);
-    }
-    // Mover abajo (↓)
-    else if (down) {
-        ComandMatchDTO cmd;
-        cmd.player_id = player_id;
-        cmd.command = GameCommand::MOVE_DOWN;
-        cmd.speed_boost = 1.0f;
-        command_queue.try_push(cmd);
-    }
-    // Mover izquierda (←)
-    else if (left) {
-        ComandMatchDTO cmd;
-        cmd.player_id = player_id;
-        cmd.command = GameCommand::MOVE_LEFT;
-        cmd.speed_boost = 1.0f;
-        command_queue.try_push(cmd);
-    }
-    // Mover derecha (→)
-    else if (right) {
-        ComandMatchDTO cmd;
-        cmd.player_id = player_id;
-        cmd.command = GameCommand::MOVE_RIGHT;
-        cmd.speed_boost = 1.0f;
-        command_queue.try_push(cmd);
-    }
-
-    // Nitro (SPACE)
-    if (space) {
-        ComandMatchDTO cmd;
-        cmd.player_id = player_id;
-        cmd.command = GameCommand::USE_NITRO;
-        command_queue.try_push(cmd);
-    }
+void ClientEventHandler::send_input_state() {
+    uint8_t bits = 0;
+    if (pressed_keys.count(SDL_SCANCODE_UP)) bits |= INPUT_UP;
+    if (pressed_keys.count(SDL_SCANCODE_DOWN)) bits |= INPUT_DOWN;
+    if (pressed_keys.count(SDL_SCANCODE_LEFT)) bits |= INPUT_LEFT;
+    if (pressed_keys.count(SDL_SCANCODE_RIGHT)) bits |= INPUT_RIGHT;
+    if (pressed_keys.count(SDL_SCANCODE_SPACE)) bits |= INPUT_NITRO;
 
-    // Si no hay ninguna tecla presionada, detener
-    if (pressed_keys.empty()) {
-        ComandMatchDTO cmd;
-        cmd.player_id = player_id;
-        cmd.command = GameCommand::STOP_ALL;
-        command_queue.try_push(cmd);
-    }
+    // Se manda aunque no haya cambios: cada estado tapa la pérdida del anterior
+    ComandMatchDTO cmd;
+    cmd.player_id = player_id;
+    cmd.command = GameCommand::INPUT_STATE;
+    cmd.input_bits = bits;
+    cmd.input_sequence = ++input_sequence;
+    input_bits = bits;
+    command_queue.try_push(cmd);
 }
 
 
@@ -163,4 +124,6 @@ void ClientEventHandler::handle_events() {
         process_cheats(event);
         process_movement(event);
     }
+
+    send_input_state();
 }
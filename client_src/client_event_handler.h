@@ -16,18 +16,31 @@ private:
     // Teclas válidas para controles
     std::unordered_set<SDL_Scancode> valid_keys;
     std::unordered_set<SDL_Scancode> pressed_keys;
+    uint32_t input_sequence;  // del último INPUT_STATE encolado
+    uint8_t input_bits;       // máscara INPUT_* de ese INPUT_STATE
 
     // Procesadores de eventos específicos
     void process_movement(const SDL_Event& event);
     void process_cheats(const SDL_Event& event);
     void process_quit(const SDL_Event& event);
 
+    // Encola el estado actual de los controles (uno por frame, ver handle_events)
+    void send_input_state();
+
 public:
     ClientEventHandler(Queue<ComandMatchDTO>& cmd_queue, int p_id, bool& running);
 
-    // Método principal que maneja todos los eventos SDL
+    /*
+     * Método principal que maneja todos los eventos SDL. Se llama una vez por
+     * frame: las teclas solo actualizan el estado y al final se manda un único
+     * INPUT_STATE, así el tráfico no depende de la repetición del teclado.
+     * */
     void handle_events();
 
+    // Último INPUT_STATE encolado (lo aplica la predicción del auto propio)
+    uint32_t last_input_sequence() const { return input_sequence; }
+    uint8_t last_input_bits() const { return input_bits; }
+
     ~ClientEventHandler() = default;
 };
 
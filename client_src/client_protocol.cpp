@@ -3,6 +3,7 @@
 #include <arpa/inet.h>  // ntohl
 #include <netinet/in.h>
 
+#include <algorithm>
 #include <cstring>  // memset, strncpy
 #include <iostream>
 #include <stdexcept>
@@ -11,7 +12,9 @@
 #include "common_src/lobby_protocol.h"
 
 ClientProtocol::ClientProtocol(const char* host, const char* servname)
-    : socket(Socket(host, servname)), host(host), port(servname) {
+    : socket(Socket(host, servname)), inbound(socket), host(host), port(servname) {
+    // Comandos chicos y frecuentes: no esperar a juntarlos con el siguiente
+    socket.set_no_delay();
     std::cout << "[ClientProtocol] Connected to server " << host << ":" << servname << std::endl;
 }
 
@@ -44,7 +47,7 @@ void ClientProtocol::disconnect() {
 
 uint8_t ClientProtocol::read_message_type() {
     uint8_t type;
-    int bytes = socket.recvall(&type, sizeof(type));
+    int bytes = inbound.recvall(&type, sizeof(type));
     if (bytes == 0) {
         throw std::runtime_error("Connection closed by server");
     }
@@ -53,31 +56,32 @@ uint8_t ClientProtocol::read_message_type() {
 
 std::string ClientProtocol::read_string() {
     uint16_t len_net;
-    socket.recvall(&len_net, sizeof(len_net));
+    inbound.recvall(&len_net, sizeof(len_net));
     uint16_t len = ntohs(len_net);
 
     std::vector<char> buffer(len);
-    socket.recvall(buffer.data(), len);
+    inbound.recvall(buffer.data(), len);
 
     return std::string(buffer.begin(), buffer.end());
 }
 
 uint16_t ClientProtocol::read_uint16() {
     uint16_t value_net;
-    socket.recvall(&value_net, sizeof(value_net));
+    inbound.recvall(&value_net, sizeof(value_net));
     return ntohs(value_net);
 }
 
 uint8_t ClientProtocol::read_uint8() {
     uint8_t value;
-    socket.recvall(&value, sizeof(value));
+    inbound.recvall(&value, sizeof(value));
     return value;
 }
 
 void ClientProtocol::send_string(const std::string& str) {
-    uint16_t len = htons(static_cast<uint16_t>(str.size()));
-    socket.sendall(&len, sizeof(len));
-    socket.sendall(str.data(), str.size());
+    std::lock_guard<std::mutex> lock(send_mutex);
+    outbound.clear();
+    outbound.put_string(str);
+    outbound.send(socket);
 }
 
 // Lobby protocol methods
@@ -116,11 +120,11 @@ std::vector<GameInfo> ClientProtocol::read_games_list_from_socket(uint16_t count
     for (uint16_t i = 0; i < count; i++) {
         GameInfo info;
         info.game_id = read_uint16();
-        socket.recvall(info.game_name, sizeof(info.game_name));
-        socket.recvall(&info.current_players, sizeof(info.current_players));
-        socket.recvall(&info.max_players, sizeof(info.max_players));
+        inbound.recvall(info.game_name, sizeof(info.game_name));
+        inbound.recvall(&info.current_players, sizeof(info.current_players));
+        inbound.recvall(&info.max_players, sizeof(info.max_players));
         uint8_t started;
-        socket.recvall(&started, sizeof(started));
+        inbound.recvall(&started, sizeof(started));
         info.is_started = (started != 0);
 
         games.push_back(info);
@@ -146,10 +150,16 @@ std::vector<GameInfo> ClientProtocol::receive_games_list() {
 void ClientProtocol::create_game(const std::string& game_name, uint8_t max_players,
                                  const std::vector<std::pair<std::string, std::string>>& races) {
     auto buffer = LobbyProtocol::serialize_create_game(game_name, max_players, races.size());
-    socket.sendall(buffer.data(), buffer.size());
-    for (const auto& race : races) {
-        send_string(race.first);  // city
-        send_string(race.second);
+    {
+        // Pedido y carreras en un solo envío
+        std::lock_guard<std::mutex> lock(send_mutex);
+        outbound.clear();
+        outbound.put_ref(buffer);
+        for (const auto& race : races) {
+            outbound.put_string(race.first);  // city
+            outbound.put_string(race.second);
+        }
+        outbound.send(socket);
     }
     std::cout << "[Protocol] Requested to create game: " << game_name
               << " (max players: " << static_cast<int>(max_players)
@@ -189,7 +199,7 @@ uint16_t ClientProtocol::receive_game_joined() {
 
 void ClientProtocol::read_error_details(std::string& error_message) {
     uint8_t error_code;
-    socket.recvall(&error_code, sizeof(error_code));
+    inbound.recvall(&error_code, sizeof(error_code));
 
     error_message = read_string();
 
@@ -226,13 +236,14 @@ ClientProtocol::receive_city_maps() {
 
 void ClientProtocol::send_selected_races(
     const std::vector<std::pair<std::string, std::string>>& races) {
+    std::lock_guard<std::mutex> lock(send_mutex);
+    outbound.clear();
     for (const auto& [city, map] : races) {
-        auto buffer_city = LobbyProtocol::serialize_string(city);
-        auto buffer_map = LobbyProtocol::serialize_string(map);
-        socket.sendall(buffer_city.data(), buffer_city.size());
-        socket.sendall(buffer_map.data(), buffer_map.size());
+        outbound.put_string(city);
+        outbound.put_string(map);
         std::cout << "[Protocol] Selected race: " << city << " - " << map << std::endl;
     }
+    outbound.send(socket);
 }
 
 void ClientProtocol::select_car(const std::string& car_name, const std::string& car_type) {
@@ -262,15 +273,116 @@ void ClientProtocol::set_ready(bool is_ready) {
 // GAME - Commands & Snapshots
 
 void ClientProtocol::send_command_client(const ComandMatchDTO& command) {
-    std::vector<uint8_t> buffer;
-    serialize_command(command, buffer);
-    if (!socket.sendall(buffer.data(), buffer.size())) {
+    std::lock_guard<std::mutex> lock(send_mutex);
+    // Con el canal UDP establecido el movimiento va por datagrama; el resto (o si falla), TCP
+    if (datagrams_live && send_input_datagram(command)) return;
+
+    outbound.clear();
+    serialize_command(command, outbound);
+    if (!outbound.send(socket)) {
         throw std::runtime_error("Error sending command");
-    }}
+    }
+}
+
+void ClientProtocol::send_snapshot_ack(uint32_t sequence) {
+    // El hilo receptor confirma mientras el emisor manda comandos por el mismo socket
+    std::lock_guard<std::mutex> lock(send_mutex);
+    outbound.clear();
+    outbound.put_uint8(CMD_SNAPSHOT_ACK);
+    outbound.put_uint32(sequence);
+    outbound.send(socket);
+}
+
+void ClientProtocol::send_ping_if_due() {
+    // Hasta el primer snapshot el servidor puede seguir leyendo mensajes de lobby
+    if (last_delivered == 0) return;
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - last_ping < std::chrono::milliseconds(PING_INTERVAL_MS)) return;
+    last_ping = now;
+
+    // Lo ya medido viaja en el ping: así lo ve también el servidor
+    const LinkStats current = link_stats();
+    std::lock_guard<std::mutex> lock(send_mutex);
+    outbound.clear();
+    outbound.put_uint8(CMD_PING);
+    outbound.put_uint32(next_ping++);
+    outbound.put_uint64(link_clock_us());
+    outbound.put_uint32(static_cast<uint32_t>(current.rtt_ms * 1000.0f));
+    outbound.put_uint32(static_cast<uint32_t>(current.jitter_ms * 1000.0f));
+    try {
+        outbound.send(socket);
+    } catch (const std::exception& e) {
+        // Si se cortó la conexión lo va a notar la próxima lectura
+        std::cerr << "[ClientProtocol] No se pudo enviar ping: " << e.what() << std::endl;
+    }
+}
+
+void ClientProtocol::read_pong() {
+    frame.resize(PONG_SIZE);
+    if (inbound.recvall(frame.data(), frame.size()) <= 0)
+        throw std::runtime_error("Connection closed by server");
+    const uint64_t arrived_us = link_clock_us();
+
+    FrameReader in(frame);
+    in.read_uint32();  // id: cada pong trae sus propias marcas, no hace falta emparejarlo
+    const uint64_t sent_us = in.read_uint64();
+    const uint64_t server_received_us = in.read_uint64();
+    const uint64_t server_sent_us = in.read_uint64();
+    const uint32_t server_tick = in.read_uint32();
+
+    std::lock_guard<std::mutex> lock(clock_mutex);
+    clock_sync.on_pong(sent_us, server_received_us, server_sent_us, arrived_us, server_tick);
+}
+
+LinkStats ClientProtocol::link_stats() {
+    std::lock_guard<std::mutex> lock(clock_mutex);
+    return clock_sync.stats(link_clock_us());
+}
+
+bool ClientProtocol::send_input_datagram(const ComandMatchDTO& command) {
+    const uint8_t code = static_cast<uint8_t>(command.command);
+    if (!carried_by_datagram(code)) return false;
+
+    const bool turning =
+            command.command == GameCommand::TURN_LEFT || command.command == GameCommand::TURN_RIGHT;
+    uint8_t param = turning ? static_cast<uint8_t>(command.turn_intensity * 100.0f) : 0;
+    uint32_t sequence = next_input;
+    if (command.command == GameCommand::INPUT_STATE) {
+        // El estado ya trae su secuencia: el servidor la usa para descartar los viejos
+        param = command.input_bits;
+        sequence = std::max(sequence, command.input_sequence);
+    }
+    next_input = sequence + 1;
+    pending_inputs.push_back({sequence, code, param});
+
+    // Viajan los últimos INPUT_REDUNDANCY comandos que el servidor todavía no confirmó
+    while (pending_inputs.size() > INPUT_REDUNDANCY ||
+           pending_inputs.front().sequence <= confirmed_input) {
+        pending_inputs.pop_front();
+    }
+
+    input_datagram.clear();
+    input_datagram.push_back(static_cast<uint8_t>(pending_inputs.size()));
+    for (const PendingInput& input : pending_inputs) {
+        const uint32_t sequence_net = htonl(input.sequence);
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&sequence_net);
+        input_datagram.insert(input_datagram.end(), bytes, bytes + sizeof(sequence_net));
+        input_datagram.push_back(input.code);
+        input_datagram.push_back(input.param);
+    }
+
+    if (datagrams->send(DGRAM_INPUT, pending_inputs.back().sequence, input_datagram.data(),
+                        input_datagram.size())) {
+        return true;
+    }
+    pending_inputs.pop_back();  // sale por TCP: no repetirlo después por UDP
+    return false;
+}
 
 void ClientProtocol::serialize_command(const ComandMatchDTO& command,
-                                       std::vector<uint8_t>& message) {
-    message.push_back(static_cast<uint8_t>(command.command));
+                                       OutboundMessage& message) {
+    message.put_uint8(static_cast<uint8_t>(command.command));
 
     // Agregar datos adicionales según el comando
     switch (command.command) {
@@ -290,10 +402,15 @@ void ClientProtocol::serialize_command(const ComandMatchDTO& command,
             // No requieren datos adicionales
             break;
 
+        case GameCommand::INPUT_STATE:
+            message.put_uint8(command.input_bits);
+            message.put_uint32(command.input_sequence);
+            break;
+
         case GameCommand::TURN_LEFT:
         case GameCommand::TURN_RIGHT:
             // Agregar intensity (uint8_t, 0-100)
-            message.push_back(static_cast<uint8_t>(command.turn_intensity * 100.0f));
+            message.put_uint8(static_cast<uint8_t>(command.turn_intensity * 100.0f));
             break;
 
         case GameCommand::UPGRADE_SPEED:
@@ -301,8 +418,8 @@ void ClientProtocol::serialize_command(const ComandMatchDTO& command,
         case GameCommand::UPGRADE_HANDLING:
         case GameCommand::UPGRADE_DURABILITY:
             // Agregar level (uint8_t) y cost (uint16_t)
-            message.push_back(command.upgrade_level);
-            push_back_uint16(message, command.upgrade_cost_ms);
+            message.put_uint8(command.upgrade_level);
+            message.put_uint16(command.upgrade_cost_ms);
             break;
 
         default:
@@ -311,34 +428,105 @@ void ClientProtocol::serialize_command(const ComandMatchDTO& command,
     }
 }
 
-void ClientProtocol::push_back_uint16(std::vector<uint8_t>& message, std::uint16_t value) {
-    uint16_t net_value = htons(value);
-    message.push_back(reinterpret_cast<uint8_t*>(&net_value)[0]);
-    message.push_back(reinterpret_cast<uint8_t*>(&net_value)[1]);
-}
-
 uint32_t ClientProtocol::read_uint32() {
     uint32_t value_net;
-    socket.recvall(&value_net, sizeof(value_net));  // lee 4 bytes del socket (big endian)
+    inbound.recvall(&value_net, sizeof(value_net));  // lee 4 bytes del socket (big endian)
     return ntohl(value_net); // convierte a host endian
 }
 
 int16_t ClientProtocol::read_int16() {
     uint16_t raw;
-    socket.recvall(&raw, sizeof(raw));
+    inbound.recvall(&raw, sizeof(raw));
     return (int16_t) ntohs(raw);   // Convierte preservando el signo
 }
 
 int32_t ClientProtocol::read_int32() {
     uint32_t net;
-    socket.recvall(&net, sizeof(net));
+    inbound.recvall(&net, sizeof(net));
     net = ntohl(net);
     return static_cast<int32_t>(net);
 }
 
+void ClientProtocol::receive_snapshot(GameState& state) {
+    while (true) {
+        send_ping_if_due();
+        if (datagrams && !inbound.has_buffered()) {
+            // Hasta la primera respuesta por UDP se reintenta el HELLO (pudo perderse)
+            const auto now = std::chrono::steady_clock::now();
+            if (!datagrams_live &&
+                now - last_hello >= std::chrono::milliseconds(DATAGRAM_HELLO_INTERVAL_MS)) {
+                datagrams->send(DGRAM_HELLO, 0);
+                last_hello = now;
+            }
+
+            // Lo que llegue primero: snapshots por UDP o mensajes por TCP
+            const int ready = datagrams->wait(socket, DATAGRAM_HELLO_INTERVAL_MS);
+            if ((ready & DATAGRAM_READY) && read_datagram_snapshots(state)) return;
+            if (!(ready & STREAM_READY)) continue;
+        }
+        if (read_stream_snapshot(state)) return;
+    }
+}
+
+bool ClientProtocol::deliver(uint32_t sequence) {
+    // Un snapshot más viejo que el último entregado sirve de base pero no se muestra
+    if (sequence <= last_delivered) return false;
+    last_delivered = sequence;
+    return true;
+}
+
+bool ClientProtocol::read_datagram_snapshots(GameState& state) {
+    bool delivered = false;
+    while (datagrams->receive(datagram_header, frame, datagram_acks)) {
+        // Los acks del servidor confirman comandos: no hace falta repetirlos más
+        if (!datagram_acks.empty()) {
+            std::lock_guard<std::mutex> lock(send_mutex);
+            for (uint32_t sequence : datagram_acks)
+                confirmed_input = std::max(confirmed_input, sequence);
+            datagram_acks.clear();
+        }
+        if (datagram_header.kind != DGRAM_SNAPSHOT || !datagrams->is_fresh(datagram_header.sequence))
+            continue;
+
+        // Mismo GAME_STATE_UPDATE enmarcado que por TCP
+        uint32_t sequence = 0;
+        try {
+            FrameReader in(frame);
+            if (in.read_uint8() != static_cast<uint8_t>(ServerMessageType::GAME_STATE_UPDATE))
+                continue;
+            if (in.read_uint32() != in.remaining()) continue;
+            // Sin base conocida no se confirma: el servidor usará otra base o un keyframe
+            if (!snapshot_decoder.decode(in, decoded, sequence)) continue;
+        } catch (const std::exception&) {
+            continue;  // datagrama truncado
+        }
+
+        datagrams->mark_received(datagram_header.sequence);
+        datagrams_live = true;
+        datagrams->send(DGRAM_ACK, 0);
+        if (deliver(sequence)) {
+            state = decoded;
+            delivered = true;
+        }
+    }
+    return delivered;
+}
+
 // (tu función está perfecta, no hace falta tocarla)
-GameState ClientProtocol::receive_snapshot() {
+bool ClientProtocol::read_stream_snapshot(GameState& state) {
     uint8_t type = read_message_type();
+    // Los PONG llegan entre snapshots, por TCP aunque los snapshots vayan por UDP
+    if (type == static_cast<uint8_t>(ServerMessageType::PONG)) {
+        read_pong();
+        return false;
+    }
+    // El manifest (slots -> nombres/auto) llega antes del snapshot que lo usa
+    while (type == static_cast<uint8_t>(ServerMessageType::RACE_MANIFEST)) {
+        if (!inbound.read_frame(frame)) throw std::runtime_error("Connection closed by server");
+        FrameReader manifest(frame);
+        snapshot_decoder.read_manifest(manifest);
+        type = read_message_type();
+    }
     if (type != (uint8_t)ServerMessageType::GAME_STATE_UPDATE) {
 
         // Manejo robusto: no intentes parsear como snapshot un mensaje diferente
@@ -349,11 +537,11 @@ GameState ClientProtocol::receive_snapshot() {
                 std::string msg = "";
                 try {
                     uint16_t len_net;
-                    socket.recvall(&len_net, sizeof(len_net));
+                    inbound.recvall(&len_net, sizeof(len_net));
                     uint16_t len = ntohs(len_net);
                     if (len > 0 && len < 4096) {
                         std::vector<char> buf(len);
-                        socket.recvall(buf.data(), len);
+                        inbound.recvall(buf.data(), len);
                         msg.assign(buf.begin(), buf.end());
                     }
                 } catch (...) {
@@ -372,115 +560,56 @@ GameState ClientProtocol::receive_snapshot() {
         // Tipo desconocido mientras estamos en juego: abortar para no desincronizar el stream
         throw std::runtime_error("Unexpected message type while expecting snapshot");
     }
-    GameState state;
-
-    // 1. PLAYERS
-    uint16_t player_count = read_uint16();
-    state.players.resize(player_count);
-
-    for (uint16_t i = 0; i < player_count; ++i) {
-        InfoPlayer& p = state.players[i];
-
-        p.username  = read_string();
-        p.car_name  = read_string();
-        p.car_type  = read_string();
-
-        p.player_id = read_uint16();
-
-        p.pos_x = static_cast<float>(read_int32()) / 100.0f;
-        p.pos_y = static_cast<float>(read_int32()) / 100.0f;
-
-        p.angle = static_cast<float>(read_uint16()) / 100.0f;
-        p.speed = static_cast<float>(read_uint16()) / 100.0f;
-
-        p.velocity_x = static_cast<float>(read_int32()) / 100.0f;
-        p.velocity_y = static_cast<float>(read_int32()) / 100.0f;
-
-        p.health       = read_uint8();
-        p.nitro_amount = read_uint8();
-
-        uint8_t flags = read_uint8();
-        p.nitro_active = (flags & 0x01) != 0;
-        p.is_drifting  = (flags & 0x02) != 0;
-        p.is_colliding = (flags & 0x04) != 0;
-
-        p.completed_laps     = read_uint16();
-        p.current_checkpoint = read_uint16();
-        p.position_in_race   = read_uint8();
-
-        p.race_time_ms = read_uint32();
-        p.total_time_ms = read_uint32();
-
-        p.race_finished = read_uint8() != 0;
-        p.is_alive      = read_uint8() != 0;
-        p.disconnected  = read_uint8() != 0;
-
-    }
-
-    uint16_t checkpointCount = read_uint16();
-    state.checkpoints.clear();
-    state.checkpoints.reserve(checkpointCount);
-
-    for (uint16_t i = 0; i < checkpointCount; ++i) {
-        CheckpointInfo c;
-        c.id    = read_uint32();
-        c.pos_x = static_cast<float>(read_int32()) / 100.0f;
-        c.pos_y = static_cast<float>(read_int32()) / 100.0f;
-        c.width = static_cast<float>(read_uint16()) / 100.0f;
-        c.angle = static_cast<float>(read_uint16()) / 100.0f;
-        c.is_start  = read_uint8() != 0;
-        c.is_finish = read_uint8() != 0;
-        state.checkpoints.push_back(std::move(c));
-    }
-
-    // 3. NPCs
-    uint16_t npcCount = read_uint16();
-    state.npcs.clear();
-    state.npcs.reserve(npcCount);
-
-    for (uint16_t i = 0; i < npcCount; ++i) {
-        NPCCarInfo n;
-        n.npc_id = read_uint32();
-        n.pos_x = static_cast<float>(read_int32()) / 100.0f;
-        n.pos_y = static_cast<float>(read_int32()) / 100.0f;
-        n.angle = static_cast<float>(read_uint16()) / 100.0f;
-        n.speed = static_cast<float>(read_uint16()) / 100.0f;
-        n.is_parked = read_uint8() != 0;
-        state.npcs.push_back(std::move(n));
-    }
-
-    // 4. RACE INFO
-    state.race_info.status = static_cast<MatchStatus>(read_uint8());
-    state.race_info.race_number       = read_uint8();
-    state.race_info.total_races       = read_uint8();
-    state.race_info.remaining_time_ms = read_uint32();
-    state.race_info.players_finished  = read_uint8();
-    state.race_info.total_players     = read_uint8();
-
-    // 5. EVENTS
-    uint16_t eventCount = read_uint16();
-    state.events.clear();
-    state.events.reserve(eventCount);
-
-    for (uint16_t i = 0; i < eventCount; ++i) {
-        GameEvent e;
-        e.type      = (GameEvent::EventType)read_uint8();
-        e.player_id = read_uint32();
-        e.pos_x = static_cast<float>(read_int32()) / 100.0f;
-        e.pos_y = static_cast<float>(read_int32()) / 100.0f;
-        state.events.push_back(std::move(e));
+    // El snapshot entero llega en uno o pocos recv y se decodifica desde memoria
+    if (!inbound.read_frame(frame)) throw std::runtime_error("Connection closed by server");
+    FrameReader in(frame);
+    uint32_t sequence = 0;
+    if (snapshot_decoder.decode(in, decoded, sequence)) {
+        try {
+            send_snapshot_ack(sequence);
+        } catch (const std::exception& e) {
+            // Sin confirmación el servidor sigue usando una base anterior (o keyframe)
+            std::cerr << "[ClientProtocol] No se pudo confirmar snapshot " << sequence << ": "
+                      << e.what() << std::endl;
+        }
+    } else {
+        // Como por UDP: los jugadores sin base quedarían en cero, no se muestra
+        std::cerr << "[ClientProtocol] Snapshot " << sequence
+                  << " sin base conocida, esperando keyframe" << std::endl;
+        return false;
     }
 
-    return state;
+    if (!deliver(sequence)) return false;
+    state = decoded;
+    return true;
 }
 
 
 int ClientProtocol::receive_client_id() {
     // Leer el ID del cliente enviado por el servidor
     uint16_t client_id = read_uint16();
+
+    // Canal UDP que ofrece el servidor para esta conexión (puerto 0: solo TCP)
+    const uint16_t udp_port = read_uint16();
+    const uint32_t token = read_uint32();
+    if (udp_port != 0) {
+        try {
+            datagrams = std::make_unique<DatagramChannel>(host.c_str(),
+                                                          std::to_string(udp_port).c_str(), token);
+            datagrams->send(DGRAM_HELLO, 0);
+            last_hello = std::chrono::steady_clock::now();
+        } catch (const std::exception& e) {
+            std::cerr << "[ClientProtocol] UDP no disponible, se usa TCP: " << e.what() << std::endl;
+            datagrams.reset();
+        }
+    }
     return static_cast<int>(client_id);
 }
 
+void ClientProtocol::simulate_network(float loss, int delay_ms, uint32_t seed) {
+    if (datagrams) datagrams->simulate(loss, delay_ms, seed);
+}
+
 // ============================================================================
 // RECEPCIÓN DE INFORMACIÓN DE CARRERA
 // ============================================================================
@@ -514,7 +643,7 @@ RaceInfoDTO ClientProtocol::receive_race_info() {
     race_info.total_checkpoints = read_uint16();
 
     uint32_t max_time_net;
-    socket.recvall(&max_time_net, sizeof(max_time_net));
+    inbound.recvall(&max_time_net, sizeof(max_time_net));
     race_info.max_time_ms = ntohl(max_time_net);
 
 
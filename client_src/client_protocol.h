@@ -1,24 +1,70 @@
 #ifndef CLIENT_PROTOCOL_H
 #define CLIENT_PROTOCOL_H
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "common_src/buffered_reader.h"
+#include "common_src/clock_sync.h"
+#include "common_src/datagram_channel.h"
 #include "common_src/dtos.h"
 #include "common_src/game_state.h"
 #include "common_src/lobby_protocol.h"
+#include "common_src/outbound_message.h"
+#include "common_src/snapshot_codec.h"
 #include "common_src/socket.h"
 
 class ClientProtocol {
 private:
     Socket socket;
+    BufferedReader inbound;            // toda lectura del socket pasa por acá
+    std::vector<uint8_t> frame;        // cuerpo del último mensaje enmarcado
     std::string host;
     std::string port;
     bool socket_shutdown_done = false;
-    void push_back_uint16(std::vector<uint8_t>& message, std::uint16_t value);
-    void serialize_command(const ComandMatchDTO& command, std::vector<uint8_t>& message);
+    std::mutex send_mutex;             // comandos (ClientSender) y acks (ClientReceiver)
+    OutboundMessage outbound;          // arena de envío, siempre bajo send_mutex
+    SnapshotDecoder snapshot_decoder;  // bases para reconstruir los deltas
+    GameState decoded;                 // destino de cada decode, se reutiliza entre snapshots
+    uint32_t last_delivered = 0;       // snapshot más nuevo entregado (UDP puede desordenar)
+
+    // Canal UDP si el servidor lo ofreció (ver datagram_channel.h)
+    struct PendingInput {
+        uint32_t sequence;
+        uint8_t code;
+        uint8_t param;
+    };
+    std::unique_ptr<DatagramChannel> datagrams;
+    std::atomic<bool> datagrams_live{false};  // ya llegó un snapshot por UDP
+    std::chrono::steady_clock::time_point last_hello;
+    DatagramHeader datagram_header;
+    std::vector<uint32_t> datagram_acks;
+    std::deque<PendingInput> pending_inputs;  // bajo send_mutex
+    std::vector<uint8_t> input_datagram;      // bajo send_mutex
+    uint32_t next_input = 1;                  // bajo send_mutex
+    uint32_t confirmed_input = 0;             // bajo send_mutex
+
+    // Pings durante la partida (ver clock_sync.h); los manda el hilo receptor
+    std::chrono::steady_clock::time_point last_ping;
+    uint32_t next_ping = 1;
+    std::mutex clock_mutex;                   // el HUD lee link_stats desde otro hilo
+    ClockSync clock_sync;                     // bajo clock_mutex
+
+    void serialize_command(const ComandMatchDTO& command, OutboundMessage& message);
     void push_back_float01_as_uint8(std::vector<uint8_t>& message, float value);
+    void send_snapshot_ack(uint32_t sequence);
+    bool send_input_datagram(const ComandMatchDTO& command);
+    bool read_stream_snapshot(GameState& state);
+    bool read_datagram_snapshots(GameState& state);
+    bool deliver(uint32_t sequence);
+    void send_ping_if_due();
+    void read_pong();
 
 
 public:
@@ -56,7 +102,8 @@ public:
     receive_city_maps();
 
     void send_command_client(const ComandMatchDTO& command);
-    GameState receive_snapshot();
+    // Pisa `state` con el próximo snapshot; reusar el mismo GameState evita realocar
+    void receive_snapshot(GameState& state);
     int receive_client_id();
 
     // Recibir información inicial de la carrera
@@ -71,6 +118,15 @@ public:
     void disconnect();
     void shutdown_socket();  // Desbloquear lecturas pendientes
 
+    // Ya llegan snapshots por el canal UDP (si no, todo sigue por TCP)
+    bool using_datagrams() const { return datagrams_live; }
+
+    // RTT, jitter, offset de reloj y tick del servidor estimados (samples = 0: sin medir)
+    LinkStats link_stats();
+
+    // Pérdida y latencia simuladas en lo que llega por UDP (pruebas locales)
+    void simulate_network(float loss, int delay_ms, uint32_t seed);
+
     ClientProtocol(const ClientProtocol&) = delete;
     ClientProtocol& operator=(const ClientProtocol&) = delete;
     ClientProtocol(ClientProtocol&&) = delete;
@@ -5,12 +5,14 @@ ClientReceiver::ClientReceiver(ClientProtocol& protocol, Queue<GameState>& queue
 
     void ClientReceiver::run() {
 
+        // Uno solo para toda la partida: cada snapshot se decodifica sobre el anterior
+        GameState game_state_snapshot;
         while (should_keep_running()) {
-            GameState game_state_snapshot;
             try {
                 if (!should_keep_running()) break;
     
-                game_state_snapshot = protocol.receive_snapshot();
+                protocol.receive_snapshot(game_state_snapshot);
+                game_state_snapshot.received_at = std::chrono::steady_clock::now();
     
                 if (game_state_snapshot.players.empty()) {
                     std::this_thread::sleep_for(std::chrono::milliseconds(100));
@@ -0,0 +1,145 @@
+#include "car_predictor.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "../../common_src/car_catalog.h"
+#include "../../common_src/config.h"
+#include "../../common_src/map_asset_cache.h"
+#include "../../common_src/race_descriptor.h"
+
+CarPredictor::CarPredictor()
+    : car_id(CarCatalog::UNKNOWN_CAR), applied_bits(0), acked_bits(0), synced(false),
+      active(false), sim_dt(1.0f / 60.0f), sub_steps(1), friction(false),
+      use_distance_field(true) {
+    load_config();
+}
+
+void CarPredictor::load_config() {
+    // Los mismos valores (y defaults) que GameLoop::load_game_config
+    int sim_rate = 60;
+    try {
+        sim_rate = Configuration::get<int>("simulation_rate_hz");
+    } catch (const std::exception&) {}
+    try {
+        sub_steps = Configuration::get<int>("physics_sub_steps");
+    } catch (const std::exception&) {}
+    try {
+        friction = Configuration::get<bool>("physics_friction");
+    } catch (const std::exception&) {}
+    try {
+        use_distance_field = Configuration::get<bool>("collision_distance_field");
+    } catch (const std::exception&) {}
+
+    sim_dt = 1.0f / static_cast<float>(std::clamp(sim_rate, 1, 1000));
+    sub_steps = std::max(1, sub_steps);
+}
+
+void CarPredictor::init_race(const std::string& yaml_path) {
+    pending.clear();
+    synced = false;
+    active = false;
+    applied_bits = 0;
+    acked_bits = 0;
+
+    try {
+        std::shared_ptr<const RaceDescriptor> race = RaceDescriptor::load(yaml_path);
+        walls = std::make_unique<CollisionManager>(
+                MapAssetCache::get(race->city, use_distance_field));
+    } catch (const std::exception& e) {
+        std::cerr << "[CarPredictor] Sin colisiones de mapa para " << yaml_path << ": "
+                  << e.what() << std::endl;
+        walls = nullptr;
+    }
+}
+
+void CarPredictor::ensure_car(const GameState& snapshot, const InfoPlayer& own) {
+    if (car && car_id == own.car_id) return;
+
+    car.reset();
+    car = std::make_unique<Car>(snapshot.car_name_of(own), snapshot.car_type_of(own));
+    car->attach_physics(physics);
+    car->setModelId(own.car_id);
+    const CarModel& model = CarCatalog::instance().get(own.car_id);
+    car->load_stats(model.max_speed, model.accel_power, model.turn_rate, model.health,
+                    model.nitro_boost, model.mass);
+    car_id = own.car_id;
+}
+
+void CarPredictor::step(uint8_t bits, uint8_t previous_bits) {
+    // Mismo orden que GameLoop::simular_tick: aplicar_inputs y después actualizar_fisica
+    car->apply_input(bits, previous_bits, sim_dt);
+
+    const float sub_dt = sim_dt / static_cast<float>(sub_steps);
+    car->setColliding(false);
+    for (int i = 0; i < sub_steps; ++i) {
+        if (friction) physics.apply_friction(sub_dt);
+        physics.integrate(sub_dt);
+        if (walls && !car->isDestroyed()) {
+            car->resolve_wall_collision(*walls, physics.old_x[0], physics.old_y[0]);
+        }
+    }
+    physics.clamp_to_bounds(MAP_LIMIT_X, MAP_LIMIT_Y);
+}
+
+void CarPredictor::predict(uint32_t sequence, uint8_t bits) {
+    if (!synced || !active) return;
+
+    pending.push_back({sequence, bits});
+    if (pending.size() > PREDICTION_MAX_PENDING) pending.pop_front();
+
+    step(bits, applied_bits);
+    applied_bits = bits;
+}
+
+void CarPredictor::reconcile(const GameState& snapshot, int player_id) {
+    auto own = std::find_if(snapshot.players.begin(), snapshot.players.end(),
+                            [player_id](const InfoPlayer& p) { return p.player_id == player_id; });
+    if (own == snapshot.players.end() || !own->in_view) return;
+
+    ensure_car(snapshot, *own);
+    active = own->is_alive && !own->race_finished && !own->disconnected;
+
+    // Lo confirmado ya está incluido en el estado del servidor
+    while (!pending.empty() && pending.front().sequence <= own->last_input) {
+        acked_bits = pending.front().bits;
+        pending.pop_front();
+    }
+
+    car->setPosition(own->pos_x, own->pos_y);
+    car->setAngle(own->angle);
+    car->setCurrentSpeed(own->speed);
+    car->setVelocity(own->velocity_x, own->velocity_y);
+    car->setNitro(own->nitro_amount, own->nitro_active);
+    synced = true;
+
+    if (!active) {
+        pending.clear();
+        applied_bits = 0;
+        return;
+    }
+
+    // Re-simular encima lo que el servidor todavía no aplicó
+    uint8_t previous = acked_bits;
+    for (const PendingInput& input : pending) {
+        step(input.bits, previous);
+        previous = input.bits;
+    }
+    applied_bits = previous;
+}
+
+void CarPredictor::apply_to(GameState& snapshot, int player_id) const {
+    if (!synced || !active) return;
+
+    for (InfoPlayer& p : snapshot.players) {
+        if (p.player_id != player_id) continue;
+        p.pos_x = car->getX();
+        p.pos_y = car->getY();
+        p.angle = car->getAngle();
+        p.speed = car->getCurrentSpeed();
+        p.velocity_x = car->getVelocityX();
+        p.velocity_y = car->getVelocityY();
+        p.is_colliding = car->isColliding();
+        return;
+    }
+}
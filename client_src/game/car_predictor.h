@@ -0,0 +1,85 @@
+#ifndef CAR_PREDICTOR_H
+#define CAR_PREDICTOR_H
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "../../common_src/car.h"
+#include "../../common_src/car_physics_pool.h"
+#include "../../common_src/collision_manager.h"
+#include "../../common_src/game_state.h"
+
+// Inputs sin confirmar que se guardan para re-simular (~2 s a 60 Hz)
+#define PREDICTION_MAX_PENDING 128
+
+/*
+ * Predicción del auto propio en el cliente.
+ *
+ * Cada INPUT_STATE que se manda se aplica ya sobre una copia local del auto
+ * (mismo Car, mismos kernels de CarPhysicsPool y mismo barrido de paredes
+ * que el GameLoop), así la tecla se ve en el frame siguiente y no después
+ * de un round trip.
+ *
+ * Cada snapshot trae el último input que el servidor aplicó a este jugador
+ * (InfoPlayer::last_input): se parte del estado del servidor y se vuelven a
+ * aplicar encima los inputs todavía sin confirmar. Si la predicción coincidía
+ * no se nota nada; si no (choque con otro auto, pérdida), se corrige sola.
+ *
+ * Se asume un input por tick del servidor (el cliente los manda a 60 FPS,
+ * igual que simulation_rate_hz por defecto); la diferencia la absorbe la
+ * reconciliación. Los choques entre autos no se predicen.
+ */
+class CarPredictor {
+private:
+    struct PendingInput {
+        uint32_t sequence;
+        uint8_t bits;
+    };
+
+    CarPhysicsPool physics;  // un solo slot; debe vivir más que `car`
+    std::unique_ptr<Car> car;
+    uint8_t car_id;
+    std::unique_ptr<CollisionManager> walls;  // nullptr: sin colisiones de mapa
+
+    std::deque<PendingInput> pending;
+    uint8_t applied_bits;  // del último paso predicho
+    uint8_t acked_bits;    // del último input confirmado por el servidor
+    bool synced;           // hay un estado del servidor sobre el que predecir
+    bool active;           // el auto está en carrera (vivo y sin terminar)
+
+    // Misma física que el servidor (config.yaml)
+    float sim_dt;
+    int sub_steps;
+    bool friction;
+    bool use_distance_field;
+
+    void load_config();
+    void ensure_car(const GameState& snapshot, const InfoPlayer& own);
+
+    // Un tick del servidor: controles + actualizar_fisica para este auto
+    void step(uint8_t bits, uint8_t previous_bits);
+
+public:
+    CarPredictor();
+
+    // Colisiones de la ciudad de la ruta (YAML) y vuelve a esperar al servidor
+    void init_race(const std::string& yaml_path);
+
+    // Aplica el input recién enviado (no hace nada hasta el primer snapshot)
+    void predict(uint32_t sequence, uint8_t bits);
+
+    // Parte del estado del servidor para `player_id` y re-simula lo no confirmado
+    void reconcile(const GameState& snapshot, int player_id);
+
+    // Pisa el auto de `player_id` en `snapshot` con el predicho (para dibujar)
+    void apply_to(GameState& snapshot, int player_id) const;
+
+    size_t pending_inputs() const { return pending.size(); }
+
+    CarPredictor(const CarPredictor&) = delete;
+    CarPredictor& operator=(const CarPredictor&) = delete;
+};
+
+#endif  // CAR_PREDICTOR_H
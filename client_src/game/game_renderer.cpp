@@ -3,59 +3,167 @@
 #include <SDL.h>
 #include <SDL_image.h>
 #include <SDL_ttf.h>
-#include <yaml-cpp/yaml.h>
 
 #include <algorithm>
 #include <cctype>
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+
+#include "../../common_src/car_catalog.h"
 
 const float RAD_TO_DEG = 180.0f / M_PI;
 
+namespace {
+
+// Hojas de sprites de autos: 8 direcciones por fila, cuadros de `size` px
+struct CarSheet {
+    const char* path;
+    int size;
+    int rows;  // filas usadas
+};
+
+constexpr CarSheet CAR_SHEETS[] = {
+        {"assets/img/map/cars/spritesheet-cars-32.png", 32, 2},
+        {"assets/img/map/cars/spritesheet-cars-40.png", 40, 10},
+        {"assets/img/map/cars/spritesheet-cars-50.png", 50, 2},
+};
+
+// Fila donde empieza cada modelo (usa esa y la siguiente: 16 direcciones)
+struct CarSprite {
+    const char* name;  // como en `cars:` de config.yaml
+    int sheet;
+    int row;
+};
+
+constexpr CarSprite CAR_SPRITES[] = {
+        {"J-Classic 600", 0, 0},
+        {"Stallion GT", 1, 0},
+        {"Cavallo V8", 1, 2},
+        {"Leyenda Urbana", 1, 4},
+        {"Brisa", 1, 6},
+        {"Nómada", 1, 8},
+        {"Senator", 2, 0},
+};
+
+constexpr int CAR_SHEET_COLUMNS = CAR_DIRECTIONS / 2;
+
+}  // namespace
+
 GameRenderer::GameRenderer(SDL2pp::Renderer& renderer_ref)
-    : renderer(renderer_ref), map_width(0), map_height(0) {
-    auto load_safe = [&](const std::string& path) -> std::unique_ptr<SDL2pp::Texture> {
-        SDL_Surface* surf = IMG_Load(path.c_str());
-        if (!surf) {
-            std::cerr << "[GameRenderer] ⚠️  AVISO: No se encontró la textura: " << path
+    : renderer(renderer_ref), car_atlas_width(0), car_atlas_height(0), map_width(0),
+      map_height(0) {
+    build_car_atlas();
+}
+
+void GameRenderer::build_car_atlas() {
+    // Las hojas se apilan una debajo de otra; el atlas es tan ancho como 8 cuadros de la mayor
+    SDL_Surface* sheets[std::size(CAR_SHEETS)] = {};
+    int sheet_y[std::size(CAR_SHEETS)] = {};
+    for (size_t i = 0; i < std::size(CAR_SHEETS); ++i) {
+        const CarSheet& sheet = CAR_SHEETS[i];
+        sheets[i] = IMG_Load(sheet.path);
+        if (!sheets[i]) {
+            std::cerr << "[GameRenderer] ⚠️  AVISO: No se encontró la textura: " << sheet.path
                       << "\n -> Verifica que el archivo exista." << std::endl;
-            return nullptr;
         }
-        return std::make_unique<SDL2pp::Texture>(renderer, SDL2pp::Surface(surf));
-    };
-
-    car_texture_32 = load_safe("assets/img/map/cars/spritesheet-cars-32.png");
-    car_texture_40 = load_safe("assets/img/map/cars/spritesheet-cars-40.png");
-    car_texture_50 = load_safe("assets/img/map/cars/spritesheet-cars-50.png");
+        sheet_y[i] = car_atlas_height;
+        car_atlas_width = std::max(car_atlas_width, CAR_SHEET_COLUMNS * sheet.size);
+        car_atlas_height += sheet.rows * sheet.size;
+    }
 
-    car_info_map["J-Classic 600"] = {0, 0, 32};
+    SDL_Surface* atlas = SDL_CreateRGBSurfaceWithFormat(0, car_atlas_width, car_atlas_height, 32,
+                                                        SDL_PIXELFORMAT_RGBA32);
+    for (size_t i = 0; i < std::size(CAR_SHEETS); ++i) {
+        if (!sheets[i]) continue;
+        if (atlas) {
+            // Copia exacta (con alpha): lo que no cubre la hoja queda transparente
+            SDL_SetSurfaceBlendMode(sheets[i], SDL_BLENDMODE_NONE);
+            SDL_Rect band = {0, 0, CAR_SHEET_COLUMNS * CAR_SHEETS[i].size,
+                             CAR_SHEETS[i].rows * CAR_SHEETS[i].size};
+            SDL_Rect dest = {0, sheet_y[i], band.w, band.h};
+            SDL_BlitSurface(sheets[i], &band, atlas, &dest);
+        }
+        SDL_FreeSurface(sheets[i]);
+    }
+    if (!atlas) {
+        std::cerr << "[GameRenderer] No se pudo crear el atlas de autos: " << SDL_GetError()
+                  << std::endl;
+        return;
+    }
+    car_atlas = std::make_unique<SDL2pp::Texture>(renderer, SDL2pp::Surface(atlas));
+
+    // Clips de cada sprite, en el mismo orden que CAR_SPRITES
+    sprite_clips.assign(std::size(CAR_SPRITES), {});
+    for (size_t i = 0; i < std::size(CAR_SPRITES); ++i) {
+        const CarSprite& sprite = CAR_SPRITES[i];
+        const int size = CAR_SHEETS[sprite.sheet].size;
+        for (int dir = 0; dir < CAR_DIRECTIONS; ++dir) {
+            const int row = sprite.row + dir / CAR_SHEET_COLUMNS;
+            sprite_clips[i][dir] = {(dir % CAR_SHEET_COLUMNS) * size,
+                                    sheet_y[sprite.sheet] + row * size, size, size};
+        }
+    }
 
-    car_info_map["Stallion GT"] = {1, 0, 40};     // Ocupa filas 0 y 1
-    car_info_map["Cavallo V8"] = {1, 2, 40};      // Ocupa filas 2 y 3 (Empieza en 2)
-    car_info_map["Leyenda Urbana"] = {1, 4, 40};  // Ocupa filas 4 y 5 (Empieza en 4)
-    car_info_map["Brisa"] = {1, 6, 40};           // Ocupa filas 6 y 7 (Empieza en 6)
-    car_info_map["Nómada"] = {1, 8, 40};          // Ocupa filas 8 y 9 (Empieza en 8)
+    // Una sola vez: (car_id, dirección) -> clip, sin buscar por nombre en cada frame
+    const CarCatalog& catalog = CarCatalog::instance();
+    car_clips.assign(catalog.size(), {});
+    for (size_t i = 0; i < std::size(CAR_SPRITES); ++i) {
+        const uint8_t car_id = catalog.id_of(CAR_SPRITES[i].name);
+        if (car_id != CarCatalog::UNKNOWN_CAR) car_clips[car_id] = sprite_clips[i];
+    }
+}
 
-    // Autos de 50px
-    car_info_map["Senator"] = {2, 0, 50};
+const SDL_Rect* GameRenderer::car_clip(const GameState& state, const InfoPlayer& player,
+                                       int direction) const {
+    const uint8_t car_id = player.car_id;
+    if (car_id < car_clips.size() && car_clips[car_id][direction].w > 0)
+        return &car_clips[car_id][direction];
 
-    for (int row = 0; row < 2; ++row) {
-        for (int dir = 0; dir < 8; ++dir) {
-            car_clips_32[row][dir] = SDL2pp::Rect(dir * 32, row * 32, 32, 32);
-        }
+    // El catálogo no tiene el modelo (p. ej. no se cargó config.yaml): se busca por nombre
+    for (size_t i = 0; i < std::size(CAR_SPRITES); ++i) {
+        if (state.car_name_of(player) == CAR_SPRITES[i].name) return &sprite_clips[i][direction];
     }
+    return nullptr;
+}
 
-    for (int row = 0; row < 10; ++row) {
-        for (int dir = 0; dir < 8; ++dir) {
-            car_clips_40[row][dir] = SDL2pp::Rect(dir * 40, row * 40, 40, 40);
-        }
+void GameRenderer::draw_car_batch() {
+    if (!car_atlas || car_batch.empty()) return;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    // Dos triángulos por auto, coordenadas de textura normalizadas al atlas
+    const float inv_w = 1.0f / static_cast<float>(car_atlas_width);
+    const float inv_h = 1.0f / static_cast<float>(car_atlas_height);
+    const SDL_Color white = {255, 255, 255, 255};
+    car_vertices.clear();
+    car_indices.clear();
+    for (const CarQuad& quad : car_batch) {
+        const int base = static_cast<int>(car_vertices.size());
+        const float x0 = static_cast<float>(quad.dest.x);
+        const float y0 = static_cast<float>(quad.dest.y);
+        const float x1 = x0 + static_cast<float>(quad.dest.w);
+        const float y1 = y0 + static_cast<float>(quad.dest.h);
+        const float u0 = static_cast<float>(quad.clip.x) * inv_w;
+        const float v0 = static_cast<float>(quad.clip.y) * inv_h;
+        const float u1 = static_cast<float>(quad.clip.x + quad.clip.w) * inv_w;
+        const float v1 = static_cast<float>(quad.clip.y + quad.clip.h) * inv_h;
+        car_vertices.push_back({{x0, y0}, white, {u0, v0}});
+        car_vertices.push_back({{x1, y0}, white, {u1, v0}});
+        car_vertices.push_back({{x1, y1}, white, {u1, v1}});
+        car_vertices.push_back({{x0, y1}, white, {u0, v1}});
+        for (int corner : {0, 1, 2, 0, 2, 3}) car_indices.push_back(base + corner);
     }
+    if (SDL_RenderGeometry(renderer.Get(), car_atlas->Get(), car_vertices.data(),
+                           static_cast<int>(car_vertices.size()), car_indices.data(),
+                           static_cast<int>(car_indices.size())) == 0) {
+        return;
+    }
+#endif
 
-    for (int row = 0; row < 2; ++row) {
-        for (int dir = 0; dir < 8; ++dir) {
-            car_clips_50[row][dir] = SDL2pp::Rect(dir * 50, row * 50, 50, 50);
-        }
+    // Sin SDL_RenderGeometry: un Copy por auto, siempre desde la misma textura
+    for (const CarQuad& quad : car_batch) {
+        renderer.Copy(*car_atlas, SDL2pp::Rect(quad.clip), SDL2pp::Rect(quad.dest));
     }
 }
 
@@ -64,15 +172,16 @@ void GameRenderer::init_race(const std::string& yaml_path) {
     std::cout << "[GameRenderer] Inicializando carrera. Config: " << yaml_path << std::endl;
 
     try {
-        YAML::Node config = YAML::LoadFile(yaml_path);
+        // Descriptor compilado (cacheado junto al YAML): sin pasar por yaml-cpp
+        std::shared_ptr<const RaceDescriptor> race = RaceDescriptor::load(yaml_path);
 
-        if (!config["race"] || !config["race"]["city"] || !config["race"]["name"]) {
+        if (race->city.empty() || race->name.empty()) {
             throw std::runtime_error(
                 "El archivo YAML no tiene los campos 'race.city' o 'race.name'");
         }
 
-        std::string raw_city = config["race"]["city"].as<std::string>();
-        std::string raw_name = config["race"]["name"].as<std::string>();
+        std::string raw_city = race->city;
+        std::string raw_name = race->name;
 
         auto normalize_path_name = [](std::string s) {
             std::transform(s.begin(), s.end(), s.begin(),
@@ -146,7 +255,7 @@ void GameRenderer::init_race(const std::string& yaml_path) {
         // }
 
         // Cargar checkpoints 
-        load_checkpoints_from_yaml(yaml_path);
+        load_checkpoints(*race);
 
         std::cout << "[GameRenderer]   Inicialización completada" << std::endl;
         std::cout << "[GameRenderer] ═══════════════════════════════════════" << std::endl;
@@ -210,54 +319,22 @@ void GameRenderer::render(const GameState& state, int player_id) {
     // Renderizar checkpoints 
     render_checkpoints(viewport, cam_x, cam_y);
 
-    // Renderizar Jugadores 
+    // Renderizar Jugadores (todos en un lote, ver draw_car_batch)
+    car_batch.clear();
     for (const auto& player : state.players) {
-        if (!player.is_alive)
+        // Fuera del área de interés solo llega el ranking, no hay posición para dibujar
+        if (!player.is_alive || !player.in_view)
             continue;
 
+        const SDL_Rect* clip = car_clip(state, player, getClipIndexFromAngle(player.angle));
+        if (!clip) continue;
+
         int screen_x = static_cast<int>(player.pos_x) - cam_x;
         int screen_y = static_cast<int>(player.pos_y) - cam_y;
-
-        auto it = car_info_map.find(player.car_name);
-        if (it == car_info_map.end()) {
-            // std::cerr << "Auto desconocido: " << player.car_name << std::endl;
-            continue;
-        }
-
-        int texture_id = it->second.texture_id;
-        int base_row = it->second.row;
-
-        // Calcular índice de 16 direcciones
-        int total_clip_idx = getClipIndexFromAngle(player.angle);
-
-      
-        int final_row = base_row;
-        int final_clip_idx = total_clip_idx;
-
-        if (total_clip_idx >= 8) {
-            final_row = base_row + 1;
-            final_clip_idx = total_clip_idx - 8;
-        }
-
-        SDL2pp::Texture* texture = nullptr;
-        SDL2pp::Rect clip;
-
-        if (texture_id == 0) {
-            texture = car_texture_32.get();
-            clip = car_clips_32[final_row][final_clip_idx];
-        } else if (texture_id == 1) {
-            texture = car_texture_40.get();
-            clip = car_clips_40[final_row][final_clip_idx];
-        } else if (texture_id == 2) {
-            texture = car_texture_50.get();
-            clip = car_clips_50[final_row][final_clip_idx];
-        }
-
-        if (texture) {
-            SDL2pp::Rect dest(screen_x - clip.w / 2, screen_y - clip.h / 2, clip.w, clip.h);
-            renderer.Copy(*texture, clip, dest);
-        }
+        SDL_Rect dest = {screen_x - clip->w / 2, screen_y - clip->h / 2, clip->w, clip->h};
+        car_batch.push_back({*clip, dest});
     }
+    draw_car_batch();
 
     if (puentes_texture)
         renderer.Copy(*puentes_texture, viewport, screen_rect);
@@ -302,51 +379,55 @@ void GameRenderer::render(const GameState& state, int player_id) {
         renderer.FillRect(playerInner);
     }
 
+    render_link_indicator();
     renderer.Present();
 }
 
-void GameRenderer::load_checkpoints_from_yaml(const std::string& yaml_path) {
-    std::cout << "[GameRenderer] Cargando checkpoints desde: " << yaml_path << std::endl;
+void GameRenderer::render_link_indicator() {
+    if (link.samples == 0) return;
+
+    // Barras de señal arriba a la izquierda: menos barras y más rojo cuanto peor el enlace
+    const float latency = link.rtt_ms + 2.0f * link.jitter_ms;
+    int bars = 1;
+    if (latency < 200.0f) bars = 2;
+    if (latency < 120.0f) bars = 3;
+    if (latency < 60.0f) bars = 4;
+
+    for (int i = 0; i < 4; ++i) {
+        SDL2pp::Rect bar(12 + i * 6, 12 + (3 - i) * 4, 4, 4 + i * 4);
+        if (i >= bars)
+            renderer.SetDrawColor(60, 60, 60, 255);
+        else if (bars >= 3)
+            renderer.SetDrawColor(0, 220, 0, 255);
+        else if (bars == 2)
+            renderer.SetDrawColor(255, 200, 0, 255);
+        else
+            renderer.SetDrawColor(255, 0, 0, 255);
+        renderer.FillRect(bar);
+    }
+}
 
+void GameRenderer::load_checkpoints(const RaceDescriptor& race) {
     checkpoints.clear();
     spawn_points.clear();
 
-    try {
-        YAML::Node config = YAML::LoadFile(yaml_path);
-
-        if (config["checkpoints"] && config["checkpoints"].IsSequence()) {
-            for (const auto& cp : config["checkpoints"]) {
-                Checkpoint checkpoint;
-                checkpoint.id = cp["id"].as<int>();
-                checkpoint.type = cp["type"].as<std::string>();
-                checkpoint.x = cp["x"].as<float>();
-                checkpoint.y = cp["y"].as<float>();
-                checkpoint.width = cp["width"].as<float>();
-                checkpoint.height = cp["height"].as<float>();
-                checkpoint.angle = cp["angle"] ? cp["angle"].as<float>() : 0.0f;
-
-                checkpoints.push_back(checkpoint);
-            }
-            std::cout << "[GameRenderer]  Cargados " << checkpoints.size() << " checkpoints"
-                      << std::endl;
-        }
-
-        if (config["spawn_points"] && config["spawn_points"].IsSequence()) {
-            
-            for (const auto& sp : config["spawn_points"]) {
-                SpawnPoint spawn;
-                spawn.x = sp["x"].as<float>();
-                spawn.y = sp["y"].as<float>();
-                spawn.angle = sp["angle"].as<float>();
-                spawn_points.push_back(spawn);
-            }
-            std::cout << "[GameRenderer] Cargados " << spawn_points.size() << " spawn points"
-                      << std::endl;
-        }
+    for (const auto& cp : race.checkpoints) {
+        Checkpoint checkpoint;
+        checkpoint.id = cp.id;
+        checkpoint.type = RaceDescriptor::type_name(cp.type);
+        checkpoint.x = cp.x;
+        checkpoint.y = cp.y;
+        checkpoint.width = cp.width;
+        checkpoint.height = cp.height;
+        checkpoint.angle = cp.angle;
+        checkpoints.push_back(checkpoint);
+    }
+    std::cout << "[GameRenderer]  Cargados " << checkpoints.size() << " checkpoints" << std::endl;
 
-    } catch (const std::exception& e) {
-        std::cerr << "[GameRenderer]  Error cargando checkpoints: " << e.what() << std::endl;
+    for (const auto& sp : race.spawn_points) {
+        spawn_points.push_back(SpawnPoint{sp.x, sp.y, sp.angle});
     }
+    std::cout << "[GameRenderer] Cargados " << spawn_points.size() << " spawn points" << std::endl;
 }
 
 void GameRenderer::render_checkpoints(const SDL2pp::Rect& viewport, int cam_x, int cam_y) {
@@ -2,12 +2,17 @@
 #define GAME_RENDERER_H
 
 #include <SDL2pp/SDL2pp.hh>
-#include <map>
+#include <array>
 #include <string>
 #include <memory>
 #include <vector>
+#include "../../common_src/clock_sync.h"
 #include "../../common_src/game_state.h"
 #include "../../common_src/collision_manager.h" 
+#include "../../common_src/race_descriptor.h"
+
+// Direcciones de cada sprite de auto (dos filas de 8 en las hojas)
+#define CAR_DIRECTIONS 16
 
 class GameRenderer {
 private:
@@ -18,33 +23,39 @@ private:
     std::unique_ptr<SDL2pp::Texture> puentes_texture;
     std::unique_ptr<SDL2pp::Texture> top_texture;
     
-    // Texturas de autos por tamaño
-    std::unique_ptr<SDL2pp::Texture> car_texture_32;
-    std::unique_ptr<SDL2pp::Texture> car_texture_40;
-    std::unique_ptr<SDL2pp::Texture> car_texture_50;
-    
+    // Atlas de autos: las hojas de 32, 40 y 50 px empaquetadas en una sola textura
+    std::unique_ptr<SDL2pp::Texture> car_atlas;
+    int car_atlas_width;
+    int car_atlas_height;
+
     // Textura del Minimapa
     std::unique_ptr<SDL2pp::Texture> minimap_texture;
 
     // Collision Manager para lógica visual
     std::unique_ptr<CollisionManager> collision_manager;
 
-    // Clips de animación por tamaño
-    std::map<int, std::map<int, SDL2pp::Rect>> car_clips_32;
-    std::map<int, std::map<int, SDL2pp::Rect>> car_clips_40;
-    std::map<int, std::map<int, SDL2pp::Rect>> car_clips_50;
-    
-    struct CarInfo {
-        int texture_id;
-        int row;
-        int size;
+    // Clip en el atlas por (car_id del CarCatalog, dirección); w = 0: modelo sin sprite
+    std::vector<std::array<SDL_Rect, CAR_DIRECTIONS>> car_clips;
+    // Los mismos clips por sprite (orden de CAR_SPRITES), para autos fuera del catálogo
+    std::vector<std::array<SDL_Rect, CAR_DIRECTIONS>> sprite_clips;
+
+    // Autos del frame: se dibujan juntos, con el atlas como única textura
+    struct CarQuad {
+        SDL_Rect clip;
+        SDL_Rect dest;
     };
-    
-    std::map<std::string, CarInfo> car_info_map;
+    std::vector<CarQuad> car_batch;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    std::vector<SDL_Vertex> car_vertices;  // el lote entero en un SDL_RenderGeometry
+    std::vector<int> car_indices;
+#endif
 
     int map_width;
     int map_height;
 
+    // Estado del enlace para el indicador del HUD (samples = 0: no se dibuja)
+    LinkStats link;
+
     // ═══════════════════════════════════════════════════════════
     // NUEVAS ESTRUCTURAS Y DECLARACIONES (Checkpoints)
     // ═══════════════════════════════════════════════════════════
@@ -70,8 +81,12 @@ private:
 
     // Funciones auxiliares privadas
     int getClipIndexFromAngle(float angle_radians);
-    void load_checkpoints_from_yaml(const std::string& yaml_path);
+    void build_car_atlas();
+    const SDL_Rect* car_clip(const GameState& state, const InfoPlayer& player, int direction) const;
+    void draw_car_batch();
+    void load_checkpoints(const RaceDescriptor& race);
     void render_checkpoints(const SDL2pp::Rect& viewport, int cam_x, int cam_y);
+    void render_link_indicator();
 
 public:
     static const int SCREEN_WIDTH = 700;
@@ -87,6 +102,9 @@ public:
 
     void render(const GameState& state, int player_id);
 
+    // Latencia medida por ClientProtocol, para el próximo render
+    void set_link_stats(const LinkStats& stats) { link = stats; }
+
     ~GameRenderer() = default;
 };
 
@@ -0,0 +1,125 @@
+#include "snapshot_interpolator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../../common_src/config.h"
+
+namespace {
+
+float lerp(float a, float b, float t) { return a + (b - a) * t; }
+
+// Por el arco más corto: de 350° a 10° pasa por 0°, no por 180°
+float lerp_angle(float a, float b, float t) {
+    const float two_pi = 2.0f * static_cast<float>(M_PI);
+    float diff = std::remainder(b - a, two_pi);
+    float angle = std::fmod(a + diff * t, two_pi);
+    if (angle < 0.0f) angle += two_pi;
+    return angle;
+}
+
+}  // namespace
+
+SnapshotInterpolator::SnapshotInterpolator()
+    : head(0), count(0), delay(std::chrono::milliseconds(INTERPOLATION_DEFAULT_DELAY_MS)) {
+    try {
+        int ms = Configuration::get<int>("interpolation_delay_ms");
+        delay = std::chrono::milliseconds(std::max(0, ms));
+    } catch (const std::exception&) {}
+}
+
+void SnapshotInterpolator::push(const GameState& snapshot) {
+    Frame& slot = frames[(head + count) % frames.size()];
+    if (count == frames.size())
+        head = (head + 1) % frames.size();
+    else
+        ++count;
+
+    slot.at = snapshot.received_at == Clock::time_point{} ? Clock::now()
+                                                          : snapshot.received_at;
+    slot.poses.clear();  // reutiliza la capacidad del vector
+    for (const InfoPlayer& p : snapshot.players) {
+        if (!p.in_view) continue;
+        slot.poses.push_back({p.player_id, p.pos_x, p.pos_y, p.angle, p.speed, p.velocity_x,
+                              p.velocity_y});
+    }
+}
+
+void SnapshotInterpolator::clear() {
+    head = 0;
+    count = 0;
+}
+
+const SnapshotInterpolator::Pose* SnapshotInterpolator::find(const Frame& frame,
+                                                             int player_id) {
+    for (const Pose& pose : frame.poses) {
+        if (pose.player_id == player_id) return &pose;
+    }
+    return nullptr;
+}
+
+bool SnapshotInterpolator::sample(int player_id, Clock::time_point at, Pose& out) const {
+    // Del más nuevo al más viejo: el primero con at <= `at` y el siguiente más nuevo
+    const Pose* older = nullptr;
+    const Pose* newer = nullptr;
+    Clock::time_point older_at;
+    Clock::time_point newer_at;
+    for (size_t i = count; i-- > 0;) {
+        const Pose* pose = find(frame(i), player_id);
+        if (!pose) continue;
+        if (frame(i).at <= at) {
+            older = pose;
+            older_at = frame(i).at;
+            break;
+        }
+        newer = pose;
+        newer_at = frame(i).at;
+    }
+
+    if (!older && !newer) return false;
+
+    // Más atrás que todo el buffer (recién empieza): el más viejo que hay
+    if (!older) {
+        out = *newer;
+        return true;
+    }
+
+    // Sin snapshot posterior: extrapolar un rato con la última velocidad
+    if (!newer) {
+        const auto ahead = std::min<Clock::duration>(
+                at - older_at, std::chrono::milliseconds(INTERPOLATION_MAX_EXTRAPOLATION_MS));
+        const float seconds = std::chrono::duration<float>(ahead).count();
+        out = *older;
+        out.pos_x += older->velocity_x * seconds;
+        out.pos_y += older->velocity_y * seconds;
+        return true;
+    }
+
+    const float t = std::chrono::duration<float>(at - older_at).count() /
+                    std::chrono::duration<float>(newer_at - older_at).count();
+    out = *older;
+    out.pos_x = lerp(older->pos_x, newer->pos_x, t);
+    out.pos_y = lerp(older->pos_y, newer->pos_y, t);
+    out.angle = lerp_angle(older->angle, newer->angle, t);
+    out.speed = lerp(older->speed, newer->speed, t);
+    out.velocity_x = lerp(older->velocity_x, newer->velocity_x, t);
+    out.velocity_y = lerp(older->velocity_y, newer->velocity_y, t);
+    return true;
+}
+
+void SnapshotInterpolator::apply_to(GameState& snapshot, int own_player_id,
+                                    Clock::time_point now) const {
+    const Clock::time_point at = now - delay;
+    for (InfoPlayer& p : snapshot.players) {
+        if (p.player_id == own_player_id || !p.in_view) continue;
+
+        Pose pose;
+        if (!sample(p.player_id, at, pose)) continue;
+        p.pos_x = pose.pos_x;
+        p.pos_y = pose.pos_y;
+        p.angle = pose.angle;
+        p.speed = pose.speed;
+        p.velocity_x = pose.velocity_x;
+        p.velocity_y = pose.velocity_y;
+    }
+}
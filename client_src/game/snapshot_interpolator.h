@@ -0,0 +1,82 @@
+#ifndef SNAPSHOT_INTERPOLATOR_H
+#define SNAPSHOT_INTERPOLATOR_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "../../common_src/game_state.h"
+
+// Snapshots recordados (~0.5 s a 60 Hz, ~1.5 s a 20 Hz)
+#define INTERPOLATION_BUFFER 32
+
+// Retraso con el que se dibujan los autos ajenos si config.yaml no dice otro
+#define INTERPOLATION_DEFAULT_DELAY_MS 100
+
+// Cuánto se sigue moviendo un auto ajeno con su última velocidad si no llegan snapshots
+#define INTERPOLATION_MAX_EXTRAPOLATION_MS 200
+
+/*
+ * Interpolación de los autos ajenos entre snapshots.
+ *
+ * Cada snapshot se guarda con la hora a la que llegó (GameState::received_at)
+ * y los autos de los demás se dibujan `delay` atrás en el tiempo, mezclando
+ * los dos snapshots que rodean ese instante. Así se mueven suave aunque el
+ * servidor mande 20 o 30 snapshots por segundo y lleguen con jitter.
+ *
+ * Si el instante pedido es posterior al último snapshot (pérdida o retraso)
+ * se extrapola con la velocidad del último, hasta
+ * INTERPOLATION_MAX_EXTRAPOLATION_MS; después el auto queda quieto.
+ *
+ * El auto propio no se toca: lo dibuja CarPredictor.
+ */
+class SnapshotInterpolator {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    // Lo que se interpola de un auto (el resto sale del snapshot más nuevo)
+    struct Pose {
+        int player_id;
+        float pos_x;
+        float pos_y;
+        float angle;
+        float speed;
+        float velocity_x;
+        float velocity_y;
+    };
+
+    struct Frame {
+        Clock::time_point at;
+        std::vector<Pose> poses;  // solo los autos con posición (in_view)
+    };
+
+    std::array<Frame, INTERPOLATION_BUFFER> frames;  // anillo, del más viejo al más nuevo
+    size_t head;   // índice del más viejo
+    size_t count;
+    Clock::duration delay;
+
+    const Frame& frame(size_t i) const { return frames[(head + i) % frames.size()]; }
+    static const Pose* find(const Frame& frame, int player_id);
+
+    // Posición de `player_id` en `at`; false si ningún snapshot lo tiene
+    bool sample(int player_id, Clock::time_point at, Pose& out) const;
+
+public:
+    SnapshotInterpolator();
+
+    // Guarda la parte móvil de `snapshot` (los snapshots llegan en orden)
+    void push(const GameState& snapshot);
+
+    // Pisa los autos ajenos de `snapshot` con su posición en `now - delay`
+    void apply_to(GameState& snapshot, int own_player_id, Clock::time_point now) const;
+
+    // Al cambiar de carrera: las posiciones viejas no sirven para interpolar
+    void clear();
+
+    void set_delay(std::chrono::milliseconds ms) { delay = ms; }
+    size_t buffered() const { return count; }
+};
+
+#endif  // SNAPSHOT_INTERPOLATOR_H
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <string>
 
+#include "common_src/car_catalog.h"
 #include "common_src/config.h"
 
 GarageWindow::GarageWindow(QWidget* parent) : BaseLobby(parent), currentCarIndex(0) {
@@ -27,53 +28,38 @@ GarageWindow::GarageWindow(QWidget* parent) : BaseLobby(parent), currentCarIndex
 }
 
 void GarageWindow::loadCars() {
-    // Cargar configuración
+    // Cargar configuración (el catálogo se construye de ella una sola vez)
     const char* path_config = "config.yaml";
-    Configuration::load_path(path_config);
-
-   
-    cars.clear();
-
     try {
-       
-        auto carsNode = Configuration::get_node("cars");
-
-        if (!carsNode.IsDefined() || !carsNode.IsSequence()) {
-            std::cerr
-                << "[GarageWindow] Error: 'cars' no encontrado o no es una secuencia en config.yaml"
-                << std::endl;
-            // Fallback: cargar datos hardcodeados
-            loadDefaultCars();
-            return;
-        }
-
-       
-        for (size_t i = 0; i < carsNode.size(); i++) {
-            YAML::Node carNode = carsNode[i];
-
-            CarInfo car;
-            car.name = QString::fromStdString(carNode["name"].template as<std::string>());
-            car.imagePath = QString::fromStdString(carNode["image_path"].template as<std::string>());
-            car.type = QString::fromStdString(carNode["type"].template as<std::string>());
-            car.speed = carNode["speed"].template as<int>();
-            car.acceleration = carNode["acceleration"].template as<int>();
-            car.handling = carNode["handling"].template as<int>();
-            car.durability = carNode["durability"].template as<int>();
-
-            cars.push_back(car);
-
-            std::cout << "[GarageWindow] Auto cargado: " << car.name.toStdString()
-                      << " (tipo: " << car.type.toStdString() << ")" << std::endl;
-        }
-
-        std::cout << "[GarageWindow]   " << cars.size() << " autos cargados desde config.yaml"
+        Configuration::load_path(path_config);
+    } catch (const std::exception& e) {
+        std::cerr << "[GarageWindow] Error cargando " << path_config << ": " << e.what()
                   << std::endl;
+    }
 
-    } catch (const std::exception& e) {
-        std::cerr << "[GarageWindow] Error cargando autos desde YAML: " << e.what() << std::endl;
+    cars.clear();
+
+    const CarCatalog& catalog = CarCatalog::instance();
+    if (catalog.size() == 0) {
         // Fallback: cargar datos hardcodeados
         loadDefaultCars();
+        return;
+    }
+
+    for (const CarModel& model : catalog.all()) {
+        CarInfo car;
+        car.name = QString::fromStdString(model.name);
+        car.imagePath = QString::fromStdString(model.image_path);
+        car.type = QString::fromStdString(model.type);
+        car.speed = model.speed;
+        car.acceleration = model.acceleration;
+        car.handling = model.handling;
+        car.durability = model.durability;
+        cars.push_back(car);
     }
+
+    std::cout << "[GarageWindow]   " << cars.size() << " autos cargados desde config.yaml"
+              << std::endl;
 }
 
 void GarageWindow::loadDefaultCars() {
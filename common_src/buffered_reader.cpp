@@ -0,0 +1,127 @@
+#include "buffered_reader.h"
+
+#include <netinet/in.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "liberror.h"
+
+BufferedReader::BufferedReader(Socket& socket, size_t capacity)
+    : socket(socket), buffer(capacity > 0 ? capacity : 1), begin(0), end(0) {}
+
+int BufferedReader::fill() {
+    // Compactar: lo pendiente pasa al principio para aprovechar todo el buffer
+    if (begin > 0) {
+        std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+    }
+    int s = socket.recvsome(buffer.data() + end, static_cast<unsigned int>(buffer.size() - end));
+    if (s > 0) end += static_cast<size_t>(s);
+    return s;
+}
+
+bool BufferedReader::receive_available() {
+    while (true) {
+        if (begin > 0) {
+            std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+            end -= begin;
+            begin = 0;
+        }
+        // Un mensaje más grande que el buffer tiene que entrar entero antes de parsearlo
+        if (end == buffer.size()) {
+            if (buffer.size() >= MAX_FRAME_SIZE)
+                throw std::runtime_error("Inbound message over " +
+                                         std::to_string(MAX_FRAME_SIZE) + " bytes");
+            buffer.resize(std::min<size_t>(buffer.size() * 2, MAX_FRAME_SIZE));
+        }
+
+        int s = socket.tryrecvsome(buffer.data() + end,
+                                   static_cast<unsigned int>(buffer.size() - end));
+        if (s == 0) return false;
+        if (s < 0) return true;  // no hay más por ahora
+        end += static_cast<size_t>(s);
+    }
+}
+
+int BufferedReader::recvall(void* data, unsigned int sz) {
+    uint8_t* out = static_cast<uint8_t*>(data);
+    unsigned int received = 0;
+
+    while (received < sz) {
+        if (begin == end) {
+            // Lecturas grandes van directo al destino, sin pasar por el buffer
+            const unsigned int missing = sz - received;
+            if (missing >= buffer.size()) {
+                int s = socket.recvall(out + received, missing);
+                if (s == 0 && received)
+                    throw LibError(EPIPE, "socket received only %d of %d bytes", received, sz);
+                return s == 0 ? 0 : static_cast<int>(sz);
+            }
+            if (fill() == 0) {
+                if (received)
+                    throw LibError(EPIPE, "socket received only %d of %d bytes", received, sz);
+                return 0;
+            }
+        }
+
+        const size_t chunk = std::min(end - begin, static_cast<size_t>(sz - received));
+        std::memcpy(out + received, buffer.data() + begin, chunk);
+        begin += chunk;
+        received += static_cast<unsigned int>(chunk);
+    }
+    return static_cast<int>(sz);
+}
+
+bool BufferedReader::read_frame(std::vector<uint8_t>& frame) {
+    uint32_t len_net;
+    if (recvall(&len_net, sizeof(len_net)) == 0) return false;
+
+    const uint32_t len = ntohl(len_net);
+    if (len > MAX_FRAME_SIZE)
+        throw std::runtime_error("Invalid frame length: " + std::to_string(len));
+
+    frame.resize(len);
+    if (len > 0 && recvall(frame.data(), len) == 0)
+        throw LibError(EPIPE, "connection closed inside a %u bytes frame", len);
+    return true;
+}
+
+// --- FrameReader ---
+
+const uint8_t* FrameReader::take(size_t sz) {
+    if (sz > remaining()) throw std::runtime_error("Truncated frame");
+    const uint8_t* data = frame.data() + offset;
+    offset += sz;
+    return data;
+}
+
+uint8_t FrameReader::read_uint8() { return *take(1); }
+
+uint16_t FrameReader::read_uint16() {
+    uint16_t value_net;
+    std::memcpy(&value_net, take(sizeof(value_net)), sizeof(value_net));
+    return ntohs(value_net);
+}
+
+uint32_t FrameReader::read_uint32() {
+    uint32_t value_net;
+    std::memcpy(&value_net, take(sizeof(value_net)), sizeof(value_net));
+    return ntohl(value_net);
+}
+
+uint64_t FrameReader::read_uint64() {
+    const uint64_t high = read_uint32();
+    return (high << 32) | read_uint32();
+}
+
+int32_t FrameReader::read_int32() { return static_cast<int32_t>(read_uint32()); }
+
+std::string FrameReader::read_string() {
+    const uint16_t len = read_uint16();
+    const uint8_t* data = take(len);
+    return std::string(reinterpret_cast<const char*>(data), len);
+}
@@ -0,0 +1,98 @@
+#ifndef BUFFERED_READER_H
+#define BUFFERED_READER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "socket.h"
+
+// Tope de un frame recibido (protege contra largos corruptos)
+#define MAX_FRAME_SIZE (1u << 20)
+
+/*
+ * Lectura con buffer sobre un Socket.
+ *
+ * `recvall` tiene la misma semántica que `Socket::recvall`, pero pide al
+ * socket todo lo que haya disponible (hasta `capacity`) y sirve las lecturas
+ * siguientes desde memoria: un mensaje de muchos campos chicos cuesta uno o
+ * pocos `recv` en vez de uno por campo.
+ *
+ * Todas las lecturas de una conexión tienen que pasar por el mismo
+ * BufferedReader; leer el socket por fuera perdería lo ya bufferizado.
+ *
+ * Con un socket no bloqueante se usa como parser reanudable:
+ * `receive_available` junta lo que haya llegado sin esperar, `pending`
+ * deja mirar esos bytes sin consumirlos y, una vez que un mensaje está
+ * entero, `recvall` lo sirve desde memoria. Lo que llegó a medias queda
+ * en el buffer para la próxima vez.
+ * */
+class BufferedReader {
+private:
+    Socket& socket;
+    std::vector<uint8_t> buffer;
+    size_t begin;  // primer byte sin consumir
+    size_t end;    // fin de los bytes válidos
+
+    // Hace un `recv` y devuelve los bytes nuevos (0 si se cerró la conexión)
+    int fill();
+
+public:
+    explicit BufferedReader(Socket& socket, size_t capacity = 4096);
+
+    /*
+     * Recibe exactamente `sz` bytes. Retorna 0 si la conexión se cerró sin
+     * recibir ninguno y lanza una excepción si se cerró a mitad de camino.
+     * */
+    int recvall(void* data, unsigned int sz);
+
+    /*
+     * Lee un frame `u32 largo | cuerpo` completo en `frame`.
+     * Retorna false si la conexión se cerró antes del largo.
+     * */
+    bool read_frame(std::vector<uint8_t>& frame);
+
+    /*
+     * Recibe sin bloquear todo lo disponible, agrandando el buffer si hace
+     * falta (hasta MAX_FRAME_SIZE de bytes sin consumir). Retorna false si
+     * la conexión se cerró; lo ya recibido se puede seguir leyendo.
+     * */
+    bool receive_available();
+
+    // Hay bytes ya recibidos sin consumir (se pueden leer sin esperar al socket)
+    bool has_buffered() const { return begin != end; }
+
+    // Bytes recibidos y sin consumir, para ver si un mensaje llegó entero
+    const uint8_t* pending() const { return buffer.data() + begin; }
+    size_t pending_size() const { return end - begin; }
+
+    BufferedReader(const BufferedReader&) = delete;
+    BufferedReader& operator=(const BufferedReader&) = delete;
+};
+
+/*
+ * Parseo desde memoria de un frame ya recibido, con la misma interfaz de
+ * lectura que los protocolos (read_uint8/16/32, read_int32, read_string).
+ * Lanza std::runtime_error si el frame es más corto de lo que se lee.
+ * */
+class FrameReader {
+private:
+    const std::vector<uint8_t>& frame;
+    size_t offset;
+
+    const uint8_t* take(size_t sz);
+
+public:
+    explicit FrameReader(const std::vector<uint8_t>& frame) : frame(frame), offset(0) {}
+
+    uint8_t read_uint8();
+    uint16_t read_uint16();
+    uint32_t read_uint32();
+    uint64_t read_uint64();
+    int32_t read_int32();
+    std::string read_string();
+
+    size_t remaining() const { return frame.size() - offset; }
+};
+
+#endif  // BUFFERED_READER_H
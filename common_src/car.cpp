@@ -4,16 +4,25 @@
 #include <cmath>
 #include <iostream>
 
+#include "collision_manager.h"
+#include "dtos.h"
+
+// Hasta cuántos píxeles se busca una celda libre para un auto que quedó dentro de la pared
+static constexpr int UNSTUCK_RADIUS = 16;
+
 // ==========================================================
 // CONSTRUCTOR
 // ==========================================================
 
 Car::Car(const std::string& model, const std::string& type)
-    : model_name(model), car_type(type), max_speed(100.0f), acceleration(50.0f), handling(1.0f),
-      max_durability(100.0f), nitro_boost(1.5f), weight(1000.0f), current_speed(0.0f),
-      current_health(100.0f), nitro_amount(100.0f), nitro_active(false), x(0.0f), y(0.0f),
-      angle(0.0f), velocity_x(0.0f), velocity_y(0.0f), is_drifting(false), is_colliding(false),
-      is_destroyed(false) {
+    : model_name(model), car_type(type), model_id(0xFF), max_speed(100.0f), acceleration(50.0f),
+      handling(1.0f),
+      max_durability(100.0f), nitro_boost(1.5f), weight(1000.0f),
+      current_health(100.0f), nitro_amount(100.0f), nitro_active(false),
+      own_physics(std::make_unique<CarPhysicsPool>()), physics(own_physics.get()),
+      physics_slot(0), is_drifting(false), is_colliding(false) {
+    // Hasta que el GameLoop lo enganche a su pool, el auto usa uno propio de 1 slot
+    physics_slot = physics->allocate(this);
 
     /*En box2d verificamos tipo de auto porque median distinto
      if (type == "classic" || type == "small") {
@@ -28,6 +37,30 @@ Car::Car(const std::string& model, const std::string& type)
     std::cout << "[Car] Creado: " << model << " (" << type << ")" << std::endl;
 }
 
+Car::~Car() {
+    physics->release(physics_slot);
+}
+
+void Car::attach_physics(CarPhysicsPool& pool) {
+    if (physics == &pool) return;
+
+    const size_t slot = pool.allocate(this);
+    pool.x[slot] = getX();
+    pool.y[slot] = getY();
+    pool.angle[slot] = getAngle();
+    pool.velocity_x[slot] = getVelocityX();
+    pool.velocity_y[slot] = getVelocityY();
+    pool.speed[slot] = getCurrentSpeed();
+    pool.old_x[slot] = getX();
+    pool.old_y[slot] = getY();
+    pool.alive[slot] = physics->alive[physics_slot];
+
+    physics->release(physics_slot);
+    physics = &pool;
+    physics_slot = slot;
+    own_physics.reset();
+}
+
 // ==========================================================
 // CONFIGURAR STATS (desde config.yaml)
 // ==========================================================
@@ -54,14 +87,14 @@ void Car::load_stats(float max_spd, float accel, float hand, float durability, f
 void Car::takeDamage(float damage) {
     current_health = std::max(0.0f, current_health - damage);
     if (current_health <= 0) {
-        is_destroyed = true;
-        current_speed = 0;
+        physics->alive[physics_slot] = 0.0f;
+        speed() = 0;
         std::cout << "[Car] " << model_name << " DESTRUIDO!" << std::endl;
     }
 }
 
 void Car::repair(float amount) {
-    if (!is_destroyed) {
+    if (!isDestroyed()) {
         current_health = std::min(max_durability, current_health + amount);
     }
 }
@@ -71,7 +104,7 @@ void Car::repair(float amount) {
 // ==========================================================
 
 void Car::activateNitro() {
-    if (nitro_amount > 0 && !nitro_active && !is_destroyed) {
+    if (nitro_amount > 0 && !nitro_active && !isDestroyed()) {
         nitro_active = true;
         std::cout << "[Car] " << model_name << " NITRO ACTIVADO!" << std::endl;
     }
@@ -90,20 +123,12 @@ void Car::rechargeNitro(float amount) {
 // ==========================================================
 // C++
 void Car::update(float delta_time) {
-    if (is_destroyed)
-        return;
-
-    // recalcular componentes de velocidad por si no se actualizan en accelerate/brake
-    velocity_x = current_speed * std::cos(angle);
-    velocity_y = current_speed * std::sin(angle);
-
-    // integrar posición
-    x += velocity_x * delta_time;
-    y += velocity_y * delta_time;
+    // recalcular componentes de velocidad e integrar posición (solo este slot)
+    physics->integrate_one(physics_slot, delta_time);
 }
 
 void Car::accelerate(float delta_time) {
-    if (is_destroyed)
+    if (isDestroyed())
         return;
 
     //Para Box2d
@@ -119,7 +144,7 @@ void Car::accelerate(float delta_time) {
         }
     }
 
-    current_speed = std::min(max_speed, current_speed + effective_acceleration * delta_time);
+    speed() = std::min(max_speed, speed() + effective_acceleration * delta_time);
 
     /*Para box2d
     float fx = current_speed * std::cos(angle);
@@ -129,12 +154,14 @@ void Car::accelerate(float delta_time) {
     b2Body_SetLinearVelocity(bodyId, velocity);
     b2Body_SetAwake(bodyId, true);
     */
-    update(delta_time);
+    // Solo la velocidad: la posición la avanza CarPhysicsPool::integrate
+    vel_x() = speed() * std::cos(heading());
+    vel_y() = speed() * std::sin(heading());
 }
 
 // Nuevos métodos para movimiento en 4 direcciones fijas
 void Car::move_up(float delta_time) {
-    if (is_destroyed)
+    if (isDestroyed())
         return;
 
     float effective_acceleration = acceleration;
@@ -147,28 +174,27 @@ void Car::move_up(float delta_time) {
     }
 
     // Acelerar hacia arriba (dirección Y negativa)
-    velocity_y -= effective_acceleration * delta_time;
+    vel_y() -= effective_acceleration * delta_time;
 
     // Limitar velocidad máxima
-    float total_speed = std::sqrt(velocity_x * velocity_x + velocity_y * velocity_y);
+    float total_speed = std::sqrt(vel_x() * vel_x() + vel_y() * vel_y());
     if (total_speed > max_speed) {
         float scale = max_speed / total_speed;
-        velocity_x *= scale;
-        velocity_y *= scale;
+        vel_x() *= scale;
+        vel_y() *= scale;
     }
 
     // Actualizar ángulo para que apunte en la dirección del movimiento
     if (total_speed > 1.0f) {
-        angle = std::atan2(velocity_y, velocity_x);
+        heading() = std::atan2(vel_y(), vel_x());
     }
 
-    current_speed = total_speed;
-    x += velocity_x * delta_time;
-    y += velocity_y * delta_time;
+    // La posición la avanza CarPhysicsPool::integrate, así el barrido de paredes la ve
+    speed() = total_speed;
 }
 
 void Car::move_down(float delta_time) {
-    if (is_destroyed)
+    if (isDestroyed())
         return;
 
     float effective_acceleration = acceleration;
@@ -181,28 +207,27 @@ void Car::move_down(float delta_time) {
     }
 
     // Acelerar hacia abajo (dirección Y positiva)
-    velocity_y += effective_acceleration * delta_time;
+    vel_y() += effective_acceleration * delta_time;
 
     // Limitar velocidad máxima
-    float total_speed = std::sqrt(velocity_x * velocity_x + velocity_y * velocity_y);
+    float total_speed = std::sqrt(vel_x() * vel_x() + vel_y() * vel_y());
     if (total_speed > max_speed) {
         float scale = max_speed / total_speed;
-        velocity_x *= scale;
-        velocity_y *= scale;
+        vel_x() *= scale;
+        vel_y() *= scale;
     }
 
     // Actualizar ángulo para que apunte en la dirección del movimiento
     if (total_speed > 1.0f) {
-        angle = std::atan2(velocity_y, velocity_x);
+        heading() = std::atan2(vel_y(), vel_x());
     }
 
-    current_speed = total_speed;
-    x += velocity_x * delta_time;
-    y += velocity_y * delta_time;
+    // La posición la avanza CarPhysicsPool::integrate, así el barrido de paredes la ve
+    speed() = total_speed;
 }
 
 void Car::move_left(float delta_time) {
-    if (is_destroyed)
+    if (isDestroyed())
         return;
 
     float effective_acceleration = acceleration;
@@ -215,28 +240,27 @@ void Car::move_left(float delta_time) {
     }
 
     // Acelerar hacia la izquierda (dirección X negativa)
-    velocity_x -= effective_acceleration * delta_time;
+    vel_x() -= effective_acceleration * delta_time;
 
     // Limitar velocidad máxima
-    float total_speed = std::sqrt(velocity_x * velocity_x + velocity_y * velocity_y);
+    float total_speed = std::sqrt(vel_x() * vel_x() + vel_y() * vel_y());
     if (total_speed > max_speed) {
         float scale = max_speed / total_speed;
-        velocity_x *= scale;
-        velocity_y *= scale;
+        vel_x() *= scale;
+        vel_y() *= scale;
     }
 
     // Actualizar ángulo para que apunte en la dirección del movimiento
     if (total_speed > 1.0f) {
-        angle = std::atan2(velocity_y, velocity_x);
+        heading() = std::atan2(vel_y(), vel_x());
     }
 
-    current_speed = total_speed;
-    x += velocity_x * delta_time;
-    y += velocity_y * delta_time;
+    // La posición la avanza CarPhysicsPool::integrate, así el barrido de paredes la ve
+    speed() = total_speed;
 }
 
 void Car::move_right(float delta_time) {
-    if (is_destroyed)
+    if (isDestroyed())
         return;
 
     float effective_acceleration = acceleration;
@@ -249,38 +273,37 @@ void Car::move_right(float delta_time) {
     }
 
     // Acelerar hacia la derecha (dirección X positiva)
-    velocity_x += effective_acceleration * delta_time;
+    vel_x() += effective_acceleration * delta_time;
 
     // Limitar velocidad máxima
-    float total_speed = std::sqrt(velocity_x * velocity_x + velocity_y * velocity_y);
+    float total_speed = std::sqrt(vel_x() * vel_x() + vel_y() * vel_y());
     if (total_speed > max_speed) {
         float scale = max_speed / total_speed;
-        velocity_x *= scale;
-        velocity_y *= scale;
+        vel_x() *= scale;
+        vel_y() *= scale;
     }
 
     // Actualizar ángulo para que apunte en la dirección del movimiento
     if (total_speed > 1.0f) {
-        angle = std::atan2(velocity_y, velocity_x);
+        heading() = std::atan2(vel_y(), vel_x());
     }
 
-    current_speed = total_speed;
-    x += velocity_x * delta_time;
-    y += velocity_y * delta_time;
+    // La posición la avanza CarPhysicsPool::integrate, así el barrido de paredes la ve
+    speed() = total_speed;
 }
 
 void Car::brake(float delta_time) {
-    if (is_destroyed)
+    if (isDestroyed())
         return;
     
     //Box2d
     //if (B2_IS_NULL(bodyId) || !b2Body_IsValid(bodyId)) return;
 
     float brake_force = acceleration * 2.0f;  // Frenar es más rápido que acelerar
-    current_speed = std::max(0.0f, current_speed - brake_force * delta_time);
+    speed() = std::max(0.0f, speed() - brake_force * delta_time);
 
-    velocity_x = current_speed * std::cos(angle);
-    velocity_y = current_speed * std::sin(angle);
+    vel_x() = speed() * std::cos(heading());
+    vel_y() = speed() * std::sin(heading());
 
     //En Box2D
     /*b2Vec2 currentVel = b2Body_GetLinearVelocity(bodyId);
@@ -290,71 +313,128 @@ void Car::brake(float delta_time) {
 }
 
 void Car::apply_friction(float delta_time) {
-    if (is_destroyed)
-        return;
+    // Fricción suave (factor cacheado en el pool) + integración de este slot
+    physics->apply_friction_one(physics_slot, delta_time);
+}
 
-    // Aplicar fricción suave: 95% de la velocidad por segundo
-    float friction_factor = std::pow(0.05f, delta_time);  // Más suave que brake
-    current_speed *= friction_factor;
+void Car::apply_input(uint8_t bits, uint8_t previous_bits, float delta_time) {
+    // Las 4 direcciones son mutuamente exclusivas (misma prioridad que el teclado)
+    if (bits & INPUT_UP) move_up(delta_time);
+    else if (bits & INPUT_DOWN) move_down(delta_time);
+    else if (bits & INPUT_LEFT) move_left(delta_time);
+    else if (bits & INPUT_RIGHT) move_right(delta_time);
 
-    // Parar completamente si la velocidad es muy baja
-    if (current_speed < 0.5f) {
-        current_speed = 0.0f;
-        velocity_x = 0.0f;
-        velocity_y = 0.0f;
-    } else {
-        // Actualizar componentes de velocidad según el ángulo actual
-        velocity_x = current_speed * std::cos(angle);
-        velocity_y = current_speed * std::sin(angle);
+    if (bits & INPUT_NITRO) activateNitro();
 
-        // Actualizar posición con la nueva velocidad
-        x += velocity_x * delta_time;
-        y += velocity_y * delta_time;
+    // Al soltar todo el auto se detiene, como hacía STOP_ALL
+    if (bits == 0 && previous_bits != 0) {
+        speed() = 0.0f;
+        vel_x() = 0.0f;
+        vel_y() = 0.0f;
     }
 }
 
+void Car::resolve_wall_collision(CollisionManager& walls, float old_x, float old_y) {
+    float new_x = getX();
+    float new_y = getY();
+
+    int current_level = 0;
+    CollisionResult col = walls.sweepCollision(old_x, old_y, new_x, new_y, current_level);
+    if (!col.is_wall) return;
+
+    float move_x = new_x - old_x;
+    float move_y = new_y - old_y;
+    float move_len = std::sqrt(move_x * move_x + move_y * move_y);
+
+    if (col.time_of_impact > 0.0f && move_len > 0.0f) {
+        // Avanzamos hasta justo antes del impacto (medio píxel)
+        float t = std::max(0.0f, col.time_of_impact - 0.5f / move_len);
+        setPosition(old_x + move_x * t, old_y + move_y * t);
+    } else {
+        // Ya estaba dentro: con SDF lo sacamos a lo largo de la normal
+        float push = col.penetration + 0.5f;
+        float out_x = old_x + col.normal_x * push;
+        float out_y = old_y + col.normal_y * push;
+        float free_x = old_x;
+        float free_y = old_y;
+        // Con toi 0 también se llega pegado al borde de una celda libre: ahí no hay que sacarlo
+        bool inside = walls.isWall((int)std::floor(old_x), (int)std::floor(old_y), current_level);
+        if (col.penetration > 0.0f &&
+            !walls.isWall((int)std::floor(out_x), (int)std::floor(out_y), current_level)) {
+            setPosition(out_x, out_y);
+        } else if (!inside) {
+            setPosition(old_x, old_y);
+        } else if (!walls.isWall((int)std::floor(new_x), (int)std::floor(new_y),
+                                 current_level)) {
+            // Sin SDF no hay penetración: dejamos pasar el paso que lo saca de la pared
+            setPosition(new_x, new_y);
+        } else if (walls.nearestFreeCell(old_x, old_y, current_level, UNSTUCK_RADIUS, free_x,
+                                         free_y)) {
+            // Si no, a la celda libre más cercana; volver a old_x/old_y lo dejaría trabado
+            setPosition(free_x, free_y);
+        } else {
+            setPosition(old_x, old_y);
+        }
+    }
+    is_colliding = true;
+
+    float vx = vel_x();
+    float vy = vel_y();
+    float dot = vx * col.normal_x + vy * col.normal_y;
+    float elasticity = 0.5f;
+
+    // Solo rebota si va contra la pared; saliendo de ella no se lo vuelve a meter
+    if (dot < 0.0f) {
+        vel_x() = vx - (1.0f + elasticity) * dot * col.normal_x;
+        vel_y() = vy - (1.0f + elasticity) * dot * col.normal_y;
+        speed() *= 0.5f;
+    }
+
+    // if (current_speed > 50.0f) takeDamage(10.0f);
+}
+
 void Car::turn_left(float delta_time) {
-    if (is_destroyed || current_speed < 5.0f)
+    if (isDestroyed() || speed() < 5.0f)
         return;  // No girar si está muy lento
 
     float turn_rate = handling * delta_time;
-    angle -= turn_rate;
+    heading() -= turn_rate;
 
     // Normalizar ángulo
-    while (angle < 0)
-        angle += 2.0f * M_PI;
-    while (angle >= 2.0f * M_PI)
-        angle -= 2.0f * M_PI;
+    while (heading() < 0)
+        heading() += 2.0f * M_PI;
+    while (heading() >= 2.0f * M_PI)
+        heading() -= 2.0f * M_PI;
 }
 
 void Car::turn_right(float delta_time) {
-    if (is_destroyed || current_speed < 5.0f)
+    if (isDestroyed() || speed() < 5.0f)
         return;
 
     float turn_rate = handling * delta_time;
-    angle += turn_rate;
+    heading() += turn_rate;
 
     // Normalizar ángulo
-    while (angle < 0)
-        angle += 2.0f * M_PI;
-    while (angle >= 2.0f * M_PI)
-        angle -= 2.0f * M_PI;
+    while (heading() < 0)
+        heading() += 2.0f * M_PI;
+    while (heading() >= 2.0f * M_PI)
+        heading() -= 2.0f * M_PI;
 }
 
 // resetear para una nueva carrera
 void Car::reset() {
-    current_speed = 0.0f;
+    speed() = 0.0f;
     current_health = max_durability;
     nitro_amount = 100.0f;
     nitro_active = false;
-    x = 0.0f;
-    y = 0.0f;
-    angle = 0.0f;
-    velocity_x = 0.0f;
-    velocity_y = 0.0f;
+    pos_x() = 0.0f;
+    pos_y() = 0.0f;
+    heading() = 0.0f;
+    vel_x() = 0.0f;
+    vel_y() = 0.0f;
     is_drifting = false;
     is_colliding = false;
-    is_destroyed = false;
+    physics->alive[physics_slot] = 1.0f;
 
     std::cout << "[Car] " << model_name << " reseteado" << std::endl;
 }
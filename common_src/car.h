@@ -2,20 +2,34 @@
 #define CAR_H
 
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
 
+#include "car_physics_pool.h"
+
+class CollisionManager;
+
 /*
  * Car: Representa un auto con física y stats
  * - Maneja posición, velocidad, ángulo (física)
  * - Stats específicos del modelo (cargados desde config.yaml)
  * - Salud, nitro, estado
  * - Encapsula el cuerpo de Box2D cuando se implemente
+ *
+ * La cinemática (posición, ángulo, velocidades) NO vive en el Car: es una
+ * vista sobre un slot de un CarPhysicsPool (SoA). Un Car suelto usa un pool
+ * propio de un slot; el GameLoop lo engancha al suyo con attach_physics().
+ *
+ * Es código compartido: el cliente corre la misma física sobre su propio
+ * auto para predecir el movimiento (ver client_src/game/car_predictor.h).
  */
 class Car {
 private:
     // ---- IDENTIFICACIÓN ----
     std::string model_name;  // Ej: "Leyenda Urbana", "Stallion GT"
     std::string car_type;    // Ej: "classic", "sport", "muscle"
+    uint8_t model_id;        // Id en el CarCatalog (0xFF si no está)
 
     // ---- STATS DEL AUTO (cargar desde config.yaml) ----
     float max_speed;       // Velocidad máxima
@@ -26,17 +40,23 @@ private:
     float weight;          // Peso (afecta física)
 
     // ---- ESTADO ACTUAL ----
-    float current_speed;   // Velocidad actual
     float current_health;  // Salud actual
     float nitro_amount;    // Cantidad de nitro restante (0-100)
     bool nitro_active;     // Si está usando nitro
 
-    // ---- FÍSICA Y POSICIÓN ----
-    float x;           // Posición X
-    float y;           // Posición Y
-    float angle;       // Ángulo de rotación (radianes)
-    float velocity_x;  // Velocidad en X
-    float velocity_y;  // Velocidad en Y
+    // ---- FÍSICA Y POSICIÓN (vista sobre el pool SoA) ----
+    std::unique_ptr<CarPhysicsPool> own_physics;  // solo si no está enganchado
+    CarPhysicsPool* physics;
+    size_t physics_slot;
+
+    float& pos_x() { return physics->x[physics_slot]; }
+    float& pos_y() { return physics->y[physics_slot]; }
+    float& heading() { return physics->angle[physics_slot]; }
+    float& vel_x() { return physics->velocity_x[physics_slot]; }
+    float& vel_y() { return physics->velocity_y[physics_slot]; }
+    float& speed() { return physics->speed[physics_slot]; }
+
+    friend class CarPhysicsPool;
 
     // ---- BOX2D ----
     // b2BodyId bodyId; 
@@ -45,36 +65,42 @@ private:
     // ---- ESTADO ----
     bool is_drifting;
     bool is_colliding;
-    bool is_destroyed;
 
 public:
     // ---- CONSTRUCTOR ----
     Car(const std::string& model, const std::string& type);
 
+    Car(const Car&) = delete;
+    Car& operator=(const Car&) = delete;
+
+    // Mueve la cinemática del auto a un slot de `pool` (el pool debe vivir más que el Car)
+    void attach_physics(CarPhysicsPool& pool);
+    size_t getPhysicsSlot() const { return physics_slot; }
+
     // ---- CONFIGURAR STATS (desde config.yaml) ----
     void load_stats(float max_spd, float accel, float hand, float durability, float nitro,
                     float wgt);
 
     // ---- FÍSICA Y MOVIMIENTO ----
     void setPosition(float nx, float ny) {
-        x = nx;
-        y = ny;
+        pos_x() = nx;
+        pos_y() = ny;
     }
-    float getX() const { return x; }
-    float getY() const { return y; }
+    float getX() const { return physics->x[physics_slot]; }
+    float getY() const { return physics->y[physics_slot]; }
 
     void setVelocity(float vx, float vy) {
-        velocity_x = vx;
-        velocity_y = vy;
+        vel_x() = vx;
+        vel_y() = vy;
     }
-    float getVelocityX() const { return velocity_x; }
-    float getVelocityY() const { return velocity_y; }
+    float getVelocityX() const { return physics->velocity_x[physics_slot]; }
+    float getVelocityY() const { return physics->velocity_y[physics_slot]; }
 
-    float getAngle() const { return angle; }
-    void setAngle(float angle_) { angle = angle_; }
+    float getAngle() const { return physics->angle[physics_slot]; }
+    void setAngle(float angle_) { heading() = angle_; }
 
-    float getCurrentSpeed() const { return current_speed; }
-    void setCurrentSpeed(float speed) { current_speed = speed; }
+    float getCurrentSpeed() const { return physics->speed[physics_slot]; }
+    void setCurrentSpeed(float new_speed) { speed() = new_speed; }
 
     // ---- STATS ----
     float getMaxSpeed() const { return max_speed; }
@@ -86,11 +112,15 @@ public:
     float getHealth() const { return current_health; }
     void takeDamage(float damage);
     void repair(float amount);
-    bool isDestroyed() const { return is_destroyed; }
+    bool isDestroyed() const { return physics->alive[physics_slot] == 0.0f; }
 
     // ---- NITRO ----
     float getNitroAmount() const { return nitro_amount; }
     bool isNitroActive() const { return nitro_active; }
+    void setNitro(float amount, bool active) {
+        nitro_amount = amount;
+        nitro_active = active;
+    }
     void activateNitro();
     void deactivateNitro();
     void rechargeNitro(float amount);
@@ -108,9 +138,18 @@ public:
     void move_left(float delta_time);   // Izquierda (←)
     void move_right(float delta_time);  // Derecha (→)
 
+    /*
+     * Aplica un tick de controles (máscara INPUT_*). `previous_bits` es lo
+     * aplicado en el tick anterior: al soltar todo el auto se detiene.
+     */
+    void apply_input(uint8_t bits, uint8_t previous_bits, float delta_time);
+
     // ---- FÍSICA ----
     void apply_friction(float delta_time);  // Desaceleración gradual
 
+    // Si el tramo (old_x, old_y) -> posición actual cruza una pared, rebota contra ella
+    void resolve_wall_collision(CollisionManager& walls, float old_x, float old_y);
+
     // ---- ESTADO ----
     void setDrifting(bool drifting) { is_drifting = drifting; }
     bool isDrifting() const { return is_drifting; }
@@ -133,8 +172,10 @@ public:
     // ---- GETTERS ----
     const std::string& getModelName() const { return model_name; }
     const std::string& getCarType() const { return car_type; }
+    uint8_t getModelId() const { return model_id; }
+    void setModelId(uint8_t id) { model_id = id; }
 
-    ~Car() = default;
+    ~Car();
 };
 
 #endif  // CAR_H
@@ -0,0 +1,92 @@
+#include "car_catalog.h"
+
+#include <iostream>
+#include <mutex>
+#include <utility>
+
+#include "config.h"
+
+namespace {
+
+std::once_flag catalog_once;
+CarCatalog shared_catalog;
+
+// Misma conversión que usaba GameLoop::add_player
+void derive_stats(CarModel& model, float speed_scale, float accel_scale) {
+    model.max_speed = static_cast<float>(model.speed) * speed_scale * 1.5f;
+    model.accel_power = static_cast<float>(model.acceleration) * accel_scale * 0.8f;
+    model.turn_rate = static_cast<float>(model.handling) * 1.0f / 100.0f;
+    model.nitro_boost = 2.0f;
+    model.mass = 1000.0f + (static_cast<float>(model.durability) * 5.0f);
+}
+
+}  // namespace
+
+CarCatalog::CarCatalog() {
+    fallback = CarModel{UNKNOWN_CAR, "", "", "", 0, 0, 0, 0,
+                        100.0f, 50.0f, 1.0f, 100.0f, 2.0f, 1000.0f};
+}
+
+CarCatalog CarCatalog::from_yaml(const YAML::Node& cars, float speed_scale,
+                                 float accel_scale) {
+    CarCatalog catalog;
+    catalog.fallback.max_speed *= speed_scale;
+    catalog.fallback.accel_power *= accel_scale;
+
+    if (!cars || !cars.IsSequence()) {
+        std::cerr << "[CarCatalog] 'cars' no encontrado en la configuración" << std::endl;
+        return catalog;
+    }
+
+    for (const auto& node : cars) {
+        if (catalog.models.size() >= UNKNOWN_CAR) {
+            std::cerr << "[CarCatalog] Demasiados autos, se ignoran los restantes" << std::endl;
+            break;
+        }
+
+        CarModel model{};
+        model.id = static_cast<uint8_t>(catalog.models.size());
+        model.name = node["name"].as<std::string>();
+        model.image_path = node["image_path"] ? node["image_path"].as<std::string>() : "";
+        model.type = node["type"] ? node["type"].as<std::string>() : "";
+        model.speed = node["speed"].as<int>();
+        model.acceleration = node["acceleration"].as<int>();
+        model.handling = node["handling"].as<int>();
+        model.durability = node["durability"].as<int>();
+        model.health = node["health"] ? node["health"].as<float>()
+                                      : static_cast<float>(model.durability);
+        derive_stats(model, speed_scale, accel_scale);
+
+        // Ante nombres repetidos gana el primero (como el recorrido lineal anterior)
+        catalog.ids_by_name.emplace(model.name, model.id);
+        catalog.models.push_back(std::move(model));
+    }
+
+    std::cout << "[CarCatalog] " << catalog.models.size() << " modelos cargados" << std::endl;
+    return catalog;
+}
+
+uint8_t CarCatalog::id_of(const std::string& name) const {
+    auto it = ids_by_name.find(name);
+    return it != ids_by_name.end() ? it->second : UNKNOWN_CAR;
+}
+
+const CarCatalog& CarCatalog::instance() {
+    std::call_once(catalog_once, [] {
+        try {
+            float speed_scale = 1.0f;
+            float accel_scale = 1.0f;
+            try {
+                speed_scale = Configuration::get<float>("vehicle_speed_scale");
+            } catch (const std::exception&) {}
+            try {
+                accel_scale = Configuration::get<float>("vehicle_accel_scale");
+            } catch (const std::exception&) {}
+            shared_catalog = from_yaml(Configuration::get_node("cars"), speed_scale, accel_scale);
+        } catch (const std::exception& e) {
+            std::cerr << "[CarCatalog] Configuración no disponible, catálogo vacío: " << e.what()
+                      << std::endl;
+        }
+    });
+    return shared_catalog;
+}
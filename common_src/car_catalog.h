@@ -0,0 +1,72 @@
+#ifndef CAR_CATALOG_H
+#define CAR_CATALOG_H
+
+#include <yaml-cpp/yaml.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Modelo de auto de la sección `cars:` de config.yaml
+struct CarModel {
+    uint8_t id;
+    std::string name;
+    std::string image_path;
+    std::string type;  // "classic", "sport", "truck"...
+
+    // Stats tal como están en el YAML (los muestra el garage)
+    int speed;
+    int acceleration;
+    int handling;
+    int durability;
+
+    // Stats derivados ya escalados, listos para Car::load_stats
+    float max_speed;
+    float accel_power;
+    float turn_rate;
+    float health;
+    float nitro_boost;
+    float mass;
+};
+
+/*
+ * CarCatalog: todos los modelos de auto, construido UNA vez al arrancar.
+ *
+ * Cada modelo tiene un id compacto (su posición en `cars:`), así que Match y
+ * GameLoop resuelven stats por índice y el nombre solo se busca una vez, al
+ * elegir el auto en el lobby. Unirse a una partida no toca el disco.
+ */
+class CarCatalog {
+private:
+    std::vector<CarModel> models;
+    std::unordered_map<std::string, uint8_t> ids_by_name;
+    CarModel fallback;  // Stats por defecto para autos que no están en el catálogo
+
+public:
+    static constexpr uint8_t UNKNOWN_CAR = 0xFF;
+
+    CarCatalog();
+
+    // `cars` es la secuencia de config.yaml; las escalas son vehicle_*_scale
+    static CarCatalog from_yaml(const YAML::Node& cars, float speed_scale, float accel_scale);
+
+    // UNKNOWN_CAR si el nombre no está en el catálogo
+    uint8_t id_of(const std::string& name) const;
+
+    // O(1); para ids desconocidos devuelve los stats por defecto
+    const CarModel& get(uint8_t id) const {
+        return id < models.size() ? models[id] : fallback;
+    }
+
+    const std::vector<CarModel>& all() const { return models; }
+    size_t size() const { return models.size(); }
+
+    /*
+     * Instancia compartida del proceso, construida desde Configuration la
+     * primera vez que se usa (el servidor la fuerza al arrancar).
+     */
+    static const CarCatalog& instance();
+};
+
+#endif  // CAR_CATALOG_H
@@ -0,0 +1,128 @@
+#include "car_physics_pool.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "car.h"
+
+CarPhysicsPool::CarPhysicsPool() : friction_dt(-1.0f), friction_factor(1.0f) {}
+
+size_t CarPhysicsPool::allocate(Car* owner) {
+    owners.push_back(owner);
+    x.push_back(0.0f);
+    y.push_back(0.0f);
+    angle.push_back(0.0f);
+    velocity_x.push_back(0.0f);
+    velocity_y.push_back(0.0f);
+    speed.push_back(0.0f);
+    old_x.push_back(0.0f);
+    old_y.push_back(0.0f);
+    alive.push_back(1.0f);
+    return owners.size() - 1;
+}
+
+void CarPhysicsPool::release(size_t slot) {
+    const size_t last = owners.size() - 1;
+    if (slot != last) {
+        // Mantener los arreglos densos: el último ocupa el hueco
+        owners[slot] = owners[last];
+        x[slot] = x[last];
+        y[slot] = y[last];
+        angle[slot] = angle[last];
+        velocity_x[slot] = velocity_x[last];
+        velocity_y[slot] = velocity_y[last];
+        speed[slot] = speed[last];
+        old_x[slot] = old_x[last];
+        old_y[slot] = old_y[last];
+        alive[slot] = alive[last];
+        owners[slot]->physics_slot = slot;
+    }
+    owners.pop_back();
+    x.pop_back();
+    y.pop_back();
+    angle.pop_back();
+    velocity_x.pop_back();
+    velocity_y.pop_back();
+    speed.pop_back();
+    old_x.pop_back();
+    old_y.pop_back();
+    alive.pop_back();
+}
+
+float CarPhysicsPool::friction_for(float delta_time) {
+    if (delta_time != friction_dt) {
+        // Fricción suave: conserva el 5% de la velocidad por segundo
+        friction_factor = std::pow(0.05f, delta_time);
+        friction_dt = delta_time;
+    }
+    return friction_factor;
+}
+
+// ==========================================================
+// KERNELS
+// ==========================================================
+
+void CarPhysicsPool::integrate(float delta_time) {
+    const size_t n = size();
+    for (size_t i = 0; i < n; ++i) {
+        old_x[i] = x[i];
+        old_y[i] = y[i];
+
+        // Los destruidos (alive = 0) conservan su velocidad y no se mueven
+        const float m = alive[i];
+        const float vx = speed[i] * std::cos(angle[i]);
+        const float vy = speed[i] * std::sin(angle[i]);
+        velocity_x[i] = m * vx + (1.0f - m) * velocity_x[i];
+        velocity_y[i] = m * vy + (1.0f - m) * velocity_y[i];
+
+        x[i] += m * velocity_x[i] * delta_time;
+        y[i] += m * velocity_y[i] * delta_time;
+    }
+}
+
+void CarPhysicsPool::apply_friction(float delta_time) {
+    const float factor = friction_for(delta_time);
+    const size_t n = size();
+    for (size_t i = 0; i < n; ++i) {
+        const float m = alive[i];
+        const float decayed = speed[i] * (m * factor + (1.0f - m));
+        // Parar completamente si la velocidad es muy baja (los destruidos quedan como están)
+        const float keep = decayed < 0.5f ? 1.0f - m : 1.0f;
+        speed[i] = decayed * keep;
+        velocity_x[i] *= keep;
+        velocity_y[i] *= keep;
+    }
+}
+
+void CarPhysicsPool::clamp_to_bounds(float max_x, float max_y) {
+    const size_t n = size();
+    for (size_t i = 0; i < n; ++i) {
+        x[i] = std::min(std::max(x[i], 0.0f), max_x);
+        y[i] = std::min(std::max(y[i], 0.0f), max_y);
+    }
+}
+
+void CarPhysicsPool::integrate_one(size_t slot, float delta_time) {
+    if (alive[slot] == 0.0f) return;
+
+    // recalcular componentes de velocidad por si no se actualizan en accelerate/brake
+    velocity_x[slot] = speed[slot] * std::cos(angle[slot]);
+    velocity_y[slot] = speed[slot] * std::sin(angle[slot]);
+
+    x[slot] += velocity_x[slot] * delta_time;
+    y[slot] += velocity_y[slot] * delta_time;
+}
+
+void CarPhysicsPool::apply_friction_one(size_t slot, float delta_time) {
+    if (alive[slot] == 0.0f) return;
+
+    speed[slot] *= friction_for(delta_time);
+
+    if (speed[slot] < 0.5f) {
+        speed[slot] = 0.0f;
+        velocity_x[slot] = 0.0f;
+        velocity_y[slot] = 0.0f;
+    } else {
+        integrate_one(slot, delta_time);
+    }
+}
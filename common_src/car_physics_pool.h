@@ -0,0 +1,67 @@
+#ifndef CAR_PHYSICS_POOL_H
+#define CAR_PHYSICS_POOL_H
+
+#include <cstddef>
+#include <vector>
+
+// Límites del mapa en px (clamp_to_bounds); el cliente los usa al predecir
+#define MAP_LIMIT_X 4640.0f
+#define MAP_LIMIT_Y 4672.0f
+
+class Car;
+
+/*
+ * CarPhysicsPool: estado cinemático de TODOS los autos en estructura de
+ * arreglos (SoA), contiguo en memoria.
+ *
+ * Cada Car es una vista sobre un slot del pool. Los kernels recorren los
+ * arreglos en orden y sin ramas (los autos destruidos se enmascaran con
+ * `alive`), así el compilador puede vectorizarlos y el costo por tick crece
+ * linealmente y sin saltos de caché al sumar jugadores o NPCs.
+ *
+ * Los slots se mantienen densos: al liberar uno se mueve el último a su
+ * lugar y se actualiza el Car dueño.
+ */
+class CarPhysicsPool {
+private:
+    std::vector<Car*> owners;
+
+    // Cache de la fricción: std::pow solo cuando cambia el dt
+    float friction_dt;
+    float friction_factor;
+
+public:
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> angle;       // radianes
+    std::vector<float> velocity_x;
+    std::vector<float> velocity_y;
+    std::vector<float> speed;       // velocidad escalar (current_speed)
+    std::vector<float> old_x;       // posición antes del último integrate()
+    std::vector<float> old_y;
+    std::vector<float> alive;       // 1.0f vivo, 0.0f destruido (máscara)
+
+    CarPhysicsPool();
+
+    CarPhysicsPool(const CarPhysicsPool&) = delete;
+    CarPhysicsPool& operator=(const CarPhysicsPool&) = delete;
+
+    size_t allocate(Car* owner);
+    void release(size_t slot);
+
+    size_t size() const { return owners.size(); }
+    Car* owner(size_t slot) const { return owners[slot]; }
+
+    // ---- KERNELS (sobre todos los slots) ----
+    void integrate(float delta_time);
+    void apply_friction(float delta_time);
+    void clamp_to_bounds(float max_x, float max_y);
+
+    // Kernels de un solo slot (para comandos individuales)
+    void integrate_one(size_t slot, float delta_time);
+    void apply_friction_one(size_t slot, float delta_time);
+
+    float friction_for(float delta_time);
+};
+
+#endif  // CAR_PHYSICS_POOL_H
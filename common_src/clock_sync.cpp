@@ -0,0 +1,75 @@
+#include "clock_sync.h"
+
+#include <algorithm>
+#include <cmath>
+
+ClockSync::ClockSync() { reset(); }
+
+void ClockSync::reset() {
+    srtt_us = 0.0f;
+    rttvar_us = 0.0f;
+    jitter_us = 0.0f;
+    last_rtt_us = 0.0f;
+    offset_us = 0.0;
+    samples = 0;
+    tick = 0;
+    tick_at_us = 0;
+    tick_rate = 0.0;
+}
+
+void ClockSync::on_pong(uint64_t t0, uint64_t t1, uint64_t t2, uint64_t t3,
+                        uint32_t server_tick) {
+    // Diferencias con signo: los relojes de cada lado no comparten época
+    const int64_t round_trip = static_cast<int64_t>(t3 - t0);
+    const int64_t server_hold = static_cast<int64_t>(t2 - t1);
+    if (round_trip < 0 || server_hold < 0) return;
+    const float rtt = static_cast<float>(std::max<int64_t>(0, round_trip - server_hold));
+    const double offset = (static_cast<double>(static_cast<int64_t>(t1 - t0)) +
+                           static_cast<double>(static_cast<int64_t>(t2 - t3))) /
+                          2.0;
+
+    if (samples == 0) {
+        srtt_us = rtt;
+        rttvar_us = rtt / 2.0f;
+        offset_us = offset;
+    } else {
+        // Muestras muy por encima de lo normal estuvieron en una cola: el offset sale torcido
+        if (rtt <= srtt_us + 2.0f * rttvar_us) offset_us += (offset - offset_us) / 8.0;
+
+        jitter_us += (std::fabs(rtt - last_rtt_us) - jitter_us) / 16.0f;
+        rttvar_us += (std::fabs(srtt_us - rtt) - rttvar_us) / 4.0f;
+        srtt_us += (rtt - srtt_us) / 8.0f;
+    }
+    last_rtt_us = rtt;
+
+    // Ritmo de ticks entre dos pongs; si el tick volvió atrás (partida nueva) se empieza de cero
+    if (samples > 0 && server_tick >= tick && t2 > tick_at_us) {
+        const double rate =
+                static_cast<double>(server_tick - tick) / static_cast<double>(t2 - tick_at_us);
+        tick_rate = tick_rate == 0.0 ? rate : tick_rate + (rate - tick_rate) / 4.0;
+    } else {
+        tick_rate = 0.0;
+    }
+    tick = server_tick;
+    tick_at_us = t2;
+    ++samples;
+}
+
+uint64_t ClockSync::to_server_time(uint64_t local_us) const {
+    return static_cast<uint64_t>(static_cast<int64_t>(local_us) + std::llround(offset_us));
+}
+
+LinkStats ClockSync::stats(uint64_t now_us) const {
+    LinkStats link;
+    link.samples = samples;
+    if (samples == 0) return link;
+
+    link.rtt_ms = srtt_us / 1000.0f;
+    link.jitter_ms = jitter_us / 1000.0f;
+    link.clock_offset_ms = static_cast<float>(offset_us / 1000.0);
+
+    const int64_t since = static_cast<int64_t>(to_server_time(now_us) - tick_at_us);
+    link.server_tick = tick;
+    if (since > 0) link.server_tick += static_cast<uint32_t>(std::llround(tick_rate * since));
+    return link;
+}
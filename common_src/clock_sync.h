@@ -0,0 +1,89 @@
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <chrono>
+#include <cstdint>
+
+/*
+ * Medición del enlace y sincronización de relojes (estilo NTP).
+ *
+ * Durante la partida el cliente manda cada PING_INTERVAL_MS un CMD_PING por
+ * TCP con la hora de envío t0; el servidor contesta con un PONG que repite
+ * t0 y agrega t1 (cuándo leyó el ping), t2 (cuándo mandó la respuesta) y
+ * su tick actual. Con t3 (la llegada del PONG):
+ *
+ *   rtt    = (t3 - t0) - (t2 - t1)
+ *   offset = ((t1 - t0) + (t2 - t3)) / 2     (reloj servidor - reloj cliente)
+ *
+ * Las horas son microsegundos de steady_clock de cada lado: no tienen una
+ * época común, justamente el offset es lo que las relaciona.
+ *
+ * El ping también lleva el RTT y el jitter que ya estimó el cliente, así el
+ * servidor los tiene por conexión sin medir nada por su cuenta.
+ * */
+
+// Cada cuánto manda el cliente un ping
+#define PING_INTERVAL_MS 500
+
+// Cuerpo de CMD_PING: u32 id | u64 t0 | u32 rtt_us | u32 jitter_us
+#define PING_SIZE 20
+
+// Cuerpo de PONG: u32 id | u64 t0 | u64 t1 | u64 t2 | u32 tick del servidor.
+// El tick cuenta pasos de simulación desde el inicio de la partida
+// (simulation_rate_hz por segundo), no snapshots enviados.
+#define PONG_SIZE 32
+
+// Estado del enlace de una conexión (lo muestran el HUD y el servidor)
+struct LinkStats {
+    float rtt_ms = 0.0f;           // ida y vuelta suavizado
+    float jitter_ms = 0.0f;        // variación media entre RTT consecutivos
+    float clock_offset_ms = 0.0f;  // reloj del servidor - reloj del cliente
+    uint32_t server_tick = 0;      // tick de simulación del servidor estimado para ahora
+    uint32_t samples = 0;          // pongs procesados (0: todavía sin datos)
+};
+
+// Hora local en microsegundos (steady_clock), la que viaja en PING/PONG
+inline uint64_t link_clock_us() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+}
+
+/*
+ * Estimador del lado del cliente. El RTT se suaviza como en TCP (RFC 6298),
+ * el jitter como en RTP (RFC 3550) y el offset solo con muestras de RTT
+ * normal: un pong demorado en una cola dice poco de los relojes.
+ *
+ * El tick del servidor avanza con un ritmo que se estima entre pongs, así
+ * `stats` puede proyectarlo a cualquier momento. No es thread-safe.
+ * */
+class ClockSync {
+private:
+    float srtt_us;
+    float rttvar_us;
+    float jitter_us;
+    float last_rtt_us;
+    double offset_us;
+    uint32_t samples;
+
+    // Último tick informado, en hora del servidor, y ticks por microsegundo
+    uint32_t tick;
+    uint64_t tick_at_us;
+    double tick_rate;
+
+public:
+    ClockSync();
+
+    // Un PONG con las cuatro marcas (t3: llegada, hora local)
+    void on_pong(uint64_t t0, uint64_t t1, uint64_t t2, uint64_t t3, uint32_t server_tick);
+
+    // Hora del servidor que corresponde a `local_us`
+    uint64_t to_server_time(uint64_t local_us) const;
+
+    LinkStats stats(uint64_t now_us) const;
+
+    // Olvida lo medido (p. ej. al reconectar)
+    void reset();
+};
+
+#endif  // CLOCK_SYNC_H
@@ -0,0 +1,54 @@
+#include "collision_data.h"
+
+#include <SDL_image.h>
+
+#include <iostream>
+#include <stdexcept>
+
+void CollisionData::bake_distance_fields(int cell_size) {
+    distance_fields.clear();
+    distance_fields.emplace_back(grid, 0, cell_size);
+    distance_fields.emplace_back(grid, 1, cell_size);
+}
+
+std::shared_ptr<const CollisionData> CollisionData::load(const std::string& pathCamino,
+                                                         const std::string& pathPuentes,
+                                                         const std::string& pathRampas,
+                                                         bool with_distance_fields) {
+    SDL_Surface* layerCamino = IMG_Load(pathCamino.c_str());
+    SDL_Surface* layerPuente = IMG_Load(pathPuentes.c_str());
+    SDL_Surface* layerRampas = pathRampas.empty() ? nullptr : IMG_Load(pathRampas.c_str());
+
+    if (!layerCamino || !layerPuente) {
+        std::string error = IMG_GetError();
+        if (layerCamino) SDL_FreeSurface(layerCamino);
+        if (layerPuente) SDL_FreeSurface(layerPuente);
+        if (layerRampas) SDL_FreeSurface(layerRampas);
+        throw std::runtime_error("Error al cargar imágenes: " + error);
+    }
+
+    const bool has_ramps = layerRampas != nullptr;
+    auto data = std::make_shared<CollisionData>();
+    try {
+        data->grid = CollisionGrid(layerCamino, layerPuente, layerRampas);
+    } catch (...) {
+        SDL_FreeSurface(layerCamino);
+        SDL_FreeSurface(layerPuente);
+        if (layerRampas) SDL_FreeSurface(layerRampas);
+        throw;
+    }
+
+    // Los píxeles ya no se necesitan: solo queda la grilla de bits
+    SDL_FreeSurface(layerCamino);
+    SDL_FreeSurface(layerPuente);
+    if (layerRampas) SDL_FreeSurface(layerRampas);
+
+    if (with_distance_fields) {
+        data->bake_distance_fields();
+    }
+
+    std::cout << "[CollisionData] Capas decodificadas (" << data->grid.GetWidth() << "x"
+              << data->grid.GetHeight() << (has_ramps ? ", con rampas" : ", sin rampas")
+              << (with_distance_fields ? ", con SDF" : "") << ")" << std::endl;
+    return data;
+}
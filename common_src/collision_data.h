@@ -0,0 +1,33 @@
+#ifndef COLLISION_DATA_H
+#define COLLISION_DATA_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "collision_grid.h"
+#include "distance_field.h"
+
+/*
+ * Datos de colisión de un mapa ya decodificados: grilla de bits por capa y
+ * (opcional) un SDF por nivel. Una vez construidos son inmutables, así que
+ * se comparten entre carreras y partidas como shared_ptr<const CollisionData>.
+ */
+struct CollisionData {
+    CollisionGrid grid;
+    std::vector<DistanceField> distance_fields;  // vacío o {suelo, puente}
+
+    // Hornea el SDF de ambos niveles sobre la grilla
+    void bake_distance_fields(int cell_size = 2);
+
+    /**
+     * Carga y decodifica las capas PNG (IMG_Load). Lanza runtime_error si
+     * faltan camino/puentes. `pathRampas` puede estar vacío.
+     */
+    static std::shared_ptr<const CollisionData> load(const std::string& pathCamino,
+                                                     const std::string& pathPuentes,
+                                                     const std::string& pathRampas,
+                                                     bool with_distance_fields);
+};
+
+#endif  // COLLISION_DATA_H
@@ -0,0 +1,66 @@
+#include "collision_grid.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+CollisionGrid::CollisionGrid() : width(0), height(0), words_per_layer(0) {}
+
+CollisionGrid::CollisionGrid(SDL_Surface* camino, SDL_Surface* puentes, SDL_Surface* rampas)
+    : width(0), height(0), words_per_layer(0) {
+    if (!camino || !puentes) {
+        throw std::runtime_error("CollisionGrid: capas de camino/puentes inválidas");
+    }
+
+    width = static_cast<uint32_t>(camino->w);
+    height = static_cast<uint32_t>(camino->h);
+    words_per_layer = (static_cast<size_t>(width) * height + 63) / 64;
+    bits.assign(words_per_layer * LAYER_COUNT, 0);
+
+    decode_layer(camino, LAYER_GROUND);
+    decode_layer(puentes, LAYER_BRIDGE);
+
+    if (rampas) {
+        decode_layer(rampas, LAYER_RAMP);
+    } else {
+        // Sin capa de rampas: rampa = suelo && puente (mismo criterio que antes)
+        const uint64_t* ground = bits.data() + LAYER_GROUND * words_per_layer;
+        const uint64_t* bridge = bits.data() + LAYER_BRIDGE * words_per_layer;
+        uint64_t* ramp = bits.data() + LAYER_RAMP * words_per_layer;
+        for (size_t i = 0; i < words_per_layer; ++i) {
+            ramp[i] = ground[i] & bridge[i];
+        }
+    }
+}
+
+void CollisionGrid::decode_layer(SDL_Surface* surface, CollisionLayer layer) {
+    // Convertimos a RGBA32 una sola vez: en memoria queda R, G, B, A por píxel
+    // sin importar el formato original del PNG (paleta, 24 bits, etc.)
+    SDL_Surface* rgba = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+    if (!rgba) {
+        throw std::runtime_error("CollisionGrid: error convirtiendo capa: " +
+                                 std::string(SDL_GetError()));
+    }
+
+    if (SDL_MUSTLOCK(rgba)) SDL_LockSurface(rgba);
+
+    // Las capas deberían medir lo mismo; si no, lo que sobra queda en 0 (pared)
+    const uint32_t w = std::min(width, static_cast<uint32_t>(rgba->w));
+    const uint32_t h = std::min(height, static_cast<uint32_t>(rgba->h));
+    uint64_t* plane = bits.data() + layer * words_per_layer;
+
+    for (uint32_t y = 0; y < h; ++y) {
+        const Uint8* row = static_cast<const Uint8*>(rgba->pixels) +
+                           static_cast<size_t>(y) * rgba->pitch;
+        const size_t base = static_cast<size_t>(y) * width;
+        for (uint32_t x = 0; x < w; ++x) {
+            // Asumimos que blanco/claro es transitable
+            const uint64_t on = row[x * 4] > 128;
+            const size_t idx = base + x;
+            plane[idx >> 6] |= on << (idx & 63);
+        }
+    }
+
+    if (SDL_MUSTLOCK(rgba)) SDL_UnlockSurface(rgba);
+    SDL_FreeSurface(rgba);
+}
@@ -1,12 +1,25 @@
 #include "collision_manager.h"
 #include <SDL_image.h>
 #include <iostream>
+#include <algorithm>
 #include <cmath>
 
 CollisionManager::CollisionManager(const std::string& pathCamino, 
                                    const std::string& pathPuentes,
-                                   const std::string& pathRampas) {
+                                   const std::string& pathRampas,
+                                   bool decode_grid)
+    : use_grid(decode_grid), width(0), height(0) {
     try {
+        if (use_grid) {
+            // Modo pre-decodificado: no se guardan superficies, solo la grilla
+            data = CollisionData::load(pathCamino, pathPuentes, pathRampas, false);
+            width = data->grid.GetWidth();
+            height = data->grid.GetHeight();
+            std::cout << "[CollisionManager] Inicializado correctamente (" 
+                      << GetWidth() << "x" << GetHeight() << ")" << std::endl;
+            return;
+        }
+
         SDL_Surface* layerCamino = IMG_Load(pathCamino.c_str());
         SDL_Surface* layerPuente = IMG_Load(pathPuentes.c_str());
 
@@ -27,6 +40,9 @@ CollisionManager::CollisionManager(const std::string& pathCamino,
             std::cout << "[CollisionManager] Advertencia: Sin capa de rampas." << std::endl;
         }
 
+        width = surfCamino->GetWidth();
+        height = surfCamino->GetHeight();
+
         std::cout << "[CollisionManager] Inicializado correctamente (" 
                   << GetWidth() << "x" << GetHeight() << ")" << std::endl;
 
@@ -35,6 +51,15 @@ CollisionManager::CollisionManager(const std::string& pathCamino,
     }
 }
 
+CollisionManager::CollisionManager(std::shared_ptr<const CollisionData> shared_data)
+    : data(std::move(shared_data)), use_grid(true), width(0), height(0) {
+    if (!data) {
+        throw std::runtime_error("Error fatal en CollisionManager: datos de colisión nulos");
+    }
+    width = data->grid.GetWidth();
+    height = data->grid.GetHeight();
+}
+
 Uint32 CollisionManager::getPixel(SDL2pp::Surface& surface, int x, int y) {
     if (x < 0 || x >= surface.GetWidth() || y < 0 || y >= surface.GetHeight()) {
         return 0;
@@ -58,6 +83,7 @@ Uint32 CollisionManager::getPixel(SDL2pp::Surface& surface, int x, int y) {
 }
 
 bool CollisionManager::hasGroundLevel(int x, int y) {
+    if (use_grid) return data->grid.test(LAYER_GROUND, x, y);
     if (!surfCamino) return false;
     SDL_Surface* s = surfCamino->Get();
     if (SDL_MUSTLOCK(s)) SDL_LockSurface(s);
@@ -73,6 +99,7 @@ bool CollisionManager::hasGroundLevel(int x, int y) {
 }
 
 bool CollisionManager::hasBridgeLevel(int x, int y) {
+    if (use_grid) return data->grid.test(LAYER_BRIDGE, x, y);
     if (!surfPuentes) return false;
     SDL_Surface* s = surfPuentes->Get();
     if (SDL_MUSTLOCK(s)) SDL_LockSurface(s);
@@ -87,6 +114,7 @@ bool CollisionManager::hasBridgeLevel(int x, int y) {
 }
 
 bool CollisionManager::isRamp(int x, int y) {
+    if (use_grid) return data->grid.test(LAYER_RAMP, x, y);
     if (!surfRampas) {
         return hasGroundLevel(x, y) && hasBridgeLevel(x, y);
     }
@@ -104,6 +132,8 @@ bool CollisionManager::isRamp(int x, int y) {
 }
 
 bool CollisionManager::isWall(int x, int y, int currentLevel) {
+    if (use_grid) return data->grid.isWall(x, y, currentLevel);
+
     // Si estamos fuera del mapa, es pared
     if (x < 0 || x >= GetWidth() || y < 0 || y >= GetHeight()) {
         return true;
@@ -184,39 +214,125 @@ void CollisionManager::calculateSurfaceNormal(int x, int y, int level, float& no
 
 CollisionResult CollisionManager::checkCollision(int x, int y, int current_level, 
                                                  int next_x, int next_y) {
-    // HACK: Silenciar warnings de variables no usadas por ahora.
-    // En el futuro, usar (x, y) para trazar una línea y evitar que el auto
-    // atraviese paredes si va muy rápido (tunneling).
-    (void)x;
-    (void)y;
+    // Barremos entre centros de píxel para no perder paredes finas (tunneling)
+    return sweepCollision(x + 0.5f, y + 0.5f, next_x + 0.5f, next_y + 0.5f, current_level);
+}
 
+CollisionResult CollisionManager::sweepCollision(float x0, float y0, float x1, float y1,
+                                                 int current_level) {
     CollisionResult result;
-    
-    // 1. Detectar rampas para saber si cambiamos de nivel automáticamente
-    // (Esta lógica se podría mover fuera si prefieres control manual)
-    result.is_on_ramp = isRamp(next_x, next_y);
-    
-    // Lógica básica de cambio de nivel:
-    // Si estoy en rampa y en nivel 0, intento ver si puedo subir (si hay puente)
-    // Si estoy en rampa y en nivel 1, intento ver si puedo bajar (si hay suelo)
-    // Nota: Esto es simplificado. Normalmente se usa la dirección del auto.
-    // Por ahora mantenemos el nivel actual a menos que una lógica externa lo cambie.
     result.current_level = current_level;
+    result.is_on_ramp = isRamp((int)std::floor(x1), (int)std::floor(y1));
+
+    const DistanceField* field = nullptr;
+    if (hasDistanceFields()) {
+        field = &data->distance_fields[current_level != 0 ? 1 : 0];
+    }
 
-    // 2. Verificar pared en la posición futura
-    result.is_wall = isWall(next_x, next_y, current_level);
+    int cx = (int)std::floor(x0);
+    int cy = (int)std::floor(y0);
 
-    if (result.is_wall) {
+    // 1. Ya arrancamos dentro de la pared: no hay recorrido libre
+    if (isWall(cx, cy, current_level)) {
+        result.is_wall = true;
         result.can_move = false;
         result.should_bounce = true;
-        
-        // Calcular la normal para el rebote físico
-        calculateSurfaceNormal(next_x, next_y, current_level, 
-                               result.normal_x, result.normal_y);
-    } else {
-        result.can_move = true;
-        result.should_bounce = false;
+        result.time_of_impact = 0.0f;
+        result.hit_x = cx;
+        result.hit_y = cy;
+        if (field && field->normal(x0, y0, result.normal_x, result.normal_y)) {
+            result.penetration = std::max(0.0f, -field->sample(x0, y0));
+        } else {
+            calculateSurfaceNormal(cx, cy, current_level, result.normal_x, result.normal_y);
+        }
+        return result;
     }
 
+    // 2. Recorrido DDA (Amanatides & Woo) celda por celda
+    const int end_x = (int)std::floor(x1);
+    const int end_y = (int)std::floor(y1);
+    const float dx = x1 - x0;
+    const float dy = y1 - y0;
+    const int step_x = (dx > 0.0f) - (dx < 0.0f);
+    const int step_y = (dy > 0.0f) - (dy < 0.0f);
+
+    const float INF = 1e30f;
+    const float t_delta_x = step_x ? 1.0f / std::fabs(dx) : INF;
+    const float t_delta_y = step_y ? 1.0f / std::fabs(dy) : INF;
+    float t_max_x = step_x > 0 ? (cx + 1 - x0) / dx : (step_x < 0 ? (x0 - cx) / -dx : INF);
+    float t_max_y = step_y > 0 ? (cy + 1 - y0) / dy : (step_y < 0 ? (y0 - cy) / -dy : INF);
+
+    int remaining = std::abs(end_x - cx) + std::abs(end_y - cy);
+    while (remaining-- > 0) {
+        float t;
+        bool crossed_x;
+        if (t_max_x < t_max_y) {
+            cx += step_x;
+            t = t_max_x;
+            t_max_x += t_delta_x;
+            crossed_x = true;
+        } else {
+            cy += step_y;
+            t = t_max_y;
+            t_max_y += t_delta_y;
+            crossed_x = false;
+        }
+
+        if (!isWall(cx, cy, current_level)) continue;
+
+        result.is_wall = true;
+        result.can_move = false;
+        result.should_bounce = true;
+        result.time_of_impact = std::clamp(t, 0.0f, 1.0f);
+        result.hit_x = cx;
+        result.hit_y = cy;
+
+        // Normal de la cara cruzada
+        result.normal_x = crossed_x ? (float)-step_x : 0.0f;
+        result.normal_y = crossed_x ? 0.0f : (float)-step_y;
+
+        // Con SDF usamos su gradiente en el punto de contacto (suave en diagonales),
+        // salvo que contradiga la cara cruzada (paredes más finas que la celda del SDF)
+        float sdf_nx, sdf_ny;
+        const float contact_x = x0 + dx * result.time_of_impact + result.normal_x * 0.5f;
+        const float contact_y = y0 + dy * result.time_of_impact + result.normal_y * 0.5f;
+        if (field && field->normal(contact_x, contact_y, sdf_nx, sdf_ny) &&
+            sdf_nx * result.normal_x + sdf_ny * result.normal_y > 0.3f) {
+            result.normal_x = sdf_nx;
+            result.normal_y = sdf_ny;
+        }
+        return result;
+    }
+
+    result.can_move = true;
+    result.should_bounce = false;
     return result;
-}
\ No newline at end of file
+}
+
+bool CollisionManager::nearestFreeCell(float x, float y, int current_level, int max_radius,
+                                       float& free_x, float& free_y) {
+    const int cx = (int)std::floor(x);
+    const int cy = (int)std::floor(y);
+    float best = -1.0f;
+
+    // Anillos crecientes alrededor de la celda; cualquier celda del anillo r
+    // queda a más de r - 1 del punto, así que se corta apenas no puede mejorar
+    for (int r = 0; r <= max_radius; ++r) {
+        if (best >= 0.0f && (float)(r - 1) * (r - 1) > best) break;
+        for (int j = cy - r; j <= cy + r; ++j) {
+            for (int i = cx - r; i <= cx + r; ++i) {
+                if (std::abs(i - cx) != r && std::abs(j - cy) != r) continue;
+                if (isWall(i, j, current_level)) continue;
+                const float dx = i + 0.5f - x;
+                const float dy = j + 0.5f - y;
+                const float dist = dx * dx + dy * dy;
+                if (best < 0.0f || dist < best) {
+                    best = dist;
+                    free_x = i + 0.5f;
+                    free_y = j + 0.5f;
+                }
+            }
+        }
+    }
+    return best >= 0.0f;
+}
@@ -8,6 +8,8 @@
 #include <vector>
 #include <cmath>
 
+#include "collision_data.h"
+
 // Resultado detallado de una consulta de colisión
 struct CollisionResult {
     bool is_wall;           // ¿Hay pared en esta posición?
@@ -19,11 +21,18 @@ struct CollisionResult {
     bool should_bounce;     // ¿Debe rebotar?
     float normal_x;         // Normal de la superficie X
     float normal_y;         // Normal de la superficie Y
-    
+    float penetration;      // Profundidad dentro de la pared (px), 0 si no hay SDF
+
+    // Datos del barrido (sweep) desde la posición actual a la futura
+    float time_of_impact;   // Fracción [0, 1] del recorrido donde se toca la pared
+    int hit_x;              // Primer píxel de pared encontrado
+    int hit_y;
+
     CollisionResult() 
         : is_wall(false), can_move(true), current_level(0), 
           is_on_ramp(false), should_bounce(false), 
-          normal_x(0.0f), normal_y(0.0f) {}
+          normal_x(0.0f), normal_y(0.0f), penetration(0.0f),
+          time_of_impact(1.0f), hit_x(0), hit_y(0) {}
 };
 
 class CollisionManager {
@@ -32,14 +41,28 @@ private:
     std::unique_ptr<SDL2pp::Surface> surfPuentes;
     std::unique_ptr<SDL2pp::Surface> surfRampas;
 
+    // Modo pre-decodificado: grilla de bits (+ SDF opcional), compartible entre partidas
+    std::shared_ptr<const CollisionData> data;
+    bool use_grid;
+    int width;
+    int height;
+
     Uint32 getPixel(SDL2pp::Surface& surface, int x, int y);
     
     // Calcula la normal de la pared muestreando píxeles vecinos
     void calculateSurfaceNormal(int x, int y, int level, float& normal_x, float& normal_y);
 
 public:
+    /**
+     * @param decode_grid Si es true (default) las capas se decodifican a una
+     *        grilla de bits al construir y las consultas no tocan SDL.
+     *        Si es false se muestrea la superficie en cada consulta.
+     */
     CollisionManager(const std::string& pathCamino, const std::string& pathPuentes,
-                     const std::string& pathRampas = "");
+                     const std::string& pathRampas = "", bool decode_grid = true);
+
+    // Vista sobre datos ya decodificados (p. ej. del MapAssetCache)
+    explicit CollisionManager(std::shared_ptr<const CollisionData> shared_data);
 
     // --- Métodos de consulta individuales ---
     bool isWall(int x, int y, int currentLevel);
@@ -49,6 +72,13 @@ public:
     bool isOnBridge(int x, int y); // Alias de hasBridgeLevel
     bool canTransition(int x, int y, int fromLevel, int toLevel);
 
+    /**
+     * true si los datos traen un campo de distancia con signo por nivel: con
+     * él checkCollision obtiene normal y penetración en O(1). Se hornea una
+     * sola vez al cargar, p. ej. con MapAssetCache::get(ciudad, true).
+     */
+    bool hasDistanceFields() const { return data && !data->distance_fields.empty(); }
+
     // --- Método unificado principal ---
     /**
      * Verifica colisión y lógica de movimiento en una posición específica.
@@ -62,9 +92,25 @@ public:
     CollisionResult checkCollision(int x, int y, int current_level, 
                                    int next_x, int next_y);
 
+    /**
+     * Barrido continuo (DDA sobre la grilla de píxeles) de (x0, y0) a (x1, y1).
+     * Devuelve el primer píxel de pared atravesado, su normal y el tiempo de
+     * impacto, así un auto rápido no atraviesa paredes finas aunque se
+     * integre una sola vez por tick.
+     */
+    CollisionResult sweepCollision(float x0, float y0, float x1, float y1, int current_level);
+
+    /**
+     * Centro del píxel transitable más cercano a (x, y) dentro de `max_radius`
+     * píxeles. Sirve para sacar de la pared a un auto cuando no hay SDF que dé
+     * la normal y la penetración. Devuelve false si no hay ninguno.
+     */
+    bool nearestFreeCell(float x, float y, int current_level, int max_radius,
+                         float& free_x, float& free_y);
+
     // Dimensiones
-    int GetWidth() const { return surfCamino ? surfCamino->GetWidth() : 0; }
-    int GetHeight() const { return surfCamino ? surfCamino->GetHeight() : 0; }
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
 };
 
 #endif  // COLLISION_MANAGER_H
\ No newline at end of file
@@ -21,7 +21,7 @@ T Configuration::get(const std::string& field) {
             if (!node[key]) {
                 throw std::runtime_error("Field not found: " + field);
             }
-            node = node[key];
+            node.reset(node[key]);  // reset: `=` escribiría sobre el YAML compartido
         }
 
         return node.as<T>();
@@ -41,7 +41,7 @@ YAML::Node Configuration::get_node(const std::string& field) {
             if (!node[key]) {
                 throw std::runtime_error("Field not found: " + field);
             }
-            node = node[key];
+            node.reset(node[key]);  // reset: `=` escribiría sobre el YAML compartido
         }
 
         return node;
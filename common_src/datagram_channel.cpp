@@ -0,0 +1,141 @@
+#include "datagram_channel.h"
+
+#include <netinet/in.h>
+#include <sys/uio.h>
+
+#include <cstring>
+
+// --- PacketTracker ---
+
+PacketTracker::PacketTracker()
+    : next_sequence(1), received_any(false), remote_sequence(0), remote_bits(0), sent() {}
+
+uint16_t PacketTracker::register_sent(uint32_t tag) {
+    // La secuencia 0 queda reservada: es el ack de un peer que todavía no recibió nada
+    if (next_sequence == 0) next_sequence = 1;
+    const uint16_t sequence = next_sequence++;
+    sent[sequence % sent.size()] = {sequence, true, tag};
+    return sequence;
+}
+
+bool PacketTracker::is_fresh(uint16_t sequence) const {
+    if (!received_any || sequence_newer(sequence, remote_sequence)) return true;
+    if (sequence == remote_sequence) return false;
+
+    const uint16_t distance = remote_sequence - sequence;
+    if (distance > DATAGRAM_ACK_BITS) return false;
+    return !(remote_bits & (1u << (distance - 1)));
+}
+
+bool PacketTracker::mark_received(uint16_t sequence) {
+    if (!is_fresh(sequence)) return false;
+
+    if (!received_any) {
+        received_any = true;
+        remote_sequence = sequence;
+        remote_bits = 0;
+    } else if (sequence_newer(sequence, remote_sequence)) {
+        // La ventana avanza: el anterior más nuevo pasa a ser un bit
+        const uint16_t shift = sequence - remote_sequence;
+        if (shift > DATAGRAM_ACK_BITS) {
+            remote_bits = 0;
+        } else if (shift == DATAGRAM_ACK_BITS) {
+            remote_bits = 1u << (DATAGRAM_ACK_BITS - 1);
+        } else {
+            remote_bits = (remote_bits << shift) | (1u << (shift - 1));
+        }
+        remote_sequence = sequence;
+    } else {
+        remote_bits |= 1u << (static_cast<uint16_t>(remote_sequence - sequence) - 1);
+    }
+    return true;
+}
+
+void PacketTracker::acknowledge(uint16_t ack, uint32_t ack_bits,
+                                std::vector<uint32_t>& acked_tags) {
+    for (Sent& entry : sent) {
+        if (!entry.pending) continue;
+
+        bool acked = entry.sequence == ack;
+        if (!acked && sequence_newer(ack, entry.sequence)) {
+            const uint16_t distance = ack - entry.sequence;
+            acked = distance <= DATAGRAM_ACK_BITS && (ack_bits & (1u << (distance - 1)));
+        }
+        if (acked) {
+            entry.pending = false;
+            acked_tags.push_back(entry.tag);
+        }
+    }
+}
+
+// --- DatagramChannel ---
+
+DatagramChannel::DatagramChannel(uint32_t token)
+    : socket("0"), token(token), buffer(DATAGRAM_MAX_SIZE) {}
+
+DatagramChannel::DatagramChannel(const char* hostname, const char* servname, uint32_t token)
+    : socket(hostname, servname), token(token), buffer(DATAGRAM_MAX_SIZE) {}
+
+bool DatagramChannel::send(uint8_t kind, uint32_t tag, const void* body, size_t sz) {
+    if (!socket.is_connected() || DATAGRAM_HEADER_SIZE + sz > DATAGRAM_MAX_SIZE) return false;
+
+    uint8_t header[DATAGRAM_HEADER_SIZE];
+    const uint32_t token_net = htonl(token);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    const uint16_t sequence_net = htons(tracker.register_sent(tag));
+    const uint16_t ack_net = htons(tracker.ack());
+    const uint32_t bits_net = htonl(tracker.ack_bits());
+
+    header[0] = kind;
+    std::memcpy(header + 1, &token_net, sizeof(token_net));
+    std::memcpy(header + 5, &sequence_net, sizeof(sequence_net));
+    std::memcpy(header + 7, &ack_net, sizeof(ack_net));
+    std::memcpy(header + 9, &bits_net, sizeof(bits_net));
+
+    struct iovec iov[2];
+    iov[0] = {header, sizeof(header)};
+    iov[1] = {const_cast<void*>(body), sz};
+    return socket.sendv(iov, sz > 0 ? 2 : 1) > 0;
+}
+
+bool DatagramChannel::receive(DatagramHeader& header, std::vector<uint8_t>& body,
+                              std::vector<uint32_t>& acked_tags) {
+    while (true) {
+        const int len = socket.try_recv(buffer.data(), static_cast<unsigned int>(buffer.size()));
+        if (len < 0) return false;
+        if (len < DATAGRAM_HEADER_SIZE) continue;  // basura: se ignora
+
+        uint32_t token_net, bits_net;
+        uint16_t sequence_net, ack_net;
+        std::memcpy(&token_net, buffer.data() + 1, sizeof(token_net));
+        if (ntohl(token_net) != token) continue;  // no es de esta conexión
+
+        std::memcpy(&sequence_net, buffer.data() + 5, sizeof(sequence_net));
+        std::memcpy(&ack_net, buffer.data() + 7, sizeof(ack_net));
+        std::memcpy(&bits_net, buffer.data() + 9, sizeof(bits_net));
+        header.kind = buffer[0];
+        header.token = token;
+        header.sequence = ntohs(sequence_net);
+        header.ack = ntohs(ack_net);
+        header.ack_bits = ntohl(bits_net);
+
+        // El primer datagrama con el token correcto fija al peer (servidor)
+        if (!socket.is_connected()) socket.connect_to_last_sender();
+
+        body.assign(buffer.begin() + DATAGRAM_HEADER_SIZE, buffer.begin() + len);
+        std::lock_guard<std::mutex> lock(mtx);
+        tracker.acknowledge(header.ack, header.ack_bits, acked_tags);
+        return true;
+    }
+}
+
+bool DatagramChannel::is_fresh(uint16_t sequence) {
+    std::lock_guard<std::mutex> lock(mtx);
+    return tracker.is_fresh(sequence);
+}
+
+void DatagramChannel::mark_received(uint16_t sequence) {
+    std::lock_guard<std::mutex> lock(mtx);
+    tracker.mark_received(sequence);
+}
@@ -0,0 +1,184 @@
+#ifndef DATAGRAM_CHANNEL_H
+#define DATAGRAM_CHANNEL_H
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "datagram_socket.h"
+#include "dtos.h"
+#include "socket.h"
+
+/*
+ * Canal UDP opcional para el tráfico de tiempo real de la carrera.
+ *
+ * El lobby, el manifest y los eventos que no se pueden perder siguen por
+ * TCP. Por este canal viajan los snapshots (servidor → cliente) y los
+ * comandos de movimiento (cliente → servidor), que se reemplazan solos: un
+ * datagrama perdido no se retransmite, lo tapa el siguiente.
+ *
+ * Se negocia al conectar: junto con el id, el servidor manda el puerto UDP
+ * que abrió para esa conexión (0 = sin UDP) y un token. El cliente se
+ * presenta con DGRAM_HELLO hasta recibir el primer snapshot por UDP; si el
+ * canal nunca se establece, ambos lados siguen usando TCP.
+ *
+ * Cada datagrama lleva una cabecera fija:
+ *   u8 tipo | u32 token | u16 secuencia | u16 ack | u32 ack_bits
+ * donde `ack` es la mayor secuencia procesada del otro lado y el bit i de
+ * `ack_bits` confirma `ack - 1 - i`. Así cada envío confirma los últimos 33
+ * datagramas recibidos sin mensajes de ack aparte (salvo DGRAM_ACK cuando
+ * no hay nada más que mandar).
+ * */
+
+enum DatagramKind : uint8_t {
+    DGRAM_HELLO = 0x01,     // cliente → servidor: fija la dirección del cliente
+    DGRAM_SNAPSHOT = 0x02,  // servidor → cliente: GAME_STATE_UPDATE enmarcado igual que por TCP
+    DGRAM_INPUT = 0x03,     // cliente → servidor: últimos comandos sin confirmar
+    DGRAM_ACK = 0x04        // solo cabecera
+};
+
+#define DATAGRAM_HEADER_SIZE 13
+#define DATAGRAM_ACK_BITS 32
+
+// Comandos repetidos en cada DGRAM_INPUT (sobreviven a INPUT_REDUNDANCY - 1 pérdidas)
+#define INPUT_REDUNDANCY 4
+
+// Cuerpo de DGRAM_INPUT: u8 cantidad | cantidad x (u32 secuencia | u8 código | u8 parámetro)
+#define DATAGRAM_INPUT_SIZE 6
+
+// Cada cuánto reintenta el cliente el DGRAM_HELLO mientras no haya respuesta
+#define DATAGRAM_HELLO_INTERVAL_MS 100
+
+struct DatagramHeader {
+    uint8_t kind = 0;
+    uint32_t token = 0;
+    uint16_t sequence = 0;
+    uint16_t ack = 0;
+    uint32_t ack_bits = 0;
+};
+
+/*
+ * Comandos que pueden viajar por UDP: los de movimiento, que se repiten
+ * mientras la tecla está apretada. INPUT_STATE viaja con su propia secuencia
+ * y los bits en el parámetro. Cheats, upgrades y la desconexión siguen
+ * por TCP porque no se pueden perder.
+ * */
+inline bool carried_by_datagram(uint8_t code) {
+    switch (code) {
+        case CMD_ACCELERATE:
+        case CMD_BRAKE:
+        case CMD_TURN_LEFT:
+        case CMD_TURN_RIGHT:
+        case CMD_USE_NITRO:
+        case CMD_MOVE_UP:
+        case CMD_MOVE_DOWN:
+        case CMD_MOVE_LEFT:
+        case CMD_MOVE_RIGHT:
+        case CMD_STOP_ALL:
+        case CMD_INPUT_STATE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Comparación de secuencias u16 con vuelta: `a` es posterior a `b`
+inline bool sequence_newer(uint16_t a, uint16_t b) {
+    return a != b && static_cast<uint16_t>(a - b) < 0x8000;
+}
+
+/*
+ * Secuencias y confirmaciones de un lado del canal.
+ *
+ * Cada datagrama enviado se registra con un `tag` (p. ej. la secuencia del
+ * snapshot que lleva); cuando el peer lo confirma, `acknowledge` devuelve
+ * los tags recién confirmados.
+ * */
+class PacketTracker {
+private:
+    struct Sent {
+        uint16_t sequence = 0;
+        bool pending = false;
+        uint32_t tag = 0;
+    };
+
+    uint16_t next_sequence;
+    bool received_any;
+    uint16_t remote_sequence;  // mayor secuencia procesada del peer
+    uint32_t remote_bits;      // bit i: se procesó remote_sequence - 1 - i
+    std::array<Sent, 2 * DATAGRAM_ACK_BITS> sent;
+
+public:
+    PacketTracker();
+
+    // Registra un envío y devuelve su secuencia
+    uint16_t register_sent(uint32_t tag);
+
+    // false si `sequence` ya se procesó o es más vieja que la ventana de acks
+    bool is_fresh(uint16_t sequence) const;
+
+    // Marca `sequence` como procesada; false si no era fresca
+    bool mark_received(uint16_t sequence);
+
+    uint16_t ack() const { return remote_sequence; }
+    uint32_t ack_bits() const { return remote_bits; }
+
+    // Aplica el ack del peer y agrega a `acked_tags` los envíos recién confirmados
+    void acknowledge(uint16_t ack, uint32_t ack_bits, std::vector<uint32_t>& acked_tags);
+};
+
+/*
+ * Socket UDP + PacketTracker de una conexión. Thread-safe: el hilo emisor y
+ * el receptor de la conexión lo usan a la vez.
+ * */
+class DatagramChannel {
+private:
+    DatagramSocket socket;
+    const uint32_t token;
+    std::mutex mtx;
+    PacketTracker tracker;
+    std::vector<uint8_t> buffer;
+
+public:
+    // Servidor: puerto efímero, el peer se fija con el primer datagrama válido
+    explicit DatagramChannel(uint32_t token);
+
+    // Cliente: conectado al puerto UDP que anunció el servidor
+    DatagramChannel(const char* hostname, const char* servname, uint32_t token);
+
+    uint16_t local_port() const { return socket.local_port(); }
+    bool has_peer() const { return socket.is_connected(); }
+
+    /*
+     * Envía cabecera + `body`. `tag` vuelve en `acked_tags` de `receive`
+     * cuando el peer confirma este datagrama. false si no hay peer todavía.
+     * */
+    bool send(uint8_t kind, uint32_t tag, const void* body, size_t sz);
+    bool send(uint8_t kind, uint32_t tag) { return send(kind, tag, nullptr, 0); }
+
+    /*
+     * Recibe el próximo datagrama con el token correcto, sin bloquear, y
+     * aplica su ack. Retorna false si no había ninguno. El datagrama no se
+     * confirma hasta llamar a `mark_received` (solo lo que se pudo usar).
+     * */
+    bool receive(DatagramHeader& header, std::vector<uint8_t>& body,
+                 std::vector<uint32_t>& acked_tags);
+
+    bool is_fresh(uint16_t sequence);
+    void mark_received(uint16_t sequence);
+
+    // Para registrarlo en un reactor (el canal sigue siendo el único que lee)
+    DatagramSocket& get_socket() { return socket; }
+
+    // Ver DatagramSocket::wait
+    int wait(Socket& stream, int timeout_ms) { return socket.wait(stream, timeout_ms); }
+
+    // Pérdida y latencia simuladas en lo recibido (pruebas locales)
+    void simulate(float loss, int delay_ms, uint32_t seed) { socket.simulate(loss, delay_ms, seed); }
+
+    DatagramChannel(const DatagramChannel&) = delete;
+    DatagramChannel& operator=(const DatagramChannel&) = delete;
+};
+
+#endif  // DATAGRAM_CHANNEL_H
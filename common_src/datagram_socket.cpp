@@ -0,0 +1,187 @@
+#include "datagram_socket.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "liberror.h"
+#include "resolver.h"
+
+DatagramSocket::DatagramSocket(const char* servname)
+    : skt(-1), connected(false), last_from(), loss(0.0f), delay(0), rng() {
+    Resolver resolver(nullptr, servname, true, SOCK_DGRAM);
+
+    while (resolver.has_next()) {
+        struct addrinfo* addr = resolver.next();
+        int s = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+        if (s == -1) continue;
+
+        if (bind(s, addr->ai_addr, addr->ai_addrlen) == -1) {
+            ::close(s);
+            continue;
+        }
+        skt = s;
+        return;
+    }
+    throw LibError(errno, "datagram socket construction failed (bind on %s)",
+                   (servname ? servname : ""));
+}
+
+DatagramSocket::DatagramSocket(const char* hostname, const char* servname)
+    : skt(-1), connected(false), last_from(), loss(0.0f), delay(0), rng() {
+    Resolver resolver(hostname, servname, false, SOCK_DGRAM);
+
+    while (resolver.has_next()) {
+        struct addrinfo* addr = resolver.next();
+        int s = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+        if (s == -1) continue;
+
+        /* En UDP `connect` no manda nada: solo fija el peer por defecto */
+        if (::connect(s, addr->ai_addr, addr->ai_addrlen) == -1) {
+            ::close(s);
+            continue;
+        }
+        skt = s;
+        connected = true;
+        return;
+    }
+    throw LibError(errno, "datagram socket construction failed (connect to %s:%s)",
+                   (hostname ? hostname : ""), (servname ? servname : ""));
+}
+
+uint16_t DatagramSocket::local_port() const {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    if (getsockname(skt, (struct sockaddr*)&addr, &len) == -1)
+        throw LibError(errno, "datagram socket getsockname failed");
+    return ntohs(addr.sin_port);
+}
+
+int DatagramSocket::sendv(struct iovec* iov, int iovcnt) {
+    if (!connected) return 0;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+
+    ssize_t s = sendmsg(skt, &msg, MSG_NOSIGNAL);
+    if (s == -1) {
+        /* El peer todavía no abrió (o ya cerró) su puerto: no es un error */
+        if (errno == ECONNREFUSED) return 0;
+        throw LibError(errno, "datagram socket sendmsg failed");
+    }
+    return static_cast<int>(s);
+}
+
+int DatagramSocket::send(const void* data, unsigned int sz) {
+    struct iovec iov = {const_cast<void*>(data), sz};
+    return sendv(&iov, 1);
+}
+
+int DatagramSocket::try_recv(void* data, unsigned int sz) {
+    if (simulating()) {
+        drain();
+        if (pending.empty() || pending.front().due > std::chrono::steady_clock::now())
+            return -1;
+
+        Pending next = std::move(pending.front());
+        pending.pop_front();
+        last_from = next.from;
+        const unsigned int len = std::min(sz, static_cast<unsigned int>(next.data.size()));
+        memcpy(data, next.data.data(), len);
+        return static_cast<int>(len);
+    }
+
+    socklen_t from_len = sizeof(last_from);
+    ssize_t s = recvfrom(skt, data, sz, MSG_DONTWAIT, (struct sockaddr*)&last_from, &from_len);
+    if (s == -1) {
+        if (errno == EAGAIN || errno == ECONNREFUSED) return -1;
+        throw LibError(errno, "datagram socket recvfrom failed");
+    }
+    return static_cast<int>(s);
+}
+
+void DatagramSocket::drain() {
+    uint8_t buffer[DATAGRAM_MAX_SIZE];
+    std::uniform_real_distribution<float> coin(0.0f, 1.0f);
+
+    while (true) {
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        ssize_t s = recvfrom(skt, buffer, sizeof(buffer), MSG_DONTWAIT,
+                             (struct sockaddr*)&from, &from_len);
+        if (s == -1) {
+            if (errno == EAGAIN || errno == ECONNREFUSED) return;
+            throw LibError(errno, "datagram socket recvfrom failed");
+        }
+        if (coin(rng) < loss) continue;
+
+        pending.push_back({std::chrono::steady_clock::now() + delay,
+                           std::vector<uint8_t>(buffer, buffer + s), from});
+    }
+}
+
+void DatagramSocket::connect_to_last_sender() {
+    if (::connect(skt, (struct sockaddr*)&last_from, sizeof(last_from)) == -1)
+        throw LibError(errno, "datagram socket connect failed");
+    connected = true;
+}
+
+int DatagramSocket::wait(Socket& stream, int timeout_ms) {
+    using clock = std::chrono::steady_clock;
+    const bool forever = timeout_ms < 0;
+    const clock::time_point deadline = clock::now() + std::chrono::milliseconds(timeout_ms);
+
+    while (true) {
+        int ready = 0;
+        int poll_ms = -1;
+        if (!forever) {
+            auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - clock::now());
+            poll_ms = static_cast<int>(std::max<int64_t>(0, left.count()));
+        }
+
+        /* Con simulación, lo "disponible" es lo que ya cumplió su demora */
+        if (simulating()) {
+            drain();
+            if (!pending.empty()) {
+                auto until_due = std::chrono::ceil<std::chrono::milliseconds>(
+                        pending.front().due - clock::now());
+                if (until_due.count() <= 0) {
+                    ready |= DATAGRAM_READY;
+                    poll_ms = 0;
+                } else if (poll_ms < 0 || until_due.count() < poll_ms) {
+                    poll_ms = static_cast<int>(until_due.count());
+                }
+            }
+        }
+
+        struct pollfd fds[2];
+        fds[0] = {skt, POLLIN, 0};
+        fds[1] = {stream.skt, POLLIN, 0};
+        if (poll(fds, 2, poll_ms) == -1) {
+            if (errno == EINTR) continue;
+            throw LibError(errno, "poll failed");
+        }
+
+        if (fds[1].revents) ready |= STREAM_READY;
+        if (fds[0].revents && !simulating()) ready |= DATAGRAM_READY;
+
+        if (ready) return ready;
+        if (!forever && clock::now() >= deadline) return 0;
+    }
+}
+
+void DatagramSocket::simulate(float loss, int delay_ms, uint32_t seed) {
+    this->loss = loss;
+    this->delay = std::chrono::milliseconds(delay_ms);
+    rng.seed(seed);
+}
+
+DatagramSocket::~DatagramSocket() {
+    if (skt != -1) ::close(skt);
+}
@@ -0,0 +1,104 @@
+#ifndef DATAGRAM_SOCKET_H
+#define DATAGRAM_SOCKET_H
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "socket.h"
+
+// Tope de un datagrama de juego: entra en una trama Ethernet sin fragmentar
+#define DATAGRAM_MAX_SIZE 1200
+
+// Resultado de `DatagramSocket::wait` (máscara)
+#define DATAGRAM_READY  0x01
+#define STREAM_READY    0x02
+
+/*
+ * TDA socket UDP (IPv4), pensado para el tráfico de tiempo real de una
+ * conexión que ya existe por TCP.
+ *
+ * El servidor lo abre en un puerto efímero (`DatagramSocket("0")`) y fija su
+ * peer con `connect_to_last_sender` al recibir el primer datagrama válido; el
+ * cliente lo abre ya conectado al host/puerto que le indicó el servidor.
+ * Conectado, el kernel descarta los datagramas de cualquier otro origen.
+ *
+ * `simulate` agrega pérdida y latencia artificiales a lo que se recibe, para
+ * probar el protocolo en loopback sin herramientas externas.
+ * */
+class DatagramSocket {
+private:
+    struct Pending {
+        std::chrono::steady_clock::time_point due;
+        std::vector<uint8_t> data;
+        struct sockaddr_in from;
+    };
+
+    int skt;
+    std::atomic<bool> connected;  // lo fija el hilo receptor, lo consulta el emisor
+    struct sockaddr_in last_from;
+
+    // Simulación de red (desactivada mientras loss == 0 y delay == 0)
+    float loss;
+    std::chrono::milliseconds delay;
+    std::mt19937 rng;
+    std::deque<Pending> pending;
+
+    bool simulating() const { return loss > 0.0f || delay.count() > 0; }
+
+    // Pasa al buffer de simulación todo lo que tenga el kernel (no bloquea)
+    void drain();
+
+    // El `Reactor` del servidor registra el file descriptor en su epoll
+    friend class Reactor;
+
+public:
+    // Socket sin conectar, enlazado a `servname` en todas las interfaces
+    explicit DatagramSocket(const char* servname);
+
+    // Socket conectado a `hostname`/`servname`
+    DatagramSocket(const char* hostname, const char* servname);
+
+    DatagramSocket(const DatagramSocket&) = delete;
+    DatagramSocket& operator=(const DatagramSocket&) = delete;
+
+    uint16_t local_port() const;
+    bool is_connected() const { return connected; }
+
+    /*
+     * Envía un datagrama armado con `iovcnt` buffers (un solo `sendmsg`).
+     * Retorna los bytes enviados, o 0 si todavía no hay peer o el peer
+     * rechazó el anterior (ICMP port unreachable). Lanza en otro error.
+     * */
+    int sendv(struct iovec* iov, int iovcnt);
+    int send(const void* data, unsigned int sz);
+
+    /*
+     * Recibe un datagrama si hay uno disponible, sin bloquear.
+     * Retorna su tamaño (truncado a `sz`) o -1 si no había ninguno.
+     * */
+    int try_recv(void* data, unsigned int sz);
+
+    // Fija como peer al remitente del último datagrama recibido
+    void connect_to_last_sender();
+
+    /*
+     * Espera hasta `timeout_ms` (-1: sin límite) a que haya un datagrama o
+     * a que `stream` tenga algo para leer (datos o cierre). Retorna una
+     * máscara de DATAGRAM_READY / STREAM_READY, 0 si venció el tiempo.
+     * */
+    int wait(Socket& stream, int timeout_ms);
+
+    // Descarta la fracción `loss` de lo recibido y demora el resto `delay_ms`
+    void simulate(float loss, int delay_ms, uint32_t seed);
+
+    ~DatagramSocket();
+};
+
+#endif  // DATAGRAM_SOCKET_H
@@ -0,0 +1,141 @@
+#include "distance_field.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr float INF = 1e20f;
+
+// Transformada de distancia 1D al cuadrado (Felzenszwalb & Huttenlocher).
+// f: costo inicial por celda (0 en las fuentes, INF en el resto)
+void edt_1d(const float* f, float* d, int n, int* v, float* z) {
+    int k = 0;
+    v[0] = 0;
+    z[0] = -INF;
+    z[1] = INF;
+    for (int q = 1; q < n; ++q) {
+        float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+        while (s <= z[k]) {
+            --k;
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = INF;
+    }
+    k = 0;
+    for (int q = 0; q < n; ++q) {
+        while (z[k + 1] < q) ++k;
+        const float dq = static_cast<float>(q - v[k]);
+        d[q] = dq * dq + f[v[k]];
+    }
+}
+
+// Distancia euclídea al cuadrado de cada celda a la fuente más cercana
+void edt_2d(std::vector<float>& grid, int cols, int rows) {
+    const int n = std::max(cols, rows);
+    std::vector<float> f(n), d(n), z(n + 1);
+    std::vector<int> v(n);
+
+    for (int x = 0; x < cols; ++x) {
+        for (int y = 0; y < rows; ++y) f[y] = grid[y * cols + x];
+        edt_1d(f.data(), d.data(), rows, v.data(), z.data());
+        for (int y = 0; y < rows; ++y) grid[y * cols + x] = d[y];
+    }
+    for (int y = 0; y < rows; ++y) {
+        float* row = grid.data() + static_cast<size_t>(y) * cols;
+        std::copy(row, row + cols, f.begin());
+        edt_1d(f.data(), d.data(), cols, v.data(), z.data());
+        std::copy(d.begin(), d.begin() + cols, row);
+    }
+}
+
+}  // namespace
+
+DistanceField::DistanceField() : cols(0), rows(0), cell_size(1), inv_cell(1.0f) {}
+
+DistanceField::DistanceField(const CollisionGrid& grid, int level, int cell_size)
+    : cols(0), rows(0), cell_size(std::max(1, cell_size)), inv_cell(0.0f) {
+    inv_cell = 1.0f / static_cast<float>(this->cell_size);
+    cols = (grid.GetWidth() + this->cell_size - 1) / this->cell_size;
+    rows = (grid.GetHeight() + this->cell_size - 1) / this->cell_size;
+    if (cols <= 0 || rows <= 0) return;
+
+    const size_t total = static_cast<size_t>(cols) * rows;
+    std::vector<uint8_t> wall(total);
+    for (int cy = 0; cy < rows; ++cy) {
+        for (int cx = 0; cx < cols; ++cx) {
+            // Muestreamos el píxel central de la celda
+            const int px = cx * this->cell_size + this->cell_size / 2;
+            const int py = cy * this->cell_size + this->cell_size / 2;
+            wall[static_cast<size_t>(cy) * cols + cx] = grid.isWall(px, py, level);
+        }
+    }
+
+    // Distancia a la pared (para celdas libres) y al espacio libre (para paredes)
+    std::vector<float> to_wall(total), to_free(total);
+    for (size_t i = 0; i < total; ++i) {
+        to_wall[i] = wall[i] ? 0.0f : INF;
+        to_free[i] = wall[i] ? INF : 0.0f;
+    }
+    edt_2d(to_wall, cols, rows);
+    edt_2d(to_free, cols, rows);
+
+    values.resize(total);
+    const float max_value = std::numeric_limits<int16_t>::max();
+    for (int cy = 0; cy < rows; ++cy) {
+        for (int cx = 0; cx < cols; ++cx) {
+            const size_t i = static_cast<size_t>(cy) * cols + cx;
+            float dist;
+            if (wall[i]) {
+                dist = -(std::sqrt(to_free[i]) - 0.5f);
+            } else {
+                // Fuera del mapa también es pared
+                const float border = static_cast<float>(
+                        std::min(std::min(cx + 1, cols - cx), std::min(cy + 1, rows - cy)));
+                dist = std::min(std::sqrt(to_wall[i]), border) - 0.5f;
+            }
+            const float units = dist * this->cell_size * UNITS_PER_PIXEL;
+            values[i] = static_cast<int16_t>(std::clamp(units, -max_value, max_value));
+        }
+    }
+}
+
+float DistanceField::cell_value(int cx, int cy) const {
+    cx = std::clamp(cx, 0, cols - 1);
+    cy = std::clamp(cy, 0, rows - 1);
+    return values[static_cast<size_t>(cy) * cols + cx] / UNITS_PER_PIXEL;
+}
+
+float DistanceField::sample(float x, float y) const {
+    if (values.empty()) return 0.0f;
+
+    // Centros de celda en (i + 0.5) * cell_size
+    const float gx = x * inv_cell - 0.5f;
+    const float gy = y * inv_cell - 0.5f;
+    const int x0 = static_cast<int>(std::floor(gx));
+    const int y0 = static_cast<int>(std::floor(gy));
+    const float fx = gx - x0;
+    const float fy = gy - y0;
+
+    const float top = cell_value(x0, y0) * (1.0f - fx) + cell_value(x0 + 1, y0) * fx;
+    const float bottom = cell_value(x0, y0 + 1) * (1.0f - fx) + cell_value(x0 + 1, y0 + 1) * fx;
+    return top * (1.0f - fy) + bottom * fy;
+}
+
+bool DistanceField::normal(float x, float y, float& normal_x, float& normal_y) const {
+    if (values.empty()) return false;
+
+    const float h = static_cast<float>(cell_size);
+    const float gx = sample(x + h, y) - sample(x - h, y);
+    const float gy = sample(x, y + h) - sample(x, y - h);
+    const float length = std::sqrt(gx * gx + gy * gy);
+    if (length < 0.001f) return false;
+
+    normal_x = gx / length;
+    normal_y = gy / length;
+    return true;
+}
@@ -0,0 +1,45 @@
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+#include <cstdint>
+#include <vector>
+
+#include "collision_grid.h"
+
+/*
+ * Campo de distancia con signo (SDF) de un nivel de la grilla de colisión.
+ *
+ * Se hornea una vez al cargar el mapa (transformada de distancia euclídea
+ * exacta, Felzenszwalb) sobre celdas de `cell_size` píxeles:
+ *   - valor > 0: espacio libre, distancia a la pared más cercana
+ *   - valor < 0: dentro de la pared, profundidad de penetración
+ *
+ * La normal de una pared es el gradiente del campo: apunta hacia afuera y
+ * es suave en diagonales. Ambas consultas son O(1).
+ */
+class DistanceField {
+private:
+    int cols;
+    int rows;
+    int cell_size;
+    float inv_cell;
+    std::vector<int16_t> values;  // distancia en 1/8 de píxel
+
+    static constexpr float UNITS_PER_PIXEL = 8.0f;
+
+    float cell_value(int cx, int cy) const;
+
+public:
+    DistanceField();
+    DistanceField(const CollisionGrid& grid, int level, int cell_size = 2);
+
+    // Distancia con signo en píxeles (interpolación bilineal)
+    float sample(float x, float y) const;
+
+    // Normal de la superficie (gradiente normalizado). false si es plano.
+    bool normal(float x, float y, float& normal_x, float& normal_y) const;
+
+    bool empty() const { return values.empty(); }
+};
+
+#endif  // DISTANCE_FIELD_H
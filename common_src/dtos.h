@@ -82,6 +82,12 @@ struct PlayerRoomState {
 #define CMD_MOVE_RIGHT 0x09
 
 #define CMD_STOP_ALL   0x30
+// Estado completo de los controles (+ u8 INPUT_* | u32 secuencia), uno por frame
+#define CMD_INPUT_STATE 0x31
+// Confirmación de snapshot (+ u32 secuencia): la consume ServerProtocol
+#define CMD_SNAPSHOT_ACK 0x40
+// Medición del enlace (+ PING_SIZE bytes, ver clock_sync.h): la consume ServerProtocol
+#define CMD_PING 0x41
 #define CMD_DISCONNECT 0xFF
 
 // Códigos de cheats
@@ -97,6 +103,13 @@ struct PlayerRoomState {
 #define CMD_UPGRADE_HANDLING   0x22
 #define CMD_UPGRADE_DURABILITY 0x23
 
+// Bits de CMD_INPUT_STATE: teclas apretadas en el frame
+#define INPUT_UP    0x01
+#define INPUT_DOWN  0x02
+#define INPUT_LEFT  0x04
+#define INPUT_RIGHT 0x08
+#define INPUT_NITRO 0x10
+
 // Comandos que el cliente envía al servidor durante la carrera
 enum class GameCommand : uint8_t {
     // Movimiento básico
@@ -129,6 +142,7 @@ enum class GameCommand : uint8_t {
 
     // Control
     STOP_ALL = CMD_STOP_ALL,
+    INPUT_STATE = CMD_INPUT_STATE,  // reemplaza a MOVE_* / USE_NITRO / STOP_ALL
     DISCONNECT = CMD_DISCONNECT
 };
 
@@ -148,6 +162,8 @@ enum class ServerMessageType : uint8_t {
     COUNTDOWN = 0x0C,           // Countdown antes de iniciar (3, 2, 1, GO!)
     RACE_TIMEOUT = 0x0D,        // Carrera terminó por timeout (10 min)
     RACE_PATHS = 0x17,          // Rutas YAML de las carreras de la partida
+    RACE_MANIFEST = 0x18,       // Slot -> jugador, nombres y auto (solo si cambia el plantel)
+    PONG = 0x19,                // Respuesta a CMD_PING (+ PONG_SIZE bytes, ver clock_sync.h)
 };
 
 // Tipo de colisión
@@ -196,11 +212,14 @@ struct ComandMatchDTO {
     UpgradeType upgrade_type;  // Para UPGRADEs
     uint8_t upgrade_level;     // Para UPGRADEs (nivel 1, 2, 3...)
     uint16_t upgrade_cost_ms;  // Para UPGRADEs (penalización en ms)
+    uint8_t input_bits;        // Para INPUT_STATE (máscara INPUT_*)
+    uint32_t input_sequence;   // Para INPUT_STATE (creciente; el servidor descarta los viejos)
 
     // Constructor por defecto
     ComandMatchDTO()
         : player_id(0), command(GameCommand::DISCONNECT), turn_intensity(0.0f), speed_boost(0.0f),
-          checkpoint_id(0), upgrade_type(UpgradeType::SPEED), upgrade_level(0), upgrade_cost_ms(0) {}
+          checkpoint_id(0), upgrade_type(UpgradeType::SPEED), upgrade_level(0), upgrade_cost_ms(0),
+          input_bits(0), input_sequence(0) {}
 };
 
 // Estado de un auto en la carrera (para enviar al cliente)
@@ -3,7 +3,7 @@
 #include <iostream>
 
 // Incluir las clases del servidor SOLO en este .cpp
-#include "../server_src/game/car.h"
+#include "car.h"
 #include "../server_src/game/player.h"
 
 // Constructor que convierte Player* a InfoPlayer
@@ -23,6 +23,7 @@ GameState::GameState(const std::vector<Player*>& player_list, const std::string&
         info.username = player_ptr->getName();
         info.car_name = player_ptr->getSelectedCar();
         info.car_type = player_ptr->getCarType();
+        info.car_id = player_ptr->getCarModelId();
 
 
         // Posición y física
@@ -46,6 +47,7 @@ GameState::GameState(const std::vector<Player*>& player_list, const std::string&
         info.completed_laps = player_ptr->getCompletedLaps();
         info.current_checkpoint = player_ptr->getCurrentCheckpoint();
         info.position_in_race = player_ptr->getPositionInRace();
+        info.last_input = player_ptr->getInputSequence();
 
         // Tiempos de carrera
         auto race_time_it = current_race_times.find(info.player_id);
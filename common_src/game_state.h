@@ -1,10 +1,12 @@
 #ifndef GAME_STATE_H_
 #define GAME_STATE_H_
 
+#include <chrono>
 #include <cstdint>
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 
 // Forward declarations (las clases del servidor se incluirán en el .cpp)
 class Player;
@@ -42,12 +44,24 @@ struct MatchConfig {
 
 // SNAPSHOT DEL JUEGO (enviado continuamente del servidor a los clientes)
 
+// ---- Datos fijos de un jugador durante la carrera ----
+// En el cliente llegan una vez por carrera en el RACE_MANIFEST (ver snapshot_codec.h)
+struct RosterEntry {
+    uint16_t player_id = 0;
+    uint8_t car_id = 0xFF;
+    std::string username;
+    std::string car_name;
+    std::string car_type;
+};
+
 // ---- Información detallada de cada jugador ----
 struct InfoPlayer {
     int player_id = 0;
     std::string username;
     std::string car_name;
     std::string car_type;
+    uint8_t car_id = 0xFF;  // Id del CarCatalog (0xFF = desconocido)
+    uint8_t slot = 0xFF;    // Cliente: índice en GameState::roster (los strings van ahí)
 
     // Posición y física del auto
     float pos_x = 0.0f;
@@ -75,6 +89,12 @@ struct InfoPlayer {
     bool race_finished = false;
     bool is_alive = true;  // false si explotó
     bool disconnected = false;
+
+    // Último INPUT_STATE del jugador ya aplicado (el cliente reconcilia su predicción)
+    uint32_t last_input = 0;
+
+    // false: fuera del área de interés del cliente (sin posición, solo ranking)
+    bool in_view = true;
 };
 
 // ---- Información de checkpoints ----
@@ -160,6 +180,12 @@ struct GameState {
     // Eventos recientes (explosiones, etc.)
     std::vector<GameEvent> events;
 
+    // Hora de llegada al cliente (la marca ClientReceiver, no viaja por la red)
+    std::chrono::steady_clock::time_point received_at{};
+
+    // Solo en el cliente: nombres y autos del manifest, compartidos entre snapshots
+    std::shared_ptr<const std::vector<RosterEntry>> roster;
+
     // ---- Constructores ----
     GameState() = default;
 
@@ -178,6 +204,23 @@ struct GameState {
         }
         return nullptr;
     }
+
+    // ---- Strings de un jugador: del roster si lo hay, si no los propios (servidor) ----
+    const RosterEntry* roster_entry(const InfoPlayer& p) const {
+        return roster && p.slot < roster->size() ? &(*roster)[p.slot] : nullptr;
+    }
+    const std::string& username_of(const InfoPlayer& p) const {
+        const RosterEntry* entry = roster_entry(p);
+        return entry ? entry->username : p.username;
+    }
+    const std::string& car_name_of(const InfoPlayer& p) const {
+        const RosterEntry* entry = roster_entry(p);
+        return entry ? entry->car_name : p.car_name;
+    }
+    const std::string& car_type_of(const InfoPlayer& p) const {
+        const RosterEntry* entry = roster_entry(p);
+        return entry ? entry->car_type : p.car_type;
+    }
 };
 
 #endif  // GAME_STATE_H_
@@ -0,0 +1,146 @@
+#ifndef MAILBOX_H_
+#define MAILBOX_H_
+
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#include "queue.h"  // ClosedQueue
+
+// Contadores de un Mailbox (copia, se pueden leer desde cualquier hilo)
+struct MailboxStats {
+    uint64_t delivered = 0;  // elementos entregados por pop()/try_pop()
+    uint64_t dropped = 0;    // elementos pisados por uno más nuevo sin llegar a entregarse
+    uint64_t coalesced = 0;  // entregas que saltearon al menos un elemento descartado
+};
+
+/*
+ * Mailbox conflacionante para estado que se reemplaza (snapshots).
+ *
+ * Como Queue, pero push() nunca bloquea ni crece más allá de `capacity`:
+ * si está lleno se descarta el elemento más viejo sin entregar. Un consumidor
+ * lento siempre recibe lo último y la memoria por conexión queda acotada.
+ *
+ * On a closed mailbox, any method will raise ClosedQueue.
+ * */
+template <typename T>
+class Mailbox {
+private:
+    std::deque<T> items;
+    const size_t capacity;
+
+    bool closed;
+    bool skipped;  // hubo descartes desde la última entrega
+    MailboxStats counters;
+
+    std::mutex mtx;
+    std::condition_variable is_not_empty;
+
+    std::function<void()> listener;
+
+    T take() {
+        T val = std::move(items.front());
+        items.pop_front();
+        counters.delivered++;
+        if (skipped) {
+            counters.coalesced++;
+            skipped = false;
+        }
+        return val;
+    }
+
+public:
+    Mailbox() : capacity(1), closed(false), skipped(false) {}
+    explicit Mailbox(const size_t capacity)
+        : capacity(capacity > 0 ? capacity : 1), closed(false), skipped(false) {}
+
+    /*
+     * `callback` se llama después de cada push, fuera del lock (p. ej. para
+     * despertar a un reactor en vez de tener un hilo bloqueado en pop).
+     * Se fija antes de compartir el mailbox con otros hilos.
+     * */
+    void set_listener(std::function<void()> callback) { listener = std::move(callback); }
+
+    // Nunca bloquea: devuelve false si tuvo que descartar un elemento viejo
+    bool try_push(T const& val) {
+        bool fits;
+        {
+            std::unique_lock<std::mutex> lck(mtx);
+
+            if (closed) {
+                throw ClosedQueue();
+            }
+
+            fits = items.size() < capacity;
+            if (!fits) {
+                items.pop_front();
+                counters.dropped++;
+                skipped = true;
+            }
+
+            if (items.empty()) {
+                is_not_empty.notify_all();
+            }
+
+            items.push_back(val);
+        }
+
+        if (listener) listener();
+        return fits;
+    }
+
+    void push(T const& val) { try_push(val); }
+
+    bool try_pop(T& val) {
+        std::unique_lock<std::mutex> lck(mtx);
+
+        if (items.empty()) {
+            if (closed) {
+                throw ClosedQueue();
+            }
+            return false;
+        }
+
+        val = take();
+        return true;
+    }
+
+    T pop() {
+        std::unique_lock<std::mutex> lck(mtx);
+
+        while (items.empty()) {
+            if (closed) {
+                throw ClosedQueue();
+            }
+            is_not_empty.wait(lck);
+        }
+
+        return take();
+    }
+
+    MailboxStats stats() {
+        std::unique_lock<std::mutex> lck(mtx);
+        return counters;
+    }
+
+    void close() {
+        std::unique_lock<std::mutex> lck(mtx);
+
+        if (closed) {
+            throw std::runtime_error("The mailbox is already closed.");
+        }
+
+        closed = true;
+        is_not_empty.notify_all();
+    }
+
+private:
+    Mailbox(const Mailbox&) = delete;
+    Mailbox& operator=(const Mailbox&) = delete;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#include "map_asset_cache.h"
+
+#include <algorithm>
+#include <iostream>
+
+std::mutex MapAssetCache::mutex;
+std::map<std::string, std::weak_ptr<const CollisionData>> MapAssetCache::entries;
+std::map<std::string, std::shared_ptr<const CollisionData>> MapAssetCache::pinned;
+
+std::string MapAssetCache::city_dir(const std::string& city_name) {
+    std::string city_clean = city_name;
+    std::transform(city_clean.begin(), city_clean.end(), city_clean.begin(), ::tolower);
+    std::replace(city_clean.begin(), city_clean.end(), ' ', '-');
+    std::replace(city_clean.begin(), city_clean.end(), '_', '-');
+    return city_clean;
+}
+
+std::string MapAssetCache::make_key(const std::string& city_dir, bool with_distance_fields) {
+    return city_dir + (with_distance_fields ? "#sdf" : "");
+}
+
+std::shared_ptr<const CollisionData> MapAssetCache::get(const std::string& city_name,
+                                                        bool with_distance_fields) {
+    const std::string dir = city_dir(city_name);
+    const std::string key = make_key(dir, with_distance_fields);
+
+    // Se decodifica con el lock tomado: dos partidas que piden la misma ciudad
+    // a la vez esperan a la primera en lugar de decodificarla dos veces
+    std::lock_guard<std::mutex> lock(mutex);
+    if (auto cached = entries[key].lock()) {
+        std::cout << "[MapAssetCache] Reutilizando colisiones de " << dir << std::endl;
+        return cached;
+    }
+
+    const std::string base_path = "assets/img/map/layers/" + dir + "/";
+    std::cout << "[MapAssetCache] Cargando colisiones desde: " << base_path << std::endl;
+    auto data = CollisionData::load(base_path + "camino.png", base_path + "puentes.png",
+                                    base_path + "rampas.png", with_distance_fields);
+    entries[key] = data;
+    return data;
+}
+
+void MapAssetCache::preload(const std::vector<std::string>& city_names,
+                            bool with_distance_fields) {
+    for (const auto& city : city_names) {
+        try {
+            auto data = get(city, with_distance_fields);
+            std::lock_guard<std::mutex> lock(mutex);
+            pinned[make_key(city_dir(city), with_distance_fields)] = data;
+        } catch (const std::exception& e) {
+            std::cerr << "[MapAssetCache] No se pudo precargar " << city << ": " << e.what()
+                      << std::endl;
+        }
+    }
+}
+
+void MapAssetCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    pinned.clear();
+    entries.clear();
+}
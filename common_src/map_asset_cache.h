@@ -0,0 +1,46 @@
+#ifndef MAP_ASSET_CACHE_H
+#define MAP_ASSET_CACHE_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "collision_data.h"
+
+/*
+ * Cache de assets de mapa para todo el proceso.
+ *
+ * Cada ciudad se decodifica una sola vez y se comparte como
+ * shared_ptr<const CollisionData> entre carreras y partidas concurrentes.
+ * Las entradas se guardan como weak_ptr: cuando ninguna partida usa una
+ * ciudad, su memoria se libera. Las ciudades precargadas quedan fijadas
+ * (pinned) hasta `clear()`.
+ */
+class MapAssetCache {
+private:
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<const CollisionData>> entries;
+    static std::map<std::string, std::shared_ptr<const CollisionData>> pinned;
+
+    static std::string make_key(const std::string& city_dir, bool with_distance_fields);
+
+public:
+    // "Vice City" -> "vice-city" (nombre de carpeta en assets/img/map/layers/)
+    static std::string city_dir(const std::string& city_name);
+
+    /**
+     * Devuelve los datos de colisión de la ciudad, decodificándolos solo si
+     * nadie los tiene cargados. Lanza runtime_error si faltan las capas.
+     */
+    static std::shared_ptr<const CollisionData> get(const std::string& city_name,
+                                                    bool with_distance_fields);
+
+    // Precarga (opcional, al iniciar el server) y fija las ciudades en memoria
+    static void preload(const std::vector<std::string>& city_names, bool with_distance_fields);
+
+    static void clear();
+};
+
+#endif  // MAP_ASSET_CACHE_H
@@ -0,0 +1,102 @@
+#include "outbound_message.h"
+
+#include <netinet/in.h>
+
+void OutboundMessage::clear() {
+    arena.clear();
+    segments.clear();
+}
+
+void OutboundMessage::append(const void* data, size_t sz) {
+    if (sz == 0) return;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+    // Escrituras seguidas en el arena forman un único iovec
+    if (segments.empty() || segments.back().external) {
+        segments.push_back({nullptr, arena.size(), 0});
+    }
+    arena.insert(arena.end(), bytes, bytes + sz);
+    segments.back().size += sz;
+}
+
+void OutboundMessage::put_uint8(uint8_t value) { append(&value, sizeof(value)); }
+
+void OutboundMessage::put_uint16(uint16_t value) {
+    uint16_t net_value = htons(value);
+    append(&net_value, sizeof(net_value));
+}
+
+void OutboundMessage::put_uint32(uint32_t value) {
+    uint32_t net_value = htonl(value);
+    append(&net_value, sizeof(net_value));
+}
+
+void OutboundMessage::put_uint64(uint64_t value) {
+    put_uint32(static_cast<uint32_t>(value >> 32));
+    put_uint32(static_cast<uint32_t>(value));
+}
+
+void OutboundMessage::put_bytes(const void* data, size_t sz) { append(data, sz); }
+
+void OutboundMessage::put_ref(const void* data, size_t sz) {
+    if (sz == 0) return;
+    segments.push_back({static_cast<const uint8_t*>(data), 0, sz});
+}
+
+void OutboundMessage::put_string(const std::string& str) {
+    put_uint16(static_cast<uint16_t>(str.size()));
+    if (str.size() <= OUTBOUND_INLINE_STRING) {
+        append(str.data(), str.size());
+    } else {
+        put_ref(str.data(), str.size());
+    }
+}
+
+size_t OutboundMessage::size() const {
+    size_t total = 0;
+    for (const Segment& segment : segments) total += segment.size;
+    return total;
+}
+
+void OutboundMessage::gather() {
+    // Los punteros al arena se resuelven recién acá: el arena pudo crecer al armar
+    iov.clear();
+    for (const Segment& segment : segments) {
+        const uint8_t* base = segment.external ? segment.external : arena.data() + segment.offset;
+        iov.push_back({const_cast<uint8_t*>(base), segment.size});
+    }
+}
+
+int OutboundMessage::send(Socket& socket) {
+    gather();
+    if (iov.empty()) return 0;
+    return socket.sendallv(iov.data(), static_cast<int>(iov.size()));
+}
+
+int OutboundMessage::try_send(Socket& socket, std::vector<uint8_t>& rest) {
+    gather();
+    if (iov.empty()) return 0;
+    const int sent = socket.trysendv(iov.data(), static_cast<int>(iov.size()));
+    if (sent < 0) return -1;
+
+    // Lo que no salió se copia: los buffers referenciados no viven hasta el próximo envío
+    copy_tail(static_cast<size_t>(sent), rest);
+    return sent;
+}
+
+void OutboundMessage::append_to(std::vector<uint8_t>& rest) {
+    gather();
+    copy_tail(0, rest);
+}
+
+void OutboundMessage::copy_tail(size_t skip, std::vector<uint8_t>& rest) {
+    for (const struct iovec& part : iov) {
+        const uint8_t* base = static_cast<const uint8_t*>(part.iov_base);
+        if (skip >= part.iov_len) {
+            skip -= part.iov_len;
+            continue;
+        }
+        rest.insert(rest.end(), base + skip, base + part.iov_len);
+        skip = 0;
+    }
+}
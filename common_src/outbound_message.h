@@ -0,0 +1,85 @@
+#ifndef OUTBOUND_MESSAGE_H
+#define OUTBOUND_MESSAGE_H
+
+#include <sys/uio.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "socket.h"
+
+// Strings de hasta este largo se copian al arena; los más largos se referencian
+#define OUTBOUND_INLINE_STRING 64
+
+/*
+ * Mensaje saliente armado en pedazos y enviado con un solo gather-write.
+ *
+ * Los campos chicos (tipos, largos, números) se escriben en un arena propio
+ * que se reutiliza entre mensajes: `clear()` no libera memoria, así que una
+ * conexión no vuelve a reservar una vez que pasó su mensaje más grande. Los
+ * bloques grandes (strings largos, buffers ya codificados como los snapshots)
+ * se referencian sin copiarlos y `send()` los junta con `Socket::sendallv`.
+ *
+ * Lo referenciado con `put_ref` / `put_string` tiene que seguir vivo hasta
+ * `send()`. No es thread-safe: cada protocolo lo usa bajo su mutex de envío.
+ * */
+class OutboundMessage {
+private:
+    struct Segment {
+        const uint8_t* external;  // nullptr: el pedazo está en el arena
+        size_t offset;            // posición en el arena (si external == nullptr)
+        size_t size;
+    };
+
+    std::vector<uint8_t> arena;
+    std::vector<Segment> segments;
+    std::vector<struct iovec> iov;
+
+    void append(const void* data, size_t sz);
+    void gather();  // arma `iov` a partir de los segmentos
+    void copy_tail(size_t skip, std::vector<uint8_t>& rest);  // desde `skip`, ya con gather
+
+public:
+    OutboundMessage() = default;
+
+    // Empieza un mensaje nuevo conservando la memoria reservada
+    void clear();
+
+    void put_uint8(uint8_t value);
+    void put_uint16(uint16_t value);  // big endian
+    void put_uint32(uint32_t value);  // big endian
+    void put_uint64(uint64_t value);  // big endian
+    void put_bytes(const void* data, size_t sz);
+    void put_bytes(const std::vector<uint8_t>& bytes) { put_bytes(bytes.data(), bytes.size()); }
+
+    // Referencia sin copiar (tiene que vivir hasta send)
+    void put_ref(const void* data, size_t sz);
+    void put_ref(const std::vector<uint8_t>& bytes) { put_ref(bytes.data(), bytes.size()); }
+
+    // u16 largo | contenido (copiado o referenciado según OUTBOUND_INLINE_STRING)
+    void put_string(const std::string& str);
+
+    size_t size() const;
+
+    /*
+     * Envía todo el mensaje con una sola syscall (salvo envíos parciales).
+     * Misma semántica que `Socket::sendall`: 0 si el socket estaba cerrado.
+     * */
+    int send(Socket& socket);
+
+    /*
+     * Envía lo que el socket acepte sin bloquear y agrega a `rest` una copia
+     * de lo que no salió, para completarlo después. Retorna los bytes
+     * enviados o -1 si la conexión se cerró.
+     * */
+    int try_send(Socket& socket, std::vector<uint8_t>& rest);
+
+    // Agrega a `rest` una copia de todo el mensaje, sin enviar nada
+    void append_to(std::vector<uint8_t>& rest);
+
+    OutboundMessage(const OutboundMessage&) = delete;
+    OutboundMessage& operator=(const OutboundMessage&) = delete;
+};
+
+#endif  // OUTBOUND_MESSAGE_H
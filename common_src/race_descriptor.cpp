@@ -0,0 +1,315 @@
+#include "race_descriptor.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+constexpr char RACE_MAGIC[4] = {'R', 'A', 'C', 'E'};
+constexpr uint16_t RACE_FORMAT_VERSION = 1;
+const char* const COMPILED_SUFFIX = ".race";
+
+// Fecha de modificación y tamaño del YAML: si no cambian no hace falta releerlo
+struct FileStamp {
+    int64_t mtime_ns = -1;
+    int64_t size = -1;
+
+    bool operator==(const FileStamp& other) const {
+        return mtime_ns == other.mtime_ns && size == other.size;
+    }
+};
+
+struct CacheEntry {
+    FileStamp stamp;
+    uint64_t hash = 0;
+    std::shared_ptr<const RaceDescriptor> race;
+};
+
+// Cache en memoria: ruta -> descriptor con el estado del YAML del que salió
+std::mutex cache_mutex;
+std::map<std::string, CacheEntry> cache;
+
+bool stat_file(const std::string& path, FileStamp& out) {
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0) return false;
+    out.mtime_ns = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000LL + info.st_mtim.tv_nsec;
+    out.size = static_cast<int64_t>(info.st_size);
+    return true;
+}
+
+// Escribe en un temporal y lo renombra encima: quien lea `path` ve el binario viejo o el nuevo
+bool write_file_atomically(const std::string& path, const std::vector<uint8_t>& bytes) {
+    const std::string tmp_path = path + ".tmp" + std::to_string(::getpid());
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        file.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+        if (!file.flush()) {
+            file.close();
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool read_file(const std::string& path, std::string& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::ostringstream ss;
+    ss << file.rdbuf();
+    out = ss.str();
+    return true;
+}
+
+// ---- Escritura/lectura binaria (orden de bytes del host: es una cache local) ----
+
+template <typename T>
+void put(std::vector<uint8_t>& buffer, T value) {
+    const size_t offset = buffer.size();
+    buffer.resize(offset + sizeof(T));
+    std::memcpy(buffer.data() + offset, &value, sizeof(T));
+}
+
+void put_string(std::vector<uint8_t>& buffer, const std::string& str) {
+    put<uint16_t>(buffer, static_cast<uint16_t>(str.size()));
+    buffer.insert(buffer.end(), str.begin(), str.end());
+}
+
+class Reader {
+private:
+    const std::vector<uint8_t>& buffer;
+    size_t offset = 0;
+
+public:
+    explicit Reader(const std::vector<uint8_t>& buffer) : buffer(buffer) {}
+
+    template <typename T>
+    bool get(T& value) {
+        if (offset + sizeof(T) > buffer.size()) return false;
+        std::memcpy(&value, buffer.data() + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+    }
+
+    bool get_string(std::string& str) {
+        uint16_t len;
+        if (!get(len) || offset + len > buffer.size()) return false;
+        str.assign(reinterpret_cast<const char*>(buffer.data() + offset), len);
+        offset += len;
+        return true;
+    }
+
+    bool at_end() const { return offset == buffer.size(); }
+};
+
+}  // namespace
+
+uint64_t RaceDescriptor::hash_bytes(const std::string& bytes) {
+    // FNV-1a de 64 bits
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : bytes) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+CheckpointType RaceDescriptor::parse_type(const std::string& type) {
+    if (type == "start") return CheckpointType::START;
+    if (type == "finish") return CheckpointType::FINISH;
+    return CheckpointType::NORMAL;
+}
+
+const char* RaceDescriptor::type_name(CheckpointType type) {
+    switch (type) {
+        case CheckpointType::START: return "start";
+        case CheckpointType::FINISH: return "finish";
+        default: return "normal";
+    }
+}
+
+RaceDescriptor RaceDescriptor::from_yaml_text(const std::string& yaml_text) {
+    YAML::Node root = YAML::Load(yaml_text);
+    RaceDescriptor race;
+
+    if (root["race"]) {
+        const YAML::Node info = root["race"];
+        if (info["name"]) race.name = info["name"].as<std::string>();
+        if (info["city"]) race.city = info["city"].as<std::string>();
+        if (info["total_laps"]) race.total_laps = info["total_laps"].as<int32_t>();
+        if (info["max_time_seconds"]) race.max_time_seconds = info["max_time_seconds"].as<int32_t>();
+    }
+
+    if (root["spawn_points"] && root["spawn_points"].IsSequence()) {
+        for (const auto& node : root["spawn_points"]) {
+            RaceSpawnDef spawn{};
+            spawn.x = node["x"].as<float>();
+            spawn.y = node["y"].as<float>();
+            spawn.angle = node["angle"] ? node["angle"].as<float>() : 0.0f;
+            race.spawn_points.push_back(spawn);
+        }
+    }
+
+    if (root["checkpoints"] && root["checkpoints"].IsSequence()) {
+        for (const auto& node : root["checkpoints"]) {
+            RaceCheckpointDef cp{};
+            cp.id = node["id"] ? node["id"].as<int32_t>() : (int32_t)race.checkpoints.size();
+            cp.type = parse_type(node["type"] ? node["type"].as<std::string>() : "normal");
+            cp.x = node["x"] ? node["x"].as<float>() : (node["cx"] ? node["cx"].as<float>() : 0.f);
+            cp.y = node["y"] ? node["y"].as<float>() : (node["cy"] ? node["cy"].as<float>() : 0.f);
+            if (node["radius"]) {
+                float r = node["radius"].as<float>();
+                cp.width = cp.height = 2.f * r;
+            } else {
+                cp.width = node["width"] ? node["width"].as<float>() : 150.f;
+                cp.height = node["height"] ? node["height"].as<float>() : 150.f;
+            }
+            cp.angle = node["angle"] ? node["angle"].as<float>() : 0.0f;
+            race.checkpoints.push_back(cp);
+        }
+        std::stable_sort(race.checkpoints.begin(), race.checkpoints.end(),
+                         [](const RaceCheckpointDef& a, const RaceCheckpointDef& b) {
+                             return a.id < b.id;
+                         });
+    }
+
+    return race;
+}
+
+std::vector<uint8_t> RaceDescriptor::serialize(uint64_t source_hash) const {
+    std::vector<uint8_t> buffer(RACE_MAGIC, RACE_MAGIC + sizeof(RACE_MAGIC));
+    put<uint16_t>(buffer, RACE_FORMAT_VERSION);
+    put<uint64_t>(buffer, source_hash);
+    put_string(buffer, name);
+    put_string(buffer, city);
+    put<int32_t>(buffer, total_laps);
+    put<int32_t>(buffer, max_time_seconds);
+
+    put<uint16_t>(buffer, static_cast<uint16_t>(spawn_points.size()));
+    for (const auto& sp : spawn_points) {
+        put<float>(buffer, sp.x);
+        put<float>(buffer, sp.y);
+        put<float>(buffer, sp.angle);
+    }
+
+    put<uint16_t>(buffer, static_cast<uint16_t>(checkpoints.size()));
+    for (const auto& cp : checkpoints) {
+        put<int32_t>(buffer, cp.id);
+        put<uint8_t>(buffer, static_cast<uint8_t>(cp.type));
+        put<float>(buffer, cp.x);
+        put<float>(buffer, cp.y);
+        put<float>(buffer, cp.width);
+        put<float>(buffer, cp.height);
+        put<float>(buffer, cp.angle);
+    }
+    return buffer;
+}
+
+bool RaceDescriptor::deserialize(const std::vector<uint8_t>& buffer, uint64_t source_hash,
+                                 RaceDescriptor& out) {
+    if (buffer.size() < sizeof(RACE_MAGIC) ||
+        std::memcmp(buffer.data(), RACE_MAGIC, sizeof(RACE_MAGIC)) != 0) {
+        return false;
+    }
+
+    Reader reader(buffer);
+    char magic[4];
+    uint16_t version;
+    uint64_t hash;
+    for (char& c : magic) reader.get(c);
+    if (!reader.get(version) || version != RACE_FORMAT_VERSION) return false;
+    if (!reader.get(hash) || hash != source_hash) return false;
+
+    RaceDescriptor race;
+    uint16_t count;
+    if (!reader.get_string(race.name) || !reader.get_string(race.city) ||
+        !reader.get(race.total_laps) || !reader.get(race.max_time_seconds) || !reader.get(count)) {
+        return false;
+    }
+
+    race.spawn_points.resize(count);
+    for (auto& sp : race.spawn_points) {
+        if (!reader.get(sp.x) || !reader.get(sp.y) || !reader.get(sp.angle)) return false;
+    }
+
+    if (!reader.get(count)) return false;
+    race.checkpoints.resize(count);
+    for (auto& cp : race.checkpoints) {
+        uint8_t type;
+        if (!reader.get(cp.id) || !reader.get(type) || !reader.get(cp.x) || !reader.get(cp.y) ||
+            !reader.get(cp.width) || !reader.get(cp.height) || !reader.get(cp.angle)) {
+            return false;
+        }
+        cp.type = static_cast<CheckpointType>(type);
+    }
+
+    if (!reader.at_end()) return false;
+    out = std::move(race);
+    return true;
+}
+
+std::shared_ptr<const RaceDescriptor> RaceDescriptor::load(const std::string& yaml_path) {
+    FileStamp stamp;
+    if (!stat_file(yaml_path, stamp)) {
+        throw std::runtime_error("No se pudo abrir la ruta: " + yaml_path);
+    }
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto cached = cache.find(yaml_path);
+    if (cached != cache.end() && cached->second.stamp == stamp) {
+        return cached->second.race;
+    }
+
+    // El YAML cambió en disco (o es la primera carga): recién ahí se lee y hashea
+    std::string yaml_text;
+    if (!read_file(yaml_path, yaml_text)) {
+        throw std::runtime_error("No se pudo abrir la ruta: " + yaml_path);
+    }
+    const uint64_t hash = hash_bytes(yaml_text);
+    if (cached != cache.end() && cached->second.hash == hash) {
+        cached->second.stamp = stamp;  // solo se tocó la fecha
+        return cached->second.race;
+    }
+
+    // 1. Binario compilado, si corresponde al YAML actual
+    const std::string compiled_path = yaml_path + COMPILED_SUFFIX;
+    auto race = std::make_shared<RaceDescriptor>();
+    std::ifstream compiled(compiled_path, std::ios::binary);
+    std::vector<uint8_t> buffer;
+    if (compiled) {
+        buffer.assign(std::istreambuf_iterator<char>(compiled), std::istreambuf_iterator<char>());
+    }
+
+    if (!deserialize(buffer, hash, *race)) {
+        // 2. Compilar desde el YAML y dejar el binario para la próxima
+        *race = from_yaml_text(yaml_text);
+        if (write_file_atomically(compiled_path, race->serialize(hash))) {
+            std::cout << "[RaceDescriptor] Compilado: " << compiled_path << std::endl;
+        } else {
+            std::cerr << "[RaceDescriptor] No se pudo escribir " << compiled_path
+                      << " (se usará solo la cache en memoria)" << std::endl;
+        }
+    }
+
+    std::shared_ptr<const RaceDescriptor> result = race;
+    cache[yaml_path] = {stamp, hash, result};
+    return result;
+}
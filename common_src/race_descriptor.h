@@ -0,0 +1,64 @@
+#ifndef RACE_DESCRIPTOR_H
+#define RACE_DESCRIPTOR_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class CheckpointType : uint8_t { NORMAL = 0, START = 1, FINISH = 2 };
+
+struct RaceSpawnDef {
+    float x;
+    float y;
+    float angle;  // grados (como en el YAML)
+};
+
+struct RaceCheckpointDef {
+    int32_t id;
+    CheckpointType type;
+    float x, y;
+    float width, height;
+    float angle;  // grados (como en el YAML)
+};
+
+/*
+ * Descriptor compilado de una ruta (server_src/city_maps/<ciudad>/<ruta>.yaml).
+ *
+ * La primera vez se parsea el YAML y se guarda una versión binaria al lado
+ * (`<ruta>.yaml.race`, escrita en un temporal y renombrada) con el hash del
+ * YAML fuente. Las siguientes cargas leen el YAML como bytes solo para
+ * hashearlo y, si coincide, usan el binario con una única lectura, sin pasar
+ * por yaml-cpp. Además se cachea en memoria por proceso junto con la fecha y
+ * el tamaño del YAML: mientras no cambien, las transiciones entre carreras
+ * solo hacen un stat().
+ */
+struct RaceDescriptor {
+    std::string name;
+    std::string city;
+    int32_t total_laps = 1;
+    int32_t max_time_seconds = 0;
+    std::vector<RaceSpawnDef> spawn_points;
+    std::vector<RaceCheckpointDef> checkpoints;  // ordenados por id
+
+    // Parsea el YAML de la ruta (mismos defaults que usaba el GameLoop)
+    static RaceDescriptor from_yaml_text(const std::string& yaml_text);
+
+    std::vector<uint8_t> serialize(uint64_t source_hash) const;
+    // false si el buffer no es un descriptor válido para `source_hash`
+    static bool deserialize(const std::vector<uint8_t>& buffer, uint64_t source_hash,
+                            RaceDescriptor& out);
+
+    /**
+     * Carga la ruta usando la cache en memoria o el binario compilado; si
+     * ninguno corresponde al hash actual del YAML, lo compila. Lanza
+     * runtime_error si el YAML no existe o es inválido.
+     */
+    static std::shared_ptr<const RaceDescriptor> load(const std::string& yaml_path);
+
+    static uint64_t hash_bytes(const std::string& bytes);
+    static CheckpointType parse_type(const std::string& type);
+    static const char* type_name(CheckpointType type);
+};
+
+#endif  // RACE_DESCRIPTOR_H
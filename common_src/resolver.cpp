@@ -14,7 +14,7 @@
 #include "liberror.h"
 #include "resolvererror.h"
 
-Resolver::Resolver(const char* hostname, const char* servname, bool is_passive) {
+Resolver::Resolver(const char* hostname, const char* servname, bool is_passive, int socktype) {
     struct addrinfo hints;
     this->result = this->_next = nullptr;
 
@@ -32,7 +32,7 @@ Resolver::Resolver(const char* hostname, const char* servname, bool is_passive)
      * */
     memset(&hints, 0, sizeof(struct addrinfo));
     hints.ai_family = AF_INET;       /* IPv4 (or AF_INET6 for IPv6)     */
-    hints.ai_socktype = SOCK_STREAM; /* TCP  (or SOCK_DGRAM for UDP)    */
+    hints.ai_socktype = socktype;    /* TCP  (or SOCK_DGRAM for UDP)    */
     hints.ai_flags = is_passive ? AI_PASSIVE : 0;
 
     /* Obtengo la (o las) direcciones según el nombre de host y servicio que
@@ -9,7 +9,7 @@
  * "Resolvedor" de hostnames y service names.
  *
  * Por simplificación este TDA se enfocara solamente
- * en direcciones IPv4 para TCP.
+ * en direcciones IPv4 (TCP por defecto, UDP con `socktype = SOCK_DGRAM`).
  * */
 class Resolver {
 private:
@@ -40,7 +40,8 @@ public:
      *
      * En caso de error se lanza una excepción.
      * */
-    Resolver(const char* hostname, const char* servname, bool is_passive);
+    Resolver(const char* hostname, const char* servname, bool is_passive,
+             int socktype = SOCK_STREAM);
 
     /*
      * Deshabilitamos el constructor por copia y operador asignación por copia
@@ -0,0 +1,568 @@
+#include "snapshot_codec.h"
+
+#include <netinet/in.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+using namespace SnapshotCodec;
+
+namespace {
+
+void push_uint8(std::vector<uint8_t>& buffer, uint8_t value) { buffer.push_back(value); }
+
+void push_uint16(std::vector<uint8_t>& buffer, uint16_t value) {
+    uint16_t net_value = htons(value);
+    buffer.push_back(reinterpret_cast<uint8_t*>(&net_value)[0]);
+    buffer.push_back(reinterpret_cast<uint8_t*>(&net_value)[1]);
+}
+
+void push_uint32(std::vector<uint8_t>& buffer, uint32_t value) {
+    uint32_t net_value = htonl(value);
+    for (int i = 0; i < 4; ++i) buffer.push_back(reinterpret_cast<uint8_t*>(&net_value)[i]);
+}
+
+void push_string(std::vector<uint8_t>& buffer, const std::string& str) {
+    push_uint16(buffer, static_cast<uint16_t>(str.size()));
+    buffer.insert(buffer.end(), str.begin(), str.end());
+}
+
+// Tipo y lugar para el u32 de largo; end_frame lo completa al terminar el cuerpo
+size_t begin_frame(std::vector<uint8_t>& buffer, ServerMessageType type) {
+    push_uint8(buffer, static_cast<uint8_t>(type));
+    const size_t at = buffer.size();
+    push_uint32(buffer, 0);
+    return at;
+}
+
+void end_frame(std::vector<uint8_t>& buffer, size_t at) {
+    const uint32_t len_net = htonl(static_cast<uint32_t>(buffer.size() - at - sizeof(uint32_t)));
+    std::memcpy(buffer.data() + at, &len_net, sizeof(len_net));
+}
+
+}  // namespace
+
+// ============================================================================
+// CUANTIZACIÓN
+// ============================================================================
+
+namespace {
+
+constexpr float kTwoPi = 6.28318530718f;
+constexpr uint32_t kAngleSteps = 1u << SNAPSHOT_ANGLE_BITS;
+
+uint16_t quantize_axis(float value, float extent) {
+    const float q = std::round(value * 65536.0f / extent);
+    return static_cast<uint16_t>(std::clamp(q, 0.0f, 65535.0f));
+}
+
+}  // namespace
+
+uint16_t SnapshotCodec::quantize_angle(float radians) {
+    // Llevar a [0, 2π) antes de cuantizar: los negativos ya no se rompen al castear
+    float wrapped = std::fmod(radians, kTwoPi);
+    if (wrapped < 0.0f) wrapped += kTwoPi;
+    const auto q = static_cast<uint32_t>(std::lround(wrapped * kAngleSteps / kTwoPi));
+    return static_cast<uint16_t>(q % kAngleSteps);
+}
+
+float SnapshotCodec::dequantize_angle(uint16_t q) {
+    return static_cast<float>(q % kAngleSteps) * kTwoPi / kAngleSteps;
+}
+
+int32_t SnapshotCodec::quantize_motion(float value) {
+    return static_cast<int32_t>(std::lround(value * SNAPSHOT_MOTION_SCALE));
+}
+
+float SnapshotCodec::dequantize_motion(int32_t q) {
+    return static_cast<float>(q) / SNAPSHOT_MOTION_SCALE;
+}
+
+uint16_t Bounds::quantize_x(float x) const { return quantize_axis(x, width); }
+uint16_t Bounds::quantize_y(float y) const { return quantize_axis(y, height); }
+
+void BitWriter::put(uint32_t value, int bits) {
+    acc = (acc << bits) | (value & ((uint64_t{1} << bits) - 1));
+    pending += bits;
+    while (pending >= 8) {
+        pending -= 8;
+        out.push_back(static_cast<uint8_t>(acc >> pending));
+    }
+}
+
+void BitWriter::put_varint(uint32_t value) {
+    do {
+        const uint32_t chunk = value & 0x7F;
+        value >>= 7;
+        put(chunk | (value ? 0x80 : 0), 8);
+    } while (value);
+}
+
+void BitWriter::align() {
+    if (pending > 0) put(0, 8 - pending);
+}
+
+bool ManifestEntry::matches(const InfoPlayer& p) const {
+    return player_id == static_cast<uint16_t>(p.player_id) && car_id == p.car_id &&
+           username == p.username && car_name == p.car_name && car_type == p.car_type;
+}
+
+PlayerWire PlayerWire::from(const InfoPlayer& p, const Bounds& bounds) {
+    PlayerWire w;
+    w.player_id = static_cast<uint16_t>(p.player_id);
+    w.pos_x = bounds.quantize_x(p.pos_x);
+    w.pos_y = bounds.quantize_y(p.pos_y);
+    w.angle = quantize_angle(p.angle);
+    w.speed = quantize_motion(p.speed);
+    w.velocity_x = quantize_motion(p.velocity_x);
+    w.velocity_y = quantize_motion(p.velocity_y);
+    w.health = static_cast<uint8_t>(p.health);
+    w.nitro_amount = static_cast<uint8_t>(p.nitro_amount);
+    w.flags = (p.nitro_active ? FLAG_NITRO_ACTIVE : 0) | (p.is_drifting ? FLAG_DRIFTING : 0) |
+              (p.is_colliding ? FLAG_COLLIDING : 0) | (p.race_finished ? FLAG_RACE_FINISHED : 0) |
+              (p.is_alive ? FLAG_ALIVE : 0) | (p.disconnected ? FLAG_DISCONNECTED : 0);
+    w.completed_laps = static_cast<uint16_t>(p.completed_laps);
+    w.current_checkpoint = static_cast<uint16_t>(p.current_checkpoint);
+    w.position_in_race = static_cast<uint8_t>(p.position_in_race);
+    w.race_time_ms = static_cast<uint32_t>(p.race_time_ms);
+    w.total_time_ms = static_cast<uint32_t>(p.total_time_ms);
+    w.last_input = p.last_input;
+    return w;
+}
+
+void PlayerWire::to(InfoPlayer& p, const Bounds& bounds) const {
+    p.player_id = player_id;
+    p.in_view = in_view;
+    p.pos_x = bounds.dequantize_x(pos_x);
+    p.pos_y = bounds.dequantize_y(pos_y);
+    p.angle = dequantize_angle(angle);
+    p.speed = dequantize_motion(speed);
+    p.velocity_x = dequantize_motion(velocity_x);
+    p.velocity_y = dequantize_motion(velocity_y);
+    p.health = health;
+    p.nitro_amount = nitro_amount;
+    p.nitro_active = (flags & FLAG_NITRO_ACTIVE) != 0;
+    p.is_drifting = (flags & FLAG_DRIFTING) != 0;
+    p.is_colliding = (flags & FLAG_COLLIDING) != 0;
+    p.race_finished = (flags & FLAG_RACE_FINISHED) != 0;
+    p.is_alive = (flags & FLAG_ALIVE) != 0;
+    p.disconnected = (flags & FLAG_DISCONNECTED) != 0;
+    p.completed_laps = completed_laps;
+    p.current_checkpoint = current_checkpoint;
+    p.position_in_race = position_in_race;
+    p.race_time_ms = static_cast<int32_t>(race_time_ms);
+    p.total_time_ms = static_cast<int32_t>(total_time_ms);
+    p.last_input = last_input;
+}
+
+uint16_t PlayerWire::diff(const PlayerWire& base) const {
+    uint16_t mask = 0;
+    if (pos_x != base.pos_x || pos_y != base.pos_y) mask |= FIELD_POSITION;
+    if (angle != base.angle) mask |= FIELD_ANGLE;
+    if (speed != base.speed) mask |= FIELD_SPEED;
+    if (velocity_x != base.velocity_x || velocity_y != base.velocity_y) mask |= FIELD_VELOCITY;
+    if (health != base.health) mask |= FIELD_HEALTH;
+    if (nitro_amount != base.nitro_amount) mask |= FIELD_NITRO;
+    if (flags != base.flags) mask |= FIELD_FLAGS;
+    if (completed_laps != base.completed_laps) mask |= FIELD_LAPS;
+    if (current_checkpoint != base.current_checkpoint) mask |= FIELD_CHECKPOINT;
+    if (position_in_race != base.position_in_race) mask |= FIELD_RACE_POSITION;
+    if (race_time_ms != base.race_time_ms) mask |= FIELD_RACE_TIME;
+    if (total_time_ms != base.total_time_ms) mask |= FIELD_TOTAL_TIME;
+    if (last_input != base.last_input) mask |= FIELD_LAST_INPUT;
+    return mask;
+}
+
+RaceWire RaceWire::from(const RaceInfo& r) {
+    RaceWire w;
+    w.status = static_cast<uint8_t>(r.status);
+    w.race_number = static_cast<uint8_t>(r.race_number);
+    w.total_races = static_cast<uint8_t>(r.total_races);
+    w.remaining_time_ms = static_cast<uint32_t>(r.remaining_time_ms);
+    w.players_finished = static_cast<uint8_t>(r.players_finished);
+    w.total_players = static_cast<uint8_t>(r.total_players);
+    return w;
+}
+
+void RaceWire::to(RaceInfo& r) const {
+    r.status = static_cast<MatchStatus>(status);
+    r.race_number = race_number;
+    r.total_races = total_races;
+    r.remaining_time_ms = static_cast<int32_t>(remaining_time_ms);
+    r.players_finished = players_finished;
+    r.total_players = total_players;
+}
+
+uint8_t RaceWire::diff(const RaceWire& base) const {
+    uint8_t mask = 0;
+    if (status != base.status) mask |= RACE_STATUS;
+    if (race_number != base.race_number) mask |= RACE_NUMBER;
+    if (total_races != base.total_races) mask |= RACE_TOTAL_RACES;
+    if (remaining_time_ms != base.remaining_time_ms) mask |= RACE_REMAINING_TIME;
+    if (players_finished != base.players_finished) mask |= RACE_PLAYERS_FINISHED;
+    if (total_players != base.total_players) mask |= RACE_TOTAL_PLAYERS;
+    return mask;
+}
+
+const PlayerWire* Frame::find(uint16_t player_id, size_t hint) const {
+    // El orden de los jugadores casi nunca cambia: probar primero la misma posición
+    if (hint < players.size() && players[hint].player_id == player_id) return &players[hint];
+    for (const auto& p : players) {
+        if (p.player_id == player_id) return &p;
+    }
+    return nullptr;
+}
+
+// ============================================================================
+// ENCODER (servidor, uno por partida)
+// ============================================================================
+
+namespace {
+
+/*
+ * Cada encoder numera secuencias y versiones de manifest en su propio rango
+ * (los 8 bits altos cambian por partida): un ack o un manifest de otra
+ * partida nunca coincide con los de esta.
+ */
+std::atomic<uint32_t> next_encoder_epoch{0};
+
+// Qué recibe un jugador en el mensaje de un cliente
+enum class Tier { UPDATE, HOLD, SUMMARY };
+
+Tier tier_of(uint8_t slot, const View& had, const Interest& interest, uint64_t far_now) {
+    const uint64_t bit = slot_bit(slot);
+    if (bit == 0 || (interest.near & bit)) return Tier::UPDATE;
+    if (!(interest.far & bit)) return Tier::SUMMARY;
+    // Un lejano se retiene solo si el cliente ya lo tiene en la base
+    return (far_now & bit) || !(had.present & bit) ? Tier::UPDATE : Tier::HOLD;
+}
+
+}  // namespace
+
+SnapshotEncoder::SnapshotEncoder()
+    : manifest_message(std::make_shared<const std::vector<uint8_t>>()),
+      manifest_version(next_encoder_epoch.fetch_add(1, std::memory_order_relaxed) << 24),
+      next_sequence(manifest_version + 1), near_radius(SNAPSHOT_NEAR_RADIUS),
+      far_radius(SNAPSHOT_FAR_RADIUS), far_interval(SNAPSHOT_FAR_INTERVAL) {}
+
+void SnapshotEncoder::set_interest(float near, float far, int interval) {
+    near_radius = near;
+    far_radius = far;
+    far_interval = static_cast<uint32_t>(std::max(1, interval));
+}
+
+void SnapshotEncoder::set_bounds(float width, float height) {
+    // Enteros como viajan en el manifest, así ambos lados cuantizan igual
+    Bounds next;
+    next.width = std::clamp(std::ceil(width), 1.0f, 65535.0f);
+    next.height = std::clamp(std::ceil(height), 1.0f, 65535.0f);
+    if (next.width == bounds.width && next.height == bounds.height) return;
+
+    bounds = next;
+    manifest_message = std::make_shared<const std::vector<uint8_t>>();  // fuerza reenvío
+}
+
+void SnapshotEncoder::update_manifest(const GameState& snapshot) {
+    bool changed = manifest_message->empty() || manifest.size() != snapshot.players.size();
+    for (size_t i = 0; !changed && i < manifest.size(); ++i) {
+        changed = !manifest[i].matches(snapshot.players[i]);
+    }
+    if (!changed) return;
+
+    // Un slot por jugador, en el orden del snapshot
+    manifest.resize(snapshot.players.size());
+    for (size_t i = 0; i < manifest.size(); ++i) {
+        const InfoPlayer& p = snapshot.players[i];
+        manifest[i].player_id = static_cast<uint16_t>(p.player_id);
+        manifest[i].car_id = p.car_id;
+        manifest[i].username = p.username;
+        manifest[i].car_name = p.car_name;
+        manifest[i].car_type = p.car_type;
+    }
+
+    auto message = std::make_shared<std::vector<uint8_t>>();
+    const size_t length_at = begin_frame(*message, ServerMessageType::RACE_MANIFEST);
+    push_uint8(*message, SNAPSHOT_CODEC_VERSION);
+    push_uint16(*message, static_cast<uint16_t>(bounds.width));
+    push_uint16(*message, static_cast<uint16_t>(bounds.height));
+    push_uint8(*message, static_cast<uint8_t>(manifest.size()));
+    for (const ManifestEntry& entry : manifest) {
+        push_uint16(*message, entry.player_id);
+        push_uint8(*message, entry.car_id);
+        push_string(*message, entry.username);
+        push_string(*message, entry.car_name);
+        push_string(*message, entry.car_type);
+    }
+    end_frame(*message, length_at);
+    manifest_message = std::move(message);
+    ++manifest_version;
+}
+
+uint8_t SnapshotEncoder::slot_of(uint16_t player_id, size_t hint) const {
+    if (hint < manifest.size() && manifest[hint].player_id == player_id)
+        return static_cast<uint8_t>(hint);
+    for (size_t i = 0; i < manifest.size(); ++i) {
+        if (manifest[i].player_id == player_id) return static_cast<uint8_t>(i);
+    }
+    return 0;
+}
+
+SnapshotHandle SnapshotEncoder::encode(const GameState& snapshot, uint32_t tick) {
+    update_manifest(snapshot);
+
+    auto encoded = std::make_shared<EncodedSnapshot>();
+    encoded->sequence = next_sequence++;
+    encoded->tick = tick;
+    encoded->keyframe_due = encoded->sequence % SNAPSHOT_KEYFRAME_INTERVAL == 0;
+    encoded->manifest_version = manifest_version;
+    encoded->manifest = manifest_message;
+    encoded->baselines = history;
+    encoded->near_radius = near_radius;
+    encoded->far_radius = far_radius;
+    encoded->far_interval = far_interval;
+    encoded->bounds = bounds;
+
+    auto frame = std::make_shared<Frame>();
+    frame->sequence = encoded->sequence;
+    frame->players.reserve(snapshot.players.size());
+    for (size_t i = 0; i < snapshot.players.size(); ++i) {
+        frame->players.push_back(PlayerWire::from(snapshot.players[i], bounds));
+        frame->players.back().slot = slot_of(frame->players.back().player_id, i);
+    }
+    frame->race = RaceWire::from(snapshot.race_info);
+    encoded->frame = frame;
+    history[encoded->sequence % SNAPSHOT_HISTORY] = std::move(frame);
+
+    BitWriter tail(encoded->tail);
+
+    // ---- 3. CHECKPOINTS ----
+    tail.put_varint(static_cast<uint32_t>(snapshot.checkpoints.size()));
+    for (const CheckpointInfo& c : snapshot.checkpoints) {
+        tail.put_signed(c.id);
+        tail.put(bounds.quantize_x(c.pos_x), 16);
+        tail.put(bounds.quantize_y(c.pos_y), 16);
+        tail.put_varint(static_cast<uint32_t>(std::lround(std::max(0.0f, c.width) * 100.0f)));
+        tail.put(quantize_angle(c.angle), SNAPSHOT_ANGLE_BITS);
+        tail.put(c.is_start ? 1 : 0, 1);
+        tail.put(c.is_finish ? 1 : 0, 1);
+    }
+
+    // ---- 4. NPCs ----
+    tail.put_varint(static_cast<uint32_t>(snapshot.npcs.size()));
+    for (const NPCCarInfo& n : snapshot.npcs) {
+        tail.put_signed(n.npc_id);
+        tail.put(bounds.quantize_x(n.pos_x), 16);
+        tail.put(bounds.quantize_y(n.pos_y), 16);
+        tail.put(quantize_angle(n.angle), SNAPSHOT_ANGLE_BITS);
+        tail.put_signed(quantize_motion(n.speed));
+        tail.put(n.is_parked ? 1 : 0, 1);
+    }
+
+    // ---- 5. EVENTS ----
+    tail.put_varint(static_cast<uint32_t>(snapshot.events.size()));
+    for (const GameEvent& e : snapshot.events) {
+        tail.put(static_cast<uint8_t>(e.type), 8);
+        tail.put_signed(e.player_id);
+        tail.put(bounds.quantize_x(e.pos_x), 16);
+        tail.put(bounds.quantize_y(e.pos_y), 16);
+    }
+    tail.align();
+
+    return encoded;
+}
+
+// ============================================================================
+// SNAPSHOT COMPARTIDO
+// ============================================================================
+
+uint32_t EncodedSnapshot::pick_baseline(uint32_t acked) const {
+    if (keyframe_due || acked == 0 || sequence - acked >= SNAPSHOT_HISTORY) return 0;
+
+    const auto& frame_ptr = baselines[acked % SNAPSHOT_HISTORY];
+    return frame_ptr && frame_ptr->sequence == acked ? acked : 0;
+}
+
+uint64_t EncodedSnapshot::far_update_mask() const {
+    // Escalonado por slot para repartir los lejanos entre ticks
+    uint64_t mask = 0;
+    for (const PlayerWire& w : frame->players) {
+        if ((sequence + w.slot) % far_interval == 0) mask |= slot_bit(w.slot);
+    }
+    return mask;
+}
+
+Interest EncodedSnapshot::interest_for(int viewer_id) const {
+    Interest interest;  // todos cercanos
+    if (viewer_id < 0 || near_radius <= 0.0f) return interest;
+
+    const PlayerWire* viewer = frame->find(static_cast<uint16_t>(viewer_id), 0);
+    if (!viewer) return interest;
+
+    const float near_sq = near_radius * near_radius;
+    const float far_sq = far_radius * far_radius;
+    interest.near = 0;
+    for (const PlayerWire& w : frame->players) {
+        const float dx = bounds.dequantize_x(w.pos_x) - bounds.dequantize_x(viewer->pos_x);
+        const float dy = bounds.dequantize_y(w.pos_y) - bounds.dequantize_y(viewer->pos_y);
+        const float dist_sq = dx * dx + dy * dy;
+        if (&w == viewer || dist_sq <= near_sq) {
+            interest.near |= slot_bit(w.slot);
+        } else if (dist_sq <= far_sq) {
+            interest.far |= slot_bit(w.slot);
+        }
+    }
+    return interest;
+}
+
+const std::vector<uint8_t>& EncodedSnapshot::message_for(uint32_t acked, const View& had,
+                                                         const Interest& interest,
+                                                         View& sent) const {
+    // Sin registro de lo que tenía el cliente en la base no hay delta posible
+    uint32_t baseline = pick_baseline(acked);
+    if (had.sequence != baseline) baseline = 0;
+    const View base_view = baseline ? had : View{};
+
+    const uint64_t far_now = far_update_mask();
+    sent = View{};
+    sent.sequence = sequence;
+    for (const PlayerWire& w : frame->players) {
+        const Tier tier = tier_of(w.slot, base_view, interest, far_now);
+        if (tier == Tier::SUMMARY) continue;
+        sent.present |= slot_bit(w.slot);
+        if (tier == Tier::UPDATE) sent.exact |= slot_bit(w.slot);
+    }
+
+    // Los Sender en la misma situación (base e interés) reciben los mismos bytes
+    const MessageKey key(baseline, base_view.present, base_view.exact, interest.near,
+                         interest.far);
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = messages.find(key);
+    if (it != messages.end()) return it->second;
+
+    std::vector<uint8_t>& buffer = messages[key];
+    write_message(baseline ? baselines[baseline % SNAPSHOT_HISTORY].get() : nullptr, base_view,
+                  interest, buffer);
+    return buffer;
+}
+
+void EncodedSnapshot::write_message(const Frame* baseline, const View& had,
+                                    const Interest& interest, std::vector<uint8_t>& buffer) const {
+    const uint64_t far_now = far_update_mask();
+    uint32_t updated = 0, held = 0, summarized = 0;
+    for (const PlayerWire& w : frame->players) {
+        switch (tier_of(w.slot, had, interest, far_now)) {
+            case Tier::UPDATE: ++updated; break;
+            case Tier::HOLD: ++held; break;
+            case Tier::SUMMARY: ++summarized; break;
+        }
+    }
+
+    buffer.reserve(16 + frame->players.size() * 24 + tail.size());
+    const size_t length_at = begin_frame(buffer, ServerMessageType::GAME_STATE_UPDATE);
+    push_uint32(buffer, sequence);
+    push_uint32(buffer, baseline ? baseline->sequence : 0);
+    BitWriter bits(buffer);
+
+    // ---- 1. PLAYERS (actualizados) ----
+    bits.put_varint(updated);
+    for (size_t i = 0; i < frame->players.size(); ++i) {
+        const PlayerWire& w = frame->players[i];
+        if (tier_of(w.slot, had, interest, far_now) != Tier::UPDATE) continue;
+
+        // Delta solo si el cliente tiene el valor exacto de la base
+        const uint64_t bit = slot_bit(w.slot);
+        const bool exact = bit == 0 || (had.exact & bit);
+        const PlayerWire* base = baseline && exact ? baseline->find(w.player_id, i) : nullptr;
+        const uint16_t mask = base ? w.diff(*base) : static_cast<uint16_t>(FIELD_ALL);
+        // Con la máscara completa el decoder toma cero como referencia de las diferencias
+        static const PlayerWire zero;
+        const PlayerWire& ref = base && mask != FIELD_ALL ? *base : zero;
+
+        bits.put(w.slot, 8);
+        bits.put(mask, 13);
+        if (mask & FIELD_POSITION) {
+            bits.put(w.pos_x, 16);
+            bits.put(w.pos_y, 16);
+        }
+        if (mask & FIELD_ANGLE) bits.put(w.angle, SNAPSHOT_ANGLE_BITS);
+        if (mask & FIELD_SPEED) bits.put_signed(w.speed - ref.speed);
+        if (mask & FIELD_VELOCITY) {
+            bits.put_signed(w.velocity_x - ref.velocity_x);
+            bits.put_signed(w.velocity_y - ref.velocity_y);
+        }
+        if (mask & FIELD_HEALTH) bits.put(w.health, 8);
+        if (mask & FIELD_NITRO) bits.put(w.nitro_amount, 8);
+        if (mask & FIELD_FLAGS) bits.put(w.flags, 6);
+        if (mask & FIELD_LAPS) bits.put_varint(w.completed_laps);
+        if (mask & FIELD_CHECKPOINT) bits.put_varint(w.current_checkpoint);
+        if (mask & FIELD_RACE_POSITION) bits.put(w.position_in_race, 8);
+        if (mask & FIELD_RACE_TIME) {
+            bits.put_signed(static_cast<int32_t>(w.race_time_ms - ref.race_time_ms));
+        }
+        if (mask & FIELD_TOTAL_TIME) {
+            bits.put_signed(static_cast<int32_t>(w.total_time_ms - ref.total_time_ms));
+        }
+        if (mask & FIELD_LAST_INPUT) {
+            bits.put_signed(static_cast<int32_t>(w.last_input - ref.last_input));
+        }
+    }
+
+    // ---- Retenidos (lejanos que no tocan este tick) ----
+    bits.put_varint(held);
+    for (const PlayerWire& w : frame->players) {
+        if (tier_of(w.slot, had, interest, far_now) == Tier::HOLD) bits.put(w.slot, 8);
+    }
+
+    // ---- Fuera de interés: resumen para el ranking ----
+    bits.put_varint(summarized);
+    for (const PlayerWire& w : frame->players) {
+        if (tier_of(w.slot, had, interest, far_now) != Tier::SUMMARY) continue;
+        bits.put(w.slot, 8);
+        bits.put(w.flags, 6);
+        bits.put_varint(w.completed_laps);
+        bits.put(w.position_in_race, 8);
+        bits.put_varint(w.race_time_ms);
+        bits.put_varint(w.total_time_ms);
+    }
+
+    // ---- 2. RACE INFO ----
+    const RaceWire& race = frame->race;
+    const uint8_t race_mask = baseline ? race.diff(baseline->race) : static_cast<uint8_t>(RACE_ALL);
+    bits.put(race_mask, 6);
+    if (race_mask & RACE_STATUS) bits.put(race.status, 8);
+    if (race_mask & RACE_NUMBER) bits.put(race.race_number, 8);
+    if (race_mask & RACE_TOTAL_RACES) bits.put(race.total_races, 8);
+    if (race_mask & RACE_REMAINING_TIME) bits.put_varint(race.remaining_time_ms);
+    if (race_mask & RACE_PLAYERS_FINISHED) bits.put(race.players_finished, 8);
+    if (race_mask & RACE_TOTAL_PLAYERS) bits.put(race.total_players, 8);
+    bits.align();
+
+    // ---- 3..5. CHECKPOINTS, NPCs, EVENTS (ya serializados) ----
+    buffer.insert(buffer.end(), tail.begin(), tail.end());
+    end_frame(buffer, length_at);
+}
+
+// ============================================================================
+// ESTADO POR CONEXIÓN
+// ============================================================================
+
+SnapshotStream::SnapshotStream() : acked(0), manifest_version(0), viewer_id(-1), sent() {}
+
+const std::vector<uint8_t>* SnapshotStream::manifest_for(const EncodedSnapshot& snapshot) {
+    if (snapshot.get_manifest_version() == manifest_version) return nullptr;
+    manifest_version = snapshot.get_manifest_version();
+    return &snapshot.manifest_message();
+}
+
+const std::vector<uint8_t>& SnapshotStream::message_for(const EncodedSnapshot& snapshot) {
+    const uint32_t base = acked.load(std::memory_order_relaxed);
+    const View& had = sent[base % SNAPSHOT_HISTORY];
+
+    View now;
+    const std::vector<uint8_t>& message =
+            snapshot.message_for(base, had, snapshot.interest_for(viewer_id), now);
+    sent[now.sequence % SNAPSHOT_HISTORY] = now;
+    return message;
+}
@@ -0,0 +1,601 @@
+#ifndef SNAPSHOT_CODEC_H
+#define SNAPSHOT_CODEC_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "dtos.h"
+#include "game_state.h"
+
+// Cada cuántos snapshots se fuerza uno completo (keyframe), ~1 s a 60 Hz
+#define SNAPSHOT_KEYFRAME_INTERVAL 60
+// Snapshots recordados por cada lado para usar como base de un delta
+#define SNAPSHOT_HISTORY 32
+
+// Área de interés por cliente (px del mapa), ajustable en config.yaml
+#define SNAPSHOT_NEAR_RADIUS 600.0f  // viewport de 700x700 + margen: todos los ticks
+#define SNAPSHOT_FAR_RADIUS 1000.0f  // alcance del minimapa: cada SNAPSHOT_FAR_INTERVAL
+#define SNAPSHOT_FAR_INTERVAL 4
+
+// Formato compacto: la versión viaja en el RACE_MANIFEST
+#define SNAPSHOT_CODEC_VERSION 3
+#define SNAPSHOT_ANGLE_BITS 14             // ángulos en [0, 2π): ~0.02° de resolución
+#define SNAPSHOT_DEFAULT_BOUNDS 8192.0f    // px, si la partida no informó el tamaño del mapa
+#define SNAPSHOT_MOTION_SCALE 16.0f        // rapidez y velocidad en 1/16 px/s
+
+/*
+ * Codec de snapshots con deltas contra la última base confirmada.
+ *
+ * Los strings de cada jugador (username, auto) no viajan en el snapshot:
+ * cuando cambia el plantel (inicio de carrera, alta o baja) se manda antes un
+ * RACE_MANIFEST que asigna a cada jugador un slot compacto:
+ *   u8 versión del codec | u16 ancho | u16 alto del mapa (px)
+ *   u8 cantidad, y por cada slot: u16 player_id | u8 car_id | 3 strings
+ *
+ * Ambos mensajes van enmarcados: byte de tipo | u32 largo del cuerpo | cuerpo,
+ * así el cliente los recibe enteros y los parsea desde memoria (FrameReader).
+ *
+ * Formato del snapshot (cuerpo del GAME_STATE_UPDATE):
+ *   u32 sequence | u32 baseline (0 = keyframe)
+ *   y a continuación un flujo de bits (BitWriter, alineado a byte al final):
+ *   varint cantidad de actualizados, y por cada uno: 8 slot | 13 máscara | campos
+ *   varint cantidad de retenidos, y por cada uno: 8 slot (se copia de la base)
+ *   varint cantidad fuera de interés, y por cada uno: 8 slot | ranking
+ *   6 máscara de race_info | campos
+ *   checkpoints, NPCs y eventos completos (otro flujo de bits alineado)
+ *
+ * Cuantización: posiciones en 16 bits relativas al tamaño del mapa (Bounds),
+ * ángulos módulo 2π en SNAPSHOT_ANGLE_BITS, rapidez y velocidad en 1/16 px/s
+ * y contadores como varint. Rapidez, velocidad, tiempos de carrera y el
+ * último input aplicado viajan como varint con signo de la diferencia con la
+ * base (cambian poco por tick).
+ *
+ * Área de interés: respecto del auto de cada cliente, los jugadores cercanos
+ * se actualizan en todos los snapshots; los lejanos (dentro del minimapa)
+ * uno de cada SNAPSHOT_FAR_INTERVAL y en el resto se retienen con el último
+ * valor que tiene el cliente; los demás solo mandan su resumen de ranking.
+ *
+ * Un campo se envía solo si su bit está en la máscara, es decir si su valor
+ * cuantizado difiere del de la base (o si el jugador no estaba en ella). El
+ * cliente confirma cada snapshot con CMD_SNAPSHOT_ACK y el servidor usa el
+ * último confirmado como base. Si la base ya salió del historial, o pasaron
+ * SNAPSHOT_KEYFRAME_INTERVAL snapshots, se envía un keyframe.
+ *
+ * El servidor codifica una vez por tick (SnapshotEncoder, uno por partida) y
+ * reparte el mismo EncodedSnapshot a todos los Sender. Cada variante del
+ * mensaje (keyframe o delta contra una base) se arma la primera vez que algún
+ * cliente la pide; los que confirmaron la misma base comparten los bytes.
+ */
+namespace SnapshotCodec {
+
+// Bits de la máscara por jugador
+enum PlayerField : uint16_t {
+    FIELD_POSITION = 1 << 0,
+    FIELD_ANGLE = 1 << 1,
+    FIELD_SPEED = 1 << 2,
+    FIELD_VELOCITY = 1 << 3,
+    FIELD_HEALTH = 1 << 4,
+    FIELD_NITRO = 1 << 5,
+    FIELD_FLAGS = 1 << 6,
+    FIELD_LAPS = 1 << 7,
+    FIELD_CHECKPOINT = 1 << 8,
+    FIELD_RACE_POSITION = 1 << 9,
+    FIELD_RACE_TIME = 1 << 10,
+    FIELD_TOTAL_TIME = 1 << 11,
+    FIELD_LAST_INPUT = 1 << 12,
+    FIELD_ALL = 0x1FFF
+};
+
+// Bits de la máscara de race_info
+enum RaceField : uint8_t {
+    RACE_STATUS = 1 << 0,
+    RACE_NUMBER = 1 << 1,
+    RACE_TOTAL_RACES = 1 << 2,
+    RACE_REMAINING_TIME = 1 << 3,
+    RACE_PLAYERS_FINISHED = 1 << 4,
+    RACE_TOTAL_PLAYERS = 1 << 5,
+    RACE_ALL = 0x3F
+};
+
+// Flags empaquetados en un byte
+enum PlayerFlag : uint8_t {
+    FLAG_NITRO_ACTIVE = 0x01,
+    FLAG_DRIFTING = 0x02,
+    FLAG_COLLIDING = 0x04,
+    FLAG_RACE_FINISHED = 0x08,
+    FLAG_ALIVE = 0x10,
+    FLAG_DISCONNECTED = 0x20
+};
+
+// Datos estáticos de un jugador, indexados por slot en el RACE_MANIFEST
+struct ManifestEntry : RosterEntry {
+    bool matches(const InfoPlayer& p) const;
+};
+
+// ---- Cuantización ----
+
+// Cualquier ángulo (también negativo o > 2π) a SNAPSHOT_ANGLE_BITS bits
+uint16_t quantize_angle(float radians);
+float dequantize_angle(uint16_t q);  // en [0, 2π)
+
+// Rapidez y velocidades (con signo) en 1/SNAPSHOT_MOTION_SCALE px/s
+int32_t quantize_motion(float value);
+float dequantize_motion(int32_t q);
+
+// Posiciones en 16 bits relativas al tamaño del mapa (se recortan a sus bordes)
+struct Bounds {
+    float width = SNAPSHOT_DEFAULT_BOUNDS;
+    float height = SNAPSHOT_DEFAULT_BOUNDS;
+
+    uint16_t quantize_x(float x) const;
+    uint16_t quantize_y(float y) const;
+    float dequantize_x(uint16_t q) const { return static_cast<float>(q) * width / 65536.0f; }
+    float dequantize_y(uint16_t q) const { return static_cast<float>(q) * height / 65536.0f; }
+};
+
+inline uint32_t zigzag(int32_t v) {
+    return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+}
+inline int32_t unzigzag(uint32_t v) {
+    return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1);
+}
+
+// Flujo de bits (el más significativo primero); varint en grupos de 7 bits
+class BitWriter {
+private:
+    std::vector<uint8_t>& out;
+    uint64_t acc = 0;
+    int pending = 0;  // bits en `acc` que todavía no forman un byte
+
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out(out) {}
+
+    void put(uint32_t value, int bits);  // bits <= 32
+    void put_varint(uint32_t value);
+    void put_signed(int32_t value) { put_varint(zigzag(value)); }
+
+    // Completa el último byte con ceros
+    void align();
+};
+
+template <typename Reader>
+class BitReader {
+private:
+    Reader& in;
+    uint64_t acc = 0;
+    int pending = 0;
+
+public:
+    explicit BitReader(Reader& in) : in(in) {}
+
+    uint32_t get(int bits) {
+        while (pending < bits) {
+            acc = (acc << 8) | in.read_uint8();
+            pending += 8;
+        }
+        pending -= bits;
+        return static_cast<uint32_t>((acc >> pending) & ((uint64_t{1} << bits) - 1));
+    }
+
+    uint32_t get_varint() {
+        uint32_t value = 0;
+        uint32_t chunk;
+        int shift = 0;
+        do {
+            chunk = get(8);
+            value |= (chunk & 0x7F) << shift;
+            shift += 7;
+        } while ((chunk & 0x80) && shift < 35);
+        return value;
+    }
+
+    int32_t get_signed() { return unzigzag(get_varint()); }
+
+    // Descarta el resto del byte actual
+    void align() { pending = 0; }
+};
+
+// Jugador tal como viaja (ya cuantizado): los deltas se comparan sobre esto
+struct PlayerWire {
+    uint16_t player_id = 0;  // no viaja: se resuelve con el slot del manifest
+    uint8_t slot = 0;
+    bool in_view = true;  // false: del cliente fuera de interés (solo ranking)
+    uint16_t pos_x = 0, pos_y = 0;
+    uint16_t angle = 0;
+    int32_t speed = 0;
+    int32_t velocity_x = 0, velocity_y = 0;
+    uint8_t health = 0, nitro_amount = 0;
+    uint8_t flags = 0;
+    uint16_t completed_laps = 0, current_checkpoint = 0;
+    uint8_t position_in_race = 0;
+    uint32_t race_time_ms = 0, total_time_ms = 0;
+    uint32_t last_input = 0;
+
+    static PlayerWire from(const InfoPlayer& p, const Bounds& bounds);
+    void to(InfoPlayer& p, const Bounds& bounds) const;
+    uint16_t diff(const PlayerWire& base) const;
+};
+
+struct RaceWire {
+    uint8_t status = 0, race_number = 0, total_races = 0;
+    uint32_t remaining_time_ms = 0;
+    uint8_t players_finished = 0, total_players = 0;
+
+    static RaceWire from(const RaceInfo& r);
+    void to(RaceInfo& r) const;
+    uint8_t diff(const RaceWire& base) const;
+};
+
+struct Frame {
+    uint32_t sequence = 0;  // 0 = vacío
+    std::vector<PlayerWire> players;
+    RaceWire race;
+
+    const PlayerWire* find(uint16_t player_id, size_t hint) const;
+};
+
+// Bit de un slot en las máscaras de interés (los slots >= 64 se tratan como cercanos)
+inline uint64_t slot_bit(uint8_t slot) { return slot < 64 ? uint64_t{1} << slot : 0; }
+
+// Jugadores cercanos y lejanos para un cliente (bits por slot)
+struct Interest {
+    uint64_t near = ~uint64_t{0};
+    uint64_t far = 0;
+};
+
+// Qué jugadores tiene un cliente en un snapshot que se le mandó
+struct View {
+    uint32_t sequence = 0;
+    uint64_t present = 0;  // actualizados o retenidos
+    uint64_t exact = 0;    // con el valor exacto del frame: sirven de base para un delta
+};
+
+}  // namespace SnapshotCodec
+
+/*
+ * Snapshot de un tick ya cuantizado e inmutable, compartido por todos los
+ * Sender de la partida. Solo el cache de mensajes cambia, bajo su mutex.
+ */
+class EncodedSnapshot {
+private:
+    friend class SnapshotEncoder;
+
+    uint32_t sequence = 0;
+    uint32_t tick = 0;  // tick de simulación del GameLoop (no viaja en el snapshot)
+    bool keyframe_due = false;
+    std::shared_ptr<const SnapshotCodec::Frame> frame;
+    std::array<std::shared_ptr<const SnapshotCodec::Frame>, SNAPSHOT_HISTORY> baselines;
+    uint32_t manifest_version = 0;
+    std::shared_ptr<const std::vector<uint8_t>> manifest;  // mensaje RACE_MANIFEST completo
+    std::vector<uint8_t> tail;  // checkpoints, NPCs y eventos: iguales para todos
+    SnapshotCodec::Bounds bounds;
+
+    float near_radius = SNAPSHOT_NEAR_RADIUS;
+    float far_radius = SNAPSHOT_FAR_RADIUS;
+    uint32_t far_interval = SNAPSHOT_FAR_INTERVAL;
+
+    // (base, presentes y exactos en la base, cercanos, lejanos) -> mensaje
+    using MessageKey = std::tuple<uint32_t, uint64_t, uint64_t, uint64_t, uint64_t>;
+    mutable std::mutex mtx;
+    mutable std::map<MessageKey, std::vector<uint8_t>> messages;
+
+    uint32_t pick_baseline(uint32_t acked) const;
+    uint64_t far_update_mask() const;
+    void write_message(const SnapshotCodec::Frame* baseline, const SnapshotCodec::View& had,
+                       const SnapshotCodec::Interest& interest, std::vector<uint8_t>& buffer) const;
+
+public:
+    uint32_t get_sequence() const { return sequence; }
+    uint32_t get_tick() const { return tick; }
+    uint32_t get_manifest_version() const { return manifest_version; }
+    const std::vector<uint8_t>& manifest_message() const { return *manifest; }
+
+    // Cercanos/lejanos respecto del auto de `viewer_id` (todos cercanos si no está)
+    SnapshotCodec::Interest interest_for(int viewer_id) const;
+
+    /*
+     * Mensaje GAME_STATE_UPDATE completo para un cliente cuyo último ack es
+     * `acked` y que en ese snapshot tenía `had`. Devuelve en `sent` lo que el
+     * cliente va a tener después de recibirlo. Los clientes en la misma
+     * situación comparten los bytes.
+     */
+    const std::vector<uint8_t>& message_for(uint32_t acked, const SnapshotCodec::View& had,
+                                            const SnapshotCodec::Interest& interest,
+                                            SnapshotCodec::View& sent) const;
+};
+
+using SnapshotHandle = std::shared_ptr<const EncodedSnapshot>;
+
+// Lado servidor: uno por partida, lo usa solo el hilo del GameLoop
+class SnapshotEncoder {
+private:
+    std::array<std::shared_ptr<const SnapshotCodec::Frame>, SNAPSHOT_HISTORY> history;
+    std::vector<SnapshotCodec::ManifestEntry> manifest;
+    std::shared_ptr<const std::vector<uint8_t>> manifest_message;
+    uint32_t manifest_version;
+    uint32_t next_sequence;
+
+    float near_radius;
+    float far_radius;
+    uint32_t far_interval;
+    SnapshotCodec::Bounds bounds;
+
+    void update_manifest(const GameState& snapshot);
+    uint8_t slot_of(uint16_t player_id, size_t hint) const;
+
+public:
+    SnapshotEncoder();
+
+    // Radios del área de interés; near_radius <= 0 la desactiva (todos cercanos)
+    void set_interest(float near, float far, int interval);
+
+    // Tamaño del mapa (px) para cuantizar posiciones; reenvía el manifest si cambia
+    void set_bounds(float width, float height);
+
+    // Cuantiza el snapshot y serializa una vez lo que no depende del cliente.
+    // `tick` es el tick de simulación en que se armó (lo informan los PONG)
+    SnapshotHandle encode(const GameState& snapshot, uint32_t tick = 0);
+};
+
+/*
+ * Estado de snapshots de una conexión: último ack, último manifest enviado y
+ * qué jugadores tiene el cliente en cada snapshot reciente (para el área de
+ * interés). Salvo el ack, solo lo toca el hilo Sender.
+ */
+class SnapshotStream {
+private:
+    std::atomic<uint32_t> acked;  // lo actualiza el hilo que lee comandos
+    uint32_t manifest_version;
+    int viewer_id;  // -1: sin auto propio, recibe todo
+    std::array<SnapshotCodec::View, SNAPSHOT_HISTORY> sent;
+
+public:
+    SnapshotStream();
+
+    void acknowledge(uint32_t sequence) { acked.store(sequence, std::memory_order_relaxed); }
+    uint32_t acked_sequence() const { return acked.load(std::memory_order_relaxed); }
+    void set_viewer(int player_id) { viewer_id = player_id; }
+
+    // Manifest a enviar antes del snapshot, o nullptr si el cliente ya lo tiene
+    const std::vector<uint8_t>* manifest_for(const EncodedSnapshot& snapshot);
+
+    const std::vector<uint8_t>& message_for(const EncodedSnapshot& snapshot);
+};
+
+// Lado cliente: uno por conexión
+class SnapshotDecoder {
+private:
+    std::array<SnapshotCodec::Frame, SNAPSHOT_HISTORY> history;
+    // Jugadores del snapshot en armado; se intercambia con el del frame, así no se realoca
+    std::vector<SnapshotCodec::PlayerWire> scratch;
+    // Inmutable: cada RACE_MANIFEST arma uno nuevo y los GameState ya entregados lo comparten
+    std::shared_ptr<const std::vector<RosterEntry>> manifest =
+            std::make_shared<const std::vector<RosterEntry>>();
+    SnapshotCodec::Bounds bounds;
+
+public:
+    // Lee el cuerpo de un RACE_MANIFEST (sin el byte de tipo)
+    template <typename Reader>
+    void read_manifest(Reader& in);
+
+    /*
+     * Lee el cuerpo de un snapshot con `in` (read_uint8/16/32, read_int32,
+     * read_string) y lo aplica sobre su base. Devuelve false si la base no
+     * está en el historial: el snapshot queda incompleto y no se confirma,
+     * así que el servidor terminará mandando un keyframe.
+     *
+     * `state` puede ser siempre el mismo: se pisa entero sin realocar. De cada
+     * jugador solo se escriben slot y car_id; los strings quedan en
+     * `state.roster` (GameState::username_of y compañía).
+     */
+    template <typename Reader>
+    bool decode(Reader& in, GameState& state, uint32_t& sequence);
+};
+
+// ---------------------------------------------------------------------------
+
+template <typename Reader>
+void SnapshotDecoder::read_manifest(Reader& in) {
+    const uint8_t version = in.read_uint8();
+    if (version != SNAPSHOT_CODEC_VERSION)
+        throw std::runtime_error("Unsupported snapshot codec version " + std::to_string(version));
+    bounds.width = static_cast<float>(in.read_uint16());
+    bounds.height = static_cast<float>(in.read_uint16());
+
+    const uint8_t count = in.read_uint8();
+    auto entries = std::make_shared<std::vector<RosterEntry>>(count);
+    for (RosterEntry& entry : *entries) {
+        entry.player_id = in.read_uint16();
+        entry.car_id = in.read_uint8();
+        entry.username = in.read_string();
+        entry.car_name = in.read_string();
+        entry.car_type = in.read_string();
+    }
+    manifest = std::move(entries);
+}
+
+template <typename Reader>
+bool SnapshotDecoder::decode(Reader& in, GameState& state, uint32_t& sequence) {
+    using namespace SnapshotCodec;
+
+    sequence = in.read_uint32();
+    const uint32_t baseline_seq = in.read_uint32();
+
+    static const Frame empty;
+    const Frame* baseline = &empty;
+    bool complete = true;
+    if (baseline_seq != 0) {
+        const Frame& candidate = history[baseline_seq % SNAPSHOT_HISTORY];
+        if (candidate.sequence == baseline_seq) {
+            baseline = &candidate;
+        } else {
+            complete = false;
+        }
+    }
+
+    Frame& frame = history[sequence % SNAPSHOT_HISTORY];
+    std::vector<PlayerWire>& players = scratch;  // `frame` puede ser la base: no pisarlo todavía
+    players.clear();
+
+    auto player_of = [&](uint8_t slot) -> uint16_t {
+        if (slot < manifest->size()) return (*manifest)[slot].player_id;
+        complete = false;
+        return 0;
+    };
+
+    BitReader<Reader> bits(in);
+
+    // 1. PLAYERS (actualizados)
+    const uint32_t player_count = bits.get_varint();
+    players.resize(player_count);
+    for (uint32_t i = 0; i < player_count; ++i) {
+        PlayerWire& w = players[i];
+        const uint8_t slot = static_cast<uint8_t>(bits.get(8));
+        const uint16_t mask = static_cast<uint16_t>(bits.get(13));
+        const uint16_t player_id = player_of(slot);
+
+        // Con la máscara completa la referencia es cero (hay campos que viajan como diferencia)
+        if (mask != FIELD_ALL) {
+            const PlayerWire* base = baseline->find(player_id, slot);
+            if (base && base->in_view) w = *base;
+            else complete = false;
+        }
+        w.player_id = player_id;
+        w.slot = slot;
+        w.in_view = true;
+
+        if (mask & FIELD_POSITION) {
+            w.pos_x = static_cast<uint16_t>(bits.get(16));
+            w.pos_y = static_cast<uint16_t>(bits.get(16));
+        }
+        if (mask & FIELD_ANGLE) w.angle = static_cast<uint16_t>(bits.get(SNAPSHOT_ANGLE_BITS));
+        if (mask & FIELD_SPEED) w.speed += bits.get_signed();
+        if (mask & FIELD_VELOCITY) {
+            w.velocity_x += bits.get_signed();
+            w.velocity_y += bits.get_signed();
+        }
+        if (mask & FIELD_HEALTH) w.health = static_cast<uint8_t>(bits.get(8));
+        if (mask & FIELD_NITRO) w.nitro_amount = static_cast<uint8_t>(bits.get(8));
+        if (mask & FIELD_FLAGS) w.flags = static_cast<uint8_t>(bits.get(6));
+        if (mask & FIELD_LAPS) w.completed_laps = static_cast<uint16_t>(bits.get_varint());
+        if (mask & FIELD_CHECKPOINT) w.current_checkpoint = static_cast<uint16_t>(bits.get_varint());
+        if (mask & FIELD_RACE_POSITION) w.position_in_race = static_cast<uint8_t>(bits.get(8));
+        if (mask & FIELD_RACE_TIME) w.race_time_ms += static_cast<uint32_t>(bits.get_signed());
+        if (mask & FIELD_TOTAL_TIME) w.total_time_ms += static_cast<uint32_t>(bits.get_signed());
+        if (mask & FIELD_LAST_INPUT) w.last_input += static_cast<uint32_t>(bits.get_signed());
+    }
+
+    // Retenidos: lejanos que este tick no se actualizan, siguen como en la base
+    const uint32_t held_count = bits.get_varint();
+    for (uint32_t i = 0; i < held_count; ++i) {
+        const uint8_t slot = static_cast<uint8_t>(bits.get(8));
+        const PlayerWire* base = baseline->find(player_of(slot), slot);
+        if (base && base->in_view) {
+            players.push_back(*base);
+        } else {
+            complete = false;
+        }
+    }
+
+    // Fuera de interés: solo lo que hace falta para el ranking
+    const uint32_t summary_count = bits.get_varint();
+    for (uint32_t i = 0; i < summary_count; ++i) {
+        PlayerWire w;
+        w.slot = static_cast<uint8_t>(bits.get(8));
+        w.player_id = player_of(w.slot);
+        w.in_view = false;
+        w.flags = static_cast<uint8_t>(bits.get(6));
+        w.completed_laps = static_cast<uint16_t>(bits.get_varint());
+        w.position_in_race = static_cast<uint8_t>(bits.get(8));
+        w.race_time_ms = bits.get_varint();
+        w.total_time_ms = bits.get_varint();
+        players.push_back(w);
+    }
+
+    // Mismo orden que el manifest, como el snapshot original
+    std::sort(players.begin(), players.end(),
+              [](const PlayerWire& a, const PlayerWire& b) { return a.slot < b.slot; });
+
+    // 2. RACE INFO
+    RaceWire race = baseline->race;
+    const uint8_t race_mask = static_cast<uint8_t>(bits.get(6));
+    if (race_mask & RACE_STATUS) race.status = static_cast<uint8_t>(bits.get(8));
+    if (race_mask & RACE_NUMBER) race.race_number = static_cast<uint8_t>(bits.get(8));
+    if (race_mask & RACE_TOTAL_RACES) race.total_races = static_cast<uint8_t>(bits.get(8));
+    if (race_mask & RACE_REMAINING_TIME) race.remaining_time_ms = bits.get_varint();
+    if (race_mask & RACE_PLAYERS_FINISHED) race.players_finished = static_cast<uint8_t>(bits.get(8));
+    if (race_mask & RACE_TOTAL_PLAYERS) race.total_players = static_cast<uint8_t>(bits.get(8));
+    bits.align();
+
+    frame.sequence = complete ? sequence : 0;
+    frame.players.swap(players);  // el vector viejo del frame queda de scratch
+    frame.race = race;
+
+    state.roster = manifest;
+    state.players.resize(frame.players.size());
+    for (size_t i = 0; i < frame.players.size(); ++i) {
+        InfoPlayer& p = state.players[i];
+        frame.players[i].to(p, bounds);
+        p.slot = frame.players[i].slot;
+        p.car_id = p.slot < manifest->size() ? (*manifest)[p.slot].car_id : 0xFF;
+    }
+    race.to(state.race_info);
+
+    // 3. CHECKPOINTS
+    const uint32_t checkpoint_count = bits.get_varint();
+    state.checkpoints.clear();
+    state.checkpoints.reserve(checkpoint_count);
+    for (uint32_t i = 0; i < checkpoint_count; ++i) {
+        CheckpointInfo c;
+        c.id = bits.get_signed();
+        c.pos_x = bounds.dequantize_x(static_cast<uint16_t>(bits.get(16)));
+        c.pos_y = bounds.dequantize_y(static_cast<uint16_t>(bits.get(16)));
+        c.width = static_cast<float>(bits.get_varint()) / 100.0f;
+        c.angle = dequantize_angle(static_cast<uint16_t>(bits.get(SNAPSHOT_ANGLE_BITS)));
+        c.is_start = bits.get(1) != 0;
+        c.is_finish = bits.get(1) != 0;
+        state.checkpoints.push_back(c);
+    }
+
+    // 4. NPCs
+    const uint32_t npc_count = bits.get_varint();
+    state.npcs.clear();
+    state.npcs.reserve(npc_count);
+    for (uint32_t i = 0; i < npc_count; ++i) {
+        NPCCarInfo n;
+        n.npc_id = bits.get_signed();
+        n.pos_x = bounds.dequantize_x(static_cast<uint16_t>(bits.get(16)));
+        n.pos_y = bounds.dequantize_y(static_cast<uint16_t>(bits.get(16)));
+        n.angle = dequantize_angle(static_cast<uint16_t>(bits.get(SNAPSHOT_ANGLE_BITS)));
+        n.speed = dequantize_motion(bits.get_signed());
+        n.is_parked = bits.get(1) != 0;
+        state.npcs.push_back(std::move(n));
+    }
+
+    // 5. EVENTS
+    const uint32_t event_count = bits.get_varint();
+    state.events.clear();
+    state.events.reserve(event_count);
+    for (uint32_t i = 0; i < event_count; ++i) {
+        GameEvent e;
+        e.type = static_cast<GameEvent::EventType>(bits.get(8));
+        e.player_id = bits.get_signed();
+        e.pos_x = bounds.dequantize_x(static_cast<uint16_t>(bits.get(16)));
+        e.pos_y = bounds.dequantize_y(static_cast<uint16_t>(bits.get(16)));
+        state.events.push_back(e);
+    }
+    bits.align();
+
+    return complete;
+}
+
+#endif  // SNAPSHOT_CODEC_H
@@ -3,11 +3,17 @@
 #include <arpa/inet.h>
 #include <assert.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <stdexcept>
@@ -249,6 +255,10 @@ Socket& Socket::operator=(Socket&& other) {
 int Socket::recvsome(void* data, unsigned int sz) {
     chk_skt_or_fail();
     int s = recv(this->skt, (char*)data, sz, 0);
+    while (s == -1 && errno == EAGAIN) {
+        wait_for(POLLIN);
+        s = recv(this->skt, (char*)data, sz, 0);
+    }
     if (s == 0) {
         /*
          * Puede ser o no un error, dependerá del protocolo.
@@ -288,6 +298,10 @@ int Socket::sendsome(const void* data, unsigned int sz) {
      * (ver más abajo).
      * */
     int s = send(this->skt, (char*)data, sz, MSG_NOSIGNAL);
+    while (s == -1 && errno == EAGAIN) {
+        wait_for(POLLOUT);
+        s = send(this->skt, (char*)data, sz, MSG_NOSIGNAL);
+    }
     if (s == -1) {
         /*
          * Este es un caso especial: cuando enviamos algo pero en el medio
@@ -374,6 +388,102 @@ int Socket::sendall(const void* data, unsigned int sz) {
     return sz;
 }
 
+int Socket::sendallv(struct iovec* iov, int iovcnt) {
+    chk_skt_or_fail();
+    unsigned int sent = 0;
+
+    while (iovcnt > 0) {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt < IOV_MAX ? iovcnt : IOV_MAX;
+
+        /* Mismo manejo de `MSG_NOSIGNAL` y `EPIPE` que `Socket::sendsome` */
+        ssize_t s = sendmsg(this->skt, &msg, MSG_NOSIGNAL);
+        if (s == -1 && errno == EAGAIN) {
+            wait_for(POLLOUT);
+            continue;
+        }
+        if (s == -1 && errno != EPIPE)
+            throw LibError(errno, "socket sendmsg failed");
+
+        if (s <= 0) {
+            stream_status |= STREAM_SEND_CLOSED;
+            if (sent)
+                throw LibError(EPIPE, "socket sent only %d bytes of a gather write", sent);
+            return 0;
+        }
+        sent += s;
+
+        // Descartar los buffers ya enviados y recortar el que quedó a medias
+        size_t left = s;
+        while (iovcnt > 0 && left >= iov->iov_len) {
+            left -= iov->iov_len;
+            ++iov;
+            --iovcnt;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char*)iov->iov_base + left;
+            iov->iov_len -= left;
+        }
+    }
+
+    return sent;
+}
+
+void Socket::set_no_delay() {
+    chk_skt_or_fail();
+    int optval = 1;
+    if (setsockopt(this->skt, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval)) == -1)
+        throw LibError(errno, "socket setsockopt TCP_NODELAY failed");
+}
+
+void Socket::set_nonblocking() {
+    chk_skt_or_fail();
+    int flags = fcntl(this->skt, F_GETFL, 0);
+    if (flags == -1 || fcntl(this->skt, F_SETFL, flags | O_NONBLOCK) == -1)
+        throw LibError(errno, "socket fcntl O_NONBLOCK failed");
+}
+
+int Socket::tryrecvsome(void* data, unsigned int sz) {
+    chk_skt_or_fail();
+    int s = recv(this->skt, (char*)data, sz, MSG_DONTWAIT);
+    if (s == -1) {
+        if (errno == EAGAIN) return -1;
+        /* Un reset del otro lado es un cierre más, como en `Socket::trysendv` */
+        if (errno != ECONNRESET) throw LibError(errno, "socket recv failed");
+        s = 0;
+    }
+    if (s == 0) stream_status |= STREAM_RECV_CLOSED;
+    return s;
+}
+
+void Socket::wait_for(short events) {
+    struct pollfd pfd = {this->skt, events, 0};
+    while (poll(&pfd, 1, -1) == -1) {
+        if (errno != EINTR) throw LibError(errno, "socket poll failed");
+    }
+}
+
+int Socket::trysendv(struct iovec* iov, int iovcnt) {
+    chk_skt_or_fail();
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt < IOV_MAX ? iovcnt : IOV_MAX;
+
+    ssize_t s = sendmsg(this->skt, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (s == -1) {
+        if (errno == EAGAIN) return 0;
+        if (errno == EPIPE || errno == ECONNRESET) {
+            stream_status |= STREAM_SEND_CLOSED;
+            return -1;
+        }
+        throw LibError(errno, "socket sendmsg failed");
+    }
+    return static_cast<int>(s);
+}
+
 Socket::Socket(int skt) {
     this->skt = skt;
     this->closed = false;
@@ -1,6 +1,8 @@
 #ifndef SOCKET_H
 #define SOCKET_H
 
+struct iovec;
+
 /*
  * TDA Socket.
  * Por simplificación este TDA se enfocará solamente
@@ -42,6 +44,21 @@ private:
      * */
     void chk_skt_or_fail() const;
 
+    /*
+     * Con el socket en modo no bloqueante (`set_nonblocking`) un `send`/`recv`
+     * puede fallar con EAGAIN: los métodos bloqueantes esperan con `poll` a
+     * que se pueda seguir, así mantienen su semántica.
+     * */
+    void wait_for(short events);
+
+    /*
+     * `DatagramSocket::wait` hace un único `poll` sobre su socket UDP y
+     * sobre esta conexión, así que necesita el file descriptor. El `Reactor`
+     * del servidor lo registra en su epoll.
+     * */
+    friend class DatagramSocket;
+    friend class Reactor;
+
 public:
     /*
      * Constructores para `Socket` tanto para conectarse a un servidor
@@ -143,6 +160,47 @@ public:
     int sendall(const void* data, unsigned int sz);
     int recvall(void* data, unsigned int sz);
 
+    /*
+     * Como `Socket::sendall` pero junta (gather) `iovcnt` buffers en un solo
+     * `sendmsg`: un mensaje armado en varios pedazos sale en una syscall, sin
+     * copiarlo a un buffer intermedio. Los `iovec` se modifican si el envío
+     * queda parcial.
+     *
+     * Retorna la cantidad total de bytes enviados o 0 si el socket se cerró
+     * sin enviar nada.
+     * */
+    int sendallv(struct iovec* iov, int iovcnt);
+
+    /*
+     * Desactiva el algoritmo de Nagle (TCP_NODELAY): cada mensaje se envía
+     * apenas se escribe en vez de esperar a juntarse con el siguiente.
+     * */
+    void set_no_delay();
+
+    /*
+     * Pasa el socket a modo no bloqueante (O_NONBLOCK). `tryrecvsome` y
+     * `trysendv` nunca esperan; el resto de los métodos siguen bloqueando
+     * hasta completar (esperan con `poll` en vez de dentro de la syscall).
+     * */
+    void set_nonblocking();
+
+    /*
+     * Recibe hasta `sz` bytes de lo que ya llegó, sin bloquear (MSG_DONTWAIT).
+     *
+     * Retorna los bytes recibidos, 0 si la conexión se cerró o -1 si
+     * todavía no llegó nada. Si hay otro error se lanza una excepción.
+     * */
+    int tryrecvsome(void* data, unsigned int sz);
+
+    /*
+     * Envía lo que el socket acepte sin bloquear (MSG_DONTWAIT) de los
+     * `iovcnt` buffers, en un solo `sendmsg`.
+     *
+     * Retorna los bytes enviados (0 si el buffer del kernel estaba lleno)
+     * o -1 si la conexión se cerró. Si hay otro error se lanza una excepción.
+     * */
+    int trysendv(struct iovec* iov, int iovcnt);
+
     /*
      * Acepta una conexión entrante y retorna un nuevo socket
      * construido a partir de ella.
@@ -8,9 +8,21 @@
 #include <chrono>
 #include <arpa/inet.h>
 
+#include "../common_src/config.h"
+
+
+// config.yaml: network_workers (hilos que atienden a todos los clientes)
+static int network_workers() {
+    try {
+        return Configuration::get<int>("network_workers");
+    } catch (const std::exception&) {
+        return 2;
+    }
+}
 
 Acceptor::Acceptor(const char* servicename)
     : socket(servicename), 
+      reactor(network_workers()),
       client_counter(0), 
       clients_connected(), 
       is_running(true),
@@ -72,8 +84,9 @@ void Acceptor::close_socket() {
 
 void Acceptor::manage_clients_connections(MatchesMonitor& monitor) {
     Socket client_socket = socket.accept();
-    ClientHandler* new_client = new ClientHandler(std::move(client_socket), ++client_counter, monitor);
-    new_client->run_threads();
+    ClientHandler* new_client =
+            new ClientHandler(std::move(client_socket), ++client_counter, monitor, reactor);
+    new_client->start();
     
     std::lock_guard<std::mutex> lock(clients_mutex);  
     clients_connected.push_back(new_client);
@@ -121,6 +134,7 @@ void Acceptor::stop_accepting() {
 void Acceptor::run() {
     MatchesMonitor monitor;
     is_accepting = true;  
+    reactor.start();
     
     try {
         while (is_running && is_accepting) {  
@@ -9,10 +9,12 @@
 #include "../common_src/thread.h"
 #include "network/client_handler.h"
 #include "network/matches_monitor.h"
+#include "network/reactor.h"
 
 class Acceptor : public Thread {
 private:
     Socket socket;
+    Reactor reactor;  // atiende a todas las conexiones (ver network/reactor.h)
     int client_counter;
     std::list<ClientHandler*> clients_connected;
     std::atomic<bool> is_running;
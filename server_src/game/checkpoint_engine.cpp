@@ -0,0 +1,88 @@
+#include "checkpoint_engine.h"
+
+#include <algorithm>
+#include <cmath>
+
+CheckpointEngine::CheckpointEngine() : lookahead(3), first_target(0), finish(-1) {}
+
+void CheckpointEngine::clear() {
+    gates.clear();
+    first_target = 0;
+    finish = -1;
+}
+
+void CheckpointEngine::build(const std::vector<RaceCheckpointDef>& checkpoints,
+                             float tolerance_base, float tolerance_finish) {
+    clear();
+    const int n = static_cast<int>(checkpoints.size());
+    gates.reserve(n);
+
+    for (int i = 0; i < n; ++i) {
+        const RaceCheckpointDef& cp = checkpoints[i];
+
+        // Dirección de la ruta en este checkpoint: del anterior al siguiente
+        const RaceCheckpointDef& prev = checkpoints[std::max(i - 1, 0)];
+        const RaceCheckpointDef& next = checkpoints[std::min(i + 1, n - 1)];
+        float dx = next.x - prev.x;
+        float dy = next.y - prev.y;
+        float len = std::sqrt(dx * dx + dy * dy);
+        if (len < 1e-3f) {
+            // Ruta de un solo punto: usar el ángulo del YAML
+            const float rad = cp.angle * static_cast<float>(M_PI / 180.0);
+            dx = std::cos(rad);
+            dy = std::sin(rad);
+            len = 1.0f;
+        }
+
+        const float w = cp.width > 0 ? cp.width : 150.f;
+        const float h = cp.height > 0 ? cp.height : 150.f;
+        const float scale = cp.type == CheckpointType::FINISH ? tolerance_finish : tolerance_base;
+
+        Gate gate{};
+        gate.id = cp.id;
+        gate.type = cp.type;
+        gate.cx = cp.x;
+        gate.cy = cp.y;
+        gate.dir_x = dx / len;
+        gate.dir_y = dy / len;
+        gate.half_length = 0.5f * std::max(w, h) * scale;
+        gates.push_back(gate);
+    }
+
+    first_target = 0;
+    for (int i = 0; i < n; ++i) {
+        if (gates[i].type != CheckpointType::START) {
+            first_target = i;
+            break;
+        }
+    }
+    for (int i = 0; i < n; ++i) {
+        if (gates[i].type == CheckpointType::FINISH) {
+            finish = i;
+            break;
+        }
+    }
+}
+
+int CheckpointEngine::find_crossing(int next_index, float x0, float y0, float x1,
+                                    float y1) const {
+    if (next_index < 0 || next_index >= size()) return -1;
+    const int last = std::min(next_index + lookahead, size() - 1);
+
+    for (int i = next_index; i <= last; ++i) {
+        const Gate& g = gates[i];
+
+        // Distancia con signo a la recta de la compuerta (positiva = adelante)
+        const float side0 = (x0 - g.cx) * g.dir_x + (y0 - g.cy) * g.dir_y;
+        const float side1 = (x1 - g.cx) * g.dir_x + (y1 - g.cy) * g.dir_y;
+        if (side0 > 0.0f || side1 <= 0.0f) continue;  // no la cruzó hacia adelante
+
+        // Punto de corte y distancia lateral al centro de la compuerta
+        const float t = side0 / (side0 - side1);
+        const float qx = x0 + (x1 - x0) * t - g.cx;
+        const float qy = y0 + (y1 - y0) * t - g.cy;
+        const float lateral = qx * -g.dir_y + qy * g.dir_x;
+        if (std::fabs(lateral) <= g.half_length) return i;
+    }
+    return -1;
+}
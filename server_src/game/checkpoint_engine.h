@@ -0,0 +1,63 @@
+#ifndef CHECKPOINT_ENGINE_H
+#define CHECKPOINT_ENGINE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "../../common_src/race_descriptor.h"
+
+/*
+ * CheckpointEngine: checkpoints de la carrera como compuertas (segmentos
+ * orientados) precalculadas al cargar la ruta.
+ *
+ * Cada compuerta cruza la pista en el centro del checkpoint, perpendicular
+ * a la dirección de la ruta (del checkpoint anterior al siguiente), y su
+ * largo sale del tamaño del checkpoint por la tolerancia configurada. Un
+ * jugador la pasa cuando el segmento entre su posición anterior y la
+ * actual la corta en el sentido de la carrera. Solo se prueban la siguiente
+ * compuerta y `lookahead` más: costo constante por jugador y por tick.
+ */
+class CheckpointEngine {
+public:
+    struct Gate {
+        int32_t id;
+        CheckpointType type;
+        float cx, cy;          // centro del checkpoint
+        float dir_x, dir_y;    // sentido de la carrera (unitario)
+        float half_length;     // mitad del largo de la compuerta
+    };
+
+private:
+    std::vector<Gate> gates;  // ordenadas por id
+    int lookahead;
+    int first_target;  // primera compuerta que no es la largada
+    int finish;        // -1 si la ruta no tiene llegada
+
+public:
+    CheckpointEngine();
+
+    void build(const std::vector<RaceCheckpointDef>& checkpoints, float tolerance_base,
+               float tolerance_finish);
+    void clear();
+    void set_lookahead(int value) { lookahead = value < 0 ? 0 : value; }
+
+    /*
+     * Índice de la primera compuerta cruzada al moverse de (x0,y0) a (x1,y1),
+     * buscando desde `next_index` hasta `next_index + lookahead`. -1 si no
+     * cruzó ninguna.
+     */
+    int find_crossing(int next_index, float x0, float y0, float x1, float y1) const;
+
+    bool empty() const { return gates.empty(); }
+    int size() const { return static_cast<int>(gates.size()); }
+    const Gate& gate(int index) const { return gates[index]; }
+    int first_target_index() const { return first_target; }
+    int finish_index() const { return finish; }
+
+    // Índice a perseguir después de pasar `index` (se queda en la última)
+    int next_after(int index) const {
+        return index + 1 < size() ? index + 1 : size() - 1;
+    }
+};
+
+#endif  // CHECKPOINT_ENGINE_H
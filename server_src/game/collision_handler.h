@@ -4,7 +4,7 @@
 #include <box2d/box2d.h>
 #include <map>
 #include <vector>
-#include "car.h"
+#include "../../common_src/car.h"
 #include "obstacle.h"
 
 struct PhysicsCollisionEvent {
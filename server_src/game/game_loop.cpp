@@ -9,7 +9,10 @@
 #include <utility>
 #include <yaml-cpp/yaml.h>
 
+#include "../../common_src/car_catalog.h"
 #include "../../common_src/config.h"
+#include "../../common_src/map_asset_cache.h"
+#include "../../common_src/race_descriptor.h"
 #include "race.h"
 
 
@@ -33,6 +36,7 @@ GameLoop::GameLoop(Queue<ComandMatchDTO>& comandos, ClientMonitor& queues)
     if (b2World_IsValid(physics_world_id)) {
         std::cout << "[GameLoop] Box2D World creado exitosamente\n";
     }*/
+    load_game_config();
     std::cout << "[GameLoop] Constructor OK.\n";
 }
 
@@ -53,140 +57,33 @@ void GameLoop::start_game() {
     is_game_started = true;
 }
 
-static inline bool segment_intersects_obb(float x0, float y0, float x1, float y1,
-                                          float cx, float cy, float w, float h, float angle_deg) {
-    const float ang = angle_deg * (M_PI / 180.0f);
-    const float c = std::cos(-ang);
-    const float s = std::sin(-ang);
-    auto to_local = [&](float x, float y) {
-        float dx = x - cx, dy = y - cy;
-        return std::pair<float,float>{dx * c - dy * s, dx * s + dy * c};
-    };
-    auto p0 = to_local(x0, y0);
-    auto p1 = to_local(x1, y1);
-    float hx = w * 0.5f, hy = h * 0.5f;
-    float dx = p1.first - p0.first;
-    float dy = p1.second - p0.second;
-    float t0 = 0.0f, t1 = 1.0f;
-    auto clip = [&](float p, float q) {
-        if (p == 0) return q >= 0; // paralelo
-        float r = q / p;
-        if (p < 0) { if (r > t1) return false; if (r > t0) t0 = r; }
-        else       { if (r < t0) return false; if (r < t1) t1 = r; }
-        return true;
-    };
-    if (!clip(-dx, p0.first + hx)) return false;
-    if (!clip( dx, hx - p0.first)) return false;
-    if (!clip(-dy, p0.second + hy)) return false;
-    if (!clip( dy, hy - p0.second)) return false;
-    return t0 <= t1;
-}
-
 void GameLoop::load_checkpoints_for_current_race() {
-    checkpoints.clear();
-    try {
-        YAML::Node map = YAML::LoadFile(current_map_yaml);
-        if (!map["checkpoints"] || !map["checkpoints"].IsSequence()) {
-            return; // no prints excepto cruces
-        }
-        for (const auto& node : map["checkpoints"]) {
-            Checkpoint cp{};
-            cp.id = node["id"] ? node["id"].as<int>() : (int)checkpoints.size();
-            cp.type = node["type"] ? node["type"].as<std::string>() : std::string("normal");
-            cp.x = node["x"] ? node["x"].as<float>() : (node["cx"] ? node["cx"].as<float>() : 0.f);
-            cp.y = node["y"] ? node["y"].as<float>() : (node["cy"] ? node["cy"].as<float>() : 0.f);
-            if (node["radius"]) {
-                float r = node["radius"].as<float>();
-                cp.width = cp.height = 2.f * r;
-            } else {
-                cp.width  = node["width"]  ? node["width"].as<float>()  : 150.f;
-                cp.height = node["height"] ? node["height"].as<float>() : 150.f;
-            }
-            cp.angle = 0.0f;
-            checkpoints.push_back(std::move(cp));
-        }
-        std::sort(checkpoints.begin(), checkpoints.end(),
-                  [](const Checkpoint& a, const Checkpoint& b) { return a.id < b.id; });
-    } catch (...) { /* silencioso */ }
-}
-
-bool GameLoop::check_player_crossed_checkpoint(int player_id, const Checkpoint& cp) {
-    auto it = players.find(player_id);
-    if (it == players.end() || !(it->second->getCar())) return false;
-    const float px = it->second->getX();
-    const float py = it->second->getY();
-    float w = cp.width  > 0 ? cp.width  : 150.f;
-    float h = cp.height > 0 ? cp.height : 150.f;
-    float scale = (cp.type == "finish") ? checkpoint_tol_finish : checkpoint_tol_base;
-    w *= scale; h *= scale;
-    auto prev_it = player_prev_pos.find(player_id);
-    if (prev_it != player_prev_pos.end()) {
-        float x0 = prev_it->second.first;
-        float y0 = prev_it->second.second;
-        float x1 = px;
-        float y1 = py;
-        float minx = cp.x - w * 0.5f;
-        float maxx = cp.x + w * 0.5f;
-        float miny = cp.y - h * 0.5f;
-        float maxy = cp.y + h * 0.5f;
-        bool p0_inside = (x0 >= minx && x0 <= maxx && y0 >= miny && y0 <= maxy);
-        bool p1_inside = (x1 >= minx && x1 <= maxx && y1 >= miny && y1 <= maxy);
-        if (p0_inside || p1_inside) return true;
-        float seg_minx = std::min(x0, x1);
-        float seg_maxx = std::max(x0, x1);
-        float seg_miny = std::min(y0, y1);
-        float seg_maxy = std::max(y0, y1);
-        if (seg_maxx >= minx && seg_minx <= maxx && seg_maxy >= miny && seg_miny <= maxy) return true;
-    }
-    float minx = cp.x - w * 0.5f;
-    float maxx = cp.x + w * 0.5f;
-    float miny = cp.y - h * 0.5f;
-    float maxy = cp.y + h * 0.5f;
-    return (px >= minx && px <= maxx && py >= miny && py <= maxy);
+    if (!current_race_descriptor) {
+        checkpoint_engine.clear();
+        return;
+    }
+    checkpoint_engine.set_lookahead(checkpoint_lookahead);
+    checkpoint_engine.build(current_race_descriptor->checkpoints, checkpoint_tol_base,
+                            checkpoint_tol_finish);
 }
 
 void GameLoop::update_checkpoints() {
-    if (checkpoints.empty()) return;
+    if (checkpoint_engine.empty()) return;
     for (auto& [pid, player_ptr] : players) {
         if (!player_ptr || player_ptr->isFinished() || player_ptr->isDisconnected()) continue;
-        if (!player_next_checkpoint.count(pid)) {
-            int first_idx = 0;
-            for (size_t i = 0; i < checkpoints.size(); ++i) {
-                if (checkpoints[i].type != "start") { first_idx = (int)i; break; }
-            }
-            player_next_checkpoint[pid] = first_idx;
-        }
-        int next_idx = player_next_checkpoint[pid];
-        if (next_idx < 0 || next_idx >= (int)checkpoints.size()) continue;
-        // 1) Intentar el esperado
-        if (check_player_crossed_checkpoint(pid, checkpoints[next_idx])) {
-            const auto& cp = checkpoints[next_idx];
-            player_ptr->setCheckpoint(cp.id);
-
-            if (cp.type == "finish") {
-                mark_player_finished(pid);
-            } else {
-                player_next_checkpoint[pid] = std::min(next_idx + 1, (int)checkpoints.size() - 1);
-            }
-            continue;
-        }
-        // 2) Escaneo completo hacia adelante: buscar el primer cp cruzado en el resto
-        bool advanced = false;
-        for (int k = next_idx + 1; k < (int)checkpoints.size(); ++k) {
-            const auto& cp_k = checkpoints[k];
-            if (check_player_crossed_checkpoint(pid, cp_k)) {
-                player_ptr->setCheckpoint(cp_k.id);
-
-                if (cp_k.type == "finish") {
-                    mark_player_finished(pid);
-                } else {
-                    player_next_checkpoint[pid] = std::min(k + 1, (int)checkpoints.size() - 1);
-                }
-                advanced = true;
-                break;
-            }
+
+        const int crossed = checkpoint_engine.find_crossing(
+                player_ptr->getNextCheckpointIndex(), player_ptr->getPrevX(),
+                player_ptr->getPrevY(), player_ptr->getX(), player_ptr->getY());
+        if (crossed < 0) continue;
+
+        const auto& gate = checkpoint_engine.gate(crossed);
+        player_ptr->setCheckpoint(gate.id);
+        if (gate.type == CheckpointType::FINISH) {
+            mark_player_finished(pid);
+        } else {
+            player_ptr->setNextCheckpointIndex(checkpoint_engine.next_after(crossed));
         }
-        (void)advanced;
     }
 }
 
@@ -213,6 +110,9 @@ void GameLoop::run() {
 
     if (!is_running.load()) return;
 
+    // Los que se sumaron en el lobby tienen que estar antes de ubicar los spawns
+    aplicar_cambios_de_jugadores();
+
     std::cout << "[GameLoop] ═══════════════════════════════════════════════\n";
     std::cout << "[GameLoop]  PARTIDA INICIADA - SIMULACIÓN COMENZANDO \n";
     std::cout << "[GameLoop]  Carreras configuradas: " << races.size() << "\n";
@@ -244,38 +144,30 @@ void GameLoop::run() {
     while (is_running.load() && !match_finished.load() && current_race_index < races.size()) {
 
 
-        auto next_frame = std::chrono::steady_clock::now();
-        const auto frame_duration = std::chrono::milliseconds(SLEEP);  // 16ms = ~60 FPS
+        // Paso fijo: la simulación avanza de a un tick sin importar cuánto
+        // tarde cada vuelta; los snapshots salen con su propio período.
+        using clock = std::chrono::steady_clock;
+        auto previous = clock::now();
+        scheduler.reset();
 
         while (is_running.load() && !current_race_finished.load()) {
+            auto now = clock::now();
+            const int steps = scheduler.advance(now - previous);
+            previous = now;
 
-            procesar_comandos();
+            for (int i = 0; i < steps && !current_race_finished.load(); ++i) simular_tick();
 
-            actualizar_fisica();
-            detectar_colisiones();
-            actualizar_estado_carrera();
-
-          
-            update_checkpoints();
-
-            if (all_players_finished_race()) {
-                current_race_finished = true;
-            }
-
-            enviar_estado_a_jugadores();
-
-          
-            for (auto& [id, p] : players) {
-                player_prev_pos[id] = {p->getX(), p->getY()};
+            // Si nos atrasamos más de max_catchup_steps ticks, el resto se descarta
+            if (scheduler.dropped_steps() > 0) {
+                std::cerr << "[GameLoop] Tick atrasado: se descartan "
+                          << scheduler.dropped_steps() << " pasos de simulación\n";
             }
 
-            next_frame += frame_duration;
-            std::this_thread::sleep_until(next_frame);
+            // Al terminar la carrera mandamos el último estado sin esperar el período
+            if (scheduler.snapshot_due(current_race_finished.load())) enviar_estado_a_jugadores();
 
-            auto now = std::chrono::steady_clock::now();
-            if (now > next_frame) {
-                next_frame = now;
-            }
+            // Dormir hasta el próximo evento (tick o envío)
+            std::this_thread::sleep_until(now + scheduler.until_next_event());
         }
         finish_current_race();
     }
@@ -288,68 +180,135 @@ void GameLoop::run() {
 // IMPLEMENTACIÓN DE MÉTODOS AUXILIARES
 // --------------------------------------------------------
 
-void GameLoop::add_player(int player_id, const std::string& name, const std::string& car_name,
-                          const std::string& car_type) {
-    auto car = std::make_unique<Car>(car_name, car_type);
+void GameLoop::add_player(int player_id, const std::string& name, uint8_t car_id,
+                          const std::string& car_name, const std::string& car_type) {
+    RosterChange change;
+    change.op = RosterOp::JOIN;
+    change.player_id = player_id;
+    change.name = name;
+    change.car_id = car_id;
+    change.car_name = car_name;
+    change.car_type = car_type;
+    roster_changes.push(change);
+}
 
-    // Cargar stats
-    try {
-        YAML::Node global_config = YAML::LoadFile("config.yaml");
-        YAML::Node cars_list = global_config["cars"];
-        float speed_scale = 1.0f;
-        float accel_scale = 1.0f;
-        if (global_config["vehicle_speed_scale"]) speed_scale = global_config["vehicle_speed_scale"].as<float>();
-        if (global_config["vehicle_accel_scale"]) accel_scale = global_config["vehicle_accel_scale"].as<float>();
-        bool car_found = false;
-        if (cars_list && cars_list.IsSequence()) {
-            for (const auto& car_node : cars_list) {
-                if (car_node["name"].as<std::string>() == car_name) {
-                    float speed = car_node["speed"].as<float>();
-                    float acceleration = car_node["acceleration"].as<float>();
-                    float handling = car_node["handling"].as<float>();
-                    float durability = car_node["durability"].as<float>();
-                    float health = car_node["health"] ? car_node["health"].as<float>() : durability;
-                    float max_speed = speed * speed_scale * 1.5f;
-                    float accel_power = acceleration * accel_scale * 0.8f;
-                    float turn_rate = handling * 1.0f / 100.0f;
-                    float nitro_boost = 2.0f;
-                    float mass = 1000.0f + (durability * 5.0f);
-                    car->load_stats(max_speed, accel_power, turn_rate, health, nitro_boost, mass);
-                    car_found = true;
-                    break;
+void GameLoop::delete_player_from_match(int player_id) {
+    RosterChange change;
+    change.op = RosterOp::LEAVE;
+    change.player_id = player_id;
+    roster_changes.push(change);
+}
+
+void GameLoop::set_player_ready(int player_id, bool ready) {
+    RosterChange change;
+    change.op = RosterOp::READY;
+    change.player_id = player_id;
+    change.ready = ready;
+    roster_changes.push(change);
+}
+
+void GameLoop::aplicar_cambios_de_jugadores() {
+    RosterChange change;
+    while (roster_changes.try_pop(change)) {
+        auto it = players.find(change.player_id);
+        switch (change.op) {
+            case RosterOp::JOIN: join_player(change); break;
+            case RosterOp::LEAVE:
+                if (it != players.end()) {
+                    std::cout << "[GameLoop] Eliminando jugador ID: " << change.player_id << "\n";
+                    players.erase(it);  // ~Car libera su slot de car_physics
                 }
-            }
+                break;
+            case RosterOp::READY:
+                if (it != players.end()) it->second->setReady(change.ready);
+                break;
         }
-        if (!car_found) car->load_stats(100.0f * speed_scale, 50.0f * accel_scale, 1.0f, 100.0f, 2.0f, 1000.0f);
-    } catch (...) {
-        // Valores por defecto con escalas
-        car->load_stats(100.0f, 50.0f, 1.0f, 100.0f, 2.0f, 1000.0f);
     }
+}
+
+void GameLoop::join_player(const RosterChange& change) {
+    auto car = std::make_unique<Car>(change.car_name, change.car_type);
+    car->attach_physics(car_physics);
+    car->setModelId(change.car_id);
+
+    // Stats precalculados del catálogo (ids desconocidos -> valores por defecto)
+    const CarModel& model = CarCatalog::instance().get(change.car_id);
+    car->load_stats(model.max_speed, model.accel_power, model.turn_rate, model.health,
+                    model.nitro_boost, model.mass);
 
-    auto player = std::make_unique<Player>(player_id, name);
+    auto player = std::make_unique<Player>(change.player_id, change.name);
     player->setCar(car.get());
     player->resetForNewRace();
+    player->setNextCheckpointIndex(checkpoint_engine.first_target_index());
     player->setCarOwnership(std::move(car));
 
-    players[player_id] = std::move(player);
-    std::cout << "[GameLoop] Jugador agregado: " << name << " (ID: " << player_id << ")\n";
+    players[change.player_id] = std::move(player);
+    std::cout << "[GameLoop] Jugador agregado: " << change.name << " (ID: " << change.player_id
+              << ")\n";
 }
 
-void GameLoop::delete_player_from_match(int player_id) {
-    auto it = players.find(player_id);
-    if (it != players.end()) {
-        std::cout << "[GameLoop] Eliminando jugador ID: " << player_id << "\n";
-        players.erase(it);
+void GameLoop::simular_tick() {
+    ++sim_tick;
+    aplicar_cambios_de_jugadores();
+    procesar_comandos();
+    aplicar_inputs();
+
+    actualizar_fisica();
+    detectar_colisiones();
+    actualizar_estado_carrera();
+
+    update_checkpoints();
+
+    if (all_players_finished_race()) {
+        current_race_finished = true;
     }
-}
 
-void GameLoop::set_player_ready(int player_id, bool ready) {
-    auto it = players.find(player_id);
-    if (it != players.end()) {
-        it->second->setReady(ready);
+    for (auto& [id, p] : players) {
+        p->setPrevPosition(p->getX(), p->getY());
     }
 }
 
+void GameLoop::load_game_config() {
+    int sim_rate = 60;
+    int send_rate = 60;
+    int max_catchup_steps = 5;
+    float interest_near = SNAPSHOT_NEAR_RADIUS;
+    float interest_far = SNAPSHOT_FAR_RADIUS;
+    int interest_far_interval = SNAPSHOT_FAR_INTERVAL;
+    try {
+        // Se lee una sola vez por partida (antes se releía en cada carrera)
+        YAML::Node cfg = YAML::LoadFile("config.yaml");
+        if (cfg["checkpoint_tolerance_base"]) checkpoint_tol_base = cfg["checkpoint_tolerance_base"].as<float>();
+        if (cfg["checkpoint_tolerance_finish"]) checkpoint_tol_finish = cfg["checkpoint_tolerance_finish"].as<float>();
+        if (cfg["checkpoint_lookahead"]) checkpoint_lookahead = cfg["checkpoint_lookahead"].as<int>();
+        if (cfg["checkpoint_debug_enabled"]) checkpoint_debug_enabled = cfg["checkpoint_debug_enabled"].as<bool>();
+        if (cfg["collision_distance_field"]) use_distance_field = cfg["collision_distance_field"].as<bool>();
+        if (cfg["physics_sub_steps"]) physics_sub_steps = cfg["physics_sub_steps"].as<int>();
+        if (cfg["physics_friction"]) physics_friction = cfg["physics_friction"].as<bool>();
+        if (cfg["simulation_rate_hz"]) sim_rate = cfg["simulation_rate_hz"].as<int>();
+        if (cfg["snapshot_rate_hz"]) send_rate = cfg["snapshot_rate_hz"].as<int>();
+        if (cfg["max_catchup_steps"]) max_catchup_steps = cfg["max_catchup_steps"].as<int>();
+        if (cfg["interest_near_radius"]) interest_near = cfg["interest_near_radius"].as<float>();
+        if (cfg["interest_far_radius"]) interest_far = cfg["interest_far_radius"].as<float>();
+        if (cfg["interest_far_interval"]) interest_far_interval = cfg["interest_far_interval"].as<int>();
+    } catch (...) {}
+
+    sim_rate = std::clamp(sim_rate, 1, 1000);
+    send_rate = std::clamp(send_rate, 1, sim_rate);
+    max_catchup_steps = std::max(1, max_catchup_steps);
+    snapshot_encoder.set_interest(interest_near, interest_far, interest_far_interval);
+
+    sim_dt = 1.0f / static_cast<float>(sim_rate);
+    scheduler.configure(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                std::chrono::nanoseconds(1000000000LL / sim_rate)),
+                        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                std::chrono::nanoseconds(1000000000LL / send_rate)),
+                        max_catchup_steps);
+
+    std::cout << "[GameLoop] Simulación a " << sim_rate << " Hz, snapshots a " << send_rate
+              << " Hz (catch-up máx " << max_catchup_steps << " ticks)\n";
+}
+
 void GameLoop::stop_match() {
     std::cout << "[GameLoop] Deteniendo partida...\n";
     is_running = false;
@@ -366,7 +325,7 @@ bool GameLoop::all_players_disconnected() const {
 
 void GameLoop::procesar_comandos() {
     ComandMatchDTO comando;
-    float delta_time = SLEEP / 1000.0f;
+    float delta_time = sim_dt;
 
     while (comandos.try_pop(comando)) {
         auto it = players.find(comando.player_id);
@@ -391,24 +350,26 @@ void GameLoop::procesar_comandos() {
             case GameCommand::DISCONNECT: player->disconnect(); break;
             case GameCommand::STOP_ALL: car->setCurrentSpeed(0); car->setVelocity(0,0); break;
 
+            // Solo se guarda: lo aplica aplicar_inputs, una vez por tick
+            case GameCommand::INPUT_STATE:
+                player->setInput(comando.input_sequence, comando.input_bits);
+                break;
+
             case GameCommand::CHEAT_INVINCIBLE: car->repair(1000.0f); break;
             case GameCommand::CHEAT_MAX_SPEED: car->setCurrentSpeed(car->getMaxSpeed()); break;
 
             case GameCommand::CHEAT_WIN_RACE: {
-                int finish_idx = -1;
-                for (size_t i = 0; i < checkpoints.size(); ++i) {
-                    if (checkpoints[i].type == "finish") { finish_idx = (int)i; break; }
-                }
+                const int finish_idx = checkpoint_engine.finish_index();
                 if (finish_idx != -1) {
-                    const auto& cp_finish = checkpoints[finish_idx];
-                    player->setPosition(cp_finish.x, cp_finish.y);
-                    player->getCar()->setPosition(cp_finish.x, cp_finish.y);
+                    const auto& cp_finish = checkpoint_engine.gate(finish_idx);
+                    player->setPosition(cp_finish.cx, cp_finish.cy);
+                    player->getCar()->setPosition(cp_finish.cx, cp_finish.cy);
                     player->setCheckpoint(cp_finish.id);
-                    player_prev_pos[comando.player_id] = {cp_finish.x, cp_finish.y};
+                    player->setPrevPosition(cp_finish.cx, cp_finish.cy);
 
                     // Ganador por cheat: tiempo muy bajo (1ms) para identificarlo
                     mark_player_finished_with_time(comando.player_id, 1);
-                    player_next_checkpoint[comando.player_id] = std::min(finish_idx + 1, (int)checkpoints.size() - 1);
+                    player->setNextCheckpointIndex(checkpoint_engine.next_after(finish_idx));
 
                     // Cerrar carrera: marcar tiempos para jugadores que NO terminaron
                     auto now = std::chrono::steady_clock::now();
@@ -449,130 +410,49 @@ void GameLoop::procesar_comandos() {
         }
     }
 }
-void GameLoop::actualizar_fisica() {
-    float total_dt = SLEEP / 1000.0f;
-    int sub_steps = 10; 
-    float sub_dt = total_dt / sub_steps;
-
-    // LÍMITES DEL MAPA
-    float map_limit_x = 4640.0f;
-    float map_limit_y = 4672.0f;
-    
-    // --- AJUSTE DE RADIO ---
-    float car_radius = 12.0f; 
-    float min_dist_collision = car_radius * 2.0f; 
-    float min_dist_sq = min_dist_collision * min_dist_collision; 
-
+void GameLoop::aplicar_inputs() {
+    // Un paso de sim_dt por tick sin importar cuántos INPUT_STATE llegaron en el medio
     for (auto& [id, player] : players) {
         Car* car = player->getCar();
-        if (!car || car->isDestroyed()) continue;
+        if (!car || player->isDisconnected()) continue;
 
-      
-        for (int i = 0; i < sub_steps; ++i) {
-            float old_x = car->getX();
-            float old_y = car->getY();
-            
-            car->update(sub_dt);
-            
-            float new_x = car->getX();
-            float new_y = car->getY();
-            bool collision_detected = false;
-
-           
-            for (auto& [other_id, other_player] : players) {
-                if (id == other_id) continue;
-                
-                Car* other_car = other_player->getCar();
-                if (!other_car || other_car->isDestroyed()) continue;
-
-                float dx = new_x - other_car->getX();
-                float dy = new_y - other_car->getY();
-                float dist_sq = dx*dx + dy*dy;
-
-                if (dist_sq < min_dist_sq) {
-                  
-                    collision_detected = true;
-                    
-                    float dist = std::sqrt(dist_sq);
-                    if (dist == 0) dist = 0.01f;
-                    float nx = dx / dist;
-                    float ny = dy / dist;
-
-                    
-                    car->setPosition(old_x, old_y);
-                    car->setColliding(true);
-
-                 
-                    float vx = car->getVelocityX();
-                    float vy = car->getVelocityY();
-
-                    float dot = vx * nx + vy * ny;
-                    float elasticity = 0.8f; 
-
-                   
-                    if (dot < 0) {
-                        float new_vx = vx - (1.0f + elasticity) * dot * nx;
-                        float new_vy = vy - (1.0f + elasticity) * dot * ny;
-                        car->setVelocity(new_vx, new_vy);
-                    }
-                    
-                    break; 
-                }
-            }
+        const uint8_t bits = player->getInputBits();
+        car->apply_input(bits, player->swapAppliedInput(bits), sim_dt);
+    }
+}
 
-            if (collision_detected) {
-                break; 
-            }
+void GameLoop::actualizar_fisica() {
+    float total_dt = sim_dt;
+    // El barrido de paredes evita el tunneling: alcanza con integrar una vez por tick
+    int sub_steps = std::max(1, physics_sub_steps);
+    float sub_dt = total_dt / sub_steps;
 
-            // COLISIÓN CON PAREDES
-            if (collision_manager) {
-                int current_level = 0; 
-                CollisionResult col = collision_manager->checkCollision(
-                    (int)old_x, (int)old_y, current_level, (int)new_x, (int)new_y
-                );
-
-                if (col.is_wall) {
-                    car->setPosition(old_x, old_y);
-                    car->setColliding(true);
-
-                    float vx = car->getVelocityX();
-                    float vy = car->getVelocityY();
-                    float dot = vx * col.normal_x + vy * col.normal_y;
-                    float elasticity = 0.5f; 
-
-                    float new_vx = vx - (1.0f + elasticity) * dot * col.normal_x;
-                    float new_vy = vy - (1.0f + elasticity) * dot * col.normal_y;
-
-                    car->setVelocity(new_vx, new_vy);
-                    
-                    float current_speed = car->getCurrentSpeed();
-                    car->setCurrentSpeed(current_speed * 0.5f);
-                    
-                   // if (current_speed > 50.0f) car->takeDamage(10.0f);
-
-                    break; 
-                } else {
-                    car->setColliding(false);
-                }
-            }
-        } 
+    const size_t count = car_physics.size();
+    for (size_t i = 0; i < count; ++i) {
+        car_physics.owner(i)->setColliding(false);
+    }
 
-        //  CLAMP (Límites del mapa)
-        float cx = car->getX();
-        float cy = car->getY();
-        if (cx < 0.0f) car->setPosition(0.0f, cy);
-        else if (cx > map_limit_x) car->setPosition(map_limit_x, cy);
-        
-        cx = car->getX(); 
-        if (cy < 0.0f) car->setPosition(cx, 0.0f);
-        else if (cy > map_limit_y) car->setPosition(cx, map_limit_y);
+    for (int step = 0; step < sub_steps; ++step) {
+        // 1. FRICCIÓN + INTEGRACIÓN (kernels sobre todos los autos, guardan old_x/old_y)
+        if (physics_friction) car_physics.apply_friction(sub_dt);
+        car_physics.integrate(sub_dt);
 
-        
-        player->setPosition(car->getX(), car->getY());
-        player->setAngle(car->getAngle());
-        player->setSpeed(car->getCurrentSpeed());
+        // 2. COLISIONES ENTRE AUTOS (broadphase, cada par una sola vez)
+        resolver_colisiones_autos();
+
+        // 3. COLISIÓN CON PAREDES
+        if (collision_manager) {
+            for (size_t i = 0; i < count; ++i) {
+                if (car_physics.alive[i] == 0.0f) continue;
+                car_physics.owner(i)->resolve_wall_collision(
+                        *collision_manager, car_physics.old_x[i], car_physics.old_y[i]);
+            }
+        }
     }
 
+    //  CLAMP (Límites del mapa). Player lee la posición del Car, no hace falta sincronizar
+    car_physics.clamp_to_bounds(MAP_LIMIT_X, MAP_LIMIT_Y);
+
     /*Con Box2d
         b2World_Step(physics_world_id, TIME_STEP, VELOCITY_ITERATIONS);
     
@@ -589,6 +469,61 @@ void GameLoop::actualizar_fisica() {
     */
 }
 
+void GameLoop::resolver_colisiones_autos() {
+    const size_t count = car_physics.size();
+    if (count < 2) return;
+
+    std::vector<float>& xs = car_physics.x;
+    std::vector<float>& ys = car_physics.y;
+    car_broadphase.rebuild(xs.data(), ys.data(), count);
+
+    const float min_dist = CAR_RADIUS * 2.0f;
+    const float elasticity = 0.8f;
+
+    car_broadphase.for_each_pair(xs.data(), ys.data(), min_dist, [&](int a, int b) {
+        if (car_physics.alive[a] == 0.0f || car_physics.alive[b] == 0.0f) return;
+        Car* car_a = car_physics.owner(a);
+        Car* car_b = car_physics.owner(b);
+
+        float dx = xs[a] - xs[b];
+        float dy = ys[a] - ys[b];
+        float dist = std::sqrt(dx * dx + dy * dy);
+        float nx = 1.0f, ny = 0.0f;
+        if (dist > 0.01f) {
+            nx = dx / dist;
+            ny = dy / dist;
+        }
+
+        // Separación repartida según el peso de cada auto
+        float mass_a = std::max(1.0f, car_a->getWeight());
+        float mass_b = std::max(1.0f, car_b->getWeight());
+        float overlap = min_dist - dist;
+        float share_a = mass_b / (mass_a + mass_b);
+        float share_b = mass_a / (mass_a + mass_b);
+        xs[a] += nx * overlap * share_a;
+        ys[a] += ny * overlap * share_a;
+        xs[b] -= nx * overlap * share_b;
+        ys[b] -= ny * overlap * share_b;
+
+        // Rebote: impulso sobre la velocidad relativa (simétrico)
+        std::vector<float>& vxs = car_physics.velocity_x;
+        std::vector<float>& vys = car_physics.velocity_y;
+        float rel_vx = vxs[a] - vxs[b];
+        float rel_vy = vys[a] - vys[b];
+        float dot = rel_vx * nx + rel_vy * ny;
+        if (dot < 0) {
+            float impulse = -(1.0f + elasticity) * dot / (1.0f / mass_a + 1.0f / mass_b);
+            vxs[a] += impulse / mass_a * nx;
+            vys[a] += impulse / mass_a * ny;
+            vxs[b] -= impulse / mass_b * nx;
+            vys[b] -= impulse / mass_b * ny;
+        }
+
+        car_a->setColliding(true);
+        car_b->setColliding(true);
+    });
+}
+
 void GameLoop::detectar_colisiones() { }
 
 void GameLoop::actualizar_estado_carrera() { }
@@ -596,8 +531,8 @@ void GameLoop::actualizar_estado_carrera() { }
 void GameLoop::verificar_ganadores() { }
 
 void GameLoop::enviar_estado_a_jugadores() {
-    GameState snapshot = create_snapshot();
-    queues_players.broadcast(snapshot);
+    // Se serializa una vez y cada cola recibe solo el handle
+    queues_players.broadcast(snapshot_encoder.encode(create_snapshot(), sim_tick));
 }
 
 GameState GameLoop::create_snapshot() {
@@ -631,41 +566,35 @@ void GameLoop::load_spawn_points_for_current_race() {
 
     std::cout << "[GameLoop] >>> Cargando spawns desde: " << current_map_yaml << std::endl;
 
-    try {
-        YAML::Node map = YAML::LoadFile(current_map_yaml);
-        if (map["spawn_points"] && map["spawn_points"].IsSequence()) {
-            for (const auto& node : map["spawn_points"]) {
-                float x = node["x"].as<float>();
-                float y = node["y"].as<float>();
-                float a = node["angle"].as<float>() * (M_PI / 180.0f);
-                spawn_points.emplace_back(x, y, a);
-            }
-        } else {
-            std::cout << "[GameLoop]  No se encontraron spawn points en el YAML." << std::endl;
-        }
-    } catch (const std::exception& e) {
-        std::cerr << "[GameLoop]  Error cargando spawns de " << current_map_yaml << ": " << e.what() << std::endl;
+    if (!current_race_descriptor) return;
+    for (const auto& def : current_race_descriptor->spawn_points) {
+        spawn_points.emplace_back(def.x, def.y, def.angle * (M_PI / 180.0f));
+    }
+    if (spawn_points.empty()) {
+        std::cout << "[GameLoop]  No se encontraron spawn points en el YAML." << std::endl;
     }
 }
 
 void GameLoop::reset_players_for_race() {
+    // Ruta compilada (spawns, checkpoints, vueltas): una sola lectura, cacheada
+    try {
+        current_race_descriptor = RaceDescriptor::load(current_map_yaml);
+        if (current_race_index < races.size()) {
+            races[current_race_index]->set_total_laps(current_race_descriptor->total_laps);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[GameLoop]  Error cargando ruta " << current_map_yaml << ": " << e.what()
+                  << std::endl;
+        current_race_descriptor = nullptr;
+    }
 
-    std::string city_clean = current_city_name; 
-
-    std::transform(city_clean.begin(), city_clean.end(), city_clean.begin(), ::tolower);
-    std::replace(city_clean.begin(), city_clean.end(), ' ', '-');
-    std::replace(city_clean.begin(), city_clean.end(), '_', '-');
-
-   
-    std::string base_path = "assets/img/map/layers/" + city_clean + "/";
-    std::string path_camino = base_path + "camino.png";
-    std::string path_puentes = base_path + "puentes.png";
-    std::string path_rampas = base_path + "rampas.png"; 
-
-    std::cout << "[GameLoop] Cargando colisiones desde: " << base_path << std::endl;
-    
+    // Las capas de la ciudad se comparten entre carreras y partidas (MapAssetCache)
     try {
-        collision_manager = std::make_unique<CollisionManager>(path_camino, path_puentes, path_rampas);
+        collision_manager = std::make_unique<CollisionManager>(
+            MapAssetCache::get(current_city_name, use_distance_field));
+        // Posiciones de los snapshots en 16 bits relativas al tamaño de esta ciudad
+        snapshot_encoder.set_bounds(static_cast<float>(collision_manager->GetWidth()),
+                                    static_cast<float>(collision_manager->GetHeight()));
     } catch (const std::exception& e) {
         std::cerr << "[GameLoop] ⚠️ Error cargando CollisionManager: " << e.what() << std::endl;
         std::cerr << "[GameLoop] -> Se jugará SIN colisiones de mapa." << std::endl;
@@ -674,25 +603,7 @@ void GameLoop::reset_players_for_race() {
 
     load_spawn_points_for_current_race();
     load_checkpoints_for_current_race();
-    try {
-        YAML::Node cfg = YAML::LoadFile("config.yaml");
-        if (cfg["checkpoint_tolerance_base"]) checkpoint_tol_base = cfg["checkpoint_tolerance_base"].as<float>();
-        if (cfg["checkpoint_tolerance_finish"]) checkpoint_tol_finish = cfg["checkpoint_tolerance_finish"].as<float>();
-        if (cfg["checkpoint_lookahead"]) checkpoint_lookahead = cfg["checkpoint_lookahead"].as<int>();
-        if (cfg["checkpoint_debug_enabled"]) checkpoint_debug_enabled = cfg["checkpoint_debug_enabled"].as<bool>();
-    } catch (...) {}
 
-    player_next_checkpoint.clear();
-    player_prev_pos.clear();
-    if (!checkpoints.empty()) {
-        int first_idx = 0;
-        for (size_t i = 0; i < checkpoints.size(); ++i) {
-            if (checkpoints[i].type != "start") { first_idx = (int)i; break; }
-        }
-        for (auto& [pid, player] : players) {
-            player_next_checkpoint[pid] = first_idx;
-        }
-    }
     if (spawn_points.empty()) {
         std::cerr << "[GameLoop]   NO HAY SPAWN POINTS! Usando posiciones por defecto" << std::endl;
     }
@@ -706,6 +617,7 @@ void GameLoop::reset_players_for_race() {
 
         player->resetForNewRace();
         player->getCar()->reset();
+        player->setNextCheckpointIndex(checkpoint_engine.first_target_index());
 
         float x = 100.f, y = 100.f, a = 0.f;
         if (idx < spawn_points.size()) {
@@ -739,7 +651,7 @@ void GameLoop::reset_players_for_race() {
         // Sincronizar posición lógica
         player->getCar()->syncFromPhysics();
         player->setPosition(player->getCar()->getX(), player->getCar()->getY());*/
-        player_prev_pos[id] = {x, y};
+        player->setPrevPosition(x, y);
 
         idx++;
     }
@@ -18,11 +18,16 @@
 #include "../../common_src/thread.h"
 #include "../network/client_monitor.h"
 #include "../../common_src/collision_manager.h" // IMPORTANTE
-#include "car.h"
+#include "../../common_src/race_descriptor.h"
+#include "../../common_src/car.h"
+#include "../../common_src/car_physics_pool.h"
+#include "checkpoint_engine.h"
 #include "player.h"
+#include "spatial_hash.h"
+#include "tick_scheduler.h"
 
 #define NITRO_DURATION 12
-#define SLEEP          16 
+#define CAR_RADIUS     12.0f
 
 class Race;
 
@@ -35,8 +40,27 @@ private:
 
     Queue<ComandMatchDTO>& comandos;  
     ClientMonitor& queues_players;    
+    SnapshotEncoder snapshot_encoder;  // un encode por tick, compartido por todas las conexiones
+
+    // Estado cinemático SoA de todos los autos (declarado antes que `players`:
+    // los Car liberan su slot al destruirse)
+    CarPhysicsPool car_physics;
 
     std::map<int, std::unique_ptr<Player>> players;  
+
+    // Altas, bajas y "listo" llegan desde Match y el reactor: se encolan y las aplica
+    // el hilo del GameLoop al empezar cada tick, así car_physics y `players` son solo suyos
+    enum class RosterOp : uint8_t { JOIN, LEAVE, READY };
+    struct RosterChange {
+        RosterOp op = RosterOp::JOIN;
+        int player_id = 0;
+        std::string name;
+        uint8_t car_id = 0;
+        std::string car_name;
+        std::string car_type;
+        bool ready = false;
+    };
+    Queue<RosterChange> roster_changes;
     
     // Carreras
     std::vector<std::unique_ptr<Race>> races;  
@@ -46,23 +70,22 @@ private:
     // Configuración actual
     std::string current_map_yaml;
     std::string current_city_name;
+    std::shared_ptr<const RaceDescriptor> current_race_descriptor;
     std::vector<std::tuple<float, float, float>> spawn_points;
     bool spawns_loaded;
 
     // Collision Manager
     std::unique_ptr<CollisionManager> collision_manager;
+    bool use_distance_field = true;  // SDF para normales/depenetración
+    int physics_sub_steps = 1;       // Con barrido continuo no hace falta sub-stepping
 
-    // Checkpoints y lógica interna
-    struct Checkpoint {
-        int id;
-        std::string type;  
-        float x, y;
-        float width, height;
-        float angle;       
-    };
-    std::vector<Checkpoint> checkpoints;
-    std::map<int, int> player_next_checkpoint;           
-    std::map<int, std::pair<float,float>> player_prev_pos; 
+    bool physics_friction = false;   // Fricción pasiva (kernel batch)
+
+    // Broadphase auto-auto
+    SpatialHash car_broadphase{CAR_RADIUS * 2.0f};
+
+    // Checkpoints como compuertas orientadas (progreso por jugador en Player)
+    CheckpointEngine checkpoint_engine;
 
     float checkpoint_tol_base = 1.5f;
     float checkpoint_tol_finish = 3.0f;
@@ -79,6 +102,11 @@ private:
     ObstacleManager obstacleManager;
     */
 
+    // Scheduler de paso fijo (config.yaml: simulation_rate_hz / snapshot_rate_hz)
+    float sim_dt = 1.0f / 60.0f;
+    TickScheduler scheduler;
+    uint32_t sim_tick = 0;  // ticks simulados desde que empezó la partida (los informa el PONG)
+
     // Tiempos
     std::chrono::steady_clock::time_point race_start_time;
     std::vector<std::map<int, uint32_t>> race_finish_times;
@@ -93,11 +121,17 @@ private:
     bool all_players_disconnected() const;
 
     void load_checkpoints_for_current_race();
-    bool check_player_crossed_checkpoint(int player_id, const Checkpoint& cp);
     void update_checkpoints();
 
+    void load_game_config();
+    void simular_tick();
+
+    void aplicar_cambios_de_jugadores();
+    void join_player(const RosterChange& change);
     void procesar_comandos();
+    void aplicar_inputs();  // estado de controles de cada jugador, una vez por tick
     void actualizar_fisica(); // AQUÍ SE USA EL COLLISION MANAGER
+    void resolver_colisiones_autos();
     void detectar_colisiones();
     void actualizar_estado_carrera();
     void verificar_ganadores();
@@ -123,8 +157,8 @@ public:
     void add_race(const std::string& city, const std::string& yaml_path);
     void set_races(std::vector<std::unique_ptr<Race>> race_configs);
 
-    void add_player(int player_id, const std::string& name, const std::string& car_name,
-                    const std::string& car_type);
+    void add_player(int player_id, const std::string& name, uint8_t car_id,
+                    const std::string& car_name, const std::string& car_type);
     void delete_player_from_match(int player_id);
     void set_player_ready(int player_id, bool ready);
 
@@ -5,6 +5,7 @@
 #include <iomanip>
 #include <utility>
 
+#include "common_src/car_catalog.h"
 #include "common_src/config.h"
 #include "common_src/dtos.h"  // RaceInfoDTO, ServerMessageType
 #define RUTA_MAPS "server_src/city_maps/"
@@ -37,7 +38,7 @@ bool Match::can_player_join_match() const {
     return static_cast<int>(players_info.size()) < max_players && state != MatchState::STARTED;
 }
 
-bool Match::add_player(int id, std::string nombre, Queue<GameState>& queue_enviadora) {
+bool Match::add_player(int id, std::string nombre, Mailbox<SnapshotHandle>& queue_enviadora) {
     std::lock_guard<std::mutex> lock(mtx);
 
     // Validar sin llamar a can_player_join_match() para evitar deadlock
@@ -152,6 +153,10 @@ bool Match::set_player_car(int player_id, const std::string& car_name, const std
 
     it->second.car_name = car_name;
     it->second.car_type = car_type;
+    it->second.car_id = CarCatalog::instance().id_of(car_name);
+    if (it->second.car_id == CarCatalog::UNKNOWN_CAR) {
+        std::cerr << "[Match] Auto '" << car_name << "' no está en el catálogo, stats por defecto\n";
+    }
 
     // Actualizar en Player también
     for (auto& player : players) {
@@ -168,7 +173,7 @@ bool Match::set_player_car(int player_id, const std::string& car_name, const std
     if (gameloop) {
         std::cout << "[Match] >>> Registrando " << it->second.name << " en GameLoop con auto "
                   << car_name << "\n";
-        gameloop->add_player(player_id, it->second.name, car_name, car_type);
+        gameloop->add_player(player_id, it->second.name, it->second.car_id, car_name, car_type);
         std::cout << "[Match]   Jugador " << it->second.name << " agregado al GameLoop exitosamente\n";
     } else {
         std::cerr << "[Match]   ERROR: GameLoop no existe, no se pudo registrar jugador\n";
@@ -311,7 +316,7 @@ void Match::set_race_configs(const std::vector<ServerRaceConfig>& configs) {
     for (const auto& [id, info] : players_info) {
         if (!info.car_name.empty() && !info.car_type.empty()) {
             std::cout << "[Match] >>> Agregando jugador " << info.name << " al GameLoop\n";
-            gameloop->add_player(id, info.name, info.car_name, info.car_type);
+            gameloop->add_player(id, info.name, info.car_id, info.car_name, info.car_type);
         }
     }
 
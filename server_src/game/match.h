@@ -10,8 +10,10 @@
 #include <vector>
 
 #include "game_loop.h"
+#include "../../common_src/car_catalog.h"
 #include "../../common_src/dtos.h"
 #include "../../common_src/game_state.h"
+#include "../../common_src/mailbox.h"
 #include "../../common_src/queue.h"
 #include "../network/client_monitor.h"
 #include "race.h"
@@ -24,8 +26,9 @@ struct PlayerLobbyInfo {
     std::string name;
     std::string car_name;
     std::string car_type;
+    uint8_t car_id = CarCatalog::UNKNOWN_CAR;  // índice en CarCatalog
     bool is_ready;
-    Queue<GameState>* sender_queue;
+    Mailbox<SnapshotHandle>* sender_queue;
 };
 
 enum class MatchState : uint8_t {
@@ -66,7 +69,7 @@ public:
 
     // ---- LOBBY: Gestión de jugadores ----
     bool can_player_join_match() const;
-    bool add_player(int id, std::string nombre, Queue<GameState>& queue_enviadora);
+    bool add_player(int id, std::string nombre, Mailbox<SnapshotHandle>& queue_enviadora);
     bool remove_player(int id_jugador);
     bool has_player(int player_id) const;
     bool has_player_by_name(const std::string& name) const;
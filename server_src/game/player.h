@@ -6,7 +6,7 @@
 #include <string>
 #include <utility>
 
-#include "car.h"  //   Player tiene un Car
+#include "../../common_src/car.h"  //   Player tiene un Car
 
 class Player {
 private:
@@ -21,6 +21,8 @@ private:
     // ---- ESTADO EN LA CARRERA ----
     int completed_laps;
     int current_checkpoint;
+    int next_checkpoint_index;  // compuerta a cruzar (índice en CheckpointEngine)
+    float prev_x, prev_y;       // posición al final del tick anterior
     int position_in_race;  // 1st, 2nd, 3rd, etc.
     int score;
     bool finished_race;
@@ -29,10 +31,17 @@ private:
     bool disconnected;
     bool is_ready;  // Para el lobby
 
+    // ---- CONTROLES ----
+    uint8_t input_bits;        // último INPUT_STATE recibido (máscara INPUT_*)
+    uint8_t applied_bits;      // lo que se aplicó en el tick anterior
+    uint32_t input_sequence;   // secuencia de ese INPUT_STATE
+
 public:
     explicit Player(int id, const std::string& name)
         : id(id), name(name), car(nullptr), completed_laps(0), current_checkpoint(0),
-          position_in_race(0), score(0), finished_race(false), disconnected(false), is_ready(false) {
+          next_checkpoint_index(0), prev_x(0.0f), prev_y(0.0f), position_in_race(0), score(0),
+          finished_race(false), disconnected(false), is_ready(false), input_bits(0),
+          applied_bits(0), input_sequence(0) {
     }
 
     // --- Auto ---
@@ -63,6 +72,8 @@ public:
         return car ? car->getCarType() : empty;
     }
 
+    uint8_t getCarModelId() const { return car ? car->getModelId() : 0xFF; }
+
     // --- Basic Getters ---
     int getId() const { return id; }
     const std::string& getName() const { return name; }
@@ -95,6 +106,17 @@ public:
     int getCurrentCheckpoint() const { return current_checkpoint; }
     void setCheckpoint(int checkpoint) { current_checkpoint = checkpoint; }
 
+    int getNextCheckpointIndex() const { return next_checkpoint_index; }
+    void setNextCheckpointIndex(int index) { next_checkpoint_index = index; }
+
+    // Posición del tick anterior (para detectar cruces de checkpoints)
+    float getPrevX() const { return prev_x; }
+    float getPrevY() const { return prev_y; }
+    void setPrevPosition(float x, float y) {
+        prev_x = x;
+        prev_y = y;
+    }
+
     // --- Posición en la carrera ---
     int getPositionInRace() const { return position_in_race; }
     void setPositionInRace(int pos) { position_in_race = pos; }
@@ -125,6 +147,20 @@ public:
     bool isDisconnected() const { return disconnected; }
     void disconnect() { disconnected = true; }
 
+    // --- Controles (se aplican una vez por tick, ver GameLoop::aplicar_inputs) ---
+    // Se queda con el estado más nuevo; false si `sequence` es viejo o repetido
+    bool setInput(uint32_t sequence, uint8_t bits) {
+        if (sequence <= input_sequence) return false;
+        input_sequence = sequence;
+        input_bits = bits;
+        return true;
+    }
+    uint8_t getInputBits() const { return input_bits; }
+    uint32_t getInputSequence() const { return input_sequence; }
+
+    // Devuelve lo aplicado en el tick anterior y registra `bits` como lo actual
+    uint8_t swapAppliedInput(uint8_t bits) { return std::exchange(applied_bits, bits); }
+
     // --- Ready (para lobby) ---
     bool getIsReady() const { return is_ready; }
     void setReady(bool ready) { is_ready = ready; }
@@ -140,9 +176,13 @@ public:
     void resetForNewRace() {
         completed_laps = 0;
         current_checkpoint = 0;
+        next_checkpoint_index = 0;
         position_in_race = 0;
         finished_race = false;
         disconnected = false;
+        // La secuencia sigue: el cliente no la reinicia entre carreras
+        input_bits = 0;
+        applied_bits = 0;
         if (car) {
             car->reset();
         }
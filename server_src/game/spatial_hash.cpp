@@ -0,0 +1,37 @@
+#include "spatial_hash.h"
+
+#include <algorithm>
+#include <cmath>
+
+SpatialHash::SpatialHash(float cell_size) : inv_cell_size(1.0f / cell_size), table_mask(0) {}
+
+void SpatialHash::rebuild(const float* xs, const float* ys, size_t count) {
+    entries.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const int32_t cx = static_cast<int32_t>(std::floor(xs[i] * inv_cell_size));
+        const int32_t cy = static_cast<int32_t>(std::floor(ys[i] * inv_cell_size));
+        entries[i] = {make_key(cx, cy), static_cast<int>(i)};
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.cell < b.cell; });
+
+    // Agrupar en celdas ocupadas
+    cells.clear();
+    for (size_t i = 0; i < count; ++i) {
+        if (cells.empty() || cells.back().key != entries[i].cell) {
+            cells.push_back({entries[i].cell, static_cast<uint32_t>(i), static_cast<uint32_t>(i)});
+        }
+        cells.back().last = static_cast<uint32_t>(i + 1);
+    }
+
+    // Tabla con carga <= 50% (potencia de 2) para buscar vecinas en O(1)
+    size_t table_size = 16;
+    while (table_size < cells.size() * 2) table_size <<= 1;
+    table.assign(table_size, -1);
+    table_mask = table_size - 1;
+    for (size_t i = 0; i < cells.size(); ++i) {
+        uint64_t slot = mix(cells[i].key) & table_mask;
+        while (table[slot] >= 0) slot = (slot + 1) & table_mask;
+        table[slot] = static_cast<int32_t>(i);
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/*
+ * SpatialHash: broadphase de grilla uniforme para colisiones auto-auto.
+ *
+ * Cada paso se reconstruye con las posiciones actuales (ordenando los
+ * cuerpos por celda) y `for_each_pair` entrega solo los pares que están a
+ * menos de `radius`. Con celdas de lado >= radius alcanza con mirar la
+ * celda propia y la mitad "hacia adelante" de las vecinas, así que cada
+ * par aparece UNA sola vez: el costo es ~O(n) en vez de O(n²).
+ */
+class SpatialHash {
+private:
+    struct Entry {
+        uint64_t cell;
+        int body;
+    };
+
+    struct Cell {
+        uint64_t key;
+        uint32_t first;  // rango [first, last) dentro de `entries`
+        uint32_t last;
+    };
+
+    float inv_cell_size;
+    std::vector<Entry> entries;  // ordenado por celda
+    std::vector<Cell> cells;     // celdas ocupadas, en el mismo orden
+    std::vector<int32_t> table;  // hash abierto: key -> índice en `cells` (-1 = vacío)
+    uint64_t table_mask;
+
+    static uint64_t make_key(int32_t cx, int32_t cy) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) |
+               static_cast<uint32_t>(cy);
+    }
+
+    static uint64_t mix(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return key;
+    }
+
+    // Rango [first, last) de `entries` que cae en la celda (vacío si no hay nadie)
+    std::pair<size_t, size_t> cell_range(uint64_t key) const {
+        for (uint64_t slot = mix(key) & table_mask;; slot = (slot + 1) & table_mask) {
+            const int32_t idx = table[slot];
+            if (idx < 0) return {0, 0};
+            if (cells[idx].key == key) return {cells[idx].first, cells[idx].last};
+        }
+    }
+
+public:
+    explicit SpatialHash(float cell_size);
+
+    void rebuild(const float* xs, const float* ys, size_t count);
+
+    /*
+     * Llama a `callback(a, b)` para cada par de cuerpos (índices del último
+     * rebuild) a distancia menor que `radius`. Cada par aparece una vez.
+     */
+    template <typename Callback>
+    void for_each_pair(const float* xs, const float* ys, float radius, Callback&& callback) const;
+
+    size_t size() const { return entries.size(); }
+};
+
+template <typename Callback>
+void SpatialHash::for_each_pair(const float* xs, const float* ys, float radius,
+                                Callback&& callback) const {
+    // Vecinas "hacia adelante": junto con la celda propia cubren cada par una vez
+    static constexpr int32_t FORWARD[4][2] = {{1, -1}, {1, 0}, {1, 1}, {0, 1}};
+    const float radius_sq = radius * radius;
+
+    auto test = [&](int a, int b) {
+        const float dx = xs[a] - xs[b];
+        const float dy = ys[a] - ys[b];
+        if (dx * dx + dy * dy < radius_sq) callback(a, b);
+    };
+
+    for (const Cell& cell : cells) {
+        const uint64_t key = cell.key;
+        const size_t begin = cell.first;
+        const size_t end = cell.last;
+
+        // 1. Pares dentro de la misma celda
+        for (size_t i = begin; i < end; ++i) {
+            for (size_t j = i + 1; j < end; ++j) {
+                test(entries[i].body, entries[j].body);
+            }
+        }
+
+        // 2. Pares con las celdas vecinas hacia adelante
+        const int32_t cx = static_cast<int32_t>(key >> 32);
+        const int32_t cy = static_cast<int32_t>(static_cast<uint32_t>(key));
+        for (const auto& offset : FORWARD) {
+            auto [first, last] = cell_range(make_key(cx + offset[0], cy + offset[1]));
+            for (size_t i = begin; i < end; ++i) {
+                for (size_t j = first; j < last; ++j) {
+                    test(entries[i].body, entries[j].body);
+                }
+            }
+        }
+    }
+}
+
+#endif  // SPATIAL_HASH_H
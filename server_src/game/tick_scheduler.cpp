@@ -0,0 +1,48 @@
+#include "tick_scheduler.h"
+
+#include <algorithm>
+
+// Mismos defaults que config.yaml: 60 Hz de simulación y de snapshots, 5 ticks de catch-up
+TickScheduler::TickScheduler()
+    : sim_period(std::chrono::duration_cast<Clock::duration>(
+              std::chrono::nanoseconds(1000000000LL / 60))),
+      send_period(sim_period), max_catchup_steps(5) {
+    reset();
+}
+
+void TickScheduler::configure(Clock::duration sim, Clock::duration send, int max_catchup) {
+    sim_period = std::max(sim, Clock::duration(1));
+    send_period = std::max(send, Clock::duration(1));
+    max_catchup_steps = std::max(1, max_catchup);
+    reset();
+}
+
+void TickScheduler::reset() {
+    accumulator = Clock::duration::zero();
+    send_accumulator = send_period;
+    dropped = 0;
+}
+
+int TickScheduler::advance(Clock::duration elapsed) {
+    accumulator += elapsed;
+    send_accumulator += elapsed;
+
+    const int64_t pending = accumulator / sim_period;
+    const int steps = static_cast<int>(std::min<int64_t>(pending, max_catchup_steps));
+    accumulator -= steps * sim_period;
+
+    // El atraso que no se recupera se tira entero; la fracción de tick se conserva
+    dropped = pending - steps;
+    accumulator %= sim_period;
+    return steps;
+}
+
+bool TickScheduler::snapshot_due(bool force) {
+    if (send_accumulator < send_period && !force) return false;
+    send_accumulator %= send_period;
+    return true;
+}
+
+TickScheduler::Clock::duration TickScheduler::until_next_event() const {
+    return std::min(sim_period - accumulator, send_period - send_accumulator);
+}
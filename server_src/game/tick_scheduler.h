@@ -0,0 +1,51 @@
+#ifndef TICK_SCHEDULER_H
+#define TICK_SCHEDULER_H
+
+#include <chrono>
+#include <cstdint>
+
+/*
+ * TickScheduler: reloj de paso fijo del GameLoop.
+ *
+ * Acumula el tiempo real transcurrido y lo convierte en ticks enteros de
+ * `sim_period`; los snapshots llevan su propio acumulador con `send_period`.
+ * Si una vuelta se atrasa, se recuperan a lo sumo `max_catchup_steps` ticks
+ * y el resto se descarta (queda en `dropped_steps`) en lugar de entrar en
+ * una espiral intentando alcanzar al reloj. No toca el reloj: el que llama
+ * le pasa el tiempo transcurrido, así se puede probar sin dormir.
+ */
+class TickScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    Clock::duration sim_period;
+    Clock::duration send_period;
+    int max_catchup_steps;
+
+    Clock::duration accumulator;
+    Clock::duration send_accumulator;
+    int64_t dropped;
+
+public:
+    TickScheduler();
+
+    void configure(Clock::duration sim_period, Clock::duration send_period, int max_catchup_steps);
+
+    // Al empezar una carrera: sin atraso y con el primer snapshot inmediato
+    void reset();
+
+    // Suma `elapsed` y devuelve cuántos ticks simular ahora
+    int advance(Clock::duration elapsed);
+
+    // Ticks descartados por el último `advance` (0 si no hubo atraso)
+    int64_t dropped_steps() const { return dropped; }
+
+    // true si toca mandar un snapshot (siempre con `force`); consume el período
+    bool snapshot_due(bool force);
+
+    // Cuánto falta para el próximo tick o envío
+    Clock::duration until_next_event() const;
+};
+
+#endif  // TICK_SCHEDULER_H
@@ -3,15 +3,43 @@
 #include <chrono>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 #include <thread>
+#include <vector>
 
+#include "../common_src/car_catalog.h"
 #include "../common_src/config.h"
+#include "../common_src/map_asset_cache.h"
 #include "server.h"
 
 #define ERROR            1
 #define SUCCESS          0
 #define TIPO_AUTO_PRUEBA "DEPORTIVO"
 
+// Precarga opcional de las colisiones de todas las ciudades (preload_map_assets en el YAML)
+static void preload_map_assets() {
+    try {
+        if (!Configuration::get<bool>("preload_map_assets")) return;
+    } catch (const std::exception&) {
+        return;
+    }
+
+    bool with_distance_fields = true;
+    try {
+        with_distance_fields = Configuration::get<bool>("collision_distance_field");
+    } catch (const std::exception&) {}
+
+    try {
+        std::vector<std::string> cities;
+        for (const auto& city : Configuration::get_node("available_cities")) {
+            cities.push_back(city.as<std::string>());
+        }
+        MapAssetCache::preload(cities, with_distance_fields);
+    } catch (const std::exception& e) {
+        std::cerr << "[Server] Precarga de mapas omitida: " << e.what() << std::endl;
+    }
+}
+
 int main(int argc, char* argv[]) {
     if (argc < 2) {
         std::cerr
@@ -23,6 +51,8 @@ int main(int argc, char* argv[]) {
     try {
         const char* path_config = argv[1];
         Configuration::load_path(path_config);
+        preload_map_assets();
+        CarCatalog::instance();  // Una sola vez: unirse a una partida no relee config.yaml
         Server server((Configuration::get<std::string>("port")).c_str());
         server.start();
 
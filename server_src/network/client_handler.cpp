@@ -3,16 +3,30 @@
 #include <utility>
 #include <sys/socket.h>
 
+#include "common_src/config.h"
 
-ClientHandler::ClientHandler(Socket skt, int id, MatchesMonitor& monitor)
-    : skt(std::move(skt)), client_id(id), protocol(this->skt), monitor(monitor), is_alive(true),
-      messages_queue(), receiver(protocol, this->client_id, messages_queue, is_alive, monitor) {}
+// config.yaml: udp_transport (opcional, por defecto todo va por TCP)
+static bool udp_transport_enabled() {
+    try {
+        return Configuration::get<bool>("udp_transport");
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+ClientHandler::ClientHandler(Socket skt, int id, MatchesMonitor& monitor, Reactor& reactor)
+    : skt(std::move(skt)), client_id(id), protocol(this->skt, udp_transport_enabled()),
+      monitor(monitor), reactor(reactor), is_alive(true),
+      messages_queue(), outbox(),
+      receiver(protocol, this->client_id, messages_queue, is_alive, monitor,
+               [this](const std::vector<uint8_t>& msg) { post(msg); }) {}
 
       void ClientHandler::send_shutdown_message(const std::vector<uint8_t>& msg) {
         try {
 
-            // Enviar mensaje directamente por el socket
-            skt.sendall(msg.data(), msg.size());
+            // Pasa por el protocolo: puede haber un snapshot a medias en el socket. No
+            // bloquea y no se encola en `outbox`: stop_connection cierra el socket enseguida
+            protocol.send_buffer(msg);
             
         } catch (const std::exception& e) {
             std::cerr << "[ClientHandler " << client_id 
@@ -20,8 +34,95 @@ ClientHandler::ClientHandler(Socket skt, int id, MatchesMonitor& monitor)
         }
     }
 
-void ClientHandler::run_threads() {
-    receiver.start();
+void ClientHandler::post(const std::vector<uint8_t>& msg) {
+    try {
+        outbox.push(msg);
+    } catch (const ClosedQueue&) {
+        return;  // la sesión está terminando
+    }
+    reactor.notify(*this);
+}
+
+void ClientHandler::start() {
+    protocol.send_client_id(client_id);
+
+    // Los workers del reactor nunca esperan al socket: un mensaje a medias queda en el buffer
+    // y lo que no sale queda pendiente en el protocolo hasta que el socket acepte más
+    protocol.set_nonblocking();
+
+    // Cada snapshot nuevo de la partida despierta a esta conexión en el reactor
+    messages_queue.set_listener([this] { reactor.notify(*this); });
+
+    reactor.add(*this, skt);
+    if (DatagramSocket* datagrams = protocol.get_datagram_socket())
+        reactor.add(*this, *datagrams);
+}
+
+bool ClientHandler::on_ready(uint32_t events) {
+    try {
+        if (events & REACTOR_WAKE) flush_outbox();
+        if ((events & (REACTOR_WAKE | REACTOR_WRITE)) && !flush_snapshots())
+            return end_session();
+
+        if ((events & REACTOR_DATAGRAM) && !receiver.poll_datagrams()) {
+            is_alive = false;
+            return false;
+        }
+
+        if (events & REACTOR_READ) {
+            // Todo lo que llegó, sin esperar; el receiver procesa solo los mensajes enteros
+            const bool open = protocol.receive_available();
+            if (!receiver.step()) {
+                is_alive = false;
+                return false;
+            }
+            if (!open) {
+                receiver.connection_closed();
+                is_alive = false;
+                return false;
+            }
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "[ClientHandler " << client_id << "] " << e.what() << std::endl;
+        return end_session();
+    }
+}
+
+bool ClientHandler::wants_write() {
+    return protocol.has_pending();
+}
+
+bool ClientHandler::flush_snapshots() {
+    if (!protocol.flush_pending()) return false;
+
+    // Mientras el socket no acepte más, lo nuevo espera (el mailbox se queda con lo último)
+    if (protocol.has_pending()) return true;
+
+    SnapshotHandle latest;
+    try {
+        SnapshotHandle next;
+        while (messages_queue.try_pop(next)) latest = std::move(next);
+    } catch (const ClosedQueue&) {
+        return true;  // la sesión está terminando
+    }
+    return !latest || protocol.offer_snapshot(*latest);
+}
+
+void ClientHandler::flush_outbox() {
+    std::vector<uint8_t> msg;
+    try {
+        while (outbox.try_pop(msg)) protocol.send_buffer(msg);
+    } catch (const ClosedQueue&) {
+        // la sesión está terminando
+    }
+}
+
+bool ClientHandler::end_session() {
+    is_alive = false;
+    receiver.kill();
+    receiver.finish();
+    return false;
 }
 
 void ClientHandler::stop_connection() {
@@ -31,6 +132,9 @@ void ClientHandler::stop_connection() {
     try {
         messages_queue.close();
     } catch (...) {}
+    try {
+        outbox.close();
+    } catch (...) {}
 
     // Matar receiver primero
     receiver.kill();
@@ -51,11 +155,15 @@ bool ClientHandler::is_running() {
 ClientHandler::~ClientHandler() {
     stop_connection();
 
-    try {
-        receiver.join();
-    } catch (const std::exception& e) {
-        std::cerr << "[ClientHandler " << client_id << "] Error joining receiver: "
-                  << e.what() << std::endl;
+    // Después de esto ningún worker del reactor vuelve a tocar esta conexión
+    reactor.remove(*this);
+    receiver.finish();
+
+    const LinkStats link = protocol.link_stats();
+    if (link.samples > 0) {
+        std::cout << "[ClientHandler " << client_id << "] Enlace: RTT " << link.rtt_ms
+                  << " ms, jitter " << link.jitter_ms << " ms (" << link.samples << " pings)"
+                  << std::endl;
     }
 
     try {
@@ -64,4 +172,4 @@ ClientHandler::~ClientHandler() {
         // Ignorar si ya estaba cerrado
     }
 
-}
\ No newline at end of file
+}
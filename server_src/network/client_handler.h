@@ -3,39 +3,69 @@
 #define SERVER_CLIENT_HANDLER_H
 
 #include "../../common_src/dtos.h"
-#include "../../common_src/queue.h"
+#include "../../common_src/mailbox.h"
 #include "../../common_src/socket.h"
 #include "common_src/game_state.h"
 #include "matches_monitor.h"
+#include "reactor.h"
 #include "receiver.h"
-#include "sender.h"
 #include "server_src/server_protocol.h"
 
-class ClientHandler {
+/*
+ * Conexión de un cliente, atendida por el Reactor del Acceptor.
+ *
+ * Lo que llega por TCP lo procesa el Receiver mensaje a mensaje; los
+ * snapshots que la partida deja en el mailbox y los mensajes que otros
+ * hilos dejan en `outbox` se envían sin bloquear cuando despiertan al
+ * reactor (y lo que no entró, cuando el socket vuelve a aceptar datos).
+ * */
+class ClientHandler : public ReactorHandler {
 private:
     Socket skt;
     int client_id;
     ServerProtocol protocol;
     MatchesMonitor& monitor;
+    Reactor& reactor;
 
     std::atomic<bool> is_alive;
-    Queue<GameState> messages_queue;
+    Mailbox<SnapshotHandle> messages_queue;
+    Queue<std::vector<uint8_t>> outbox;  // mensajes de otros hilos (broadcasts del lobby)
 
     Receiver receiver;
 
+    // Envía el snapshot más nuevo del mailbox; false si la conexión se cerró
+    bool flush_snapshots();
+
+    // Pasa al protocolo lo que dejaron en `outbox` (sin bloquear)
+    void flush_outbox();
+
+    // Termina la sesión desde el reactor (retorna false para on_ready)
+    bool end_session();
+
 public:
-    explicit ClientHandler(Socket skt, int id, MatchesMonitor& monitor);
+    explicit ClientHandler(Socket skt, int id, MatchesMonitor& monitor, Reactor& reactor);
+
+    // Envía el id al cliente y registra la conexión en el reactor
+    void start();
+
+    bool on_ready(uint32_t events) override;
+    bool wants_write() override;
 
-    void run_threads();
     bool is_running();
     void stop_connection();
     void force_disconnect(); //   NUEVO
     void send_shutdown_message(const std::vector<uint8_t>& msg); //   NUEVO
 
-    Queue<GameState>& get_message_queue() { return messages_queue; }
+    // Encola `msg` y despierta a la conexión: lo envía su worker (thread-safe, no bloquea)
+    void post(const std::vector<uint8_t>& msg);
+
+    Mailbox<SnapshotHandle>& get_message_queue() { return messages_queue; }
     int get_id() const { return client_id; }
 
-    ~ClientHandler();
+    // RTT y jitter del cliente según sus pings (métricas del servidor)
+    LinkStats link_stats() { return protocol.link_stats(); }
+
+    ~ClientHandler() override;
 };
 
 #endif
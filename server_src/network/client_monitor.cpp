@@ -5,19 +5,19 @@
 
 ClientMonitor::ClientMonitor() {}
 
-void ClientMonitor::add_client_queue(Queue<GameState>& queue, int player_id) {
+void ClientMonitor::add_client_queue(Mailbox<SnapshotHandle>& queue, int player_id) {
     std::lock_guard<std::mutex> lock(mtx);
     queues_list.push_back(std::make_pair(std::ref(queue), player_id));
 }
 
-void ClientMonitor::broadcast(const GameState& state) {
+void ClientMonitor::broadcast(const SnapshotHandle& state) {
     std::lock_guard<std::mutex> lock(mtx);
     if (queues_list.empty()) {
         return;
     }
 
     for (auto& pair : queues_list) {
-        Queue<GameState>& queue = pair.first;
+        Mailbox<SnapshotHandle>& queue = pair.first;
         try {
             queue.try_push(state);
         } catch (const ClosedQueue&) {
@@ -4,21 +4,22 @@
 #include <mutex>
 #include <utility>
 
-#include "common_src/game_state.h"
-#include "common_src/queue.h"
+#include "common_src/mailbox.h"
+#include "common_src/snapshot_codec.h"
 
 class ClientMonitor {
-    std::list<std::pair<Queue<GameState>&, int>> queues_list;  // recurso compartido
+    std::list<std::pair<Mailbox<SnapshotHandle>&, int>> queues_list;  // recurso compartido
     std::mutex mtx;
 
 public:
     ClientMonitor();
 
     // Add new client
-    void add_client_queue(Queue<GameState>& queue, int player_id);
+    void add_client_queue(Mailbox<SnapshotHandle>& queue, int player_id);
 
-    // recieve a particular status of the game and it is added to every client queue
-    void broadcast(const GameState& state);
+    // recieve a particular status of the game (encoded once) and its handle is added to every
+    // client queue
+    void broadcast(const SnapshotHandle& state);
 
     void delete_client_queue(int player_id);
 };
@@ -9,7 +9,7 @@
 // ============================================
 
 int MatchesMonitor::create_match(int max_players, const std::string& host_name, int player_id,
-                                 Queue<GameState>& sender_message_queue) {
+                                 Mailbox<SnapshotHandle>& sender_message_queue) {
     std::lock_guard<std::mutex> lock(mtx);
 
   
@@ -47,7 +47,7 @@ int MatchesMonitor::create_match(int max_players, const std::string& host_name,
 }
 
 bool MatchesMonitor::join_match(int match_id, const std::string& player_name, int player_id,
-                                Queue<GameState>& sender_message_queue) {
+                                Mailbox<SnapshotHandle>& sender_message_queue) {
     std::lock_guard<std::mutex> lock(mtx);
 
     if (player_to_match.find(player_name) != player_to_match.end()) {
@@ -88,7 +88,7 @@ bool MatchesMonitor::leave_match(const std::string& player_name) {
     }
 
     int match_id = it->second;
-    unregister_player_socket(match_id, player_name);
+    unregister_player_outbox(match_id, player_name);
 
     // Eliminar del lookup
     player_to_match.erase(it);
@@ -110,7 +110,7 @@ bool MatchesMonitor::leave_match(const std::string& player_name) {
     match_it->second->remove_player(player_id);
    
     if (match_it->second->is_empty()) {
-        player_sockets.erase(match_id);
+        player_outboxes.erase(match_id);
         matches.erase(match_it);
     }
 
@@ -267,24 +267,24 @@ std::map<int, PlayerLobbyInfo> MatchesMonitor::get_match_players_snapshot(int ma
 }
 
 // ============================================
-// SOCKETS Y BROADCAST
+// BANDEJAS DE SALIDA Y BROADCAST
 // ============================================
 
-void MatchesMonitor::register_player_socket(int match_id, const std::string& player_name,
-                                            Socket& socket) {
+void MatchesMonitor::register_player_outbox(int match_id, const std::string& player_name,
+                                            LobbyOutbox outbox) {
     std::lock_guard<std::mutex> lock(mtx);
-    player_sockets[match_id][player_name] = &socket;
+    player_outboxes[match_id][player_name] = std::move(outbox);
 
 }
 
-void MatchesMonitor::unregister_player_socket(int match_id, const std::string& player_name) {
+void MatchesMonitor::unregister_player_outbox(int match_id, const std::string& player_name) {
 
-    auto it = player_sockets.find(match_id);
-    if (it != player_sockets.end()) {
+    auto it = player_outboxes.find(match_id);
+    if (it != player_outboxes.end()) {
         it->second.erase(player_name);
 
         if (it->second.empty()) {
-            player_sockets.erase(it);
+            player_outboxes.erase(it);
         }
     }
 }
@@ -293,24 +293,25 @@ void MatchesMonitor::broadcast_to_match(int match_id, const std::vector<uint8_t>
                                         const std::string& exclude_player) {
     std::lock_guard<std::mutex> lock(mtx);
 
-    auto it = player_sockets.find(match_id);
-    if (it == player_sockets.end()) {
+    auto it = player_outboxes.find(match_id);
+    if (it == player_outboxes.end()) {
         return;
     }
 
     int sent_count = 0;
-    for (const auto& [player_name, socket] : it->second) {
+    for (const auto& [player_name, outbox] : it->second) {
         if (player_name == exclude_player) {
             continue;
         }
 
         try {
-            if (!socket) {
-                std::cerr << "[MatchesMonitor]   Null socket for " << player_name << std::endl;
+            if (!outbox) {
+                std::cerr << "[MatchesMonitor]   Null outbox for " << player_name << std::endl;
                 continue;
             }
 
-            socket->sendall(buffer.data(), buffer.size());
+            // Lo envía el worker de esa conexión; acá solo se encola
+            outbox(buffer);
             sent_count++;
 
         } catch (const std::exception& e) {
@@ -338,6 +339,12 @@ bool MatchesMonitor::start_match(int match_id) {
     return true;
 }
 
+bool MatchesMonitor::is_match_started(int match_id) const {
+    std::lock_guard<std::mutex> lock(const_cast<std::mutex&>(mtx));
+    auto it = matches.find(match_id);
+    return (it != matches.end()) && it->second->is_started();
+}
+
 Queue<ComandMatchDTO>* MatchesMonitor::get_command_queue(int match_id) {
     std::lock_guard<std::mutex> lock(mtx);
 
@@ -356,7 +363,7 @@ Queue<ComandMatchDTO>* MatchesMonitor::get_command_queue(int match_id) {
 void MatchesMonitor::clear_all_matches() {
     std::lock_guard<std::mutex> lock(mtx);
     matches.clear();
-    player_sockets.clear();
+    player_outboxes.clear();
     player_to_match.clear();
     id_matches = 0;
 }
@@ -1,6 +1,7 @@
 #ifndef MATCHES_MONITOR_H
 #define MATCHES_MONITOR_H
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -9,10 +10,18 @@
 
 #include "common_src/game_state.h"
 #include "common_src/lobby_protocol.h"
+#include "common_src/mailbox.h"
 #include "common_src/queue.h"
 #include "common_src/socket.h"
 #include "server_src/game/match.h"
 
+/*
+ * Bandeja de salida de una conexión del lobby: encola el mensaje y despierta
+ * a su handler en el reactor, que lo envía desde su propio worker. Así un
+ * broadcast no escribe en el socket de otro cliente ni espera a que lea.
+ * */
+using LobbyOutbox = std::function<void(const std::vector<uint8_t>&)>;
+
 class MatchesMonitor {
 private:
     int id_matches = 0;
@@ -20,7 +29,7 @@ private:
     std::map<int, std::unique_ptr<Match>> matches;
 
     
-    std::map<int, std::map<std::string, Socket*>> player_sockets;
+    std::map<int, std::map<std::string, LobbyOutbox>> player_outboxes;
 
     
     std::map<std::string, int> player_to_match;
@@ -39,9 +48,9 @@ public:
 
     // ---- LOBBY: Gestión de partidas ----
     int create_match(int max_players, const std::string& host_name, int player_id,
-                     Queue<GameState>& sender_message_queue);
+                     Mailbox<SnapshotHandle>& sender_message_queue);
     bool join_match(int match_id, const std::string& player_name, int player_id,
-                    Queue<GameState>& sender_message_queue);
+                    Mailbox<SnapshotHandle>& sender_message_queue);
     bool leave_match(const std::string& player_name);
     bool leave_match_by_id(int player_id, int match_id);
 
@@ -62,14 +71,15 @@ public:
     // ---- LOBBY: Snapshot ----
     std::map<int, PlayerLobbyInfo> get_match_players_snapshot(int match_id) const;
 
-    // ---- LOBBY: Sockets y Broadcast ----
-    void register_player_socket(int match_id, const std::string& player_name, Socket& socket);
-    void unregister_player_socket(int match_id, const std::string& player_name);
+    // ---- LOBBY: Bandejas de salida y Broadcast ----
+    void register_player_outbox(int match_id, const std::string& player_name, LobbyOutbox outbox);
+    void unregister_player_outbox(int match_id, const std::string& player_name);
     void broadcast_to_match(int match_id, const std::vector<uint8_t>& buffer,
                             const std::string& exclude_player = "");
 
     // ---- GAME: Inicio de partida ----
     bool start_match(int match_id);
+    bool is_match_started(int match_id) const;
     Queue<ComandMatchDTO>* get_command_queue(int match_id);
 
     // ---- ADMIN ----
@@ -0,0 +1,209 @@
+#include "reactor.h"
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <climits>
+#include <iostream>
+#include <utility>
+
+#include "../../common_src/liberror.h"
+
+#define REACTOR_MAX_EVENTS 64
+
+Reactor::Reactor(int worker_count) : epoll_fd(-1), wake_fd(-1), ready(UINT_MAX - 1) {
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd == -1)
+        throw LibError(errno, "epoll_create1 failed");
+
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd == -1) {
+        ::close(epoll_fd);
+        throw LibError(errno, "eventfd failed");
+    }
+
+    // El eventfd se distingue por no tener Watch asociado
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event) == -1) {
+        ::close(wake_fd);
+        ::close(epoll_fd);
+        throw LibError(errno, "epoll_ctl ADD eventfd failed");
+    }
+
+    if (worker_count < 1) worker_count = 1;
+    for (int i = 0; i < worker_count; ++i) workers.emplace_back(&Reactor::work, this);
+}
+
+void Reactor::add(ReactorHandler& handler, Socket& socket) {
+    watch(handler, socket.skt, REACTOR_READ);
+}
+
+void Reactor::add(ReactorHandler& handler, DatagramSocket& socket) {
+    watch(handler, socket.skt, REACTOR_DATAGRAM);
+}
+
+void Reactor::watch(ReactorHandler& handler, int fd, uint32_t read_event) {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::unique_ptr<Registration>& registration = registrations[&handler];
+    if (!registration) {
+        registration = std::make_unique<Registration>();
+        registration->handler = &handler;
+    }
+
+    auto watch = std::make_unique<Watch>(Watch{registration.get(), fd, read_event});
+    struct epoll_event event = {};
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    event.data.ptr = watch.get();
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1)
+        throw LibError(errno, "epoll_ctl ADD failed");
+    registration->watches.push_back(std::move(watch));
+}
+
+void Reactor::arm(const Watch& watch, bool want_write) {
+    struct epoll_event event = {};
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    if (want_write && watch.read_event == REACTOR_READ) event.events |= EPOLLOUT;
+    event.data.ptr = const_cast<Watch*>(&watch);
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, watch.fd, &event) == -1)
+        throw LibError(errno, "epoll_ctl MOD failed");
+}
+
+void Reactor::disarm(Registration& registration) {
+    if (registration.removed) return;
+    registration.removed = true;
+    // Puede fallar si el fd ya se cerró: igual deja de estar en el epoll
+    for (const auto& watch : registration.watches)
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, watch->fd, nullptr);
+}
+
+void Reactor::schedule(Registration& registration, uint32_t events) {
+    registration.pending |= events;
+    if (registration.busy || registration.removed) return;
+    try {
+        ready.push(&registration);
+        registration.busy = true;
+    } catch (const ClosedQueue&) {
+        // El reactor se está cerrando: ya no hay workers que lo atiendan
+    }
+}
+
+void Reactor::notify(ReactorHandler& handler) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = registrations.find(&handler);
+    if (it != registrations.end()) schedule(*it->second, REACTOR_WAKE);
+}
+
+void Reactor::remove(ReactorHandler& handler) {
+    std::unique_lock<std::mutex> lock(mtx);
+    auto it = registrations.find(&handler);
+    if (it == registrations.end()) return;
+
+    Registration* registration = it->second.get();
+    disarm(*registration);
+    idle.wait(lock, [registration] { return !registration->busy; });
+
+    // Un lote de epoll_wait ya devuelto puede apuntar todavía a sus Watch
+    it = registrations.find(&handler);
+    retired.push_back(std::move(it->second));
+    registrations.erase(it);
+}
+
+void Reactor::work() {
+    while (true) {
+        Registration* registration = nullptr;
+        try {
+            registration = ready.pop();
+        } catch (const ClosedQueue&) {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true) {
+            const uint32_t events = registration->pending;
+            registration->pending = 0;
+            lock.unlock();
+
+            bool keep = false;
+            try {
+                keep = registration->handler->on_ready(events);
+            } catch (const std::exception& e) {
+                std::cerr << "[Reactor] Handler error: " << e.what() << std::endl;
+            }
+
+            lock.lock();
+            if (!keep) {
+                disarm(*registration);
+                break;
+            }
+            // Lo que llegó mientras corría se atiende ya, sin volver a pasar por epoll
+            if (registration->pending && !registration->removed) continue;
+            if (registration->removed) break;
+
+            try {
+                const bool want_write = registration->handler->wants_write();
+                for (const auto& watch : registration->watches) arm(*watch, want_write);
+            } catch (const std::exception& e) {
+                std::cerr << "[Reactor] " << e.what() << std::endl;
+                disarm(*registration);
+            }
+            break;
+        }
+        registration->busy = false;
+        idle.notify_all();
+    }
+}
+
+void Reactor::run() {
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+
+    while (should_keep_running()) {
+        const int count = epoll_wait(epoll_fd, events, REACTOR_MAX_EVENTS, -1);
+        if (count == -1) {
+            if (errno == EINTR) continue;
+            throw LibError(errno, "epoll_wait failed");
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        for (int i = 0; i < count; ++i) {
+            const Watch* watch = static_cast<const Watch*>(events[i].data.ptr);
+            if (!watch) {
+                uint64_t value;
+                if (read(wake_fd, &value, sizeof(value)) == -1 && errno != EAGAIN)
+                    throw LibError(errno, "eventfd read failed");
+                continue;
+            }
+
+            Registration& registration = *watch->registration;
+            if (registration.removed) continue;
+
+            uint32_t ready_events = 0;
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+                ready_events |= watch->read_event;
+            if (events[i].events & EPOLLOUT) ready_events |= REACTOR_WRITE;
+            schedule(registration, ready_events);
+        }
+        retired.clear();
+    }
+}
+
+void Reactor::stop() {
+    Thread::stop();
+    const uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) == -1)
+        std::cerr << "[Reactor] Could not wake the event loop" << std::endl;
+}
+
+Reactor::~Reactor() {
+    stop();
+    join();
+
+    ready.close();
+    for (std::thread& worker : workers) worker.join();
+
+    ::close(wake_fd);
+    ::close(epoll_fd);
+}
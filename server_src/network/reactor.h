@@ -0,0 +1,124 @@
+#ifndef SERVER_REACTOR_H
+#define SERVER_REACTOR_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../../common_src/datagram_socket.h"
+#include "../../common_src/queue.h"
+#include "../../common_src/socket.h"
+#include "../../common_src/thread.h"
+
+// Eventos que recibe un ReactorHandler (máscara)
+enum ReactorEvent : uint32_t {
+    REACTOR_READ = 0x01,      // el socket TCP tiene datos (o se cerró)
+    REACTOR_WRITE = 0x02,     // el socket TCP volvió a aceptar datos (ver wants_write)
+    REACTOR_DATAGRAM = 0x04,  // llegó algo al socket UDP de la conexión
+    REACTOR_WAKE = 0x08       // Reactor::notify (p. ej. hay un snapshot nuevo para enviar)
+};
+
+/*
+ * Una conexión atendida por el Reactor.
+ *
+ * `on_ready` corre en un worker del reactor y nunca en dos a la vez para el
+ * mismo handler, así que no necesita sincronizar su propio estado. No debe
+ * quedarse esperando a que el cliente mande algo: solo se lo llama cuando
+ * hay algo para hacer.
+ * */
+class ReactorHandler {
+public:
+    // Atiende `events`; false para que el reactor deje de vigilar la conexión
+    virtual bool on_ready(uint32_t events) = 0;
+
+    // Consultado al volver a armar la conexión: true si quedó algo por enviar
+    virtual bool wants_write() { return false; }
+
+    virtual ~ReactorHandler() = default;
+};
+
+/*
+ * Reactor de E/S sobre epoll.
+ *
+ * Un hilo espera eventos de todas las conexiones y los reparte en un pool
+ * chico de workers, en vez de tener un Receiver y un Sender bloqueados por
+ * cliente: una conexión ociosa (p. ej. en el lobby) no ocupa ningún hilo,
+ * solo su file descriptor en el epoll.
+ *
+ * Cada file descriptor se arma con EPOLLONESHOT: después de un evento queda
+ * desarmado hasta que el worker termina con el handler, y lo que llegue
+ * mientras tanto (otro evento, un notify) se acumula y se atiende en la
+ * misma pasada. Así un handler nunca corre en paralelo consigo mismo.
+ * */
+class Reactor : public Thread {
+private:
+    struct Registration;
+
+    // Un file descriptor vigilado (el TCP o el UDP de una conexión)
+    struct Watch {
+        Registration* registration;
+        int fd;
+        uint32_t read_event;  // REACTOR_READ o REACTOR_DATAGRAM
+    };
+
+    struct Registration {
+        ReactorHandler* handler;
+        std::vector<std::unique_ptr<Watch>> watches;
+        uint32_t pending = 0;  // eventos acumulados para la próxima pasada
+        bool busy = false;     // encolado o corriendo en un worker
+        bool removed = false;
+    };
+
+    int epoll_fd;
+    int wake_fd;  // eventfd para sacar al hilo del epoll_wait al cerrar
+
+    std::mutex mtx;
+    std::condition_variable idle;
+    std::unordered_map<ReactorHandler*, std::unique_ptr<Registration>> registrations;
+    // Bajas que todavía pueden aparecer en el lote de epoll_wait en curso
+    std::vector<std::unique_ptr<Registration>> retired;
+
+    Queue<Registration*> ready;
+    std::vector<std::thread> workers;
+
+    void watch(ReactorHandler& handler, int fd, uint32_t read_event);
+    void arm(const Watch& watch, bool want_write);
+    void disarm(Registration& registration);
+
+    // Acumula `events` y, si el handler está libre, lo pasa a un worker (bajo mtx)
+    void schedule(Registration& registration, uint32_t events);
+    void work();
+
+public:
+    explicit Reactor(int worker_count);
+
+    // Vigila la conexión TCP de `handler` (varias veces: cada llamada suma un fd)
+    void add(ReactorHandler& handler, Socket& socket);
+
+    // Vigila también el canal UDP de la conexión (eventos REACTOR_DATAGRAM)
+    void add(ReactorHandler& handler, DatagramSocket& socket);
+
+    /*
+     * Deja de vigilar a `handler` y espera a que ningún worker lo esté
+     * usando: al volver se lo puede destruir. No se puede llamar desde el
+     * propio `on_ready`.
+     * */
+    void remove(ReactorHandler& handler);
+
+    // Agenda un REACTOR_WAKE para `handler` (thread-safe, no bloquea)
+    void notify(ReactorHandler& handler);
+
+    void run() override;
+    void stop() override;
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    ~Reactor() override;
+};
+
+#endif  // SERVER_REACTOR_H
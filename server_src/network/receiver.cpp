@@ -12,11 +12,12 @@
 
 #define RUTA_MAPS "server_src/city_maps/"
 
-Receiver::Receiver(ServerProtocol& protocol, int id, Queue<GameState>& sender_messages_queue,
-                   std::atomic<bool>& is_running, MatchesMonitor& monitor)
+Receiver::Receiver(ServerProtocol& protocol, int id, Mailbox<SnapshotHandle>& sender_messages_queue,
+                   std::atomic<bool>& is_running, MatchesMonitor& monitor, LobbyOutbox outbox)
     : protocol(protocol), id(id), match_id(-1), sender_messages_queue(sender_messages_queue),
-      is_running(is_running), monitor(monitor), commands_queue(),
-      sender(protocol, sender_messages_queue, is_running, id) {}
+      is_running(is_running), monitor(monitor), outbox(std::move(outbox)), commands_queue(),
+      phase(Phase::HANDSHAKE),
+      current_match_id(-1), finished(false) {}
 
 std::vector<std::pair<std::string, std::vector<std::pair<std::string, std::string>>>>
 Receiver::get_city_maps() {
@@ -49,12 +50,69 @@ Receiver::get_city_maps() {
     return ciudades_y_carreras;
 }
 
-void Receiver::handle_lobby() {
-    int current_match_id = -1;
+bool Receiver::step() {
+    // Con el servidor cerrando, la sesión termina sin leer nada más
+    if (!is_running) phase = Phase::DONE;
+
+    // Solo mensajes enteros: sus lecturas salen del buffer y no bloquean al worker
+    while (phase != Phase::DONE && message_ready()) {
+        switch (phase) {
+        case Phase::HANDSHAKE:
+            handle_handshake();
+            break;
+        case Phase::LOBBY:
+            handle_lobby_message();
+            break;
+        case Phase::MATCH:
+            handle_match_message();
+            break;
+        case Phase::DONE:
+            break;
+        }
+    }
+
+    if (phase != Phase::DONE) return true;
+    finish();
+    return false;
+}
+
+bool Receiver::message_ready() {
+    // Solo el host pasa por MSG_START_GAME: el resto de la sala entra a la partida acá,
+    // antes de leer su primer comando (que no tiene formato de mensaje de lobby)
+    if (phase == Phase::LOBBY && current_match_id != -1 &&
+        monitor.is_match_started(current_match_id)) {
+        enter_match();
+    }
+    if (phase != Phase::MATCH) return protocol.has_lobby_message();
+
+    try {
+        if (!protocol.consume_control_messages()) {
+            end_match();
+            return false;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[Receiver " << username << "] Read error: " << e.what() << std::endl;
+        end_match();
+        return false;
+    }
+    return protocol.has_match_message();
+}
+
+void Receiver::connection_closed() {
+    if (phase == Phase::HANDSHAKE || phase == Phase::LOBBY) {
+        handle_lobby_error(std::runtime_error("Connection closed"));
+    } else {
+        end_match();
+    }
+    finish();
+}
+
+void Receiver::handle_handshake() {
     try {
         uint8_t msg_type_user = protocol.read_message_type();
         if (msg_type_user != MSG_USERNAME) {
             std::cerr << "[Receiver] Invalid protocol start (expected MSG_USERNAME)\n";
+            phase = Phase::DONE;
             return;
         }
 
@@ -63,409 +121,422 @@ void Receiver::handle_lobby() {
         auto welcome_msg = "Welcome to Need for Speed 2D, " + username + "!";
         protocol.send_buffer(LobbyProtocol::serialize_welcome(welcome_msg));
 
-        bool in_lobby = true;
+        phase = Phase::LOBBY;
+    } catch (const std::exception& e) {
+        handle_lobby_error(e);
+    }
+}
 
-        while (is_running && in_lobby) {
-            
-            if (!is_running) {
-                throw std::runtime_error("Server shutdown");
-            }
-            
-            uint8_t msg_type = protocol.read_message_type();
-            switch (msg_type) {
-            // ------------------------------------------------------------
-            case MSG_LIST_GAMES: {
-                std::cout << "[Receiver] " << username << " requested games list\n";
+void Receiver::handle_lobby_message() {
+    bool in_lobby = true;
+    try {
+        uint8_t msg_type = protocol.read_message_type();
+        switch (msg_type) {
+        // ------------------------------------------------------------
+        case MSG_LIST_GAMES: {
+            std::cout << "[Receiver] " << username << " requested games list\n";
 
-                std::vector<GameInfo> games = monitor.list_available_matches();
+            std::vector<GameInfo> games = monitor.list_available_matches();
 
 
-                auto response = LobbyProtocol::serialize_games_list(games);
-                protocol.send_buffer(response);
+            auto response = LobbyProtocol::serialize_games_list(games);
+            protocol.send_buffer(response);
+            break;
+        }
+        // ------------------------------------------------------------
+        case MSG_CREATE_GAME: {
+            std::string game_name = protocol.read_string();
+            uint8_t max_players = protocol.get_uint8_t();
+            uint8_t num_races = protocol.get_uint8_t();
+
+            if (current_match_id != -1) {
+                protocol.send_buffer(LobbyProtocol::serialize_error(
+                    ERR_ALREADY_IN_GAME, "You are already in a game"));
                 break;
             }
-            // ------------------------------------------------------------
-            case MSG_CREATE_GAME: {
-                std::string game_name = protocol.read_string();
-                uint8_t max_players = protocol.get_uint8_t();
-                uint8_t num_races = protocol.get_uint8_t();
-
-                if (current_match_id != -1) {
-                    protocol.send_buffer(LobbyProtocol::serialize_error(
-                        ERR_ALREADY_IN_GAME, "You are already in a game"));
-                    break;
-                }
 
-                if (monitor.is_player_in_match(username)) {
-                    protocol.send_buffer(LobbyProtocol::serialize_error(
-                        ERR_ALREADY_IN_GAME, "You are already in a game (monitor check)"));
-                    break;
-                }
+            if (monitor.is_player_in_match(username)) {
+                protocol.send_buffer(LobbyProtocol::serialize_error(
+                    ERR_ALREADY_IN_GAME, "You are already in a game (monitor check)"));
+                break;
+            }
 
-                // Crear la partida (el host se agrega automáticamente)
-                int new_match_id =
-                    monitor.create_match(max_players, username, id, sender_messages_queue);
-                if (new_match_id < 0) {  
-                    protocol.send_buffer(
-                        LobbyProtocol::serialize_error(ERR_ALREADY_IN_GAME, "Error creating match"));
-                    break;
-                }
+            // Crear la partida (el host se agrega automáticamente)
+            int new_match_id =
+                monitor.create_match(max_players, username, id, sender_messages_queue);
+            if (new_match_id < 0) {  
+                protocol.send_buffer(
+                    LobbyProtocol::serialize_error(ERR_ALREADY_IN_GAME, "Error creating match"));
+                break;
+            }
 
-                current_match_id = new_match_id;
-                this->match_id = new_match_id;
+            current_match_id = new_match_id;
+            this->match_id = new_match_id;
 
-                // Registrar socket
-                monitor.register_player_socket(match_id, username, protocol.get_socket());
+            // Registrar bandeja de salida
+            monitor.register_player_outbox(match_id, username, outbox);
 
-                // Recibir selección de carreras
-                std::vector<ServerRaceConfig> races;
-                for (int i = 0; i < num_races; ++i) {
-                    std::string city = protocol.read_string();
-                    std::string map = protocol.read_string();
-                    races.push_back({city, map});
+            // Recibir selección de carreras
+            std::vector<ServerRaceConfig> races;
+            for (int i = 0; i < num_races; ++i) {
+                std::string city = protocol.read_string();
+                std::string map = protocol.read_string();
+                races.push_back({city, map});
 
-                }
+            }
 
-                
-                monitor.add_races_to_match(match_id, races);
+            
+            monitor.add_races_to_match(match_id, races);
 
-                protocol.send_buffer(LobbyProtocol::serialize_game_created(match_id));
+            protocol.send_buffer(LobbyProtocol::serialize_game_created(match_id));
 
-                // ENVIAR YAML AL CLIENTE
-                std::vector<std::string> yaml_paths = monitor.get_race_paths(match_id);
-                if (!yaml_paths.empty()) {
-                    protocol.send_race_paths(yaml_paths);
+            // ENVIAR YAML AL CLIENTE
+            std::vector<std::string> yaml_paths = monitor.get_race_paths(match_id);
+            if (!yaml_paths.empty()) {
+                protocol.send_race_paths(yaml_paths);
 
-                }
+            }
+
+            break;
+        }
+        // ------------------------------------------------------------
+        case MSG_JOIN_GAME: {
+            int game_id = static_cast<int>(protocol.read_uint16());
 
+            if (current_match_id != -1) {
+
+                protocol.send_buffer(LobbyProtocol::serialize_error(
+                    ERR_ALREADY_IN_GAME, "You are already in a game"));
                 break;
             }
-            // ------------------------------------------------------------
-            case MSG_JOIN_GAME: {
-                int game_id = static_cast<int>(protocol.read_uint16());
 
-                if (current_match_id != -1) {
+            // 1. CAPTURAR SNAPSHOT **ANTES** DE AGREGAR AL JUGADOR
+            auto existing_players = monitor.get_match_players_snapshot(game_id);
 
-                    protocol.send_buffer(LobbyProtocol::serialize_error(
-                        ERR_ALREADY_IN_GAME, "You are already in a game"));
-                    break;
-                }
+            // 2. REGISTRAR BANDEJA **ANTES** DE JOIN
+            monitor.register_player_outbox(game_id, username, outbox);
 
-                // 1. CAPTURAR SNAPSHOT **ANTES** DE AGREGAR AL JUGADOR
-                auto existing_players = monitor.get_match_players_snapshot(game_id);
+            // 3. HACER JOIN
+            bool success = monitor.join_match(game_id, username, id, sender_messages_queue);
 
-                // 2. REGISTRAR SOCKET **ANTES** DE JOIN
-                monitor.register_player_socket(game_id, username, protocol.get_socket());
+            if (!success) {
+                monitor.unregister_player_outbox(game_id, username);
+                protocol.send_buffer(
+                    LobbyProtocol::serialize_error(ERR_GAME_FULL, "Game is full or started"));
+                break;
+            }
 
-                // 3. HACER JOIN
-                bool success = monitor.join_match(game_id, username, id, sender_messages_queue);
+            current_match_id = game_id;
+            this->match_id = game_id;
 
-                if (!success) {
-                    monitor.unregister_player_socket(game_id, username);
-                    protocol.send_buffer(
-                        LobbyProtocol::serialize_error(ERR_GAME_FULL, "Game is full or started"));
-                    break;
-                }
+            // 4. ENVIAR CONFIRMACIÓN AL NUEVO JUGADOR
+            protocol.send_buffer(
+                LobbyProtocol::serialize_game_joined(static_cast<uint16_t>(game_id)));
 
-                current_match_id = game_id;
-                this->match_id = game_id;
+            // 5. ENVIAR SNAPSHOT DE JUGADORES EXISTENTES
 
-                // 4. ENVIAR CONFIRMACIÓN AL NUEVO JUGADOR
-                protocol.send_buffer(
-                    LobbyProtocol::serialize_game_joined(static_cast<uint16_t>(game_id)));
+            for (const auto& [player_id, player_info] : existing_players) {
+                // Notificar que este jugador existe
+                auto joined_notif =
+                    LobbyProtocol::serialize_player_joined_notification(player_info.name);
+                protocol.send_buffer(joined_notif);
 
-                // 5. ENVIAR SNAPSHOT DE JUGADORES EXISTENTES
 
-                for (const auto& [player_id, player_info] : existing_players) {
-                    // Notificar que este jugador existe
-                    auto joined_notif =
-                        LobbyProtocol::serialize_player_joined_notification(player_info.name);
-                    protocol.send_buffer(joined_notif);
+                // Si tiene auto seleccionado, notificarlo
+                if (!player_info.car_name.empty()) {
+                    auto car_notif = LobbyProtocol::serialize_car_selected_notification(
+                        player_info.name, player_info.car_name, player_info.car_type);
+                    protocol.send_buffer(car_notif);
 
+                }
 
-                    // Si tiene auto seleccionado, notificarlo
-                    if (!player_info.car_name.empty()) {
-                        auto car_notif = LobbyProtocol::serialize_car_selected_notification(
-                            player_info.name, player_info.car_name, player_info.car_type);
-                        protocol.send_buffer(car_notif);
+                // Si está ready, notificarlo
+                if (player_info.is_ready) {
+                    auto ready_notif = LobbyProtocol::serialize_player_ready_notification(
+                        player_info.name, true);
+                    protocol.send_buffer(ready_notif);
 
-                    }
+                }
+            }
 
-                    // Si está ready, notificarlo
-                    if (player_info.is_ready) {
-                        auto ready_notif = LobbyProtocol::serialize_player_ready_notification(
-                            player_info.name, true);
-                        protocol.send_buffer(ready_notif);
+            // Enviar marcador de fin de snapshot
+            std::vector<uint8_t> end_marker;
+            end_marker.push_back(MSG_ROOM_SNAPSHOT);
+            end_marker.push_back(0);
+            end_marker.push_back(0);
+            protocol.send_buffer(end_marker);
 
-                    }
-                }
 
-                // Enviar marcador de fin de snapshot
-                std::vector<uint8_t> end_marker;
-                end_marker.push_back(MSG_ROOM_SNAPSHOT);
-                end_marker.push_back(0);
-                end_marker.push_back(0);
-                protocol.send_buffer(end_marker);
 
+            // ENVIAR YAML AL CLIENTE
+            std::vector<std::string> yaml_paths = monitor.get_race_paths(game_id);
+            if (!yaml_paths.empty()) {
+                protocol.send_race_paths(yaml_paths);
 
+            }
 
-                // ENVIAR YAML AL CLIENTE
-                std::vector<std::string> yaml_paths = monitor.get_race_paths(game_id);
-                if (!yaml_paths.empty()) {
-                    protocol.send_race_paths(yaml_paths);
+            // 6. BROADCAST A LOS DEMÁS **DESPUÉS**
+            auto joined_notif = LobbyProtocol::serialize_player_joined_notification(username);
+            monitor.broadcast_to_match(game_id, joined_notif, username);
 
-                }
 
-                // 6. BROADCAST A LOS DEMÁS **DESPUÉS**
-                auto joined_notif = LobbyProtocol::serialize_player_joined_notification(username);
-                monitor.broadcast_to_match(game_id, joined_notif, username);
+
+            break;
+        }
+        // ------------------------------------------------------------
+        case MSG_SELECT_CAR: {
+            std::string car_name = protocol.read_string();
+            std::string car_type = protocol.read_string();
 
 
 
+            if (current_match_id == -1) {
+                protocol.send_buffer(LobbyProtocol::serialize_error(ERR_PLAYER_NOT_IN_GAME,
+                                                                    "You are not in any game"));
                 break;
             }
-            // ------------------------------------------------------------
-            case MSG_SELECT_CAR: {
-                std::string car_name = protocol.read_string();
-                std::string car_type = protocol.read_string();
 
+            // Guardar el auto
+            if (!monitor.set_player_car(username, car_name, car_type)) {
+                protocol.send_buffer(LobbyProtocol::serialize_error(ERR_INVALID_CAR_INDEX,
+                                                                    "Failed to select car"));
+                break;
+            }
 
+            // Enviar ACK al cliente
+            protocol.send_buffer(LobbyProtocol::serialize_car_selected_ack(car_name, car_type));
 
-                if (current_match_id == -1) {
-                    protocol.send_buffer(LobbyProtocol::serialize_error(ERR_PLAYER_NOT_IN_GAME,
-                                                                        "You are not in any game"));
-                    break;
-                }
-
-                // Guardar el auto
-                if (!monitor.set_player_car(username, car_name, car_type)) {
-                    protocol.send_buffer(LobbyProtocol::serialize_error(ERR_INVALID_CAR_INDEX,
-                                                                        "Failed to select car"));
-                    break;
-                }
+            // Broadcast a TODOS EXCEPTO al que seleccionó
+            auto notif =
+                LobbyProtocol::serialize_car_selected_notification(username, car_name, car_type);
+            monitor.broadcast_to_match(current_match_id, notif, username);
 
-                // Enviar ACK al cliente
-                protocol.send_buffer(LobbyProtocol::serialize_car_selected_ack(car_name, car_type));
 
-                // Broadcast a TODOS EXCEPTO al que seleccionó
-                auto notif =
-                    LobbyProtocol::serialize_car_selected_notification(username, car_name, car_type);
-                monitor.broadcast_to_match(current_match_id, notif, username);
+            break;
+        }
+        // ------------------------------------------------------------
+        case MSG_LEAVE_GAME: {
+            uint16_t game_id = protocol.read_uint16();
 
 
+            if (current_match_id != game_id) {
+                protocol.send_buffer(LobbyProtocol::serialize_error(ERR_PLAYER_NOT_IN_GAME,
+                                                                    "You are not in that game"));
                 break;
             }
-            // ------------------------------------------------------------
-            case MSG_LEAVE_GAME: {
-                uint16_t game_id = protocol.read_uint16();
 
+            
+            auto left_notif = LobbyProtocol::serialize_player_left_notification(username);
+            monitor.broadcast_to_match(game_id, left_notif, username);
 
-                if (current_match_id != game_id) {
-                    protocol.send_buffer(LobbyProtocol::serialize_error(ERR_PLAYER_NOT_IN_GAME,
-                                                                        "You are not in that game"));
-                    break;
-                }
+            // Eliminar del monitor
+            monitor.leave_match(username);
 
-                
-                auto left_notif = LobbyProtocol::serialize_player_left_notification(username);
-                monitor.broadcast_to_match(game_id, left_notif, username);
+            current_match_id = -1;
+            this->match_id = -1;
 
-                // Eliminar del monitor
-                monitor.leave_match(username);
 
-                current_match_id = -1;
-                this->match_id = -1;
+            // Enviar lista de partidas actualizada
+            std::vector<GameInfo> games = monitor.list_available_matches();
+            auto buffer = LobbyProtocol::serialize_games_list(games);
+            protocol.send_buffer(buffer);
 
 
-                // Enviar lista de partidas actualizada
-                std::vector<GameInfo> games = monitor.list_available_matches();
-                auto buffer = LobbyProtocol::serialize_games_list(games);
-                protocol.send_buffer(buffer);
+            break;
+        }
+        // ------------------------------------------------------------
+        case MSG_PLAYER_READY: {
+            uint8_t is_ready = protocol.get_uint8_t();
 
+            if (current_match_id == -1) {
+                protocol.send_buffer(LobbyProtocol::serialize_error(ERR_PLAYER_NOT_IN_GAME,
+                                                                    "You are not in any game"));
+                break;
+            }
 
+            if (!monitor.set_player_ready(username, is_ready != 0)) {
+                protocol.send_buffer(LobbyProtocol::serialize_error(
+                    ERR_INVALID_CAR_INDEX, "You must select a car before being ready"));
                 break;
             }
-            // ------------------------------------------------------------
-            case MSG_PLAYER_READY: {
-                uint8_t is_ready = protocol.get_uint8_t();
-
-                if (current_match_id == -1) {
-                    protocol.send_buffer(LobbyProtocol::serialize_error(ERR_PLAYER_NOT_IN_GAME,
-                                                                        "You are not in any game"));
-                    break;
-                }
 
-                if (!monitor.set_player_ready(username, is_ready != 0)) {
-                    protocol.send_buffer(LobbyProtocol::serialize_error(
-                        ERR_INVALID_CAR_INDEX, "You must select a car before being ready"));
-                    break;
-                }
+            
+            // Durante el juego, el ClientHandler maneja toda la comunicación
+            if (current_match_id != -1) {
+                auto notif =
+                    LobbyProtocol::serialize_player_ready_notification(username, is_ready != 0);
+                monitor.broadcast_to_match(current_match_id, notif, username);
+            }
 
-                
-                // Durante el juego, el Sender maneja toda la comunicación
-                if (current_match_id != -1) {
-                    auto notif =
-                        LobbyProtocol::serialize_player_ready_notification(username, is_ready != 0);
-                    monitor.broadcast_to_match(current_match_id, notif, username);
-                }
+            break;
+        }
+        // ------------------------------------------------------------
+        case MSG_START_GAME: {
+            int game_id = static_cast<int>(protocol.read_uint16());
 
+            if (current_match_id != game_id) {
+                protocol.send_buffer(LobbyProtocol::serialize_error(ERR_PLAYER_NOT_IN_GAME,
+                                                                    "You are not in this game"));
                 break;
             }
-            // ------------------------------------------------------------
-            case MSG_START_GAME: {
-                int game_id = static_cast<int>(protocol.read_uint16());
-
-                if (current_match_id != game_id) {
-                    protocol.send_buffer(LobbyProtocol::serialize_error(ERR_PLAYER_NOT_IN_GAME,
-                                                                        "You are not in this game"));
-                    break;
-                }
 
-                // Validar que se pueda iniciar
-                if (!monitor.is_match_ready(game_id)) {
-                    protocol.send_buffer(LobbyProtocol::serialize_error(
-                        ERR_PLAYERS_NOT_READY, "Not all players are ready or no races configured"));
-                    break;
-                }
+            // Validar que se pueda iniciar
+            if (!monitor.is_match_ready(game_id)) {
+                protocol.send_buffer(LobbyProtocol::serialize_error(
+                    ERR_PLAYERS_NOT_READY, "Not all players are ready or no races configured"));
+                break;
+            }
 
-                
-                monitor.start_match(game_id);
+            
+            monitor.start_match(game_id);
 
-                std::vector<uint8_t> start_msg = {
-                    static_cast<uint8_t>(LobbyMessageType::MSG_GAME_STARTED)};
+            std::vector<uint8_t> start_msg = {
+                static_cast<uint8_t>(LobbyMessageType::MSG_GAME_STARTED)};
 
-                // Enviar al jugador que solicitó el inicio
-                protocol.send_buffer(start_msg);
+            // Enviar al jugador que solicitó el inicio
+            protocol.send_buffer(start_msg);
 
-                // Broadcast a todos los demás
-                monitor.broadcast_to_match(game_id, start_msg, username);
-                
-                in_lobby = false;
+            // Broadcast a todos los demás
+            monitor.broadcast_to_match(game_id, start_msg, username);
+            
+            in_lobby = false;
 
-                break;
-            }
-            // ------------------------------------------------------------
-            default:
-                std::cerr << "[Receiver] Unknown message type: " << static_cast<int>(msg_type)
-                          << std::endl;
-                in_lobby = false;
-                break;
-            }
+            break;
+        }
+        // ------------------------------------------------------------
+        default:
+            // Los comandos de partida no pasan por acá (ver message_ready): el stream está roto
+            throw std::runtime_error("Unknown lobby message type: " +
+                                     std::to_string(static_cast<int>(msg_type)));
         }
 
-        // OBTENER QUEUE DE COMANDOS DEL MATCH
-        commands_queue = monitor.get_command_queue(match_id);
+        if (!in_lobby) enter_match();
+    } catch (const std::exception& e) {
+        handle_lobby_error(e);
+    }
+}
 
-        // INICIAR SENDER (para enviar GameState a este jugador)
-        sender.start();
+void Receiver::enter_match() {
+    // OBTENER QUEUE DE COMANDOS DEL MATCH
+    commands_queue = monitor.get_command_queue(match_id);
 
-        
-        // porque el hilo Sender (ClientMonitor) es el único que debe escribir durante la partida.
-        // Eliminamos el socket del registro de MatchesMonitor para este jugador.
-        try {
-            monitor.unregister_player_socket(match_id, username);
-        } catch (const std::exception& e) {
-            std::cerr << "[Receiver] Warning: could not unregister socket for " << username
-                      << ": " << e.what() << std::endl;
-        }
+    // Desde acá los snapshots los envía el ClientHandler cuando el mailbox le avisa:
+    // es el único que debe escribir durante la partida.
+    // Eliminamos la bandeja del registro de MatchesMonitor para este jugador.
+    try {
+        monitor.unregister_player_outbox(match_id, username);
     } catch (const std::exception& e) {
-        std::string error_msg = e.what();
+        std::cerr << "[Receiver] Warning: could not unregister outbox for " << username
+                  << ": " << e.what() << std::endl;
+    }
+
+    phase = Phase::MATCH;
+}
+
+void Receiver::handle_lobby_error(const std::exception& e) {
+    std::string error_msg = e.what();
 
+    
+    if (error_msg.find("Server shutdown") != std::string::npos) {
+        std::cout << "[Receiver " << username << "] Server is shutting down" << std::endl;
         
-        if (error_msg.find("Server shutdown") != std::string::npos) {
-            std::cout << "[Receiver " << username << "] Server is shutting down" << std::endl;
-            
+        
+        try {
+            std::vector<uint8_t> shutdown_msg;
+            shutdown_msg.push_back(MSG_ERROR);
+            shutdown_msg.push_back(0xFF); // Código especial
+            std::string msg = "SERVER SHUTDOWN - DISCONNECTING";
+            uint16_t len = htons(msg.size());
+            shutdown_msg.push_back(reinterpret_cast<uint8_t*>(&len)[0]);
+            shutdown_msg.push_back(reinterpret_cast<uint8_t*>(&len)[1]);
+            shutdown_msg.insert(shutdown_msg.end(), msg.begin(), msg.end());
             
-            try {
-                std::vector<uint8_t> shutdown_msg;
-                shutdown_msg.push_back(MSG_ERROR);
-                shutdown_msg.push_back(0xFF); // Código especial
-                std::string msg = "SERVER SHUTDOWN - DISCONNECTING";
-                uint16_t len = htons(msg.size());
-                shutdown_msg.push_back(reinterpret_cast<uint8_t*>(&len)[0]);
-                shutdown_msg.push_back(reinterpret_cast<uint8_t*>(&len)[1]);
-                shutdown_msg.insert(shutdown_msg.end(), msg.begin(), msg.end());
-                
-                protocol.send_buffer(shutdown_msg);
-            } catch (...) {
-                // Ignorar errores al enviar
-            }
+            protocol.send_buffer(shutdown_msg);
+        } catch (...) {
+            // Ignorar errores al enviar
         }
+    }
 
-        if (error_msg.find("Connection closed") != std::string::npos) {
-            std::cout << "[Receiver] Player " << username << " disconnected" << std::endl;
-        } else {
-            std::cerr << "[Receiver] Lobby error: " << error_msg << std::endl;
-        }
+    if (error_msg.find("Connection closed") != std::string::npos) {
+        std::cout << "[Receiver] Player " << username << " disconnected" << std::endl;
+    } else {
+        std::cerr << "[Receiver] Lobby error: " << error_msg << std::endl;
+    }
 
-        // Cleanup en caso de desconexión
-        if (!username.empty() && current_match_id != -1) {
+    // Cleanup en caso de desconexión
+    if (!username.empty() && current_match_id != -1) {
 
-            try {
-                monitor.leave_match(username);
-                std::cout << "[Receiver]   " << username << " cleaned up successfully" << std::endl;
-            } catch (const std::exception& cleanup_error) {
-                std::cerr << "[Receiver]   Failed to cleanup: " << cleanup_error.what()
-                          << std::endl;
-            }
+        try {
+            monitor.leave_match(username);
+            std::cout << "[Receiver]   " << username << " cleaned up successfully" << std::endl;
+        } catch (const std::exception& cleanup_error) {
+            std::cerr << "[Receiver]   Failed to cleanup: " << cleanup_error.what()
+                      << std::endl;
         }
-        is_running = false;
     }
+    is_running = false;
+    phase = Phase::DONE;
 }
 
-void Receiver::handle_match_messages() {
+void Receiver::handle_match_message() {
+    ComandMatchDTO comand_match;
+    comand_match.player_id = id;
 
     try {
-        while (is_running) {
-            if (!is_running) {
-                break;
-            }
-            
-            ComandMatchDTO comand_match;
-            comand_match.player_id = id;
-
-            try {
-                protocol.read_command_client(comand_match);
-            } catch (const std::exception& e) {
-                // Socket cerrado o error de lectura
-                std::string error_msg = e.what();
-                if (error_msg.find("shutdown") != std::string::npos ||
-                    error_msg.find("Connection closed") != std::string::npos ||
-                    !is_running) {
-                } else {
-                    std::cerr << "[Receiver " << username << "] Read error: " << error_msg << std::endl;
-                }
-                break;
-            }
-
-            
-            if (!is_running) {
-                break;
-            }
+        if (!protocol.read_command_client(comand_match)) {
+            end_match();
+            return;
+        }
+    } catch (const std::exception& e) {
+        // Socket cerrado o error de lectura
+        std::string error_msg = e.what();
+        if (error_msg.find("shutdown") != std::string::npos ||
+            error_msg.find("Connection closed") != std::string::npos ||
+            !is_running) {
+        } else {
+            std::cerr << "[Receiver " << username << "] Read error: " << error_msg << std::endl;
+        }
+        end_match();
+        return;
+    }
 
-            try {
-                commands_queue->try_push(comand_match);
+    if (!is_running || !dispatch(comand_match)) end_match();
+}
 
-                if (comand_match.command == GameCommand::DISCONNECT) {
-                    break;
-                }
-            } catch (const std::exception& e) {
-                std::cerr << "[Receiver] Error pushing command: " << e.what() << std::endl;
-                break;
-            }
-        }
-        is_running = false;
+bool Receiver::dispatch(const ComandMatchDTO& comand_match) {
+    try {
+        commands_queue->try_push(comand_match);
+        return comand_match.command != GameCommand::DISCONNECT;
     } catch (const std::exception& e) {
-        std::cerr << "[Receiver] Match error: " << e.what() << std::endl;
+        std::cerr << "[Receiver] Error pushing command: " << e.what() << std::endl;
+        return false;
     }
 }
 
-void Receiver::run() {
-    //  FASE LOBBY
-    handle_lobby();
+void Receiver::end_match() {
+    is_running = false;
+    phase = Phase::DONE;
+}
+
+bool Receiver::poll_datagrams() {
+    ComandMatchDTO comand_match;
+    comand_match.player_id = id;
+
+    // Fuera de la partida se consumen igual (HELLO), pero no hay a quién entregar comandos
+    while (protocol.poll_datagram_command(comand_match)) {
+        if (phase != Phase::MATCH) continue;
+        if (!dispatch(comand_match)) {
+            end_match();
+            finish();
+            return false;
+        }
+    }
+    return phase != Phase::DONE;
+}
 
-    // VERIFICAR SI PASÓ A FASE DE JUEGO
-    handle_match_messages();
+void Receiver::finish() {
+    if (finished) return;
+    finished = true;
 
     
     // (evita acceso a memoria liberada durante shutdown)
@@ -478,9 +549,17 @@ void Receiver::run() {
         }
     }
 
-    sender_messages_queue.close();
-    sender.join();
+    try {
+        sender_messages_queue.close();
+    } catch (const std::exception&) {
+        // Ya lo cerró ClientHandler::stop_connection
+    }
 
+    // Con un cliente lento el mailbox descarta snapshots viejos en vez de acumularlos
+    MailboxStats stats = sender_messages_queue.stats();
+    std::cout << "[Receiver " << id << "] Snapshots enviados: " << stats.delivered
+              << ", descartados: " << stats.dropped << " (en " << stats.coalesced << " saltos)"
+              << std::endl;
 }
 
 void Receiver::kill() {
@@ -491,6 +570,5 @@ bool Receiver::status() {
     return is_running;
 }
 
-Receiver::~Receiver() {
-    sender.join();
-}
+Receiver::~Receiver() {}
+
@@ -1,51 +1,87 @@
 #ifndef SERVER_RECEIVER_H
 #define SERVER_RECEIVER_H
 
+#include <atomic>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "../../common_src/dtos.h"
+#include "../../common_src/mailbox.h"
 #include "../../common_src/queue.h"
 #include "../../common_src/socket.h"
-#include "../../common_src/thread.h"
 #include "common_src/game_state.h"
 #include "matches_monitor.h"
-#include "sender.h"
 #include "server_src/server_protocol.h"
 
-class Receiver : public Thread {
+/*
+ * Sesión de un cliente: presentación, lobby y partida.
+ *
+ * No tiene hilo propio: el ClientHandler llama a `step` cada vez que el
+ * reactor avisa que llegó algo por TCP, y cada llamada procesa los mensajes
+ * que ya llegaron enteros (nunca espera al socket). Los snapshots de la
+ * partida los envía el ClientHandler.
+ * */
+class Receiver {
+    enum class Phase { HANDSHAKE, LOBBY, MATCH, DONE };
+
     ServerProtocol& protocol;
     int id;
     int match_id;
     std::string username;
-    Queue<GameState>& sender_messages_queue;
+    Mailbox<SnapshotHandle>& sender_messages_queue;
     std::atomic<bool>& is_running;
     MatchesMonitor& monitor;
+    LobbyOutbox outbox;  // por donde le llegan los broadcasts del lobby (ver matches_monitor.h)
     Queue<ComandMatchDTO>* commands_queue = nullptr;
-    Sender sender;
+
+    Phase phase;
+    int current_match_id;
+    bool finished;
 
     bool handle_client_lobby();
 
+    // Hay un mensaje entero para la fase actual (en partida, después de acks y pings)
+    bool message_ready();
+
+    void handle_handshake();
+    void handle_lobby_message();
+    void handle_lobby_error(const std::exception& e);
+    void enter_match();
+    void handle_match_message();
+    void end_match();
+
+    // Entrega un comando a la partida; false si la sesión tiene que terminar
+    bool dispatch(const ComandMatchDTO& comand_match);
+
 public:
     Receiver(const Receiver& other) = delete;
     Receiver& operator=(const Receiver& other) = delete;
 
-    Receiver(Receiver&& other) = default;
+    explicit Receiver(ServerProtocol& protocol, int id,
+                      Mailbox<SnapshotHandle>& sender_messages_queue, std::atomic<bool>& is_running,
+                      MatchesMonitor& monitor, LobbyOutbox outbox);
+
+    // Procesa los mensajes completos del cliente; false cuando la sesión terminó
+    bool step();
+
+    // El cliente cerró la conexión: limpia según la fase y termina la sesión
+    void connection_closed();
+
+    // Entrega los comandos llegados por UDP sin bloquear; false cuando la sesión terminó
+    bool poll_datagrams();
 
-    explicit Receiver(ServerProtocol& protocol, int id, Queue<GameState>& sender_messages_queue,
-                      std::atomic<bool>& is_running, MatchesMonitor& monitor);
+    // Cierre de la sesión: deja la partida y cierra el mailbox (solo la primera vez)
+    void finish();
 
-    void run() override;
     void kill();
     bool status();
 
     std::vector<std::pair<std::string, std::vector<std::pair<std::string, std::string>>>>
     get_city_maps();
-    void handle_lobby();
-    void handle_match_messages();
 
-    virtual ~Receiver();
+    ~Receiver();
 };
 
 #endif  // SERVER_RECEIVER_H
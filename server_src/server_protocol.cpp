@@ -1,21 +1,95 @@
 #include "server_protocol.h"
 
 #include <netinet/in.h>
+#include <sys/uio.h>
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <random>
 #include <stdexcept>
 
 #include "../common_src/dtos.h"
 #include "common_src/lobby_protocol.h"
 
-ServerProtocol::ServerProtocol(Socket& skt) : socket(skt) {}
+namespace {
+
+// Mira los bytes ya recibidos sin consumirlos: solo dice si un mensaje está entero
+class PendingBytes {
+    const uint8_t* data;
+    size_t size;
+    size_t offset;
+
+public:
+    PendingBytes(const uint8_t* data, size_t size) : data(data), size(size), offset(0) {}
+
+    bool skip(size_t sz) {
+        if (sz > size - offset) return false;
+        offset += sz;
+        return true;
+    }
+
+    bool uint8(uint8_t& value) {
+        if (!skip(1)) return false;
+        value = data[offset - 1];
+        return true;
+    }
+
+    bool string() {
+        if (!skip(2)) return false;
+        return skip(static_cast<size_t>(data[offset - 2]) << 8 | data[offset - 1]);
+    }
+};
+
+// Bytes que siguen al código de un comando de partida (ver read_command_client)
+size_t command_payload_size(uint8_t cmd_code) {
+    switch (cmd_code) {
+    case CMD_TURN_LEFT:
+    case CMD_TURN_RIGHT:
+        return 1;
+    case CMD_CHEAT_TELEPORT:
+        return 2;
+    case CMD_UPGRADE_SPEED:
+    case CMD_UPGRADE_ACCEL:
+    case CMD_UPGRADE_HANDLING:
+    case CMD_UPGRADE_DURABILITY:
+        return 3;
+    case CMD_SNAPSHOT_ACK:
+        return 4;
+    case CMD_INPUT_STATE:
+        return 5;
+    case CMD_PING:
+        return PING_SIZE;
+    default:
+        return 0;
+    }
+}
+
+}  // namespace
+
+ServerProtocol::ServerProtocol(Socket& skt, bool use_datagrams)
+    : socket(skt), inbound(skt), datagram_token(0), stream_until(0), datagram_acked(0),
+      last_input(0), server_tick(0) {
+    // Cada mensaje sale entero en un envío: no hace falta que Nagle los junte
+    socket.set_no_delay();
+
+    if (use_datagrams) {
+        try {
+            datagram_token = std::random_device{}();
+            datagrams = std::make_unique<DatagramChannel>(datagram_token);
+        } catch (const std::exception& e) {
+            // Sin puerto UDP la conexión funciona igual, todo por TCP
+            std::cerr << "[ServerProtocol] UDP deshabilitado: " << e.what() << std::endl;
+            datagrams.reset();
+        }
+    }
+}
 
 // --- Lectura básica de datos ---
 
 uint8_t ServerProtocol::read_message_type() {
     uint8_t type;
-    int bytes = socket.recvall(&type, sizeof(type));
+    int bytes = inbound.recvall(&type, sizeof(type));
     if (bytes == 0)
         throw std::runtime_error("Connection closed");
     return type;
@@ -23,7 +97,7 @@ uint8_t ServerProtocol::read_message_type() {
 
 std::string ServerProtocol::read_string() {
     uint16_t len_net;
-    int bytes_read = socket.recvall(&len_net, sizeof(len_net));
+    int bytes_read = inbound.recvall(&len_net, sizeof(len_net));
     if (bytes_read == 0)
         throw std::runtime_error("Connection closed while reading string length");
 
@@ -32,34 +106,58 @@ std::string ServerProtocol::read_string() {
         throw std::runtime_error("Invalid string length: " + std::to_string(len));
 
     std::vector<char> buffer(len);
-    socket.recvall(buffer.data(), len);
+    inbound.recvall(buffer.data(), len);
     return std::string(buffer.begin(), buffer.end());
 }
 
 uint16_t ServerProtocol::read_uint16() {
     uint16_t value_net;
-    socket.recvall(&value_net, sizeof(value_net));
+    inbound.recvall(&value_net, sizeof(value_net));
     return ntohs(value_net);
 }
 
+void ServerProtocol::set_nonblocking() {
+    socket.set_nonblocking();
+    std::lock_guard<std::mutex> lock(send_mutex);
+    nonblocking = true;
+}
+
 void ServerProtocol::send_buffer(const std::vector<uint8_t>& buffer) {
-    socket.sendall(buffer.data(), buffer.size());
+    std::lock_guard<std::mutex> lock(send_mutex);
+    outbound.clear();
+    outbound.put_ref(buffer);
+    deliver();
 }
 
 uint8_t ServerProtocol::get_uint8_t() {
     uint8_t n;
-    socket.recvall(&n, sizeof(n));
+    inbound.recvall(&n, sizeof(n));
     return n;
 }
 
 /** lee comandos que el cliente envia durante la fase de juego. Lee los datos del socket y los
  interpreta segun el codigo de comando recibido **/
 bool ServerProtocol::read_command_client(ComandMatchDTO& command) {
-    // Leer el código de comando (1 byte)
     uint8_t cmd_code;
-    int bytes = socket.recvall(&cmd_code, sizeof(cmd_code));
-    if (bytes == 0) return false; // conexión cerrada
-    if (bytes < 0) return false;  // error de lectura
+    while (true) {
+        // Con canal UDP se atiende lo que llegue primero: datagramas o el socket TCP
+        if (datagrams && next_datagram_input(command)) return true;
+
+        // Leer el código de comando (1 byte)
+        int bytes = inbound.recvall(&cmd_code, sizeof(cmd_code));
+        if (bytes == 0) return false; // conexión cerrada
+        if (bytes < 0) return false;  // error de lectura
+
+        // Las confirmaciones de snapshot y los pings se consumen acá, no llegan al GameLoop
+        if (cmd_code == CMD_PING) {
+            if (!answer_ping()) return false;
+            continue;
+        }
+        if (cmd_code != CMD_SNAPSHOT_ACK) break;
+        uint32_t sequence_net;
+        if (inbound.recvall(&sequence_net, sizeof(sequence_net)) <= 0) return false;
+        snapshot_stream.acknowledge(ntohl(sequence_net));
+    }
     // Log desactivado para reducir spam en producción
     // std::cout << "[ServerProtocol] Reading command code: 0x" << std::hex << (int)cmd_code << std::dec << std::endl;
 
@@ -107,6 +205,17 @@ bool ServerProtocol::read_command_client(ComandMatchDTO& command) {
         command.command = GameCommand::STOP_ALL;
         break;
 
+    case CMD_INPUT_STATE: {
+        command.command = GameCommand::INPUT_STATE;
+        uint8_t bits;
+        uint32_t sequence_net;
+        inbound.recvall(&bits, sizeof(bits));
+        inbound.recvall(&sequence_net, sizeof(sequence_net));
+        command.input_bits = bits;
+        command.input_sequence = ntohl(sequence_net);
+        break;
+    }
+
     case CMD_DISCONNECT:
         command.command = GameCommand::DISCONNECT;
         break;
@@ -133,7 +242,7 @@ bool ServerProtocol::read_command_client(ComandMatchDTO& command) {
         command.command = GameCommand::TURN_LEFT;
         // Leer intensidad del giro (1 byte: 0-100 = 0.0-1.0)
         uint8_t intensity;
-        socket.recvall(&intensity, sizeof(intensity));
+        inbound.recvall(&intensity, sizeof(intensity));
         command.turn_intensity = static_cast<float>(intensity) / 100.0f;
         break;
     }
@@ -143,7 +252,7 @@ bool ServerProtocol::read_command_client(ComandMatchDTO& command) {
         command.command = GameCommand::TURN_RIGHT;
         // Leer intensidad del giro (1 byte: 0-100 = 0.0-1.0)
         uint8_t intensity;
-        socket.recvall(&intensity, sizeof(intensity));
+        inbound.recvall(&intensity, sizeof(intensity));
         command.turn_intensity = static_cast<float>(intensity) / 100.0f;
         break;
     }
@@ -152,7 +261,7 @@ bool ServerProtocol::read_command_client(ComandMatchDTO& command) {
         command.command = GameCommand::CHEAT_TELEPORT_CHECKPOINT;
         // Leer ID del checkpoint (2 bytes)
         uint16_t checkpoint_id;
-        socket.recvall(&checkpoint_id, sizeof(checkpoint_id));
+        inbound.recvall(&checkpoint_id, sizeof(checkpoint_id));
         command.checkpoint_id = ntohs(checkpoint_id);
         break;
     }
@@ -162,10 +271,10 @@ bool ServerProtocol::read_command_client(ComandMatchDTO& command) {
         command.command = GameCommand::UPGRADE_SPEED;
         command.upgrade_type = UpgradeType::SPEED;
         // Leer nivel (1 byte)
-        socket.recvall(&command.upgrade_level, sizeof(command.upgrade_level));
+        inbound.recvall(&command.upgrade_level, sizeof(command.upgrade_level));
         // Leer costo en ms (2 bytes)
         uint16_t cost_net;
-        socket.recvall(&cost_net, sizeof(cost_net));
+        inbound.recvall(&cost_net, sizeof(cost_net));
         command.upgrade_cost_ms = ntohs(cost_net);
         break;
     }
@@ -173,9 +282,9 @@ bool ServerProtocol::read_command_client(ComandMatchDTO& command) {
     case CMD_UPGRADE_ACCEL: {
         command.command = GameCommand::UPGRADE_ACCELERATION;
         command.upgrade_type = UpgradeType::ACCELERATION;
-        socket.recvall(&command.upgrade_level, sizeof(command.upgrade_level));
+        inbound.recvall(&command.upgrade_level, sizeof(command.upgrade_level));
         uint16_t cost_net;
-        socket.recvall(&cost_net, sizeof(cost_net));
+        inbound.recvall(&cost_net, sizeof(cost_net));
         command.upgrade_cost_ms = ntohs(cost_net);
         break;
     }
@@ -183,9 +292,9 @@ bool ServerProtocol::read_command_client(ComandMatchDTO& command) {
     case CMD_UPGRADE_HANDLING: {
         command.command = GameCommand::UPGRADE_HANDLING;
         command.upgrade_type = UpgradeType::HANDLING;
-        socket.recvall(&command.upgrade_level, sizeof(command.upgrade_level));
+        inbound.recvall(&command.upgrade_level, sizeof(command.upgrade_level));
         uint16_t cost_net;
-        socket.recvall(&cost_net, sizeof(cost_net));
+        inbound.recvall(&cost_net, sizeof(cost_net));
         command.upgrade_cost_ms = ntohs(cost_net);
         break;
     }
@@ -193,9 +302,9 @@ bool ServerProtocol::read_command_client(ComandMatchDTO& command) {
     case CMD_UPGRADE_DURABILITY: {
         command.command = GameCommand::UPGRADE_DURABILITY;
         command.upgrade_type = UpgradeType::DURABILITY;
-        socket.recvall(&command.upgrade_level, sizeof(command.upgrade_level));
+        inbound.recvall(&command.upgrade_level, sizeof(command.upgrade_level));
         uint16_t cost_net;
-        socket.recvall(&cost_net, sizeof(cost_net));
+        inbound.recvall(&cost_net, sizeof(cost_net));
         command.upgrade_cost_ms = ntohs(cost_net);
         break;
     }
@@ -209,42 +318,120 @@ bool ServerProtocol::read_command_client(ComandMatchDTO& command) {
     return true;
 }
 
-// ============================================================================
-// FUNCIONES HELPER PARA SERIALIZACIÓN
-// ============================================================================
+bool ServerProtocol::receive_available() { return inbound.receive_available(); }
 
-static void push_back_uint16_t(std::vector<uint8_t>& buffer, uint16_t value) {
-    uint16_t net_value = htons(value);
-    buffer.push_back(reinterpret_cast<uint8_t*>(&net_value)[0]);
-    buffer.push_back(reinterpret_cast<uint8_t*>(&net_value)[1]);
+bool ServerProtocol::has_lobby_message() const {
+    PendingBytes in(inbound.pending(), inbound.pending_size());
+    uint8_t type;
+    if (!in.uint8(type)) return false;
+
+    switch (type) {
+    case MSG_USERNAME:
+        return in.string();
+    case MSG_LIST_GAMES:
+        return true;
+    case MSG_CREATE_GAME: {
+        // nombre | max jugadores | cantidad de carreras | (ciudad, mapa) por carrera
+        uint8_t max_players, num_races;
+        if (!in.string() || !in.uint8(max_players) || !in.uint8(num_races)) return false;
+        for (int i = 0; i < num_races; ++i) {
+            if (!in.string() || !in.string()) return false;
+        }
+        return true;
+    }
+    case MSG_JOIN_GAME:
+    case MSG_START_GAME:
+    case MSG_LEAVE_GAME:
+        return in.skip(sizeof(uint16_t));
+    case MSG_SELECT_CAR:
+        return in.string() && in.string();
+    case MSG_PLAYER_READY:
+        return in.skip(sizeof(uint8_t));
+    default:
+        return true;  // tipo desconocido: no hace falta esperar nada más para rechazarlo
+    }
 }
 
-static void push_back_uint32_t(std::vector<uint8_t>& buffer, uint32_t value) {
-    uint32_t net_value = htonl(value);
-    buffer.push_back(reinterpret_cast<uint8_t*>(&net_value)[0]);
-    buffer.push_back(reinterpret_cast<uint8_t*>(&net_value)[1]);
-    buffer.push_back(reinterpret_cast<uint8_t*>(&net_value)[2]);
-    buffer.push_back(reinterpret_cast<uint8_t*>(&net_value)[3]);
+bool ServerProtocol::has_match_message() const {
+    PendingBytes in(inbound.pending(), inbound.pending_size());
+    uint8_t cmd_code;
+    return in.uint8(cmd_code) && in.skip(command_payload_size(cmd_code));
 }
 
-static void push_back_int32_t(std::vector<uint8_t>& buffer, int32_t value) {
-    uint32_t net_value = htonl(static_cast<uint32_t>(value));
-    buffer.push_back(reinterpret_cast<uint8_t*>(&net_value)[0]);
-    buffer.push_back(reinterpret_cast<uint8_t*>(&net_value)[1]);
-    buffer.push_back(reinterpret_cast<uint8_t*>(&net_value)[2]);
-    buffer.push_back(reinterpret_cast<uint8_t*>(&net_value)[3]);
+bool ServerProtocol::consume_control_messages() {
+    while (has_match_message()) {
+        const uint8_t cmd_code = *inbound.pending();
+        if (cmd_code != CMD_PING && cmd_code != CMD_SNAPSHOT_ACK) return true;
+
+        uint8_t code;
+        inbound.recvall(&code, sizeof(code));
+        if (cmd_code == CMD_PING) {
+            if (!answer_ping()) return false;
+            continue;
+        }
+        uint32_t sequence_net;
+        inbound.recvall(&sequence_net, sizeof(sequence_net));
+        snapshot_stream.acknowledge(ntohl(sequence_net));
+    }
+    return true;
 }
 
-static void push_back_string(std::vector<uint8_t>& buffer, const std::string& str) {
-    // Enviar longitud (uint16_t)
-    push_back_uint16_t(buffer, static_cast<uint16_t>(str.size()));
-    // Enviar contenido
-    buffer.insert(buffer.end(), str.begin(), str.end());
+bool ServerProtocol::answer_ping() {
+    const uint64_t received_us = link_clock_us();
+    ping_body.resize(PING_SIZE);
+    if (inbound.recvall(ping_body.data(), ping_body.size()) <= 0) return false;
+
+    FrameReader in(ping_body);
+    const uint32_t ping_id = in.read_uint32();
+    const uint64_t sent_us = in.read_uint64();
+    const uint32_t rtt_us = in.read_uint32();
+    const uint32_t jitter_us = in.read_uint32();
+    {
+        std::lock_guard<std::mutex> lock(link_mutex);
+        link.rtt_ms = static_cast<float>(rtt_us) / 1000.0f;
+        link.jitter_ms = static_cast<float>(jitter_us) / 1000.0f;
+        ++link.samples;
+    }
+
+    std::lock_guard<std::mutex> lock(send_mutex);
+    if (!try_complete_backlog()) return false;
+
+    // Detrás de un snapshot a medias no se puede intercalar: el cliente manda otro ping
+    if (!backlog.empty()) return true;
+
+    outbound.clear();
+    outbound.put_uint8(static_cast<uint8_t>(ServerMessageType::PONG));
+    outbound.put_uint32(ping_id);
+    outbound.put_uint64(sent_us);
+    outbound.put_uint64(received_us);
+    outbound.put_uint64(link_clock_us());
+    outbound.put_uint32(server_tick);
+    return outbound.try_send(socket, backlog) >= 0;
+}
+
+LinkStats ServerProtocol::link_stats() {
+    LinkStats current;
+    {
+        std::lock_guard<std::mutex> lock(link_mutex);
+        current = link;
+    }
+    std::lock_guard<std::mutex> lock(send_mutex);
+    current.server_tick = server_tick;
+    return current;
 }
 
 bool ServerProtocol::send_client_id(int client_id) {
-    uint16_t id = htons(static_cast<uint16_t>(client_id));
-    socket.sendall(&id, sizeof(id));
+    {
+        std::lock_guard<std::mutex> lock(send_mutex);
+        outbound.clear();
+        outbound.put_uint16(static_cast<uint16_t>(client_id));
+        // Canal UDP de esta conexión: puerto (0 = solo TCP) y token para presentarse
+        outbound.put_uint16(datagrams ? datagrams->local_port() : 0);
+        outbound.put_uint32(datagram_token);
+        deliver();
+    }
+    // El área de interés de los snapshots se centra en el auto de este cliente
+    snapshot_stream.set_viewer(client_id);
     return true;
 }
 
@@ -256,113 +443,171 @@ bool ServerProtocol::send_client_id(int client_id) {
 
 
 
-bool ServerProtocol::send_snapshot(const GameState& snapshot) {
-    std::vector<uint8_t> buffer;
-    buffer.reserve(4096);
-
-    buffer.push_back(static_cast<uint8_t>(ServerMessageType::GAME_STATE_UPDATE));
+bool ServerProtocol::stage_snapshot(const EncodedSnapshot& snapshot) {
+    // Manifest solo si cambió el plantel desde el último que recibió este cliente
+    const std::vector<uint8_t>* manifest = snapshot_stream.manifest_for(snapshot);
 
-    // ---- 1. PLAYERS ----
-    push_back_uint16_t(buffer, static_cast<uint16_t>(snapshot.players.size()));
+    // Delta contra el último snapshot confirmado (o keyframe), compartido entre clientes
+    const std::vector<uint8_t>& message = snapshot_stream.message_for(snapshot);
 
-    for (const InfoPlayer& p : snapshot.players) {
-        // Strings
-        push_back_string(buffer, p.username);
-        push_back_string(buffer, p.car_name);
-        push_back_string(buffer, p.car_type);
+    /*
+     * Por UDP solo cuando el cliente ya se presentó y confirmó el último
+     * manifest: el manifest va por TCP y un snapshot por UDP podría llegar
+     * antes que él. Si el mensaje no entra en un datagrama, va por TCP.
+     * */
+    if (manifest) stream_until = snapshot.get_sequence();
+    server_tick = snapshot.get_tick();
+    if (datagrams && datagrams->has_peer() &&
+        snapshot_stream.acked_sequence() >= stream_until &&
+        datagrams->send(DGRAM_SNAPSHOT, snapshot.get_sequence(), message.data(), message.size())) {
+        return true;
+    }
 
-        // player_id
-        push_back_uint16_t(buffer, static_cast<uint16_t>(p.player_id));
+    // Ambos buffers son del EncodedSnapshot: se envían juntos sin copiarlos
+    outbound.clear();
+    if (manifest) outbound.put_ref(*manifest);
+    outbound.put_ref(message);
+    return false;
+}
 
-        // pos_x / pos_y (int32 scaled x100)
-        push_back_int32_t(buffer, static_cast<int32_t>(p.pos_x * 100.0f));
-        push_back_int32_t(buffer, static_cast<int32_t>(p.pos_y * 100.0f));
+bool ServerProtocol::send_snapshot(const EncodedSnapshot& snapshot) {
+    std::lock_guard<std::mutex> lock(send_mutex);
+    if (stage_snapshot(snapshot)) return true;
+    complete_backlog();
+    return outbound.send(socket) > 0;
+}
 
-        // angle / speed (uint16 scaled)
-        push_back_uint16_t(buffer, static_cast<uint16_t>(p.angle * 100.0f));
-        push_back_uint16_t(buffer, static_cast<uint16_t>(p.speed * 100.0f));
+bool ServerProtocol::offer_snapshot(const EncodedSnapshot& snapshot) {
+    std::lock_guard<std::mutex> lock(send_mutex);
+    if (!try_complete_backlog()) return false;
 
-        // velocity_x / velocity_y (int16 scaled)
-        push_back_int32_t(buffer, static_cast<int32_t>(p.velocity_x * 100.0f));
-        push_back_int32_t(buffer, static_cast<int32_t>(p.velocity_y * 100.0f));
+    // Un mensaje a medias no se puede intercalar: este snapshot se saltea
+    if (!backlog.empty()) return true;
 
+    if (stage_snapshot(snapshot)) return true;
+    return outbound.try_send(socket, backlog) >= 0;
+}
 
-        // health, nitro (uint8)
-        buffer.push_back((uint8_t)p.health);
-        buffer.push_back((uint8_t)p.nitro_amount);
+bool ServerProtocol::flush_pending() {
+    std::lock_guard<std::mutex> lock(send_mutex);
+    return try_complete_backlog();
+}
 
-        // flags
-        uint8_t flags = 0;
-        flags |= p.nitro_active ? 0x01 : 0;
-        flags |= p.is_drifting  ? 0x02 : 0;
-        flags |= p.is_colliding ? 0x04 : 0;
-        buffer.push_back(flags);
+bool ServerProtocol::has_pending() {
+    std::lock_guard<std::mutex> lock(send_mutex);
+    return !backlog.empty();
+}
 
-        // progreso
-        push_back_uint16_t(buffer, p.completed_laps);
-        push_back_uint16_t(buffer, p.current_checkpoint);
-        buffer.push_back((uint8_t)p.position_in_race);
+void ServerProtocol::complete_backlog() {
+    if (backlog.empty()) return;
+    socket.sendall(backlog.data(), backlog.size());
+    backlog.clear();
+}
 
-        // race time
-        push_back_uint32_t(buffer, p.race_time_ms);
-        push_back_uint32_t(buffer, p.total_time_ms);
+bool ServerProtocol::try_complete_backlog() {
+    if (backlog.empty()) return true;
+    struct iovec iov = {backlog.data(), backlog.size()};
+    const int sent = socket.trysendv(&iov, 1);
+    if (sent < 0) return false;
+    backlog.erase(backlog.begin(), backlog.begin() + sent);
+    return true;
+}
 
-        // estados
-        buffer.push_back(p.race_finished ? 1 : 0);
-        buffer.push_back(p.is_alive ? 1 : 0);
-        buffer.push_back(p.disconnected ? 1 : 0);
+bool ServerProtocol::deliver() {
+    if (!nonblocking) {
+        complete_backlog();
+        return outbound.send(socket) > 0;
     }
+    if (!try_complete_backlog()) return false;
 
-    // ---- 2. CHECKPOINTS ----
-    push_back_uint16_t(buffer, snapshot.checkpoints.size());
-    for (const CheckpointInfo& c : snapshot.checkpoints) {
-        push_back_uint32_t(buffer, c.id);
-        push_back_int32_t(buffer, (int32_t)(c.pos_x * 100.0f));
-        push_back_int32_t(buffer, (int32_t)(c.pos_y * 100.0f));
-        push_back_uint16_t(buffer, (uint16_t)(c.width * 100.0f));
-        push_back_uint16_t(buffer, (uint16_t)(c.angle * 100.0f));
-
-        buffer.push_back(c.is_start ? 1 : 0);
-        buffer.push_back(c.is_finish ? 1 : 0);
+    // Detrás de un mensaje a medias se encola entero: no se puede intercalar
+    if (!backlog.empty()) {
+        outbound.append_to(backlog);
+        return true;
     }
+    return outbound.try_send(socket, backlog) >= 0;
+}
 
-    // ---- 3. NPCs ----
-    push_back_uint16_t(buffer, snapshot.npcs.size());
-    for (const NPCCarInfo& n : snapshot.npcs) {
-        push_back_uint32_t(buffer, n.npc_id);
-        push_back_int32_t(buffer, (int32_t)(n.pos_x * 100.0f));
-        push_back_int32_t(buffer, (int32_t)(n.pos_y * 100.0f));
-        push_back_uint16_t(buffer, (uint16_t)(n.angle * 100.0f));
-        push_back_uint16_t(buffer, (uint16_t)(n.speed * 100.0f));
+bool ServerProtocol::send_snapshot(const GameState& snapshot) {
+    return send_snapshot(*own_encoder.encode(snapshot));
+}
 
-        buffer.push_back(n.is_parked ? 1 : 0);
+void ServerProtocol::take_datagram_input(ComandMatchDTO& command) {
+    const DatagramInput input = datagram_inputs.front();
+    datagram_inputs.pop_front();
+    command.command = static_cast<GameCommand>(input.code);
+    command.speed_boost = 1.0f;
+    command.turn_intensity = static_cast<float>(input.param) / 100.0f;
+    if (command.command == GameCommand::INPUT_STATE) {
+        command.input_bits = input.param;
+        command.input_sequence = input.sequence;
     }
+}
 
-    // ---- 4. RACE INFO ----
-    buffer.push_back((uint8_t)snapshot.race_info.status);
-    buffer.push_back((uint8_t)snapshot.race_info.race_number);
-    buffer.push_back((uint8_t)snapshot.race_info.total_races);
-
-    push_back_uint32_t(buffer, snapshot.race_info.remaining_time_ms);
-
-    buffer.push_back((uint8_t)snapshot.race_info.players_finished);
-    buffer.push_back((uint8_t)snapshot.race_info.total_players);
-
-    // ---- 5. EVENTS ----
-    push_back_uint16_t(buffer, snapshot.events.size());
+bool ServerProtocol::poll_datagram_command(ComandMatchDTO& command) {
+    if (!datagrams) return false;
+    if (datagram_inputs.empty()) receive_datagrams();
+    if (datagram_inputs.empty()) return false;
+    take_datagram_input(command);
+    return true;
+}
 
-    for (const GameEvent& e : snapshot.events) {
-        buffer.push_back((uint8_t)e.type);
-        push_back_uint32_t(buffer, e.player_id);
-        push_back_int32_t(buffer, (int32_t)(e.pos_x * 100.0f));
-        push_back_int32_t(buffer, (int32_t)(e.pos_y * 100.0f));
+bool ServerProtocol::next_datagram_input(ComandMatchDTO& command) {
+    while (true) {
+        if (!datagram_inputs.empty()) {
+            take_datagram_input(command);
+            return true;
+        }
+        if (inbound.has_buffered()) return false;
+
+        const int ready = datagrams->wait(socket, -1);
+        if (ready & DATAGRAM_READY) receive_datagrams();
+        if ((ready & STREAM_READY) && datagram_inputs.empty()) return false;
     }
+}
 
-    // ---- SEND ----
-    return socket.sendall(buffer.data(), buffer.size());
+void ServerProtocol::receive_datagrams() {
+    while (datagrams->receive(datagram_header, datagram_body, datagram_acks)) {
+        // El snapshot más nuevo confirmado por UDP pasa a ser la base de los deltas
+        if (!datagram_acks.empty()) {
+            uint32_t newest = datagram_acked;
+            for (uint32_t sequence : datagram_acks) newest = std::max(newest, sequence);
+            datagram_acks.clear();
+            if (newest != datagram_acked) {
+                datagram_acked = newest;
+                snapshot_stream.acknowledge(newest);
+            }
+        }
+
+        // HELLO y ACK no traen nada más que la cabecera
+        if (!datagrams->is_fresh(datagram_header.sequence)) continue;
+        if (datagram_header.kind == DGRAM_INPUT && !read_datagram_inputs()) continue;
+        datagrams->mark_received(datagram_header.sequence);
+    }
 }
 
+bool ServerProtocol::read_datagram_inputs() {
+    try {
+        FrameReader in(datagram_body);
+        const uint8_t count = in.read_uint8();
+        for (uint8_t i = 0; i < count; ++i) {
+            const uint32_t sequence = in.read_uint32();
+            const uint8_t code = in.read_uint8();
+            const uint8_t param = in.read_uint8();
+            // Cada comando viaja en varios datagramas: se entrega una sola vez y en orden
+            if (sequence <= last_input || !carried_by_datagram(code)) continue;
+            last_input = sequence;
+            datagram_inputs.push_back({sequence, code, param});
+        }
+        return true;
+    } catch (const std::exception&) {
+        return false;  // datagrama truncado: se descarta sin confirmarlo
+    }
+}
 
+void ServerProtocol::simulate_network(float loss, int delay_ms, uint32_t seed) {
+    if (datagrams) datagrams->simulate(loss, delay_ms, seed);
+}
 
 
 // ============================================================================
@@ -370,56 +615,49 @@ bool ServerProtocol::send_snapshot(const GameState& snapshot) {
 // ============================================================================
 
 bool ServerProtocol::send_race_info(const RaceInfoDTO& race_info) {
-    std::vector<uint8_t> buffer;
-
-    // 1. Tipo de mensaje
-    buffer.push_back(static_cast<uint8_t>(ServerMessageType::RACE_INFO));
-
-    // 2. Ciudad (string con longitud)
     std::string city_str(race_info.city_name);
-    push_back_string(buffer, city_str);
-
-    // 3. Nombre de carrera (string con longitud)
     std::string race_str(race_info.race_name);
-    push_back_string(buffer, race_str);
-
-    // 4. Ruta del mapa (string con longitud)
     std::string map_str(race_info.map_file_path);
-    push_back_string(buffer, map_str);
-
-    // 5. Datos numéricos
-    buffer.push_back(race_info.total_laps);
-    buffer.push_back(race_info.race_number);
-    buffer.push_back(race_info.total_races);
 
-    push_back_uint16_t(buffer, race_info.total_checkpoints);
-    push_back_uint32_t(buffer, race_info.max_time_ms);
+    std::lock_guard<std::mutex> lock(send_mutex);
+    outbound.clear();
 
-    // ENVIAR BUFFER
-    socket.sendall(buffer.data(), buffer.size());
-
-    return true;
+    // 1. Tipo de mensaje
+    outbound.put_uint8(static_cast<uint8_t>(ServerMessageType::RACE_INFO));
+
+    // 2. Ciudad, nombre de carrera y ruta del mapa (strings con longitud)
+    outbound.put_string(city_str);
+    outbound.put_string(race_str);
+    outbound.put_string(map_str);
+
+    // 3. Datos numéricos
+    outbound.put_uint8(race_info.total_laps);
+    outbound.put_uint8(race_info.race_number);
+    outbound.put_uint8(race_info.total_races);
+    outbound.put_uint16(race_info.total_checkpoints);
+    outbound.put_uint32(race_info.max_time_ms);
+
+    // ENVIAR (una sola syscall)
+    return deliver();
 }
 
 // ENVIAR RUTAS YAML DE LAS CARRERAS
 
 bool ServerProtocol::send_race_paths(const std::vector<std::string>& yaml_paths) {
-    std::vector<uint8_t> buffer;
+    std::lock_guard<std::mutex> lock(send_mutex);
+    outbound.clear();
 
     // 1. Tipo de mensaje
-    buffer.push_back(static_cast<uint8_t>(ServerMessageType::RACE_PATHS));
+    outbound.put_uint8(static_cast<uint8_t>(ServerMessageType::RACE_PATHS));
 
     // 2. Cantidad de carreras (uint8_t porque no habrá más de 255 carreras por partida)
-    buffer.push_back(static_cast<uint8_t>(yaml_paths.size()));
+    outbound.put_uint8(static_cast<uint8_t>(yaml_paths.size()));
 
-    // 3. Cada path como string
+    // 3. Cada path como string (los largos se referencian sin copiar)
     for (const auto& path : yaml_paths) {
-        push_back_string(buffer, path);
+        outbound.put_string(path);
     }
 
-    // 4. Enviar buffer
-    socket.sendall(buffer.data(), buffer.size());
-
-
-    return true;
+    // 4. Enviar (una sola syscall)
+    return deliver();
 }
@@ -1,18 +1,79 @@
 #ifndef SERVER_PROTOCOL_H
 #define SERVER_PROTOCOL_H
 #include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "common_src/buffered_reader.h"
+#include "common_src/clock_sync.h"
+#include "common_src/datagram_channel.h"
 #include "common_src/dtos.h"
 #include "common_src/game_state.h"
+#include "common_src/outbound_message.h"
+#include "common_src/snapshot_codec.h"
 #include "common_src/socket.h"
 
 class ServerProtocol {
     Socket& socket;
+    BufferedReader inbound;            // toda lectura del socket pasa por acá
+    std::mutex send_mutex;             // snapshots y lobby/partida comparten el socket
+    OutboundMessage outbound;          // arena de envío, siempre bajo send_mutex
+    std::vector<uint8_t> backlog;      // resto de un offer_snapshot que el socket no aceptó
+    bool nonblocking = false;          // ver set_nonblocking
+    SnapshotStream snapshot_stream;    // último ack y manifest de esta conexión
+    SnapshotEncoder own_encoder;       // solo para send_snapshot(GameState)
+
+    // Canal UDP opcional (nullptr: todo por TCP). Ver datagram_channel.h
+    std::unique_ptr<DatagramChannel> datagrams;
+    uint32_t datagram_token;
+    uint32_t stream_until;      // snapshots por TCP hasta que el cliente confirme este
+    uint32_t datagram_acked;    // último snapshot confirmado por UDP
+    uint32_t last_input;        // secuencia del último comando de DGRAM_INPUT aceptado
+    struct DatagramInput {
+        uint32_t sequence;
+        uint8_t code;
+        uint8_t param;
+    };
+    std::deque<DatagramInput> datagram_inputs;
+    DatagramHeader datagram_header;
+    std::vector<uint8_t> datagram_body;
+    std::vector<uint32_t> datagram_acks;
+
+    // Pings del cliente (ver clock_sync.h)
+    uint32_t server_tick;            // tick de simulación del último snapshot, bajo send_mutex
+    std::vector<uint8_t> ping_body;
+    std::mutex link_mutex;
+    LinkStats link;                  // lo que informa el cliente en cada ping, bajo link_mutex
+
+    // Lee el cuerpo de un CMD_PING y contesta el PONG; false si se cerró la conexión
+    bool answer_ping();
+
+    // Próximo comando llegado por UDP; false cuando hay algo para leer por TCP
+    bool next_datagram_input(ComandMatchDTO& command);
+    void take_datagram_input(ComandMatchDTO& command);
+
+    // Procesa los datagramas disponibles (acks de snapshots y comandos)
+    void receive_datagrams();
+    bool read_datagram_inputs();
+
+    // Manda el snapshot por UDP si corresponde; si no, lo deja armado en `outbound`
+    bool stage_snapshot(const EncodedSnapshot& snapshot);
+
+    // Bajo send_mutex: completa el backlog bloqueando / sin bloquear (false: se cerró)
+    void complete_backlog();
+    bool try_complete_backlog();
+
+    // Bajo send_mutex: envía `outbound` detrás del backlog; sin bloquear si el socket
+    // es no bloqueante (lo que no sale queda en el backlog). false si se cerró
+    bool deliver();
 
 public:
-    explicit ServerProtocol(Socket& s);
+    // Con `use_datagrams` se ofrece al cliente el canal UDP en send_client_id
+    explicit ServerProtocol(Socket& s, bool use_datagrams = false);
 
     // Procesa mensajes del cliente
     bool process_client_messages(const std::string& username);
@@ -31,10 +92,17 @@ public:
     float read_float32();
 
 
+    /*
+     * Pasa el socket a O_NONBLOCK (lo usa el reactor). Desde acá ningún envío
+     * espera al socket: lo que no entra queda pendiente como en offer_snapshot
+     * y sale con `flush_pending` cuando el socket vuelve a aceptar datos.
+     * */
+    void set_nonblocking();
+
     // Envía un buffer
     void send_buffer(const std::vector<uint8_t>& buffer);
 
-    //envia client id
+    //envia client id (y el puerto/token UDP, 0 si no hay canal)
     bool send_client_id(int client_id);
 
     // Obtener referencia al socket
@@ -43,9 +111,46 @@ public:
     // leer comando cliente
     bool read_command_client(ComandMatchDTO& command);
 
-    // Enviar snapshot (GameState) al cliente
+    // Enviar snapshot ya codificado por la partida, como delta del último confirmado
+    bool send_snapshot(const EncodedSnapshot& snapshot);
+
+    // Codifica y envía un snapshot suelto (sin pasar por el encoder de la partida)
     bool send_snapshot(const GameState& snapshot);
 
+    /*
+     * Como send_snapshot pero sin bloquear nunca (lo usa el reactor). Lo que
+     * el socket no acepte queda pendiente hasta `flush_pending`; mientras
+     * tanto los snapshots nuevos se descartan, el siguiente los reemplaza.
+     * Retorna false si la conexión se cerró.
+     * */
+    bool offer_snapshot(const EncodedSnapshot& snapshot);
+    bool flush_pending();
+    bool has_pending();
+
+    /*
+     * Lectura sin bloquear para el reactor (socket en O_NONBLOCK): se recibe
+     * lo disponible y solo se lee un mensaje cuando llegó entero, así sus
+     * lecturas salen de memoria. Lo que llegó a medias espera a la próxima.
+     * */
+    bool receive_available();  // false si el cliente cerró la conexión
+    bool has_lobby_message() const;
+    bool has_match_message() const;
+
+    // Contesta los pings y registra los acks que ya llegaron enteros; false si se cerró
+    bool consume_control_messages();
+
+    // Procesa los datagramas disponibles sin bloquear; false si no dejaron ningún comando
+    bool poll_datagram_command(ComandMatchDTO& command);
+
+    // RTT y jitter que midió el cliente (samples = 0: todavía no mandó pings)
+    LinkStats link_stats();
+
+    // Socket UDP de la conexión (nullptr: todo por TCP)
+    DatagramSocket* get_datagram_socket() { return datagrams ? &datagrams->get_socket() : nullptr; }
+
+    // Pérdida y latencia simuladas en lo que llega por UDP (pruebas locales)
+    void simulate_network(float loss, int delay_ms, uint32_t seed);
+
     // Enviar información inicial de la carrera
     bool send_race_info(const RaceInfoDTO& race_info);
 
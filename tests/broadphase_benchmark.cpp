@@ -0,0 +1,101 @@
+// Benchmark del broadphase auto-auto: fuerza bruta O(n²) vs SpatialHash.
+// Uso: ./broadphase_benchmark [iteraciones]
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "server_src/game/spatial_hash.h"
+
+namespace {
+
+constexpr float CAR_RADIUS_PX = 12.0f;
+constexpr float MIN_DIST = CAR_RADIUS_PX * 2.0f;
+
+struct Scenario {
+    const char* name;
+    float width;
+    float height;
+};
+
+size_t brute_force_pairs(const std::vector<float>& xs, const std::vector<float>& ys) {
+    const float min_dist_sq = MIN_DIST * MIN_DIST;
+    size_t pairs = 0;
+    for (size_t i = 0; i < xs.size(); ++i) {
+        for (size_t j = i + 1; j < xs.size(); ++j) {
+            const float dx = xs[i] - xs[j];
+            const float dy = ys[i] - ys[j];
+            if (dx * dx + dy * dy < min_dist_sq) ++pairs;
+        }
+    }
+    return pairs;
+}
+
+size_t hashed_pairs(SpatialHash& hash, const std::vector<float>& xs, const std::vector<float>& ys) {
+    size_t pairs = 0;
+    hash.rebuild(xs.data(), ys.data(), xs.size());
+    hash.for_each_pair(xs.data(), ys.data(), MIN_DIST, [&](int, int) { ++pairs; });
+    return pairs;
+}
+
+template <typename F>
+double time_us_per_step(int iterations, F&& step) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) step();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 2000;
+
+    // Mapa completo (tráfico disperso) y una grilla de largada (autos apretados)
+    const Scenario scenarios[] = {{"mapa 4640x4672", 4640.0f, 4672.0f},
+                                  {"largada 400x400", 400.0f, 400.0f}};
+    const int body_counts[] = {8, 16, 32, 64, 128, 256};
+
+    std::mt19937 rng(42);
+    SpatialHash hash(MIN_DIST);
+    bool all_match = true;
+    volatile size_t sink = 0;
+
+    for (const auto& scenario : scenarios) {
+        std::cout << "== " << scenario.name << " ==" << std::endl;
+        std::cout << std::setw(8) << "autos" << std::setw(10) << "pares" << std::setw(16)
+                  << "O(n^2) us" << std::setw(16) << "hash us" << std::endl;
+
+        for (int count : body_counts) {
+            std::uniform_real_distribution<float> dist_x(0.0f, scenario.width);
+            std::uniform_real_distribution<float> dist_y(0.0f, scenario.height);
+            std::vector<float> xs(count), ys(count);
+            for (int i = 0; i < count; ++i) {
+                xs[i] = dist_x(rng);
+                ys[i] = dist_y(rng);
+            }
+
+            const size_t expected = brute_force_pairs(xs, ys);
+            const size_t found = hashed_pairs(hash, xs, ys);
+            if (expected != found) {
+                std::cerr << "[Benchmark] ERROR: " << count << " autos, fuerza bruta=" << expected
+                          << " hash=" << found << std::endl;
+                all_match = false;
+            }
+
+            const double brute_us =
+                    time_us_per_step(iterations, [&] { sink = sink + brute_force_pairs(xs, ys); });
+            const double hash_us =
+                    time_us_per_step(iterations, [&] { sink = sink + hashed_pairs(hash, xs, ys); });
+
+            std::cout << std::setw(8) << count << std::setw(10) << expected << std::setw(16)
+                      << std::fixed << std::setprecision(2) << brute_us << std::setw(16) << hash_us
+                      << std::endl;
+        }
+    }
+
+    return all_match ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,4 +1,4 @@
-#include "../common_src/queue.h"
+#include "../common_src/mailbox.h"
 #include "../server_src/game/match.h"
 #include "../server_src/network/matches_monitor.h"
 #include "common_src/config.h"
@@ -11,7 +11,7 @@ using ::testing::Gt;
 class MatchesMonitorTest : public ::testing::Test {
 protected:
     MatchesMonitor monitor;
-    Queue<GameState> dummy_queue;
+    Mailbox<SnapshotHandle> dummy_queue;
 
     void SetUp() override {
         // No cargar config.yaml para evitar problemas en tests
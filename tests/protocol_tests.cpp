@@ -1,23 +1,110 @@
 #include <arpa/inet.h>
+#include <sys/socket.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <memory>
 #include <thread>
 
 #include "../client_src/client_protocol.h"
+#include "../client_src/game/car_predictor.h"
+#include "../client_src/game/snapshot_interpolator.h"
 #include "../client_src/lobby/model/lobby_client.h"
+#include "../common_src/car_catalog.h"
+#include "../common_src/collision_manager.h"
 #include "../common_src/config.h"
 #include "../common_src/dtos.h"
 #include "../common_src/lobby_protocol.h"
+#include "../common_src/map_asset_cache.h"
+#include "../common_src/mailbox.h"
+#include "../common_src/race_descriptor.h"
+#include "../server_src/game/checkpoint_engine.h"
+#include "../server_src/game/tick_scheduler.h"
+#include "../server_src/network/reactor.h"
 #include "../server_src/server_protocol.h"
 #include <fstream>
 #include <string>
 #include <cctype>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
+#include <filesystem>
 
 constexpr const char* kHost = "127.0.0.1";
 constexpr const char* kPort = "8085";
 constexpr int kDelay = 100;
+// Medio paso de cuantización del codec de snapshots
+constexpr float kPositionTolerance = SNAPSHOT_DEFAULT_BOUNDS / 65536.0f / 2.0f;
+constexpr float kAngleTolerance = 6.28318530718f / (1 << SNAPSHOT_ANGLE_BITS) / 2.0f + 1e-6f;
+
+// Capa RGBA32 en memoria: blanco donde `walkable(x, y)`, negro (pared) en el resto
+template <typename Walkable>
+SDL_Surface* make_layer(int w, int h, Walkable walkable) {
+    SDL_Surface* layer = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_RGBA32);
+    for (int y = 0; y < h; ++y) {
+        Uint8* row = static_cast<Uint8*>(layer->pixels) + y * layer->pitch;
+        for (int x = 0; x < w; ++x) {
+            const Uint8 value = walkable(x, y) ? 255 : 0;
+            row[x * 4] = row[x * 4 + 1] = row[x * 4 + 2] = value;
+            row[x * 4 + 3] = 255;
+        }
+    }
+    return layer;
+}
+
+// Capa guardada en disco (IMG_Load reconoce el formato por el contenido, no por la extensión)
+template <typename Walkable>
+void write_layer(const std::string& path, int w, int h, Walkable walkable) {
+    SDL_Surface* layer = make_layer(w, h, walkable);
+    SDL_SaveBMP(layer, path.c_str());
+    SDL_FreeSurface(layer);
+}
+
+// Mapa de colisión sin puentes ni rampas, sin pasar por PNGs
+template <typename Walkable>
+std::shared_ptr<const CollisionData> make_collision_map(int w, int h, Walkable walkable,
+                                                        bool with_distance_fields = false) {
+    SDL_Surface* camino = make_layer(w, h, walkable);
+    SDL_Surface* puentes = make_layer(w, h, [](int, int) { return false; });
+    auto data = std::make_shared<CollisionData>();
+    data->grid = CollisionGrid(camino, puentes, nullptr);
+    SDL_FreeSurface(camino);
+    SDL_FreeSurface(puentes);
+    if (with_distance_fields) data->bake_distance_fields();
+    return data;
+}
+
+// Directorio temporal propio del test, se borra con todo su contenido al salir
+class TempDir {
+private:
+    std::filesystem::path root;
+
+public:
+    TempDir() {
+        char pattern[] = "/tmp/taller_testsXXXXXX";
+        if (!mkdtemp(pattern)) throw std::runtime_error("mkdtemp");
+        root = pattern;
+    }
+    ~TempDir() { std::filesystem::remove_all(root); }
+
+    std::string path(const std::string& name) const { return (root / name).string(); }
+    const std::filesystem::path& get() const { return root; }
+};
+
+void write_text(const std::string& path, const std::string& text) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << text;
+}
+
+// Espera hasta ~1 s a que se cumpla `pred` (lo hace otro hilo)
+template <typename Pred>
+bool wait_until(Pred pred) {
+    for (int i = 0; i < 1000 && !pred(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return pred();
+}
 
 // TESTS DE INTEGRACIÓN: CLIENTE ↔ SERVIDOR REALES
 
@@ -674,6 +761,47 @@ TEST(GameCommandProtocolTest, MultipleCommandsSequence) {
     server_thread.join();
 }
 
+TEST(GameCommandProtocolTest, InputStateCarriesBitsAndSequence) {
+    std::thread server_thread([&]() {
+        Socket server_socket(kPort);
+        Socket client_conn = server_socket.accept();
+
+        ServerProtocol server_protocol(client_conn);
+
+        ComandMatchDTO first;
+        ASSERT_TRUE(server_protocol.read_command_client(first));
+        EXPECT_EQ(first.command, GameCommand::INPUT_STATE);
+        EXPECT_EQ(first.input_bits, INPUT_UP | INPUT_NITRO);
+        EXPECT_EQ(first.input_sequence, 7u);
+
+        // Sin teclas apretadas también viaja: es lo que frena al auto
+        ComandMatchDTO second;
+        ASSERT_TRUE(server_protocol.read_command_client(second));
+        EXPECT_EQ(second.command, GameCommand::INPUT_STATE);
+        EXPECT_EQ(second.input_bits, 0);
+        EXPECT_EQ(second.input_sequence, 0x01020304u);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kDelay));
+
+    std::thread client_thread([&]() {
+        ClientProtocol client_protocol(kHost, kPort);
+
+        ComandMatchDTO state;
+        state.command = GameCommand::INPUT_STATE;
+        state.input_bits = INPUT_UP | INPUT_NITRO;
+        state.input_sequence = 7;
+        client_protocol.send_command_client(state);
+
+        state.input_bits = 0;
+        state.input_sequence = 0x01020304;
+        client_protocol.send_command_client(state);
+    });
+
+    client_thread.join();
+    server_thread.join();
+}
+
 // TESTS DE RACE_INFO (INFORMACIÓN INICIAL DE CARRERA)
 
 TEST(RaceInfoProtocolTest, SendAndReceiveRaceInfo) {
@@ -1014,7 +1142,8 @@ TEST(GameSnapshotProtocolTest, SendAndReceiveSnapshotBasic) {
 
     std::thread client_thread([&]() {
         ClientProtocol cp(kHost, kPort);
-        GameState received = cp.receive_snapshot();
+        GameState received;
+        cp.receive_snapshot(received);
 
         // Verificar tamaños dinámicos leídos desde el YAML
         ASSERT_EQ(received.checkpoints.size(), static_cast<size_t>(expected_checkpoints));
@@ -1129,7 +1258,8 @@ TEST(GameSnapshotProtocolTest, SendAndReceiveSnapshotMultiplePlayers) {
     // Hilo cliente
     std::thread client_thread([&]() {
         ClientProtocol cp(kHost, kPort);
-        GameState received = cp.receive_snapshot();
+        GameState received;
+        cp.receive_snapshot(received);
 
         ASSERT_EQ(received.players.size(), 3u);
         ASSERT_EQ(received.npcs.size(), 2u);
@@ -1202,7 +1332,8 @@ TEST(GameSnapshotProtocolTest, SendAndReceiveSnapshotMultiplePlayers) {
 
         // Si el cliente implementa consumo de mensajes intermedios,
         // receive_snapshot debe devolver el snapshot aunque se haya enviado RACE_INFO antes.
-        GameState received = cp.receive_snapshot();
+        GameState received;
+        cp.receive_snapshot(received);
 
         ASSERT_EQ(received.players.size(), 1u);
         ASSERT_EQ(received.checkpoints.size(), static_cast<size_t>(expected_checkpoints));
@@ -1238,7 +1369,8 @@ TEST(GameStateSnapshotTest, EmptySnapshotSerialization) {
 
     std::thread client_thread([&]() {
         ClientProtocol cp(kHost, kPort);
-        GameState received = cp.receive_snapshot();
+        GameState received;
+        cp.receive_snapshot(received);
 
         EXPECT_EQ(received.race_info.status, sent.race_info.status);
         EXPECT_EQ(received.race_info.remaining_time_ms, sent.race_info.remaining_time_ms);
@@ -1299,18 +1431,20 @@ TEST(GameStateSnapshotTest, SinglePlayerSnapshot) {
 
     std::thread client_thread([&]() {
         ClientProtocol cp(kHost, kPort);
-        GameState received = cp.receive_snapshot();
+        GameState received;
+        cp.receive_snapshot(received);
 
         ASSERT_EQ(received.players.size(), 1u);
         const auto& rp = received.players[0];
 
         EXPECT_EQ(rp.player_id, p.player_id);
-        EXPECT_EQ(rp.username, p.username);
-        EXPECT_EQ(rp.car_name, p.car_name);
-        EXPECT_EQ(rp.car_type, p.car_type);
-        EXPECT_FLOAT_EQ(rp.pos_x, p.pos_x);
-        EXPECT_FLOAT_EQ(rp.pos_y, p.pos_y);
-        EXPECT_FLOAT_EQ(rp.angle, p.angle);
+        EXPECT_EQ(received.username_of(rp), p.username);
+        EXPECT_EQ(received.car_name_of(rp), p.car_name);
+        EXPECT_EQ(received.car_type_of(rp), p.car_type);
+        // Formato compacto: error de a lo sumo medio paso de cuantización
+        EXPECT_NEAR(rp.pos_x, p.pos_x, kPositionTolerance);
+        EXPECT_NEAR(rp.pos_y, p.pos_y, kPositionTolerance);
+        EXPECT_NEAR(rp.angle, p.angle, kAngleTolerance);
         EXPECT_FLOAT_EQ(rp.speed, p.speed);
         EXPECT_FLOAT_EQ(rp.velocity_x, p.velocity_x);
         EXPECT_FLOAT_EQ(rp.velocity_y, p.velocity_y);
@@ -1380,14 +1514,15 @@ TEST(GameStateSnapshotTest, MultiplePlayersSnapshot) {
 
     std::thread client_thread([&]() {
         ClientProtocol cp(kHost, kPort);
-        GameState received = cp.receive_snapshot();
+        GameState received;
+        cp.receive_snapshot(received);
 
         ASSERT_EQ(received.players.size(), 5u);
 
         for (size_t i = 0; i < 5; ++i) {
             const auto& rp = received.players[i];
             EXPECT_EQ(rp.player_id, i + 1);
-            EXPECT_EQ(rp.username, "Player" + std::to_string(i + 1));
+            EXPECT_EQ(received.username_of(rp), "Player" + std::to_string(i + 1));
             EXPECT_EQ(rp.position_in_race, i + 1);
             EXPECT_EQ(rp.race_finished, (i == 4));
             EXPECT_EQ(rp.is_alive, (i != 2));
@@ -1434,7 +1569,8 @@ TEST(GameStateSnapshotTest, SnapshotWithCheckpoints) {
 
     std::thread client_thread([&]() {
         ClientProtocol cp(kHost, kPort);
-        GameState received = cp.receive_snapshot();
+        GameState received;
+        cp.receive_snapshot(received);
 
         ASSERT_EQ(received.checkpoints.size(), 10u);
 
@@ -1499,7 +1635,8 @@ TEST(GameStateSnapshotTest, SnapshotWithEvents) {
 
     std::thread client_thread([&]() {
         ClientProtocol cp(kHost, kPort);
-        GameState received = cp.receive_snapshot();
+        GameState received;
+        cp.receive_snapshot(received);
 
         ASSERT_EQ(received.events.size(), 3u);
 
@@ -1547,7 +1684,8 @@ TEST(GameStateSnapshotTest, SnapshotWithDifferentRaceStatuses) {
 
         std::thread client_thread([&, status]() {
             ClientProtocol cp(kHost, kPort);
-            GameState received = cp.receive_snapshot();
+            GameState received;
+            cp.receive_snapshot(received);
 
             EXPECT_EQ(received.race_info.status, status);
         });
@@ -1610,7 +1748,8 @@ TEST(GameStateSnapshotTest, SnapshotWithMaxPlayers) {
 
     std::thread client_thread([&]() {
         ClientProtocol cp(kHost, kPort);
-        GameState received = cp.receive_snapshot();
+        GameState received;
+        cp.receive_snapshot(received);
 
         ASSERT_EQ(received.players.size(), MAX_PLAYERS);
 
@@ -1680,7 +1819,8 @@ TEST(GameStateSnapshotTest, SnapshotSequence) {
         ClientProtocol cp(kHost, kPort);
 
         for (int i = 0; i < 3; ++i) {
-            GameState received = cp.receive_snapshot();
+            GameState received;
+            cp.receive_snapshot(received);
 
             EXPECT_EQ(received.race_info.remaining_time_ms, 500000u - (i * 50000));
             ASSERT_EQ(received.players.size(), 1u);
@@ -1694,3 +1834,1607 @@ TEST(GameStateSnapshotTest, SnapshotSequence) {
     client_thread.join();
     server_thread.join();
 }
+
+TEST(GameStateSnapshotTest, DeltaSnapshotAfterAck) {
+    // El segundo snapshot viaja como delta del primero (ya confirmado por el cliente)
+    GameState first;
+    first.race_info.status = MatchStatus::IN_PROGRESS;
+    first.race_info.remaining_time_ms = 300000;
+    first.race_info.race_number = 2;
+    first.race_info.total_races = 3;
+
+    InfoPlayer p;
+    p.player_id = 7;
+    p.username = "DeltaPlayer";
+    p.car_name = "DeltaCar";
+    p.car_type = "Sport";
+    p.pos_x = 120.0f;
+    p.pos_y = 340.0f;
+    p.speed = 80.0f;
+    p.health = 90;
+    p.nitro_amount = 40;
+    p.completed_laps = 1;
+    p.current_checkpoint = 3;
+    p.position_in_race = 2;
+    p.is_alive = true;
+    p.last_input = 500;
+    first.players.push_back(p);
+
+    GameState second = first;
+    second.players[0].pos_x = 125.5f;
+    second.players[0].last_input = 503;
+    second.players[0].speed = 82.0f;
+    second.race_info.remaining_time_ms = 299984;
+
+    std::thread server_thread([&]() {
+        Socket server_socket(kPort);
+        Socket client_conn = server_socket.accept();
+        ServerProtocol sp(client_conn);
+
+        EXPECT_TRUE(sp.send_snapshot(first));
+
+        // La confirmación llega antes del comando y se consume sin devolverse
+        ComandMatchDTO command;
+        EXPECT_TRUE(sp.read_command_client(command));
+        EXPECT_EQ(command.command, GameCommand::ACCELERATE);
+
+        EXPECT_TRUE(sp.send_snapshot(second));
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kDelay));
+
+    std::thread client_thread([&]() {
+        ClientProtocol cp(kHost, kPort);
+        GameState received;
+        cp.receive_snapshot(received);
+        ASSERT_EQ(received.players.size(), 1u);
+
+        ComandMatchDTO command;
+        command.command = GameCommand::ACCELERATE;
+        cp.send_command_client(command);
+
+        cp.receive_snapshot(received);
+        ASSERT_EQ(received.players.size(), 1u);
+        const InfoPlayer& r = received.players[0];
+        EXPECT_EQ(r.player_id, 7);
+        EXPECT_EQ(received.username_of(r), "DeltaPlayer");
+        EXPECT_EQ(received.car_name_of(r), "DeltaCar");
+        EXPECT_FLOAT_EQ(r.pos_x, 125.5f);
+        EXPECT_FLOAT_EQ(r.pos_y, 340.0f);
+        EXPECT_FLOAT_EQ(r.speed, 82.0f);
+        EXPECT_EQ(r.health, 90);
+        EXPECT_EQ(r.completed_laps, 1);
+        EXPECT_EQ(r.current_checkpoint, 3);
+        EXPECT_TRUE(r.is_alive);
+        EXPECT_EQ(r.last_input, 503u);
+        EXPECT_EQ(received.race_info.remaining_time_ms, 299984);
+        EXPECT_EQ(received.race_info.race_number, 2);
+    });
+
+    client_thread.join();
+    server_thread.join();
+}
+
+TEST(GameStateSnapshotTest, SnapshotWithoutBaselineIsNotDelivered) {
+    SnapshotEncoder encoder;
+    GameState state;
+    InfoPlayer p;
+    p.player_id = 5;
+    p.username = "Lost";
+    p.pos_x = 25.0f;
+    p.pos_y = 60.0f;
+    state.players.push_back(p);
+
+    SnapshotHandle first = encoder.encode(state);
+    state.players[0].pos_x = 50.0f;
+    SnapshotHandle second = encoder.encode(state);
+    state.players[0].pos_x = 75.0f;
+    SnapshotHandle third = encoder.encode(state);
+
+    std::atomic<bool> client_done{false};
+    std::thread server_thread([&]() {
+        Socket server_socket(kPort);
+        Socket client_conn = server_socket.accept();
+
+        // El servidor cree que el cliente tiene `first`, pero nunca le llegó
+        SnapshotStream stream;
+        stream.message_for(*first);
+        stream.acknowledge(first->get_sequence());
+        const std::vector<uint8_t>* manifest = stream.manifest_for(*second);
+        ASSERT_NE(manifest, nullptr);
+        client_conn.sendall(manifest->data(), manifest->size());
+        const std::vector<uint8_t>& delta = stream.message_for(*second);
+        client_conn.sendall(delta.data(), delta.size());
+
+        // Después llega un keyframe
+        SnapshotStream fresh;
+        const std::vector<uint8_t>& keyframe = fresh.message_for(*third);
+        client_conn.sendall(keyframe.data(), keyframe.size());
+        wait_until([&] { return client_done.load(); });
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kDelay));
+
+    std::thread client_thread([&]() {
+        ClientProtocol cp(kHost, kPort);
+        // El delta sin base se descarta: lo primero que se entrega es el keyframe
+        GameState received;
+        cp.receive_snapshot(received);
+        ASSERT_EQ(received.players.size(), 1u);
+        EXPECT_EQ(received.players[0].player_id, 5);
+        EXPECT_NEAR(received.players[0].pos_x, 75.0f, kPositionTolerance);
+        EXPECT_NEAR(received.players[0].pos_y, 60.0f, kPositionTolerance);
+        client_done = true;
+    });
+
+    client_thread.join();
+    server_thread.join();
+}
+
+TEST(GameStateSnapshotTest, ManifestResentWhenRosterChanges) {
+    // Los nombres viajan en el RACE_MANIFEST: un jugador nuevo debe llegar con sus strings
+    GameState first;
+    InfoPlayer a;
+    a.player_id = 1;
+    a.username = "Alpha";
+    a.car_name = "Senator";
+    a.car_type = "truck";
+    a.car_id = 6;
+    a.pos_x = 10.0f;
+    first.players.push_back(a);
+
+    GameState second = first;
+    InfoPlayer b;
+    b.player_id = 4;
+    b.username = "Bravo";
+    b.car_name = "Brisa";
+    b.car_type = "sport";
+    b.car_id = 4;
+    b.pos_x = 20.0f;
+    second.players.push_back(b);
+
+    std::thread server_thread([&]() {
+        Socket server_socket(kPort);
+        Socket client_conn = server_socket.accept();
+        ServerProtocol sp(client_conn);
+        EXPECT_TRUE(sp.send_snapshot(first));
+        EXPECT_TRUE(sp.send_snapshot(first));
+        EXPECT_TRUE(sp.send_snapshot(second));
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kDelay));
+
+    std::thread client_thread([&]() {
+        ClientProtocol cp(kHost, kPort);
+        std::shared_ptr<const std::vector<RosterEntry>> roster;
+        for (int i = 0; i < 2; ++i) {
+            GameState received;
+            cp.receive_snapshot(received);
+            ASSERT_EQ(received.players.size(), 1u);
+            EXPECT_EQ(received.username_of(received.players[0]), "Alpha");
+            EXPECT_EQ(received.players[0].car_id, 6);
+            // Mismo manifest: los snapshots comparten el roster en vez de copiar strings
+            EXPECT_TRUE(received.players[0].username.empty());
+            if (i > 0) {
+                EXPECT_EQ(received.roster, roster);
+            }
+            roster = received.roster;
+        }
+
+        GameState received;
+
+        cp.receive_snapshot(received);
+        ASSERT_EQ(received.players.size(), 2u);
+        EXPECT_NE(received.roster, roster);
+        EXPECT_EQ(received.username_of(received.players[0]), "Alpha");
+        EXPECT_EQ(received.players[1].player_id, 4);
+        EXPECT_EQ(received.username_of(received.players[1]), "Bravo");
+        EXPECT_EQ(received.car_name_of(received.players[1]), "Brisa");
+        EXPECT_EQ(received.car_type_of(received.players[1]), "sport");
+        EXPECT_EQ(received.players[1].car_id, 4);
+        EXPECT_FLOAT_EQ(received.players[1].pos_x, 20.0f);
+    });
+
+    client_thread.join();
+    server_thread.join();
+}
+
+TEST(GameStateSnapshotTest, EncodedSnapshotSharedAcrossClients) {
+    // Un encode por tick: los clientes con la misma base reciben el mismo buffer
+    SnapshotEncoder encoder;
+    GameState state;
+    InfoPlayer p;
+    p.player_id = 3;
+    p.username = "Shared";
+    p.car_name = "Brisa";
+    state.players.push_back(p);
+
+    SnapshotHandle first = encoder.encode(state);
+    state.players[0].pos_x = 50.0f;
+    SnapshotHandle second = encoder.encode(state);
+
+    SnapshotStream up_to_date, late;
+    up_to_date.message_for(*first);
+    up_to_date.acknowledge(first->get_sequence());
+
+    // El manifest no cambió entre ticks: se manda una sola vez por cliente
+    EXPECT_NE(up_to_date.manifest_for(*first), nullptr);
+    EXPECT_EQ(up_to_date.manifest_for(*second), nullptr);
+
+    const std::vector<uint8_t>& delta = up_to_date.message_for(*second);
+    const std::vector<uint8_t>& keyframe = late.message_for(*second);
+    EXPECT_LT(delta.size(), keyframe.size());
+
+    SnapshotStream other_up_to_date, other_late;
+    other_up_to_date.message_for(*first);
+    other_up_to_date.acknowledge(first->get_sequence());
+    EXPECT_EQ(&other_up_to_date.message_for(*second), &delta);
+    EXPECT_EQ(&other_late.message_for(*second), &keyframe);
+}
+
+TEST(GameStateSnapshotTest, AreaOfInterestKeepsRankingOfDistantPlayers) {
+    // Un auto lejano no manda posición, pero su progreso sigue llegando para el ranking
+    SnapshotEncoder encoder;
+    encoder.set_interest(600.0f, 1000.0f, 4);
+    GameState state;
+    InfoPlayer viewer, near, distant;
+    viewer.player_id = 1;
+    near.player_id = 2;
+    near.pos_x = 300.0f;
+    distant.player_id = 3;
+    distant.pos_x = 5000.0f;
+    distant.completed_laps = 2;
+    distant.position_in_race = 1;
+    state.players = {viewer, near, distant};
+
+    SnapshotStream viewer_stream, everything;
+    viewer_stream.set_viewer(1);
+    SnapshotHandle snapshot = encoder.encode(state);
+    EXPECT_LT(viewer_stream.message_for(*snapshot).size(),
+              everything.message_for(*snapshot).size());
+
+    std::thread server_thread([&]() {
+        Socket server_socket(kPort);
+        Socket client_conn = server_socket.accept();
+        ServerProtocol sp(client_conn);
+        EXPECT_TRUE(sp.send_client_id(1));
+        EXPECT_TRUE(sp.send_snapshot(*snapshot));
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kDelay));
+
+    std::thread client_thread([&]() {
+        ClientProtocol cp(kHost, kPort);
+        EXPECT_EQ(cp.receive_client_id(), 1);
+        GameState received;
+        cp.receive_snapshot(received);
+        ASSERT_EQ(received.players.size(), 3u);
+        EXPECT_TRUE(received.players[1].in_view);
+        EXPECT_FLOAT_EQ(received.players[1].pos_x, 300.0f);
+        EXPECT_FALSE(received.players[2].in_view);
+        EXPECT_EQ(received.players[2].completed_laps, 2);
+        EXPECT_EQ(received.players[2].position_in_race, 1);
+    });
+
+    client_thread.join();
+    server_thread.join();
+}
+
+TEST(SnapshotMailboxTest, SlowConsumerOnlySeesLatest) {
+    // Un cliente lento no acumula snapshots: el más nuevo pisa al que no se envió
+    Mailbox<SnapshotHandle> mailbox;
+    SnapshotEncoder encoder;
+    GameState state;
+
+    SnapshotHandle last;
+    for (int i = 0; i < 5; ++i) {
+        last = encoder.encode(state);
+        mailbox.try_push(last);
+    }
+
+    EXPECT_EQ(mailbox.pop(), last);
+    SnapshotHandle none;
+    EXPECT_FALSE(mailbox.try_pop(none));
+
+    MailboxStats stats = mailbox.stats();
+    EXPECT_EQ(stats.delivered, 1u);
+    EXPECT_EQ(stats.dropped, 4u);
+    EXPECT_EQ(stats.coalesced, 1u);
+
+    mailbox.close();
+    EXPECT_THROW(mailbox.pop(), ClosedQueue);
+}
+
+TEST(BufferedReaderTest, CommandsBatchedInOneSendAreAllRead) {
+    // Varios comandos en un solo segmento: el receptor los sirve desde su buffer
+    std::thread server_thread([&]() {
+        Socket server_socket(kPort);
+        Socket client_conn = server_socket.accept();
+        ServerProtocol server_protocol(client_conn);
+
+        ComandMatchDTO cmd;
+        ASSERT_TRUE(server_protocol.read_command_client(cmd));
+        EXPECT_EQ(cmd.command, GameCommand::ACCELERATE);
+        ASSERT_TRUE(server_protocol.read_command_client(cmd));
+        EXPECT_EQ(cmd.command, GameCommand::TURN_RIGHT);
+        EXPECT_FLOAT_EQ(cmd.turn_intensity, 0.50f);
+        ASSERT_TRUE(server_protocol.read_command_client(cmd));
+        EXPECT_EQ(cmd.command, GameCommand::UPGRADE_SPEED);
+        EXPECT_EQ(cmd.upgrade_level, 2);
+        EXPECT_EQ(cmd.upgrade_cost_ms, 1500);
+
+        // El cliente cerró: no hay más comandos
+        EXPECT_FALSE(server_protocol.read_command_client(cmd));
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kDelay));
+
+    std::thread client_thread([&]() {
+        Socket client_socket(kHost, kPort);
+        const uint8_t batch[] = {CMD_ACCELERATE, CMD_TURN_RIGHT, 50, CMD_UPGRADE_SPEED, 2,
+                                 0x05, 0xDC};
+        client_socket.sendall(batch, sizeof(batch));
+    });
+
+    client_thread.join();
+    server_thread.join();
+}
+
+TEST(BufferedReaderTest, FrameReaderRejectsTruncatedFrame) {
+    const std::vector<uint8_t> frame = {0x00, 0x05, 'a', 'b'};  // string de 5 con 2 bytes
+    FrameReader in(frame);
+    EXPECT_THROW(in.read_string(), std::runtime_error);
+}
+
+TEST(OutboundMessageTest, GatherWriteKeepsFieldOrder) {
+    // Campos en el arena y bloques referenciados salen intercalados en orden
+    const std::string long_path(200, 'p');
+    const std::vector<uint8_t> encoded = {0xAA, 0xBB, 0xCC};
+
+    std::thread server_thread([&]() {
+        Socket server_socket(kPort);
+        Socket client_conn = server_socket.accept();
+        OutboundMessage message;
+        for (int round = 0; round < 2; ++round) {  // el arena se reutiliza
+            message.clear();
+            message.put_uint8(0x07);
+            message.put_string("city");
+            message.put_string(long_path);
+            message.put_ref(encoded);
+            message.put_uint32(42);
+            EXPECT_EQ(message.size(), 1u + 6u + 202u + 3u + 4u);
+            EXPECT_EQ(message.send(client_conn), static_cast<int>(message.size()));
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kDelay));
+
+    std::thread client_thread([&]() {
+        Socket client_socket(kHost, kPort);
+        BufferedReader inbound(client_socket);
+        for (int round = 0; round < 2; ++round) {
+            std::vector<uint8_t> bytes(216);
+            ASSERT_EQ(inbound.recvall(bytes.data(), bytes.size()), 216);
+            FrameReader in(bytes);
+            EXPECT_EQ(in.read_uint8(), 0x07);
+            EXPECT_EQ(in.read_string(), "city");
+            EXPECT_EQ(in.read_string(), long_path);
+            EXPECT_EQ(in.read_uint8(), 0xAA);
+            EXPECT_EQ(in.read_uint16(), 0xBBCC);
+            EXPECT_EQ(in.read_uint32(), 42u);
+            EXPECT_EQ(in.remaining(), 0u);
+        }
+    });
+
+    client_thread.join();
+    server_thread.join();
+}
+
+// TESTS DEL FORMATO COMPACTO (CUANTIZACIÓN Y FLUJO DE BITS)
+
+TEST(CompactSnapshotCodecTest, EveryAngleCodeRoundTrips) {
+    for (uint32_t q = 0; q < (1u << SNAPSHOT_ANGLE_BITS); ++q) {
+        const float angle = SnapshotCodec::dequantize_angle(static_cast<uint16_t>(q));
+        ASSERT_GE(angle, 0.0f);
+        ASSERT_LT(angle, 6.28318530718f);
+        ASSERT_EQ(SnapshotCodec::quantize_angle(angle), q);
+    }
+}
+
+TEST(CompactSnapshotCodecTest, AnglesWrapIntoFullTurn) {
+    // Antes `angle * 100` casteado a uint16_t rompía los negativos
+    const float two_pi = 6.28318530718f;
+    for (int i = -4000; i <= 4000; ++i) {
+        const float angle = static_cast<float>(i) * 0.005f;  // [-20, 20] rad
+        const float decoded = SnapshotCodec::dequantize_angle(SnapshotCodec::quantize_angle(angle));
+        float error = std::fmod(std::fabs(decoded - angle), two_pi);
+        error = std::min(error, two_pi - error);
+        ASSERT_LE(error, kAngleTolerance) << "angle " << angle;
+    }
+}
+
+TEST(CompactSnapshotCodecTest, PositionsWithinHalfStepOfMapBounds) {
+    SnapshotCodec::Bounds bounds;
+    bounds.width = 4640.0f;
+    bounds.height = 4672.0f;
+    for (int i = 0; i < 46400; ++i) {
+        const float x = static_cast<float>(i) * 0.1f;
+        const float step = bounds.width / 65536.0f;
+        ASSERT_NEAR(bounds.dequantize_x(bounds.quantize_x(x)), x, step / 2.0f + 1e-3f) << x;
+        const float y = x * bounds.height / bounds.width;
+        ASSERT_NEAR(bounds.dequantize_y(bounds.quantize_y(y)), y, step / 2.0f + 1e-3f) << y;
+    }
+    // Fuera del mapa se recorta a los bordes
+    EXPECT_EQ(bounds.quantize_x(-50.0f), 0);
+    EXPECT_EQ(bounds.quantize_x(99999.0f), 65535);
+}
+
+TEST(CompactSnapshotCodecTest, BitStreamRoundTripsFieldsAndVarints) {
+    std::vector<int32_t> values = {0, 1, -1, 63, -64, 64, 127, 128, -129, 16383, 16384,
+                                   INT32_MAX, INT32_MIN};
+    for (int shift = 0; shift < 31; ++shift) {
+        values.push_back(1 << shift);
+        values.push_back(-(1 << shift));
+        values.push_back((1 << shift) - 1);
+    }
+
+    std::vector<uint8_t> buffer;
+    SnapshotCodec::BitWriter writer(buffer);
+    for (size_t i = 0; i < values.size(); ++i) {
+        writer.put(static_cast<uint32_t>(i) & 0x3F, 6);  // campos que no caen en bytes
+        writer.put_signed(values[i]);
+        writer.put_varint(static_cast<uint32_t>(values[i]));
+        writer.put(static_cast<uint32_t>(values[i]), 32);
+    }
+    writer.align();
+
+    FrameReader in(buffer);
+    SnapshotCodec::BitReader<FrameReader> reader(in);
+    for (size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQ(reader.get(6), static_cast<uint32_t>(i) & 0x3F);
+        ASSERT_EQ(reader.get_signed(), values[i]);
+        ASSERT_EQ(reader.get_varint(), static_cast<uint32_t>(values[i]));
+        ASSERT_EQ(reader.get(32), static_cast<uint32_t>(values[i]));
+    }
+    reader.align();
+    EXPECT_EQ(in.remaining(), 0u);
+}
+
+TEST(CompactSnapshotCodecTest, DecodingReusesTheSameBuffers) {
+    SnapshotEncoder encoder;
+    SnapshotStream stream;
+    SnapshotDecoder decoder;
+    GameState state;
+    for (int i = 0; i < 4; ++i) {
+        InfoPlayer p;
+        p.player_id = i + 1;
+        p.pos_y = 100.0f * (i + 1);
+        state.players.push_back(p);
+    }
+
+    // Sin el byte de tipo ni el largo, como los lee ClientProtocol
+    auto body = [](const std::vector<uint8_t>& message) {
+        return std::vector<uint8_t>(message.begin() + 5, message.end());
+    };
+
+    // Dos vueltas al historial: los frames del anillo se pisan con vectores reciclados
+    GameState decoded;
+    const InfoPlayer* players_data = nullptr;
+    for (int tick = 0; tick < 2 * SNAPSHOT_HISTORY; ++tick) {
+        for (InfoPlayer& p : state.players) p.pos_x = 10.0f + tick * p.player_id;
+        SnapshotHandle snapshot = encoder.encode(state);
+        if (const std::vector<uint8_t>* manifest = stream.manifest_for(*snapshot)) {
+            const std::vector<uint8_t> manifest_body = body(*manifest);
+            FrameReader in(manifest_body);
+            decoder.read_manifest(in);
+        }
+        const std::vector<uint8_t> message = body(stream.message_for(*snapshot));
+        FrameReader in(message);
+        uint32_t sequence = 0;
+        ASSERT_TRUE(decoder.decode(in, decoded, sequence));
+        stream.acknowledge(sequence);
+
+        ASSERT_EQ(decoded.players.size(), 4u);
+        if (tick == 0) players_data = decoded.players.data();
+        EXPECT_EQ(decoded.players.data(), players_data) << "tick " << tick;
+        for (const InfoPlayer& p : decoded.players) {
+            EXPECT_NEAR(p.pos_x, 10.0f + tick * p.player_id, kPositionTolerance);
+        }
+    }
+}
+
+TEST(CompactSnapshotCodecTest, MovingPlayerCostsFewBytesPerSnapshot) {
+    // Un auto en movimiento: posición, ángulo, velocidad y tiempos cambian cada tick
+    SnapshotEncoder encoder;
+    encoder.set_bounds(4640.0f, 4672.0f);
+    GameState state;
+    for (int i = 0; i < 8; ++i) {
+        InfoPlayer p;
+        p.player_id = i + 1;
+        p.pos_x = 1000.0f + 40.0f * i;
+        p.pos_y = 2000.0f;
+        p.speed = 150.0f;
+        p.velocity_x = 150.0f;
+        p.race_time_ms = 10000;
+        p.total_time_ms = 10000;
+        state.players.push_back(p);
+    }
+    SnapshotHandle first = encoder.encode(state);
+    for (InfoPlayer& p : state.players) {
+        p.pos_x += 2.5f;
+        p.angle -= 0.02f;  // negativo: antes se rompía al cuantizar
+        p.speed += 1.0f;
+        p.velocity_x += 1.0f;
+        p.race_time_ms += 16;
+        p.total_time_ms += 16;
+    }
+    SnapshotHandle second = encoder.encode(state);
+
+    SnapshotStream stream;
+    const size_t keyframe = stream.message_for(*first).size();
+    stream.acknowledge(first->get_sequence());
+    const size_t delta = stream.message_for(*second).size();
+
+    // Antes: 31 bytes por jugador en movimiento (slot, máscara, int32 y u16 fijos)
+    const size_t header = 1 + 4 + 4 + 4;  // tipo, largo, secuencia, base
+    EXPECT_LE(delta - header, 8u * 31u / 2u);
+    EXPECT_LT(delta, keyframe);
+}
+
+TEST(DatagramChannelTest, AckBitsConfirmOnlyReceivedPackets) {
+    // El 3 se pierde: el ack del 5 confirma 1, 2, 4 y 5 en una sola cabecera
+    PacketTracker sender, receiver;
+    for (uint32_t tag = 10; tag < 15; ++tag) sender.register_sent(tag);
+    for (uint16_t sequence : {1, 2, 4, 5}) EXPECT_TRUE(receiver.mark_received(sequence));
+    EXPECT_FALSE(receiver.mark_received(4));  // duplicado
+    EXPECT_TRUE(receiver.is_fresh(3));        // llegó tarde pero está en la ventana
+
+    EXPECT_EQ(receiver.ack(), 5);
+    EXPECT_EQ(receiver.ack_bits(), 0b1101u);
+
+    std::vector<uint32_t> acked;
+    sender.acknowledge(receiver.ack(), receiver.ack_bits(), acked);
+    EXPECT_EQ(acked, (std::vector<uint32_t>{10, 11, 13, 14}));
+
+    // Cada envío se confirma una sola vez aunque el ack se repita
+    acked.clear();
+    sender.acknowledge(receiver.ack(), receiver.ack_bits(), acked);
+    EXPECT_TRUE(acked.empty());
+}
+
+TEST(DatagramChannelTest, SnapshotsMoveToDatagramsAfterManifest) {
+    // El primer snapshot (con manifest) va por TCP; confirmado, los siguientes van por UDP
+    std::atomic<bool> done(false);
+
+    std::thread server_thread([&]() {
+        Socket server_socket(kPort);
+        Socket client_conn = server_socket.accept();
+        ServerProtocol sp(client_conn, true);
+        ASSERT_TRUE(sp.send_client_id(1));
+
+        std::thread reader([&]() {
+            ComandMatchDTO cmd;
+            while (sp.read_command_client(cmd)) {
+                if (cmd.command == GameCommand::DISCONNECT) break;
+            }
+        });
+
+        SnapshotEncoder encoder;
+        GameState state;
+        InfoPlayer player;
+        player.player_id = 1;
+        for (int i = 1; !done && i < 2000; ++i) {
+            player.pos_x = static_cast<float>(i);
+            state.players = {player};
+            sp.send_snapshot(*encoder.encode(state));
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        reader.join();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kDelay));
+
+    std::thread client_thread([&]() {
+        ClientProtocol cp(kHost, kPort);
+        ASSERT_EQ(cp.receive_client_id(), 1);
+
+        float last_x = 0.0f;
+        for (int i = 0; i < 200 && !cp.using_datagrams(); ++i) {
+            GameState received;
+            cp.receive_snapshot(received);
+            ASSERT_EQ(received.players.size(), 1u);
+            EXPECT_GT(received.players[0].pos_x, last_x);  // nunca vuelve atrás
+            last_x = received.players[0].pos_x;
+        }
+        EXPECT_TRUE(cp.using_datagrams());
+
+        // Por UDP siguen llegando deltas completos y en orden
+        for (int i = 0; i < 20; ++i) {
+            GameState received;
+            cp.receive_snapshot(received);
+            ASSERT_EQ(received.players.size(), 1u);
+            EXPECT_GT(received.players[0].pos_x, last_x);
+            last_x = received.players[0].pos_x;
+        }
+
+        done = true;
+        ComandMatchDTO disconnect = {};
+        disconnect.command = GameCommand::DISCONNECT;
+        cp.send_command_client(disconnect);
+    });
+
+    client_thread.join();
+    server_thread.join();
+}
+
+TEST(DatagramChannelTest, MovementInputsSurviveLossWithRedundancy) {
+    // Con la mitad de los datagramas perdidos, cada comando viaja en varios y casi todos
+    // llegan, una sola vez y en orden
+    constexpr int kInputs = 40;
+    std::atomic<bool> done(false);
+    std::vector<int> received_inputs;
+
+    std::thread server_thread([&]() {
+        Socket server_socket(kPort);
+        Socket client_conn = server_socket.accept();
+        ServerProtocol sp(client_conn, true);
+        sp.simulate_network(0.5f, 0, 1234);
+        ASSERT_TRUE(sp.send_client_id(1));
+
+        std::thread reader([&]() {
+            ComandMatchDTO cmd;
+            while (sp.read_command_client(cmd)) {
+                if (cmd.command == GameCommand::DISCONNECT) break;
+                if (cmd.command != GameCommand::TURN_LEFT) continue;
+                received_inputs.push_back(static_cast<int>(std::lround(cmd.turn_intensity * 100)));
+            }
+            done = true;
+        });
+
+        SnapshotEncoder encoder;
+        GameState state;
+        InfoPlayer player;
+        player.player_id = 1;
+        state.players = {player};
+        while (!done) {
+            sp.send_snapshot(*encoder.encode(state));
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        reader.join();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kDelay));
+
+    ClientProtocol cp(kHost, kPort);
+    ASSERT_EQ(cp.receive_client_id(), 1);
+    std::thread receiver([&]() {
+        try {
+            GameState ignored;
+            while (true) cp.receive_snapshot(ignored);
+        } catch (const std::exception&) {
+            // El servidor cerró la conexión
+        }
+    });
+
+    for (int i = 0; i < 500 && !cp.using_datagrams(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    ASSERT_TRUE(cp.using_datagrams());
+
+    for (int i = 1; i <= kInputs; ++i) {
+        ComandMatchDTO turn = {};
+        turn.command = GameCommand::TURN_LEFT;
+        turn.turn_intensity = (static_cast<float>(i) + 0.5f) / 100.0f;  // el protocolo trunca
+        cp.send_command_client(turn);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(kDelay));
+
+    ComandMatchDTO disconnect = {};
+    disconnect.command = GameCommand::DISCONNECT;
+    cp.send_command_client(disconnect);
+    server_thread.join();
+    cp.shutdown_socket();
+    receiver.join();
+
+    // Sin redundancia llegaría la mitad; con INPUT_REDUNDANCY se pierde muy poco
+    EXPECT_GE(received_inputs.size(), static_cast<size_t>(kInputs * 3 / 4));
+    for (size_t i = 1; i < received_inputs.size(); ++i)
+        EXPECT_LT(received_inputs[i - 1], received_inputs[i]);
+}
+
+namespace {
+// Handler mínimo: cuenta lo que recibe y cierra cuando el cliente cierra
+class CountingHandler : public ReactorHandler {
+public:
+    Socket socket;
+    std::atomic<int> bytes{0};
+    std::atomic<int> wakes{0};
+    std::atomic<bool> closed{false};
+
+    explicit CountingHandler(Socket socket) : socket(std::move(socket)) {}
+
+    bool on_ready(uint32_t events) override {
+        if (events & REACTOR_WAKE) wakes++;
+        if (events & REACTOR_READ) {
+            char byte;
+            if (socket.recvsome(&byte, 1) == 0) {
+                closed = true;
+                return false;
+            }
+            bytes++;
+        }
+        return true;
+    }
+};
+
+}  // namespace
+
+TEST(ReactorTest, ManyIdleConnectionsServedByTwoWorkers) {
+    // Cien conexiones ociosas no ocupan hilos; las que hablan se atienden igual
+    constexpr int kConnections = 100;
+    Reactor reactor(2);
+    reactor.start();
+
+    Socket server_socket(kPort);
+    std::vector<Socket> clients;
+    std::vector<std::unique_ptr<CountingHandler>> handlers;
+    for (int i = 0; i < kConnections; ++i) {
+        clients.emplace_back(kHost, kPort);
+        handlers.push_back(std::make_unique<CountingHandler>(server_socket.accept()));
+        reactor.add(*handlers.back(), handlers.back()->socket);
+    }
+
+    const char ping = 'x';
+    clients[3].sendall(&ping, 1);
+    clients[50].sendall(&ping, 1);
+    clients[50].sendall(&ping, 1);
+    clients[99].sendall(&ping, 1);
+    EXPECT_TRUE(wait_until([&] {
+        return handlers[3]->bytes == 1 && handlers[50]->bytes == 2 && handlers[99]->bytes == 1;
+    }));
+    EXPECT_EQ(handlers[0]->bytes, 0);
+
+    // Los notify se agendan aunque el socket no tenga nada
+    reactor.notify(*handlers[7]);
+    EXPECT_TRUE(wait_until([&] { return handlers[7]->wakes >= 1; }));
+
+    // El cierre del cliente llega como lectura y el handler se da de baja solo
+    clients[10].shutdown(SHUT_RDWR);
+    EXPECT_TRUE(wait_until([&] { return handlers[10]->closed.load(); }));
+
+    for (auto& handler : handlers) reactor.remove(*handler);
+}
+
+TEST(ServerProtocolTest, OfferedSnapshotsNeverBlockOnSlowClient) {
+    // Con un cliente que no lee, offer_snapshot deja el resto pendiente en vez de bloquear
+    std::atomic<bool> filled(false);
+    int32_t last_time = -1;
+
+    GameState state;
+    for (int i = 0; i < 100; ++i) {
+        InfoPlayer p;
+        p.player_id = i + 1;
+        p.username = "Player" + std::to_string(i);
+        p.pos_x = static_cast<float>(i * 10);
+        state.players.push_back(p);
+    }
+
+    std::thread server_thread([&]() {
+        Socket server_socket(kPort);
+        Socket client_conn = server_socket.accept();
+        ServerProtocol sp(client_conn);
+        SnapshotEncoder encoder;
+
+        auto slowest = std::chrono::steady_clock::duration::zero();
+        for (int i = 0; i < 200000 && !sp.has_pending(); ++i) {
+            state.race_info.remaining_time_ms = 100000 + i;
+            SnapshotHandle snapshot = encoder.encode(state);
+            const auto start = std::chrono::steady_clock::now();
+            EXPECT_TRUE(sp.offer_snapshot(*snapshot));
+            slowest = std::max(slowest, std::chrono::steady_clock::now() - start);
+        }
+        EXPECT_TRUE(sp.has_pending());
+        EXPECT_LT(slowest, std::chrono::milliseconds(100));
+        filled = true;
+
+        // El resto sale a medida que el cliente lee; después, un snapshot reconocible
+        while (sp.has_pending()) {
+            EXPECT_TRUE(sp.flush_pending());
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        state.race_info.remaining_time_ms = 42;
+        EXPECT_TRUE(sp.send_snapshot(*encoder.encode(state)));
+        std::this_thread::sleep_for(std::chrono::milliseconds(kDelay));
+        client_conn.shutdown(SHUT_RDWR);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kDelay));
+
+    std::thread client_thread([&]() {
+        ClientProtocol cp(kHost, kPort);
+        while (!filled) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        try {
+            while (true) {
+                GameState received;
+                cp.receive_snapshot(received);
+                ASSERT_EQ(received.players.size(), 100u);
+                last_time = received.race_info.remaining_time_ms;
+            }
+        } catch (const std::exception&) {
+            // El servidor cerró la conexión
+        }
+    });
+
+    client_thread.join();
+    server_thread.join();
+    EXPECT_EQ(last_time, 42);
+}
+
+TEST(ServerProtocolTest, LobbyRepliesNeverBlockOnSlowClient) {
+    // Mensajes del lobby por un socket no bloqueante: lo que no entra queda pendiente
+    Socket server_socket(kPort);
+    Socket client(kHost, kPort);
+    Socket conn = server_socket.accept();
+    ServerProtocol sp(conn);
+    sp.set_nonblocking();
+
+    std::vector<uint8_t> expected;
+    std::vector<uint8_t> message(1024);
+    auto slowest = std::chrono::steady_clock::duration::zero();
+    for (int i = 0; i < 100000 && !sp.has_pending(); ++i) {
+        std::fill(message.begin(), message.end(), static_cast<uint8_t>(i));
+        const auto start = std::chrono::steady_clock::now();
+        sp.send_buffer(message);
+        slowest = std::max(slowest, std::chrono::steady_clock::now() - start);
+        expected.insert(expected.end(), message.begin(), message.end());
+    }
+    ASSERT_TRUE(sp.has_pending());
+
+    // Detrás de uno a medias los siguientes se encolan enteros, en orden
+    for (int i = 0; i < 4; ++i) {
+        std::fill(message.begin(), message.end(), static_cast<uint8_t>(0xA0 + i));
+        sp.send_buffer(message);
+        expected.insert(expected.end(), message.begin(), message.end());
+    }
+    EXPECT_LT(slowest, std::chrono::milliseconds(100));
+
+    // El cliente lee todo mientras el servidor completa lo pendiente
+    std::vector<uint8_t> received(expected.size());
+    std::thread reader([&] { client.recvall(received.data(), received.size()); });
+    while (sp.has_pending()) {
+        ASSERT_TRUE(sp.flush_pending());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    reader.join();
+    EXPECT_TRUE(received == expected);
+}
+
+TEST(ServerProtocolTest, PartialMessagesWaitInTheBuffer) {
+    // Como en el reactor: socket no bloqueante, solo se leen los mensajes que llegaron enteros
+    Socket server_socket(kPort);
+    Socket client(kHost, kPort);
+    Socket conn = server_socket.accept();
+    conn.set_nonblocking();
+    ServerProtocol sp(conn);
+    auto receive = [&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(kDelay));
+        return sp.receive_available();
+    };
+
+    std::vector<uint8_t> stream = LobbyProtocol::serialize_select_car("Ferrari", "sport");
+    const size_t lobby_size = stream.size();
+    const std::vector<uint8_t> commands = {CMD_SNAPSHOT_ACK, 0, 0, 0, 9,
+                                           CMD_INPUT_STATE,  INPUT_UP, 0, 0, 0, 7};
+    stream.insert(stream.end(), commands.begin(), commands.end());
+
+    EXPECT_TRUE(sp.receive_available());  // todavía no llegó nada: no espera
+    EXPECT_FALSE(sp.has_lobby_message());
+
+    client.sendall(stream.data(), 5);
+    ASSERT_TRUE(receive());
+    EXPECT_FALSE(sp.has_lobby_message());
+
+    // El resto del mensaje de lobby y la mitad de los comandos
+    client.sendall(stream.data() + 5, static_cast<unsigned int>(lobby_size - 5 + 8));
+    ASSERT_TRUE(receive());
+    ASSERT_TRUE(sp.has_lobby_message());
+    EXPECT_EQ(sp.read_message_type(), MSG_SELECT_CAR);
+    EXPECT_EQ(sp.read_string(), "Ferrari");
+    EXPECT_EQ(sp.read_string(), "sport");
+
+    // El ack ya está entero y se consume; el INPUT_STATE todavía no
+    EXPECT_TRUE(sp.consume_control_messages());
+    EXPECT_FALSE(sp.has_match_message());
+
+    client.sendall(stream.data() + lobby_size + 8, 3);
+    ASSERT_TRUE(receive());
+    ASSERT_TRUE(sp.has_match_message());
+    ComandMatchDTO command;
+    ASSERT_TRUE(sp.read_command_client(command));
+    EXPECT_EQ(command.command, GameCommand::INPUT_STATE);
+    EXPECT_EQ(command.input_bits, INPUT_UP);
+    EXPECT_EQ(command.input_sequence, 7u);
+
+    client.shutdown(SHUT_WR);
+    EXPECT_FALSE(receive());
+}
+
+TEST(ClockSyncTest, PingAnsweredInsideProtocolAndMeasured) {
+    std::thread server_thread([&]() {
+        Socket server_socket(kPort);
+        Socket client_conn = server_socket.accept();
+        ServerProtocol sp(client_conn);
+
+        GameState state;
+        InfoPlayer p;
+        p.player_id = 1;
+        state.players.push_back(p);
+        // El PONG informa el tick de simulación, no la secuencia del snapshot (que
+        // arrastra la época del encoder en los bits altos)
+        SnapshotEncoder encoder;
+        EXPECT_TRUE(sp.send_snapshot(*encoder.encode(state, 1234)));
+
+        // El ping se contesta adentro: read_command_client devuelve el comando siguiente
+        ComandMatchDTO command;
+        ASSERT_TRUE(sp.read_command_client(command));
+        EXPECT_EQ(command.command, GameCommand::DISCONNECT);
+        EXPECT_EQ(sp.link_stats().samples, 1u);
+
+        EXPECT_TRUE(sp.send_snapshot(*encoder.encode(state, 1235)));
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kDelay));
+
+    std::thread client_thread([&]() {
+        ClientProtocol cp(kHost, kPort);
+        // Sin snapshots el servidor puede estar todavía en el lobby: no se pingea
+        GameState received;
+        cp.receive_snapshot(received);
+        EXPECT_EQ(received.players.size(), 1u);
+
+        // Ya en partida, receive_snapshot manda un ping; el PONG llega antes que el snapshot
+        std::thread receiver([&]() { cp.receive_snapshot(received); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(kDelay));
+
+        ComandMatchDTO bye;
+        bye.command = GameCommand::DISCONNECT;
+        cp.send_command_client(bye);
+        receiver.join();
+
+        EXPECT_EQ(received.players.size(), 1u);
+        const LinkStats link = cp.link_stats();
+        EXPECT_EQ(link.samples, 1u);
+        EXPECT_EQ(link.server_tick, 1234u);
+        EXPECT_GE(link.rtt_ms, 0.0f);
+        EXPECT_LT(link.rtt_ms, 100.0f);
+        EXPECT_LT(std::fabs(link.clock_offset_ms), 50.0f);  // mismo reloj en ambos extremos
+    });
+
+    client_thread.join();
+    server_thread.join();
+}
+
+TEST(ClockSyncTest, EstimatesRttOffsetAndServerTick) {
+    // Servidor 5 ms adelantado, 10 ms de ida, 14 ms de vuelta y 1 ms de proceso
+    ClockSync sync;
+    const uint64_t server_ahead = 5000;
+    uint32_t tick = 600;
+    for (uint64_t t0 = 1000000; t0 < 3000000; t0 += 100000) {
+        const uint64_t t1 = t0 + 10000 + server_ahead;
+        const uint64_t t2 = t1 + 1000;
+        const uint64_t t3 = t2 - server_ahead + 14000;
+        sync.on_pong(t0, t1, t2, t3, tick);
+        tick += 6;  // 60 ticks por segundo
+    }
+
+    const LinkStats link = sync.stats(3000000);
+    EXPECT_EQ(link.samples, 20u);
+    EXPECT_NEAR(link.rtt_ms, 24.0f, 1e-3f);
+    EXPECT_NEAR(link.jitter_ms, 0.0f, 1e-3f);
+    // Con ida y vuelta asimétricas el offset queda corrido la mitad de la diferencia
+    EXPECT_NEAR(link.clock_offset_ms, 5.0f - 2.0f, 1e-2f);
+
+    // Último pong: tick 714 en la hora de servidor 2.916 s; 3 s locales son 3.003 s del servidor
+    EXPECT_NEAR(static_cast<double>(link.server_tick), 714.0 + 0.087 * 60.0, 1.0);
+
+    // Un pong demorado sube el RTT y el jitter, pero no mueve el offset
+    sync.on_pong(3100000, 3115000, 3116000, 3300000, tick);
+    const LinkStats late = sync.stats(3300000);
+    EXPECT_GT(late.rtt_ms, link.rtt_ms);
+    EXPECT_GT(late.jitter_ms, 0.0f);
+    EXPECT_NEAR(late.clock_offset_ms, link.clock_offset_ms, 1e-3f);
+}
+
+TEST(CarPredictionTest, ReconcileReplaysUnconfirmedInputs) {
+    // El "servidor": el mismo Car y los mismos kernels que GameLoop, sin paredes
+    auto bits_for = [](uint32_t sequence) -> uint8_t {
+        if (sequence <= 10) return INPUT_UP;
+        if (sequence <= 20) return INPUT_LEFT;
+        if (sequence <= 25) return 0;  // soltar todo frena en seco
+        return INPUT_DOWN | INPUT_NITRO;
+    };
+    const float dt = 1.0f / 60.0f;
+    CarPhysicsPool pool;
+    Car server_car("Predicted", "classic");
+    server_car.attach_physics(pool);
+    const CarModel& model = CarCatalog::instance().get(CarCatalog::UNKNOWN_CAR);
+    server_car.load_stats(model.max_speed, model.accel_power, model.turn_rate, model.health,
+                          model.nitro_boost, model.mass);
+    server_car.setPosition(1000.0f, 1000.0f);
+    uint8_t server_bits = 0;
+    auto server_tick = [&](uint32_t sequence) {
+        server_car.apply_input(bits_for(sequence), server_bits, dt);
+        server_bits = bits_for(sequence);
+        pool.integrate(dt);
+        pool.clamp_to_bounds(MAP_LIMIT_X, MAP_LIMIT_Y);
+    };
+    auto server_state = [&](uint32_t last_input) {
+        GameState state;
+        InfoPlayer own;
+        own.player_id = 1;
+        own.car_id = CarCatalog::UNKNOWN_CAR;
+        own.pos_x = server_car.getX();
+        own.pos_y = server_car.getY();
+        own.angle = server_car.getAngle();
+        own.speed = server_car.getCurrentSpeed();
+        own.velocity_x = server_car.getVelocityX();
+        own.velocity_y = server_car.getVelocityY();
+        own.nitro_amount = server_car.getNitroAmount();
+        own.nitro_active = server_car.isNitroActive();
+        own.last_input = last_input;
+        state.players.push_back(own);
+        return state;
+    };
+
+    CarPredictor predictor;
+    predictor.reconcile(server_state(0), 1);
+    for (uint32_t sequence = 1; sequence <= 30; ++sequence) {
+        predictor.predict(sequence, bits_for(sequence));
+    }
+
+    // El servidor va 10 inputs atrás: la predicción se rehace sobre su estado
+    for (uint32_t sequence = 1; sequence <= 20; ++sequence) server_tick(sequence);
+    predictor.reconcile(server_state(20), 1);
+    EXPECT_EQ(predictor.pending_inputs(), 10u);
+
+    for (uint32_t sequence = 21; sequence <= 30; ++sequence) server_tick(sequence);
+    GameState view = server_state(20);
+    view.players[0].pos_x = view.players[0].pos_y = 0.0f;
+    predictor.apply_to(view, 1);
+    EXPECT_NEAR(view.players[0].pos_x, server_car.getX(), 1e-3f);
+    EXPECT_NEAR(view.players[0].pos_y, server_car.getY(), 1e-3f);
+    EXPECT_NEAR(view.players[0].speed, server_car.getCurrentSpeed(), 1e-3f);
+
+    // Un empujón que el cliente no predijo (p. ej. otro auto) se corrige con el snapshot
+    server_car.setPosition(server_car.getX() + 30.0f, server_car.getY());
+    predictor.reconcile(server_state(30), 1);
+    EXPECT_EQ(predictor.pending_inputs(), 0u);
+    predictor.apply_to(view, 1);
+    EXPECT_NEAR(view.players[0].pos_x, server_car.getX(), 1e-3f);
+}
+
+TEST(SnapshotInterpolationTest, RemoteCarsRenderBetweenSnapshots) {
+    using namespace std::chrono;
+    const auto t0 = steady_clock::time_point{} + seconds(10);
+    auto snapshot_at = [&](int ms, float x, float angle) {
+        GameState state;
+        InfoPlayer own;
+        own.player_id = 1;
+        own.pos_x = 999.0f;
+        InfoPlayer remote;
+        remote.player_id = 2;
+        remote.pos_x = x;
+        remote.angle = angle;
+        remote.velocity_x = 500.0f;
+        state.players = {own, remote};
+        state.received_at = t0 + milliseconds(ms);
+        return state;
+    };
+
+    SnapshotInterpolator interpolator;
+    interpolator.set_delay(milliseconds(100));
+    interpolator.push(snapshot_at(0, 0.0f, 6.2f));
+    interpolator.push(snapshot_at(50, 50.0f, 0.1f));
+    interpolator.push(snapshot_at(100, 100.0f, 0.1f));
+
+    // now - delay = 25 ms: a mitad de camino entre los dos primeros, por el arco corto
+    GameState view = snapshot_at(100, 100.0f, 0.1f);
+    interpolator.apply_to(view, 1, t0 + milliseconds(125));
+    EXPECT_NEAR(view.players[1].pos_x, 25.0f, 1e-3f);
+    const float two_pi = 2.0f * static_cast<float>(M_PI);
+    const float expected_angle = (6.2f + 0.1f + two_pi) / 2.0f - two_pi;  // ~0.008, no ~3.15
+    EXPECT_NEAR(view.players[1].angle, expected_angle, 1e-3f);
+    EXPECT_FLOAT_EQ(view.players[0].pos_x, 999.0f);  // el propio es de CarPredictor
+
+    // Sin snapshots nuevos se extrapola, pero no más de 200 ms
+    view = snapshot_at(100, 100.0f, 0.1f);
+    interpolator.apply_to(view, 1, t0 + milliseconds(250));
+    EXPECT_NEAR(view.players[1].pos_x, 100.0f + 500.0f * 0.05f, 1e-2f);
+    interpolator.apply_to(view, 1, t0 + seconds(5));
+    EXPECT_NEAR(view.players[1].pos_x, 100.0f + 500.0f * 0.2f, 1e-2f);
+
+    // Fuera del área de interés no hay posición que dibujar
+    view.players[1].in_view = false;
+    view.players[1].pos_x = 0.0f;
+    interpolator.apply_to(view, 1, t0 + milliseconds(125));
+    EXPECT_FLOAT_EQ(view.players[1].pos_x, 0.0f);
+}
+
+// ============================================================
+// TESTS DE COLISIÓN CON PAREDES
+// ============================================================
+
+TEST(CollisionGridTest, MatchesPerPixelDecode) {
+    // 70 de ancho: las filas no empiezan en múltiplos de 64 bits
+    const int w = 70;
+    const int h = 33;
+    TempDir dir;
+    const std::string camino = dir.path("camino.png");
+    const std::string puentes = dir.path("puentes.png");
+    const std::string rampas = dir.path("rampas.png");
+    write_layer(camino, w, h, [](int x, int y) { return (x * 7 + y * 3) % 5 != 0; });
+    write_layer(puentes, w, h, [](int x, int y) { return x > 20 && x < 50 && y % 4 != 0; });
+    write_layer(rampas, w, h, [](int x, int) { return x == 21 || x == 49; });
+
+    // Con y sin capa de rampas (sin ella la rampa es suelo && puente)
+    for (const std::string& ramp_path : {rampas, std::string()}) {
+        CollisionManager pixels(camino, puentes, ramp_path, false);
+        CollisionManager grid(camino, puentes, ramp_path, true);
+        ASSERT_EQ(grid.GetWidth(), w);
+        ASSERT_EQ(grid.GetHeight(), h);
+
+        // Incluye el borde de afuera: fuera del mapa es pared en ambos modos
+        for (int y = -1; y <= h; ++y) {
+            for (int x = -1; x <= w; ++x) {
+                ASSERT_EQ(grid.hasGroundLevel(x, y), pixels.hasGroundLevel(x, y)) << x << "," << y;
+                ASSERT_EQ(grid.hasBridgeLevel(x, y), pixels.hasBridgeLevel(x, y)) << x << "," << y;
+                ASSERT_EQ(grid.isRamp(x, y), pixels.isRamp(x, y)) << x << "," << y;
+                ASSERT_EQ(grid.isWall(x, y, 0), pixels.isWall(x, y, 0)) << x << "," << y;
+                ASSERT_EQ(grid.isWall(x, y, 1), pixels.isWall(x, y, 1)) << x << "," << y;
+            }
+        }
+    }
+}
+
+TEST(MapAssetCacheTest, SharesLiveEntriesAndEvictsUnusedOnes) {
+    // El cache busca las capas relativas al directorio de trabajo
+    TempDir dir;
+    const std::filesystem::path previous_cwd = std::filesystem::current_path();
+    std::filesystem::current_path(dir.get());
+    struct RestoreCwd {
+        std::filesystem::path path;
+        ~RestoreCwd() {
+            std::filesystem::current_path(path);
+            MapAssetCache::clear();
+        }
+    } restore{previous_cwd};
+    MapAssetCache::clear();
+
+    const std::string layers = "assets/img/map/layers/test-city/";
+    auto write_city = [&](int w) {
+        std::filesystem::create_directories(layers);
+        write_layer(layers + "camino.png", w, 16, [](int x, int) { return x % 8 != 0; });
+        write_layer(layers + "puentes.png", w, 16, [](int, int) { return false; });
+    };
+    write_city(32);
+
+    // Mientras alguien la usa, la ciudad se comparte (el nombre se normaliza)
+    auto first = MapAssetCache::get("Test City", false);
+    auto second = MapAssetCache::get("test_city", false);
+    EXPECT_EQ(first, second);
+    EXPECT_TRUE(first->distance_fields.empty());
+
+    // Con SDF es otra entrada, horneada una sola vez
+    auto baked = MapAssetCache::get("Test City", true);
+    EXPECT_NE(baked, first);
+    EXPECT_EQ(baked->distance_fields.size(), 2u);
+    EXPECT_EQ(MapAssetCache::get("Test City", true), baked);
+
+    // Las capas cambian en disco pero la entrada viva sigue siendo la misma
+    write_city(48);
+    EXPECT_EQ(MapAssetCache::get("Test City", false)->grid.GetWidth(), 32);
+
+    // Sin usuarios se libera y la próxima carga lee el disco de nuevo
+    std::weak_ptr<const CollisionData> evicted = first;
+    first.reset();
+    second.reset();
+    EXPECT_TRUE(evicted.expired());
+    EXPECT_EQ(MapAssetCache::get("Test City", false)->grid.GetWidth(), 48);
+
+    // Las precargadas quedan fijadas hasta clear()
+    MapAssetCache::preload({"Test City"}, false);
+    std::weak_ptr<const CollisionData> pinned = MapAssetCache::get("Test City", false);
+    EXPECT_FALSE(pinned.expired());
+    MapAssetCache::clear();
+    EXPECT_TRUE(pinned.expired());
+}
+
+TEST(SweepCollisionTest, TimeOfImpactOnThinWall) {
+    // Pared vertical de 1 px en x = 32
+    CollisionManager walls(make_collision_map(64, 16, [](int x, int) { return x != 32; }));
+
+    CollisionResult hit = walls.sweepCollision(10.5f, 8.5f, 50.5f, 8.5f, 0);
+    EXPECT_TRUE(hit.is_wall);
+    EXPECT_EQ(hit.hit_x, 32);
+    EXPECT_EQ(hit.hit_y, 8);
+    EXPECT_NEAR(hit.time_of_impact, (32.0f - 10.5f) / 40.0f, 1e-5f);
+    EXPECT_FLOAT_EQ(hit.normal_x, -1.0f);
+    EXPECT_FLOAT_EQ(hit.normal_y, 0.0f);
+
+    // Del otro lado la normal apunta al revés
+    hit = walls.sweepCollision(50.5f, 4.5f, 20.5f, 12.5f, 0);
+    EXPECT_TRUE(hit.is_wall);
+    EXPECT_EQ(hit.hit_x, 32);
+    EXPECT_NEAR(hit.time_of_impact, (50.5f - 33.0f) / 30.0f, 1e-5f);
+    EXPECT_FLOAT_EQ(hit.normal_x, 1.0f);
+
+    // Frenar justo antes de la pared no es choque
+    hit = walls.sweepCollision(10.5f, 8.5f, 31.9f, 8.5f, 0);
+    EXPECT_FALSE(hit.is_wall);
+    EXPECT_FLOAT_EQ(hit.time_of_impact, 1.0f);
+}
+
+TEST(SweepCollisionTest, NitroCarDoesNotTunnelThroughThinWall) {
+    CollisionManager walls(make_collision_map(400, 32, [](int x, int) { return x != 200; }));
+
+    // Mucho más rápido que 1 px por tick: sin barrido la pared no se vería nunca
+    const float dt = 1.0f / 60.0f;
+    CarPhysicsPool pool;
+    Car car("Nitro", "classic");
+    car.attach_physics(pool);
+    car.load_stats(3000.0f, 20000.0f, 3.0f, 100.0f, 2.0f, 1.0f);
+    car.setPosition(20.0f, 16.0f);
+
+    // Los mismos pasos que GameLoop: input, integración y barrido desde old_x/old_y
+    uint8_t previous_bits = 0;
+    bool collided = false;
+    for (int tick = 0; tick < 60; ++tick) {
+        const uint8_t bits = INPUT_RIGHT | INPUT_NITRO;
+        car.apply_input(bits, previous_bits, dt);
+        previous_bits = bits;
+        pool.integrate(dt);
+        car.resolve_wall_collision(walls, pool.old_x[0], pool.old_y[0]);
+        collided = collided || car.isColliding();
+        ASSERT_LT(car.getX(), 200.0f) << "atravesó la pared en el tick " << tick;
+    }
+    EXPECT_TRUE(collided);
+    EXPECT_GT(car.getX(), 198.0f);
+}
+
+TEST(SweepCollisionTest, CarInsideWallWithoutDistanceFieldGetsOut) {
+    // Transitable a la izquierda de x = 32; sin SDF no hay normal ni penetración
+    CollisionManager walls(make_collision_map(64, 16, [](int x, int) { return x < 32; }));
+    ASSERT_FALSE(walls.hasDistanceFields());
+
+    CarPhysicsPool pool;
+    Car car("Stuck", "classic");
+    car.attach_physics(pool);
+    car.load_stats(300.0f, 2000.0f, 3.0f, 100.0f, 2.0f, 1.0f);
+
+    // Quieto dentro de la pared: va a la celda libre más cercana
+    car.setPosition(36.2f, 8.5f);
+    car.resolve_wall_collision(walls, 36.2f, 8.5f);
+    EXPECT_TRUE(car.isColliding());
+    EXPECT_FLOAT_EQ(car.getX(), 31.5f);
+    EXPECT_FLOAT_EQ(car.getY(), 8.5f);
+
+    // Manejando hacia afuera sale en pocos ticks en vez de volver siempre a old_x
+    const float dt = 1.0f / 60.0f;
+    car.setPosition(40.5f, 8.5f);
+    uint8_t previous_bits = 0;
+    for (int tick = 0; tick < 30; ++tick) {
+        car.apply_input(INPUT_LEFT, previous_bits, dt);
+        previous_bits = INPUT_LEFT;
+        pool.integrate(dt);
+        car.resolve_wall_collision(walls, pool.old_x[0], pool.old_y[0]);
+    }
+    EXPECT_LT(car.getX(), 32.0f);
+    EXPECT_FALSE(walls.isWall((int)car.getX(), (int)car.getY(), 0));
+}
+
+TEST(DistanceFieldTest, NormalAndPenetrationOnAxisAlignedWall) {
+    // Transitable a la izquierda de x = 32, pared a la derecha
+    auto data = make_collision_map(64, 64, [](int x, int) { return x < 32; }, true);
+    const DistanceField& field = data->distance_fields[0];
+
+    EXPECT_NEAR(field.sample(20.0f, 32.0f), 12.0f, 1.5f);
+    EXPECT_NEAR(field.sample(40.0f, 32.0f), -8.0f, 1.5f);
+
+    // Arrancando dentro de la pared: empuja hacia -x tanto como se metió
+    CollisionManager walls(data);
+    ASSERT_TRUE(walls.hasDistanceFields());
+    CollisionResult hit = walls.sweepCollision(36.0f, 32.0f, 40.0f, 32.0f, 0);
+    EXPECT_TRUE(hit.is_wall);
+    EXPECT_NEAR(hit.normal_x, -1.0f, 0.05f);
+    EXPECT_NEAR(hit.normal_y, 0.0f, 0.05f);
+    EXPECT_NEAR(hit.penetration, 4.0f, 1.5f);
+}
+
+TEST(DistanceFieldTest, NormalAndPenetrationOnDiagonalWall) {
+    // Pared del otro lado de x + y = 64: la normal sale a 45° hacia el origen
+    auto data = make_collision_map(128, 128, [](int x, int y) { return x + y < 64; }, true);
+    CollisionManager walls(data);
+    const float diagonal = 1.0f / std::sqrt(2.0f);
+
+    CollisionResult hit = walls.sweepCollision(36.0f, 36.0f, 40.0f, 40.0f, 0);
+    EXPECT_TRUE(hit.is_wall);
+    EXPECT_NEAR(hit.normal_x, -diagonal, 0.1f);
+    EXPECT_NEAR(hit.normal_y, -diagonal, 0.1f);
+    EXPECT_NEAR(hit.penetration, (36.0f + 36.0f - 64.0f) * diagonal, 1.5f);
+
+    // Chocando desde afuera la normal también es la del SDF, no la de la cara del píxel
+    hit = walls.sweepCollision(10.5f, 20.5f, 50.5f, 20.5f, 0);
+    EXPECT_TRUE(hit.is_wall);
+    EXPECT_EQ(hit.hit_x, 44);
+    EXPECT_NEAR(hit.normal_x, -diagonal, 0.1f);
+    EXPECT_NEAR(hit.normal_y, -diagonal, 0.1f);
+}
+
+// ============================================================
+// TESTS DE RUTAS COMPILADAS (.race)
+// ============================================================
+
+TEST(RaceDescriptorTest, CompiledRaceRoundTripAndInvalidation) {
+    TempDir dir;
+    const std::string yaml_path = dir.path("playa.yaml");
+    const std::string yaml_text =
+            "race:\n  name: Playa\n  city: Vice City\n  total_laps: 3\n"
+            "spawn_points:\n  - {x: 10, y: 20, angle: 90}\n"
+            "checkpoints:\n"
+            "  - {id: 1, type: finish, x: 300, y: 40, width: 80, height: 20, angle: 45}\n"
+            "  - {id: 0, type: start, cx: 100, cy: 40, radius: 30}\n";
+    write_text(yaml_path, yaml_text);
+
+    auto race = RaceDescriptor::load(yaml_path);
+    EXPECT_EQ(race->name, "Playa");
+    EXPECT_EQ(race->city, "Vice City");
+    EXPECT_EQ(race->total_laps, 3);
+    ASSERT_EQ(race->spawn_points.size(), 1u);
+    EXPECT_FLOAT_EQ(race->spawn_points[0].angle, 90.0f);
+    ASSERT_EQ(race->checkpoints.size(), 2u);
+    EXPECT_EQ(race->checkpoints[0].type, CheckpointType::START);
+    EXPECT_FLOAT_EQ(race->checkpoints[0].width, 60.0f);
+    EXPECT_EQ(race->checkpoints[1].type, CheckpointType::FINISH);
+
+    // El binario queda al lado del YAML y no sobra ningún temporal
+    EXPECT_TRUE(std::filesystem::exists(yaml_path + ".race"));
+    EXPECT_EQ(std::distance(std::filesystem::directory_iterator(dir.get()),
+                            std::filesystem::directory_iterator()),
+              2);
+
+    // Ida y vuelta por el formato binario; con otro hash no se acepta
+    const uint64_t hash = RaceDescriptor::hash_bytes(yaml_text);
+    RaceDescriptor copy;
+    ASSERT_TRUE(RaceDescriptor::deserialize(race->serialize(hash), hash, copy));
+    EXPECT_EQ(copy.name, race->name);
+    EXPECT_EQ(copy.city, race->city);
+    EXPECT_EQ(copy.total_laps, race->total_laps);
+    ASSERT_EQ(copy.checkpoints.size(), race->checkpoints.size());
+    for (size_t i = 0; i < copy.checkpoints.size(); ++i) {
+        EXPECT_EQ(copy.checkpoints[i].id, race->checkpoints[i].id);
+        EXPECT_FLOAT_EQ(copy.checkpoints[i].x, race->checkpoints[i].x);
+        EXPECT_FLOAT_EQ(copy.checkpoints[i].angle, race->checkpoints[i].angle);
+    }
+    EXPECT_FALSE(RaceDescriptor::deserialize(race->serialize(hash), hash + 1, copy));
+
+    // Sin cambios en disco sale de la cache en memoria
+    EXPECT_EQ(RaceDescriptor::load(yaml_path), race);
+
+    // Otro YAML: se recompila y el .race pasa a ser el del hash nuevo
+    std::string edited = yaml_text;
+    edited.replace(edited.find("total_laps: 3"), 13, "total_laps: 12");
+    write_text(yaml_path, edited);
+    auto reloaded = RaceDescriptor::load(yaml_path);
+    EXPECT_NE(reloaded, race);
+    EXPECT_EQ(reloaded->total_laps, 12);
+
+    std::ifstream compiled(yaml_path + ".race", std::ios::binary);
+    const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(compiled)),
+                                     std::istreambuf_iterator<char>());
+    EXPECT_TRUE(RaceDescriptor::deserialize(bytes, RaceDescriptor::hash_bytes(edited), copy));
+    EXPECT_FALSE(RaceDescriptor::deserialize(bytes, hash, copy));
+}
+
+// ============================================================
+// TESTS DE FÍSICA DE AUTOS
+// ============================================================
+
+namespace {
+// Cinemática escalar de Car antes del pool (Car::update y Car::apply_friction)
+struct ScalarCar {
+    float x, y, angle, speed, velocity_x, velocity_y;
+    bool destroyed;
+
+    void update(float dt) {
+        if (destroyed) return;
+        velocity_x = speed * std::cos(angle);
+        velocity_y = speed * std::sin(angle);
+        x += velocity_x * dt;
+        y += velocity_y * dt;
+    }
+
+    void apply_friction(float dt) {
+        if (destroyed) return;
+        speed *= std::pow(0.05f, dt);
+        if (speed < 0.5f) {
+            speed = 0.0f;
+            velocity_x = 0.0f;
+            velocity_y = 0.0f;
+        } else {
+            velocity_x = speed * std::cos(angle);
+            velocity_y = speed * std::sin(angle);
+            x += velocity_x * dt;
+            y += velocity_y * dt;
+        }
+    }
+};
+}  // namespace
+
+TEST(CarPhysicsPoolTest, KernelsMatchScalarCarCode) {
+    // 13 autos: no es múltiplo del ancho de ningún vector SIMD
+    CarPhysicsPool pool;
+    std::vector<ScalarCar> reference;
+    for (int i = 0; i < 13; ++i) {
+        ScalarCar car{10.0f * i, 5.0f * i, 0.37f * i, i % 4 == 0 ? 0.4f : 40.0f * i,
+                      3.0f, -2.0f, i % 5 == 3};
+        const size_t slot = pool.allocate(nullptr);
+        pool.x[slot] = car.x;
+        pool.y[slot] = car.y;
+        pool.angle[slot] = car.angle;
+        pool.speed[slot] = car.speed;
+        pool.velocity_x[slot] = car.velocity_x;
+        pool.velocity_y[slot] = car.velocity_y;
+        pool.alive[slot] = car.destroyed ? 0.0f : 1.0f;
+        reference.push_back(car);
+    }
+
+    // Varios dt: la fricción cacheada se recalcula cuando cambia
+    const float steps[] = {1.0f / 60.0f, 1.0f / 60.0f, 1.0f / 30.0f, 1.0f / 600.0f};
+    for (int tick = 0; tick < 40; ++tick) {
+        const float dt = steps[tick % 4];
+        if (tick % 2 == 0) {
+            // El viejo apply_friction también movía el auto: fricción + integración
+            pool.apply_friction(dt);
+            pool.integrate(dt);
+            for (ScalarCar& car : reference) car.apply_friction(dt);
+        } else {
+            pool.integrate(dt);
+            for (ScalarCar& car : reference) car.update(dt);
+        }
+
+        for (size_t i = 0; i < reference.size(); ++i) {
+            const ScalarCar& car = reference[i];
+            ASSERT_FLOAT_EQ(pool.x[i], car.x) << "tick " << tick << ", auto " << i;
+            ASSERT_FLOAT_EQ(pool.y[i], car.y) << "tick " << tick << ", auto " << i;
+            ASSERT_FLOAT_EQ(pool.speed[i], car.speed) << "tick " << tick << ", auto " << i;
+            ASSERT_FLOAT_EQ(pool.velocity_x[i], car.velocity_x) << "tick " << tick << ", auto " << i;
+            ASSERT_FLOAT_EQ(pool.velocity_y[i], car.velocity_y) << "tick " << tick << ", auto " << i;
+        }
+    }
+}
+
+TEST(TickSchedulerTest, FixedStepsAndCatchUpCap) {
+    using std::chrono::milliseconds;
+    TickScheduler scheduler;
+    scheduler.configure(milliseconds(10), milliseconds(20), 5);
+
+    // El primer snapshot sale enseguida, el siguiente recién con el período
+    EXPECT_EQ(scheduler.advance(milliseconds(0)), 0);
+    EXPECT_TRUE(scheduler.snapshot_due(false));
+    EXPECT_FALSE(scheduler.snapshot_due(false));
+
+    // Solo ticks enteros; la fracción queda para la próxima vuelta
+    EXPECT_EQ(scheduler.advance(milliseconds(25)), 2);
+    EXPECT_TRUE(scheduler.snapshot_due(false));
+    EXPECT_EQ(scheduler.until_next_event(), milliseconds(5));
+    EXPECT_EQ(scheduler.advance(milliseconds(4)), 0);
+    EXPECT_EQ(scheduler.advance(milliseconds(1)), 1);
+    EXPECT_EQ(scheduler.dropped_steps(), 0);
+
+    // Un atraso de 20 ticks: se recuperan 5, se descartan 15 y se conserva la fracción
+    EXPECT_EQ(scheduler.advance(milliseconds(203)), 5);
+    EXPECT_EQ(scheduler.dropped_steps(), 15);
+    EXPECT_EQ(scheduler.advance(milliseconds(6)), 0);
+    EXPECT_EQ(scheduler.dropped_steps(), 0);
+    EXPECT_EQ(scheduler.advance(milliseconds(1)), 1);
+
+    // Al terminar la carrera el último estado sale sin esperar el período
+    EXPECT_TRUE(scheduler.snapshot_due(false));
+    EXPECT_FALSE(scheduler.snapshot_due(false));
+    EXPECT_TRUE(scheduler.snapshot_due(true));
+
+    // 600 vueltas de 1 ms son 60 ticks justos, como 60 Hz durante un segundo
+    scheduler.configure(milliseconds(10), milliseconds(20), 5);
+    int steps = 0;
+    for (int i = 0; i < 600; ++i) steps += scheduler.advance(milliseconds(1));
+    EXPECT_EQ(steps, 60);
+}
+
+// ============================================================
+// TESTS DEL CATÁLOGO DE AUTOS
+// ============================================================
+
+TEST(CarCatalogTest, IdsFollowConfigOrderAndResolveStats) {
+    const YAML::Node cars = YAML::Load(
+            "- {name: Senator, type: classic, speed: 60, acceleration: 40, handling: 50, "
+            "durability: 80}\n"
+            "- {name: Brisa, type: sport, speed: 90, acceleration: 70, handling: 80, "
+            "durability: 40, health: 55}\n"
+            "- {name: Senator, type: truck, speed: 10, acceleration: 10, handling: 10, "
+            "durability: 10}\n");
+    const CarCatalog catalog = CarCatalog::from_yaml(cars, 2.0f, 0.5f);
+
+    // El id es la posición en `cars:`; con nombres repetidos gana el primero
+    ASSERT_EQ(catalog.size(), 3u);
+    EXPECT_EQ(catalog.id_of("Senator"), 0);
+    EXPECT_EQ(catalog.id_of("Brisa"), 1);
+    EXPECT_EQ(catalog.id_of("Inexistente"), CarCatalog::UNKNOWN_CAR);
+    for (const CarModel& model : catalog.all()) EXPECT_EQ(&catalog.get(model.id), &model);
+
+    // Stats ya escalados, listos para Car::load_stats
+    const CarModel& brisa = catalog.get(catalog.id_of("Brisa"));
+    EXPECT_EQ(brisa.type, "sport");
+    EXPECT_FLOAT_EQ(brisa.max_speed, 90.0f * 2.0f * 1.5f);
+    EXPECT_FLOAT_EQ(brisa.accel_power, 70.0f * 0.5f * 0.8f);
+    EXPECT_FLOAT_EQ(brisa.turn_rate, 0.8f);
+    EXPECT_FLOAT_EQ(brisa.health, 55.0f);
+    EXPECT_FLOAT_EQ(catalog.get(0).health, 80.0f);
+
+    // Ids desconocidos caen en los stats por defecto (escalados igual)
+    const CarModel& unknown = catalog.get(CarCatalog::UNKNOWN_CAR);
+    EXPECT_EQ(unknown.id, CarCatalog::UNKNOWN_CAR);
+    EXPECT_FLOAT_EQ(unknown.max_speed, 100.0f * 2.0f);
+    EXPECT_EQ(&catalog.get(3), &unknown);
+}
+
+// ============================================================
+// TESTS DE CHECKPOINTS
+// ============================================================
+
+TEST(CheckpointEngineTest, GatesCountOnlyForwardCrossingsWithinLookahead) {
+    // Ruta recta hacia +x: largada, cuatro checkpoints y llegada cada 100 px
+    std::vector<RaceCheckpointDef> route;
+    for (int i = 0; i <= 5; ++i) {
+        const CheckpointType type = i == 0   ? CheckpointType::START
+                                    : i == 5 ? CheckpointType::FINISH
+                                             : CheckpointType::NORMAL;
+        route.push_back({i, type, 100.0f * i, 0.0f, 40.0f, 40.0f, 0.0f});
+    }
+    CheckpointEngine engine;
+    engine.build(route, 1.5f, 3.0f);
+    engine.set_lookahead(2);
+
+    ASSERT_EQ(engine.size(), 6);
+    EXPECT_EQ(engine.first_target_index(), 1);
+    EXPECT_EQ(engine.finish_index(), 5);
+    EXPECT_EQ(engine.next_after(5), 5);
+    EXPECT_FLOAT_EQ(engine.gate(1).half_length, 30.0f);
+    EXPECT_FLOAT_EQ(engine.gate(5).half_length, 60.0f);
+
+    // En el sentido de la carrera cuenta; volviendo marcha atrás no
+    EXPECT_EQ(engine.find_crossing(1, 90.0f, 0.0f, 110.0f, 0.0f), 1);
+    EXPECT_EQ(engine.find_crossing(1, 110.0f, 0.0f, 90.0f, 0.0f), -1);
+    EXPECT_EQ(engine.find_crossing(1, 105.0f, 10.0f, 110.0f, -10.0f), -1);  // ya estaba adelante
+
+    // Solo dentro del largo de la compuerta
+    EXPECT_EQ(engine.find_crossing(1, 90.0f, 25.0f, 110.0f, 25.0f), 1);
+    EXPECT_EQ(engine.find_crossing(1, 90.0f, 40.0f, 110.0f, 40.0f), -1);
+    EXPECT_EQ(engine.find_crossing(5, 490.0f, 50.0f, 510.0f, 50.0f), 5);  // la llegada es más ancha
+
+    // Con lookahead 2, saltear el 1 todavía deja pasar el 2 y el 3, pero no el 4
+    EXPECT_EQ(engine.find_crossing(1, 190.0f, 0.0f, 210.0f, 0.0f), 2);
+    EXPECT_EQ(engine.find_crossing(1, 290.0f, 0.0f, 310.0f, 0.0f), 3);
+    EXPECT_EQ(engine.find_crossing(1, 390.0f, 0.0f, 410.0f, 0.0f), -1);
+    engine.set_lookahead(3);
+    EXPECT_EQ(engine.find_crossing(1, 390.0f, 0.0f, 410.0f, 0.0f), 4);
+
+    // Cruzar varias en un mismo tick devuelve la primera
+    EXPECT_EQ(engine.find_crossing(1, 50.0f, 0.0f, 350.0f, 0.0f), 1);
+
+    // Con la ruta en sentido contrario, cuenta el cruce hacia -x
+    std::reverse(route.begin(), route.end());
+    for (size_t i = 0; i < route.size(); ++i) route[i].id = static_cast<int32_t>(i);
+    engine.build(route, 1.5f, 3.0f);
+    EXPECT_EQ(engine.find_crossing(1, 410.0f, 0.0f, 390.0f, 0.0f), 1);
+    EXPECT_EQ(engine.find_crossing(1, 390.0f, 0.0f, 410.0f, 0.0f), -1);
+}